@@ -0,0 +1,125 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELHITSELECTIONSEARCH_H
+#define EUTELHITSELECTIONSEARCH_H 1
+
+// system includes <>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Hit selection search of EUTelTestFitter
+  /*! A hit selection takes one hit or no hit on every active plane.
+   *  The selections are numbered like the digits of a number, with
+   *  one digit per plane and the last plane as lowest digit, and are
+   *  checked in decreasing order. The selection without hit on a plane
+   *  has the highest digit, so every selection is checked after the
+   *  selections it extends on the following planes.
+   *
+   *  A selection is fitted if it has at least two hits (three without
+   *  beam constraint, unless two are enough), can still reach the
+   *  number of active planes allowed by the missing hits and passes
+   *  the preselection of the fitter. Fits with enough planes and a
+   *  chi2 plus missing/skip penalty between the chi2 limits are
+   *  accepted.
+   *
+   *  Fitting more hits can not lower the fit chi2, so whenever a
+   *  selection fails, all selections extending it are skipped:
+   *
+   *  \li when the fit chi2 is out of the chi2 limits;
+   *  \li when the preselection fails on a plane, from that plane on;
+   *  \li when too many fired planes must stay skipped;
+   *  \li when the chi2 of the fitted selection it extends plus the
+   *  smallest penalty still reachable is above the chi2 limit. The
+   *  chi2 is kept per plane together with the number of the fitted
+   *  selection, so it is never taken from an unrelated selection.
+   *
+   *  The skipped selections could not be accepted, the accepted fits
+   *  and their order are the same as when every selection is fitted.
+   *
+   *  The search only keeps its configuration: search is const and
+   *  can be called from several threads with different fitters.
+   */
+  class EUTelHitSelectionSearch {
+
+  public:
+    //! Type used for numbering of hit selections (can be large)
+    typedef long long int type_fitcount;
+
+    //! The fit of the hit selections
+    /*! The hits of a selection are given as one index per plane, the
+     *  index of the hit in the plane or -1 for no hit.
+     */
+    class Fitter {
+    public:
+      virtual ~Fitter() {}
+
+      //! Cuts on the hits of a selection before the fit
+      /*! @return The first plane whose hit fails the cuts, 0 if the
+       *  selection passes. A failing plane must be decided by the hits
+       *  up to that plane only.
+       */
+      virtual int preselect(const std::vector<int> &hits) = 0;
+
+      //! Fit a selection of nFired hits
+      /*! @return The fit chi2, negative if the fit failed
+       */
+      virtual double fit(const std::vector<int> &hits, int nFired) = 0;
+
+      //! An accepted fit, called right after its fit
+      /*! @param chi2 The fit chi2 plus the penalty
+       */
+      virtual void accept(const std::vector<int> &hits, int nFired,
+                          double chi2, double penalty) = 0;
+    };
+
+    //! Default constructor: no plane, nothing missing or skipped
+    EUTelHitSelectionSearch();
+
+    //! Set the planes, true for the planes hits are selected on
+    void setActivePlanes(const std::vector<bool> &isActive);
+
+    //! Set the number of active planes without hit a fit may have
+    void setAllowedMissingHits(int allowMissingHits);
+
+    //! Set the number of planes with hits a fit may leave out
+    void setAllowedSkipHits(int allowSkipHits);
+
+    //! Set the chi2 penalties of a missing and of a skipped hit
+    void setPenalties(double missingHitPenalty, double skipHitPenalty);
+
+    //! Set the range of accepted chi2
+    void setChi2Limits(double chi2Min, double chi2Max);
+
+    //! Whether 2 hit fits make sense, as with the beam constraint
+    void setBeamConstraint(bool useBeamConstraint);
+
+    //! Search the hit selections of an event
+    /*! @param planeHits The number of hits on each plane
+     *  @param fitter The fitter of the selections
+     *  @return The lowest chi2 plus penalty of the fits with enough
+     *  planes, or the largest double if there was none
+     */
+    double search(const std::vector<int> &planeHits, Fitter &fitter) const;
+
+  private:
+    std::vector<bool> _isActive;
+    int _nActivePlanes;
+    int _allowMissingHits;
+    int _allowSkipHits;
+    double _missingHitPenalty;
+    double _skipHitPenalty;
+    double _chi2Min;
+    double _chi2Max;
+    bool _useBeamConstraint;
+  };
+
+} // namespace eutelescope
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELMILLETRACKFINDER_H
+#define EUTELMILLETRACKFINDER_H 1
+
+// system includes <>
+#include <cstddef>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Track candidate search of EUTelMille
+  /*! The candidates are combinations of one hit index per plane (-1
+   *  for a plane without hit), in the same order and with the same
+   *  duplicates as the recursive search EUTelMille used before:
+   *
+   *  \li the hits of each plane are tried in index order. A hit whose
+   *  absolute X and Y residuals with respect to the hit chosen on the
+   *  previous plane are outside the residual window of that plane pair
+   *  continues the candidate without hit, as does an empty plane.
+   *  \li a candidate is dropped as soon as it has more planes without
+   *  hit than allowed.
+   *  \li every hit of the last plane ends a candidate, without
+   *  residual cut, until the maximum number of candidates is
+   *  reached. If the last plane is empty, the candidates have one
+   *  entry less and are not limited.
+   *
+   *  Instead of computing the residuals of every hit, the hits of each
+   *  plane are sorted in X and only the hits inside the X window are
+   *  checked. The branches without hit on a plane only depend on the
+   *  hits chosen before, so they are searched once and their
+   *  candidates are copied for the other failing hits.
+   *
+   *  The finder only keeps its configuration: findTracks is const and
+   *  can be called from several threads at once.
+   */
+  class EUTelMilleTrackFinder {
+
+  public:
+    //! Default constructor: no missing hits and 2000 candidates at most
+    EUTelMilleTrackFinder();
+
+    //! Set the residual windows
+    /*! Element @c i of each vector is the window of the absolute
+     *  residual between plane @c i and plane @c i+1.
+     */
+    void setResidualWindows(const std::vector<double> &xMin,
+                            const std::vector<double> &xMax,
+                            const std::vector<double> &yMin,
+                            const std::vector<double> &yMax);
+
+    //! Set the number of planes a candidate may miss
+    void setAllowedMissingHits(int allowedMissingHits);
+
+    //! Set the maximum number of candidates
+    void setMaxCandidates(size_t maxCandidates);
+
+    //! Find the track candidates
+    /*! @param xPos The X positions of the hits, one vector per plane
+     *  @param yPos The Y positions of the hits, one vector per plane
+     *  @param candidates The hit indices of the candidates, replaced
+     */
+    void findTracks(const std::vector<std::vector<double>> &xPos,
+                    const std::vector<std::vector<double>> &yPos,
+                    std::vector<std::vector<int>> &candidates) const;
+
+  private:
+    struct Search;
+
+    std::vector<double> _residualsXMin;
+    std::vector<double> _residualsXMax;
+    std::vector<double> _residualsYMin;
+    std::vector<double> _residualsYMax;
+    int _allowedMissingHits;
+    size_t _maxCandidates;
+  };
+
+} // namespace eutelescope
+
+#endif
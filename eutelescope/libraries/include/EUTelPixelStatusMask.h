@@ -0,0 +1,172 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELPIXELSTATUSMASK_H
+#define EUTELPIXELSTATUSMASK_H 1
+
+// system includes <>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Packed pixel bitmap
+  /*! One bit per pixel index, stored in 64 bit words. The bits past
+   *  the last pixel of the last word are always zero.
+   */
+  class EUTelPixelBitmap {
+
+  public:
+    //! Default constructor, without pixels
+    EUTelPixelBitmap();
+
+    //! Change the number of pixels, new pixels are not set
+    void resize(size_t nPixels);
+
+    //! The number of pixels
+    inline size_t size() const { return _nPixels; }
+
+    //! Unset all pixels with a word-wise memset
+    void clear();
+
+    inline bool test(size_t index) const {
+      return (_words[index >> 6] >> (index & 63)) & 1;
+    }
+
+    inline void set(size_t index) {
+      _words[index >> 6] |= std::uint64_t(1) << (index & 63);
+    }
+
+    inline void reset(size_t index) {
+      _words[index >> 6] &= ~(std::uint64_t(1) << (index & 63));
+    }
+
+    //! The first set pixel at or after @a from, size() if there is none
+    size_t findNext(size_t from) const;
+
+    //! The number of set pixels
+    size_t count() const;
+
+    //! The packed words, pixel @c i is bit <tt>i % 64</tt> of word
+    //! <tt>i / 64</tt>
+    inline const std::vector<std::uint64_t> &getWords() const {
+      return _words;
+    }
+
+  private:
+    std::vector<std::uint64_t> _words;
+    size_t _nPixels;
+  };
+
+  //! Pixel status of one sensor for the clustering
+  /*! The status collection of a sensor is loaded into a bitmap of the
+   *  bad pixels whenever its values change, i.e. the pixels whose status is not
+   *  EUTELESCOPE::GOODPIXEL. The pixels used by a cluster
+   *  (EUTELESCOPE::HITPIXEL) and the good pixels without data
+   *  (EUTELESCOPE::MISSINGPIXEL) of the current event are kept in two
+   *  more bitmaps, which are cleared at the beginning of each event
+   *  instead of resetting the status vector pixel by pixel. The hot
+   *  pixels of the hot pixel database are kept apart: they are not
+   *  part of the status.
+   *
+   *  A pixel is good if it is neither bad, nor hit, nor missing, as
+   *  the status value EUTELESCOPE::GOODPIXEL after the reset of the
+   *  previous event.
+   */
+  class EUTelPixelStatusMask {
+
+  public:
+    //! Default constructor, without pixels and without status
+    EUTelPixelStatusMask();
+
+    //! Load the status values of the sensor
+    /*! The number of pixels becomes at least the size of @a status.
+     *  HIT and MISSING values left over in @a status count as good.
+     *  The hot pixels are kept. A copy of the values is kept to
+     *  recognise them later.
+     */
+    void setStatus(const std::vector<short> &status);
+
+    //! True once setStatus has been called and until clearStatus
+    inline bool hasStatus() const { return _hasStatus; }
+
+    //! True if the mask was loaded from exactly these status values
+    /*! The status collection can be changed in place by another
+     *  processor, so the values are compared and not their address.
+     */
+    bool hasStatus(const std::vector<short> &status) const;
+
+    //! Forget the status and the current event, the hot pixels are kept
+    void clearStatus();
+
+    //! Change the number of pixels, new pixels are good and not hot
+    void resize(size_t nPixels);
+
+    //! The number of pixels
+    inline size_t size() const { return _bad.size(); }
+
+    //! Forget the hit and missing pixels of the previous event
+    void clearEvent();
+
+    inline bool isGood(size_t index) const {
+      const size_t word = index >> 6;
+      const std::uint64_t notGood = _bad.getWords()[word] |
+                                    _hit.getWords()[word] |
+                                    _missing.getWords()[word];
+      return !((notGood >> (index & 63)) & 1);
+    }
+
+    inline bool isBad(size_t index) const { return _bad.test(index); }
+    inline bool isHit(size_t index) const { return _hit.test(index); }
+    inline bool isMissing(size_t index) const { return _missing.test(index); }
+    inline bool isHot(size_t index) const { return _hot.test(index); }
+
+    //! Mark a pixel as used by a cluster, it is no longer missing
+    inline void setHit(size_t index) {
+      _hit.set(index);
+      _missing.reset(index);
+    }
+
+    //! Mark a good pixel without data in the current event
+    inline void setMissing(size_t index) { _missing.set(index); }
+
+    //! Mark a pixel of the hot pixel database
+    inline void setHot(size_t index) { _hot.set(index); }
+
+    //! The first good pixel at or after @a from, size() if there is none
+    /*! Whole words of bad or used pixels are skipped at once, so
+     *  looping over the good pixels of a sensor costs about one
+     *  operation per 64 pixels plus one per good pixel.
+     */
+    size_t findGood(size_t from) const;
+
+    //! The first good pixel set in @a candidates at or after @a from
+    /*! The candidates are indexed as the status, e.g. the pixels of a
+     *  sparse frame above the seed cut. The scan skips whole words as
+     *  findGood. Pixels past the end of @a candidates are not
+     *  candidates. @return size() if there is none
+     */
+    size_t findGood(size_t from, const EUTelPixelBitmap &candidates) const;
+
+  private:
+    //! findGood within the candidate words, all pixels without them
+    size_t findGood(size_t from, const std::uint64_t *candidates,
+                    size_t nCandidateWords) const;
+
+    EUTelPixelBitmap _bad;
+    EUTelPixelBitmap _hot;
+    EUTelPixelBitmap _hit;
+    EUTelPixelBitmap _missing;
+    std::vector<short> _status;
+    bool _hasStatus;
+  };
+
+} // namespace eutelescope
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELSTRAIGHTLINEFIT_H
+#define EUTELSTRAIGHTLINEFIT_H 1
+
+// system includes <>
+#include <cstddef>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Closed form straight line fit of tracks with one hit per plane
+  /*! The X and Y coordinates are fitted independently as a function of
+   *  z with weights 1/resolution^2, as in EUTelLineFit (see Blobel,
+   *  page 226). For fixed plane positions and resolutions the fitted
+   *  slope and the weighted mean position are linear in the measured
+   *  positions, so their coefficients are computed once by setPlanes
+   *  and a fit is a couple of dot products per track.
+   *
+   *  The fit functions take many tracks at once. The positions are
+   *  stored plane by plane: the position of track @c t on plane @c p
+   *  is element <tt>p * nTracks + t</tt>, and the same holds for the
+   *  fitted positions.
+   */
+  class EUTelStraightLineFit {
+
+  public:
+    //! Default constructor, without planes
+    EUTelStraightLineFit();
+
+    //! Set the plane configuration and compute the fit coefficients
+    /*! @param zPos The z position of each plane
+     *  @param resolX The X resolution of each plane
+     *  @param resolY The Y resolution of each plane
+     */
+    void setPlanes(const std::vector<double> &zPos,
+                   const std::vector<double> &resolX,
+                   const std::vector<double> &resolY);
+
+    //! The z positions of the current configuration
+    inline const std::vector<double> &getZPositions() const { return _zPos; }
+
+    //! The number of planes of the current configuration
+    inline size_t getNPlanes() const { return _zPos.size(); }
+
+    //! Fit the X coordinate of @a nTracks tracks
+    /*! @param nTracks The number of tracks
+     *  @param xPos The measured positions, plane by plane
+     *  @param xFit The fitted positions, plane by plane
+     *  @param slope The fitted slope dx/dz of each track
+     *  @param chi2 The chi2 of each track
+     */
+    void fitX(size_t nTracks, const double *xPos, double *xFit, double *slope,
+              double *chi2) const;
+
+    //! Fit the Y coordinate of @a nTracks tracks
+    /*! Same as fitX, with the Y resolutions.
+     */
+    void fitY(size_t nTracks, const double *yPos, double *yFit, double *slope,
+              double *chi2) const;
+
+  private:
+    //! Fit coefficients of one coordinate
+    struct Projection {
+      //! 1/resolution^2 of each plane
+      std::vector<double> weight;
+      //! Coefficients of the weighted mean position
+      std::vector<double> mean;
+      //! Coefficients of the slope
+      std::vector<double> slope;
+      //! z of each plane relative to the weighted mean z
+      std::vector<double> dz;
+
+      Projection() : weight(), mean(), slope(), dz() {}
+      void set(const std::vector<double> &zPos,
+               const std::vector<double> &resol);
+      void fit(size_t nTracks, const double *pos, double *fitPos,
+               double *fitSlope, double *chi2) const;
+    };
+
+    std::vector<double> _zPos;
+    Projection _projectionX;
+    Projection _projectionY;
+  };
+
+} // namespace eutelescope
+
+#endif
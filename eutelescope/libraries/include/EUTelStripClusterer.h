@@ -0,0 +1,68 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELSTRIPCLUSTERER_H
+#define EUTELSTRIPCLUSTERER_H 1
+
+// system includes <>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eutelescope {
+
+  //! Clustering of binary strip data on packed bit words
+  /*! The hit strips of one sensor are kept as one bit per strip. Runs of
+   *  adjacent hits are found with shifts and masks on whole words, so the
+   *  cost goes with the number of words and clusters, not with the number
+   *  of strips.
+   */
+  class EUTelStripClusterer {
+
+  public:
+    //! A cluster: first strip and number of strips
+    struct StripCluster {
+      int first;
+      int size;
+    };
+
+    EUTelStripClusterer();
+
+    //! Clears all hits and sets the number of strips
+    void reset(int nStrips);
+
+    //! Marks a strip as hit, strips outside the sensor are ignored
+    void setStrip(int strip);
+
+    //! Resets to @a nStrips strips and marks every strip with a value
+    //! above zero as hit
+    void setStrips(const float *values, int nStrips);
+
+    //! The number of hit strips
+    int getNumberOfHits() const;
+
+    //! Appends the clusters to @a clusters, in strip order
+    /*! Runs longer than @a maxSize are split into clusters of at most
+     *  @a maxSize strips, @a maxSize < 1 means no limit.
+     */
+    void findClusters(int maxSize, std::vector<StripCluster> &clusters) const;
+
+  private:
+    //! Appends a run of hit strips, split into clusters of at most maxSize
+    static void addRun(int first, int last, int maxSize,
+                       std::vector<StripCluster> &clusters);
+
+    int _nStrips;
+
+    //! One bit per strip, strip i is bit i % 64 of word i / 64
+    std::vector<std::uint64_t> _words;
+  };
+
+} // namespace eutelescope
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+#ifndef EUTELTHRESHOLDCOMPACTION_H
+#define EUTELTHRESHOLDCOMPACTION_H 1
+
+// system includes <>
+#include <cstddef>
+
+namespace eutelescope {
+
+  //! Threshold compaction of a full frame
+  /*! These functions select the pixels of a full frame passing the
+   *  zero suppression, as done by EUTelRawDataSparsifier: a pixel
+   *  survives if its status is EUTELESCOPE::GOODPIXEL and its signal
+   *  (adc - pedestal) is above sigmaCut * noise.
+   *
+   *  The index and the signal of the surviving pixels are written in
+   *  order into @a indices and @a signals, which must have room for
+   *  @a noOfPixels entries. The number of surviving pixels is
+   *  returned.
+   */
+  namespace ThresholdCompaction {
+
+    //! Compaction using the fastest implementation available on this CPU
+    size_t compact(const short *adcValues, const float *pedestalValues,
+                   const float *noiseValues, const short *statusValues,
+                   size_t noOfPixels, float sigmaCut, int *indices,
+                   float *signals);
+
+    //! Plain scalar implementation
+    size_t compactScalar(const short *adcValues, const float *pedestalValues,
+                         const float *noiseValues, const short *statusValues,
+                         size_t noOfPixels, float sigmaCut, int *indices,
+                         float *signals);
+
+    //! True if compact uses the AVX2 implementation
+    bool hasAVX2();
+
+  } // namespace ThresholdCompaction
+
+} // namespace eutelescope
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelHitSelectionSearch.h"
+
+// system includes <>
+#include <algorithm>
+#include <limits>
+
+using namespace eutelescope;
+
+EUTelHitSelectionSearch::EUTelHitSelectionSearch()
+    : _isActive(), _nActivePlanes(0), _allowMissingHits(0),
+      _allowSkipHits(0), _missingHitPenalty(0.), _skipHitPenalty(0.),
+      _chi2Min(0.), _chi2Max(0.), _useBeamConstraint(false) {}
+
+void EUTelHitSelectionSearch::setActivePlanes(
+    const std::vector<bool> &isActive) {
+  _isActive = isActive;
+  _nActivePlanes = static_cast<int>(
+      std::count(_isActive.begin(), _isActive.end(), true));
+}
+
+void EUTelHitSelectionSearch::setAllowedMissingHits(int allowMissingHits) {
+  _allowMissingHits = allowMissingHits;
+}
+
+void EUTelHitSelectionSearch::setAllowedSkipHits(int allowSkipHits) {
+  _allowSkipHits = allowSkipHits;
+}
+
+void EUTelHitSelectionSearch::setPenalties(double missingHitPenalty,
+                                           double skipHitPenalty) {
+  _missingHitPenalty = missingHitPenalty;
+  _skipHitPenalty = skipHitPenalty;
+}
+
+void EUTelHitSelectionSearch::setChi2Limits(double chi2Min, double chi2Max) {
+  _chi2Min = chi2Min;
+  _chi2Max = chi2Max;
+}
+
+void EUTelHitSelectionSearch::setBeamConstraint(bool useBeamConstraint) {
+  _useBeamConstraint = useBeamConstraint;
+}
+
+double EUTelHitSelectionSearch::search(const std::vector<int> &planeHits,
+                                       Fitter &fitter) const {
+  const int nTelPlanes = static_cast<int>(_isActive.size());
+  double chi2min = std::numeric_limits<double>::max();
+
+  // Count planes active in this event and number of fit possibilities,
+  // from the last plane, to allow for "smart" track finding
+
+  std::vector<int> planeChoice(nTelPlanes);
+  std::vector<type_fitcount> planeMod(nTelPlanes);
+  int nFiredPlanes = 0;
+  type_fitcount nChoice = 1;
+
+  for (int ipl = nTelPlanes - 1; ipl >= 0; ipl--) {
+    if (planeHits[ipl] > 0) {
+      nFiredPlanes++;
+      planeChoice[ipl] = planeHits[ipl] + 1;
+    } else {
+      planeChoice[ipl] = 1;
+    }
+    planeMod[ipl] = nChoice;
+    nChoice *= planeChoice[ipl];
+  }
+
+  if (nFiredPlanes + _allowMissingHits < _nActivePlanes) {
+    return chi2min;
+  }
+
+  // Start from one-hit track to allow for "smart" skipping of wrong matches
+
+  int istart = 0;
+  int nmiss = _allowMissingHits;
+
+  while (nmiss > 0 || !_isActive[istart]) {
+    if (_isActive[istart]) {
+      nmiss--;
+    }
+    istart++;
+  }
+
+  // Chi2 of the last fitted hit selection ending on each plane, with its
+  // number. Used as lower limit for the selections extending it.
+
+  std::vector<double> prefixChi2(nTelPlanes, 0.);
+  std::vector<type_fitcount> prefixChoice(nTelPlanes, -1);
+
+  std::vector<int> hits(nTelPlanes, -1);
+
+  for (type_fitcount ichoice = nChoice - planeMod[istart] - 1; ichoice >= 0;
+       ichoice--) {
+    int nChoiceFired = 0;
+    int ifirst = -1;
+    int ilast = 0;
+    int iprev = -1;
+    int nleft = 0;
+
+    // Decode the hit selection
+
+    for (int ipl = 0; ipl < nTelPlanes; ipl++) {
+      hits[ipl] = -1;
+
+      if (_isActive[ipl]) {
+        int ihit =
+            static_cast<int>((ichoice / planeMod[ipl]) % planeChoice[ipl]);
+
+        if (ihit < planeHits[ipl]) {
+          hits[ipl] = ihit;
+
+          if (ifirst >= 0) {
+            iprev = ilast;
+          }
+
+          if (ifirst < 0) {
+            ifirst = ipl;
+          }
+
+          ilast = ipl;
+          nleft = 0;
+          nChoiceFired++;
+        } else {
+          nleft++; // Counts number of planes with missing
+                   // hits after the last hit
+        }
+      }
+    }
+
+    // Skip this hit selection and all selections extending it on the
+    // following planes, if none of them can be accepted. The penalty is
+    // lowest with the fewest or with the most hits still possible.
+
+    if (nChoiceFired > 0) {
+      int nAddable = 0;
+      for (int ipl = ilast + 1; ipl < nTelPlanes; ipl++) {
+        if (_isActive[ipl] && planeHits[ipl] > 0) {
+          nAddable++;
+        }
+      }
+
+      if (nChoiceFired + nAddable + _allowSkipHits < nFiredPlanes) {
+        ichoice -= planeMod[ilast] - 1;
+        continue;
+      }
+
+      double minChi2 = 0.;
+      if (iprev >= 0) {
+        type_fitcount parent =
+            ichoice - ichoice % planeMod[iprev] + planeMod[iprev] - 1;
+        if (prefixChoice[iprev] == parent) {
+          minChi2 = prefixChi2[iprev];
+        }
+      }
+
+      double fewestPenalty =
+          (_nActivePlanes - nFiredPlanes) * _missingHitPenalty +
+          (nFiredPlanes - nChoiceFired) * _skipHitPenalty;
+      double mostPenalty =
+          (_nActivePlanes - nFiredPlanes) * _missingHitPenalty +
+          (nFiredPlanes - nChoiceFired - nAddable) * _skipHitPenalty;
+
+      if (minChi2 + std::min(fewestPenalty, mostPenalty) >= _chi2Max) {
+        ichoice -= planeMod[ilast] - 1;
+        continue;
+      }
+    }
+
+    // No fit to 1 hit :-)
+
+    if (nChoiceFired < 2) {
+      continue;
+    }
+
+    // Fit with 2 hits make sense only with beam constraint, or
+    // when 2 point fit is allowed
+
+    if (nChoiceFired == 2 && !_useBeamConstraint &&
+        nChoiceFired + _allowMissingHits < _nActivePlanes) {
+      continue;
+    }
+
+    // Skip also if the fit can not be extended to proper number
+    // of planes; no need to check remaining planes !!!
+
+    if (nChoiceFired + nleft < _nActivePlanes - _allowMissingHits) {
+      ichoice -= planeMod[ilast] - 1;
+      continue;
+    }
+
+    int firstFailed = fitter.preselect(hits);
+
+    if (firstFailed > 0) {
+      ichoice -= planeMod[firstFailed] - 1;
+      continue;
+    }
+
+    double choiceChi2 = fitter.fit(hits, nChoiceFired);
+
+    if (choiceChi2 < 0.) {
+      continue;
+    }
+
+    prefixChi2[ilast] = choiceChi2;
+    prefixChoice[ilast] = ichoice;
+
+    // Penalty for missing or skiped hits
+    double penalty = (_nActivePlanes - nFiredPlanes) * _missingHitPenalty +
+                     (nFiredPlanes - nChoiceFired) * _skipHitPenalty;
+
+    double trackChi2 = choiceChi2 + penalty;
+
+    if (nChoiceFired + _allowMissingHits >= _nActivePlanes &&
+        nChoiceFired + _allowSkipHits >= nFiredPlanes && trackChi2 < chi2min) {
+      chi2min = trackChi2;
+    }
+
+    // Check if better than chi2Max
+    // If not: skip also all track possibilities which include
+    // this hit selection !!!
+
+    if (choiceChi2 >= _chi2Max || choiceChi2 < _chi2Min) {
+      ichoice -= planeMod[ilast] - 1;
+      continue;
+    }
+
+    // Skip fit if could not be accepted (too few planes fired)
+
+    if (nChoiceFired + _allowMissingHits < _nActivePlanes ||
+        nChoiceFired + _allowSkipHits < nFiredPlanes) {
+      continue;
+    }
+
+    if (trackChi2 < _chi2Max && trackChi2 > _chi2Min) {
+      fitter.accept(hits, nChoiceFired, trackChi2, penalty);
+    }
+  }
+
+  return chi2min;
+}
@@ -0,0 +1,206 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelMilleTrackFinder.h"
+
+// system includes <>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace eutelescope;
+
+//! State of one findTracks call
+struct EUTelMilleTrackFinder::Search {
+  typedef std::pair<double, int> SortedHit;
+
+  Search(const EUTelMilleTrackFinder &finder,
+         const std::vector<std::vector<double>> &xPos,
+         const std::vector<std::vector<double>> &yPos,
+         std::vector<std::vector<int>> &candidates)
+      : finder(finder), xPos(xPos), yPos(yPos), candidates(candidates),
+        sortedX(xPos.size()), passing(xPos.size()), track(xPos.size(), -1),
+        lastPlane(xPos.size() - 1), limited(!xPos.back().empty()) {
+    for (size_t plane = 1; plane < xPos.size(); ++plane) {
+      sortedX[plane].reserve(xPos[plane].size());
+      for (size_t hit = 0; hit < xPos[plane].size(); ++hit) {
+        sortedX[plane].push_back(
+            SortedHit(xPos[plane][hit], static_cast<int>(hit)));
+      }
+      std::sort(sortedX[plane].begin(), sortedX[plane].end());
+    }
+  }
+
+  // only the hits of the last plane are limited, so nothing can be
+  // added any more once the limit is reached
+  bool full() const {
+    return limited && candidates.size() >= finder._maxCandidates;
+  }
+
+  // residual cut between hit prevHit of plane pair-1 and hit of plane
+  // pair+1, with the residuals of a missing previous hit as before
+  bool accept(size_t pair, int prevHit, int hit) const {
+    double residualX = -999999.;
+    double residualY = -999999.;
+    if (prevHit >= 0) {
+      residualX = std::abs(xPos[pair][prevHit] - xPos[pair + 1][hit]);
+      residualY = std::abs(yPos[pair][prevHit] - yPos[pair + 1][hit]);
+    }
+    return !(residualX < finder._residualsXMin[pair] ||
+             residualX > finder._residualsXMax[pair] ||
+             residualY < finder._residualsYMin[pair] ||
+             residualY > finder._residualsYMax[pair]);
+  }
+
+  // fills passing[plane] with the hits of plane accepted after the hit
+  // chosen on the previous plane, in index order
+  void findPassing(size_t plane) {
+    std::vector<int> &pass = passing[plane];
+    const int nHits = static_cast<int>(xPos[plane].size());
+    pass.clear();
+    if (plane == 0 || (track[plane - 1] < 0 && accept(plane - 1, -1, 0))) {
+      for (int hit = 0; hit < nHits; ++hit) {
+        pass.push_back(hit);
+      }
+      return;
+    }
+    const int prevHit = track[plane - 1];
+    if (prevHit < 0) {
+      return;
+    }
+
+    const double x = xPos[plane - 1][prevHit];
+    const double xMax = finder._residualsXMax[plane - 1];
+    std::vector<SortedHit>::const_iterator first = sortedX[plane].begin();
+    std::vector<SortedHit>::const_iterator last = sortedX[plane].end();
+    if (!std::isnan(xMax)) {
+      // |x - hit| is monotonic on both sides of x, so the hits with
+      // |x - hit| <= xMax are exactly a range of the sorted hits
+      first = std::partition_point(first, last, [&](const SortedHit &hit) {
+        return hit.first < x && x - hit.first > xMax;
+      });
+      last = std::partition_point(first, last, [&](const SortedHit &hit) {
+        return hit.first <= x || hit.first - x <= xMax;
+      });
+    }
+    for (; first != last; ++first) {
+      if (accept(plane - 1, prevHit, first->second)) {
+        pass.push_back(first->second);
+      }
+    }
+    std::sort(pass.begin(), pass.end());
+  }
+
+  void search(size_t plane, int hit, int missing) {
+    if (hit < 0) {
+      ++missing;
+    }
+    if (missing > finder._allowedMissingHits) {
+      return;
+    }
+    if (plane > 0) {
+      track[plane - 1] = hit;
+    }
+
+    const size_t nHits = xPos[plane].size();
+    if (plane == lastPlane) {
+      if (nHits == 0) {
+        candidates.push_back(
+            std::vector<int>(track.begin(), track.begin() + plane));
+      }
+      for (size_t lastHit = 0; lastHit < nHits && !full(); ++lastHit) {
+        track[plane] = static_cast<int>(lastHit);
+        candidates.push_back(
+            std::vector<int>(track.begin(), track.begin() + plane + 1));
+      }
+      return;
+    }
+    if (nHits == 0) {
+      search(plane + 1, -1, missing);
+      return;
+    }
+
+    // every hit failing the cut continues without hit: the gaps
+    // between the accepted hits
+    findPassing(plane);
+    const std::vector<int> &pass = passing[plane];
+    size_t next = 0;
+    for (size_t iPass = 0; iPass <= pass.size() && !full(); ++iPass) {
+      const size_t passHit = iPass < pass.size() ? pass[iPass] : nHits;
+      searchMissing(plane + 1, missing, passHit - next);
+      if (iPass < pass.size() && !full()) {
+        search(plane + 1, static_cast<int>(passHit), missing);
+      }
+      next = passHit + 1;
+    }
+  }
+
+  // count times the branch without hit on plane-1
+  void searchMissing(size_t plane, int missing, size_t count) {
+    if (count == 0 || missing >= finder._allowedMissingHits) {
+      return;
+    }
+    const size_t first = candidates.size();
+    search(plane, -1, missing);
+    const size_t last = candidates.size();
+    for (size_t copy = 1; copy < count && first < last; ++copy) {
+      for (size_t candidate = first; candidate < last; ++candidate) {
+        if (full()) {
+          return;
+        }
+        candidates.push_back(std::vector<int>());
+        candidates.back() = candidates[candidate];
+      }
+    }
+  }
+
+  const EUTelMilleTrackFinder &finder;
+  const std::vector<std::vector<double>> &xPos;
+  const std::vector<std::vector<double>> &yPos;
+  std::vector<std::vector<int>> &candidates;
+  std::vector<std::vector<SortedHit>> sortedX;
+  std::vector<std::vector<int>> passing;
+  std::vector<int> track;
+  const size_t lastPlane;
+  const bool limited;
+};
+
+EUTelMilleTrackFinder::EUTelMilleTrackFinder()
+    : _residualsXMin(), _residualsXMax(), _residualsYMin(), _residualsYMax(),
+      _allowedMissingHits(0), _maxCandidates(2000) {}
+
+void EUTelMilleTrackFinder::setResidualWindows(
+    const std::vector<double> &xMin, const std::vector<double> &xMax,
+    const std::vector<double> &yMin, const std::vector<double> &yMax) {
+  _residualsXMin = xMin;
+  _residualsXMax = xMax;
+  _residualsYMin = yMin;
+  _residualsYMax = yMax;
+}
+
+void EUTelMilleTrackFinder::setAllowedMissingHits(int allowedMissingHits) {
+  _allowedMissingHits = allowedMissingHits;
+}
+
+void EUTelMilleTrackFinder::setMaxCandidates(size_t maxCandidates) {
+  _maxCandidates = maxCandidates;
+}
+
+void EUTelMilleTrackFinder::findTracks(
+    const std::vector<std::vector<double>> &xPos,
+    const std::vector<std::vector<double>> &yPos,
+    std::vector<std::vector<int>> &candidates) const {
+  candidates.clear();
+  if (xPos.empty()) {
+    return;
+  }
+  Search search(*this, xPos, yPos, candidates);
+  search.search(0, 0, 0);
+}
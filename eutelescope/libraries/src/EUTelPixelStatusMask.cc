@@ -0,0 +1,146 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelPixelStatusMask.h"
+#include "EUTELESCOPE.h"
+
+// system includes <>
+#include <algorithm>
+#include <cstring>
+
+using namespace eutelescope;
+
+EUTelPixelBitmap::EUTelPixelBitmap() : _words(), _nPixels(0) {}
+
+void EUTelPixelBitmap::resize(size_t nPixels) {
+  // unset the bits past the last pixel, they must stay zero
+  if (nPixels < _nPixels && (nPixels & 63) != 0) {
+    _words[nPixels >> 6] &= (std::uint64_t(1) << (nPixels & 63)) - 1;
+  }
+  _words.resize((nPixels + 63) >> 6, 0);
+  _nPixels = nPixels;
+}
+
+void EUTelPixelBitmap::clear() {
+  if (!_words.empty()) {
+    std::memset(_words.data(), 0, _words.size() * sizeof(std::uint64_t));
+  }
+}
+
+size_t EUTelPixelBitmap::findNext(size_t from) const {
+  if (from >= _nPixels) {
+    return _nPixels;
+  }
+  size_t word = from >> 6;
+  std::uint64_t bits = _words[word] & (~std::uint64_t(0) << (from & 63));
+  while (bits == 0) {
+    if (++word == _words.size()) {
+      return _nPixels;
+    }
+    bits = _words[word];
+  }
+  return (word << 6) + static_cast<size_t>(__builtin_ctzll(bits));
+}
+
+size_t EUTelPixelBitmap::count() const {
+  size_t count = 0;
+  for (size_t word = 0; word < _words.size(); ++word) {
+    count += static_cast<size_t>(__builtin_popcountll(_words[word]));
+  }
+  return count;
+}
+
+EUTelPixelStatusMask::EUTelPixelStatusMask()
+    : _bad(), _hot(), _hit(), _missing(), _status(), _hasStatus(false) {}
+
+void EUTelPixelStatusMask::setStatus(const std::vector<short> &status) {
+  if (status.size() > size()) {
+    resize(status.size());
+  }
+  _bad.clear();
+  for (size_t index = 0; index < status.size(); ++index) {
+    const short value = status[index];
+    if (value != EUTELESCOPE::GOODPIXEL && value != EUTELESCOPE::HITPIXEL &&
+        value != EUTELESCOPE::MISSINGPIXEL) {
+      _bad.set(index);
+    }
+  }
+  clearEvent();
+  _status = status;
+  _hasStatus = true;
+}
+
+bool EUTelPixelStatusMask::hasStatus(const std::vector<short> &status) const {
+  return _hasStatus && status == _status;
+}
+
+void EUTelPixelStatusMask::clearStatus() {
+  _bad.clear();
+  clearEvent();
+  _status.clear();
+  _hasStatus = false;
+}
+
+void EUTelPixelStatusMask::resize(size_t nPixels) {
+  _bad.resize(nPixels);
+  _hot.resize(nPixels);
+  _hit.resize(nPixels);
+  _missing.resize(nPixels);
+}
+
+void EUTelPixelStatusMask::clearEvent() {
+  _hit.clear();
+  _missing.clear();
+}
+
+size_t EUTelPixelStatusMask::findGood(size_t from) const {
+  return findGood(from, nullptr, _bad.getWords().size());
+}
+
+size_t
+EUTelPixelStatusMask::findGood(size_t from,
+                               const EUTelPixelBitmap &candidates) const {
+  const std::vector<std::uint64_t> &words = candidates.getWords();
+  return findGood(from, words.data(),
+                  std::min(words.size(), _bad.getWords().size()));
+}
+
+size_t EUTelPixelStatusMask::findGood(size_t from,
+                                      const std::uint64_t *candidates,
+                                      size_t nCandidateWords) const {
+  const size_t nPixels = size();
+  if (from >= nPixels || (from >> 6) >= nCandidateWords) {
+    return nPixels;
+  }
+  const std::vector<std::uint64_t> &bad = _bad.getWords();
+  const std::vector<std::uint64_t> &hit = _hit.getWords();
+  const std::vector<std::uint64_t> &missing = _missing.getWords();
+
+  size_t word = from >> 6;
+  std::uint64_t good = ~(bad[word] | hit[word] | missing[word]) &
+                       (~std::uint64_t(0) << (from & 63));
+  if (candidates != nullptr) {
+    good &= candidates[word];
+  }
+  while (good == 0) {
+    if (++word == nCandidateWords) {
+      return nPixels;
+    }
+    good = ~(bad[word] | hit[word] | missing[word]);
+    if (candidates != nullptr) {
+      good &= candidates[word];
+    }
+  }
+  // the bits past the last pixel are zero in every bitmap, so they
+  // look good: stop at the end of the sensor
+  const size_t index =
+      (word << 6) + static_cast<size_t>(__builtin_ctzll(good));
+  return index < nPixels ? index : nPixels;
+}
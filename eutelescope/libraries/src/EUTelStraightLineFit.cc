@@ -0,0 +1,97 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelStraightLineFit.h"
+
+using namespace eutelescope;
+
+EUTelStraightLineFit::EUTelStraightLineFit()
+    : _zPos(), _projectionX(), _projectionY() {}
+
+void EUTelStraightLineFit::setPlanes(const std::vector<double> &zPos,
+                                     const std::vector<double> &resolX,
+                                     const std::vector<double> &resolY) {
+  _zPos = zPos;
+  _projectionX.set(zPos, resolX);
+  _projectionY.set(zPos, resolY);
+}
+
+void EUTelStraightLineFit::fitX(size_t nTracks, const double *xPos,
+                                double *xFit, double *slope,
+                                double *chi2) const {
+  _projectionX.fit(nTracks, xPos, xFit, slope, chi2);
+}
+
+void EUTelStraightLineFit::fitY(size_t nTracks, const double *yPos,
+                                double *yFit, double *slope,
+                                double *chi2) const {
+  _projectionY.fit(nTracks, yPos, yFit, slope, chi2);
+}
+
+void EUTelStraightLineFit::Projection::set(const std::vector<double> &zPos,
+                                           const std::vector<double> &resol) {
+  const size_t nPlanes = zPos.size();
+  weight.resize(nPlanes);
+  mean.resize(nPlanes);
+  slope.resize(nPlanes);
+  dz.resize(nPlanes);
+
+  double sumWeight = 0.0;
+  double sumZ = 0.0;
+  for (size_t iPlane = 0; iPlane < nPlanes; ++iPlane) {
+    weight[iPlane] = 1.0 / (resol[iPlane] * resol[iPlane]);
+    sumWeight += weight[iPlane];
+    sumZ += weight[iPlane] * zPos[iPlane];
+  }
+  const double zMean = sumZ / sumWeight;
+
+  double sumZZ = 0.0;
+  for (size_t iPlane = 0; iPlane < nPlanes; ++iPlane) {
+    dz[iPlane] = zPos[iPlane] - zMean;
+    sumZZ += weight[iPlane] * dz[iPlane] * dz[iPlane];
+  }
+
+  for (size_t iPlane = 0; iPlane < nPlanes; ++iPlane) {
+    mean[iPlane] = weight[iPlane] / sumWeight;
+    slope[iPlane] = weight[iPlane] * dz[iPlane] / sumZZ;
+  }
+}
+
+void EUTelStraightLineFit::Projection::fit(size_t nTracks, const double *pos,
+                                           double *fitPos, double *fitSlope,
+                                           double *chi2) const {
+  const size_t nPlanes = weight.size();
+
+  // the weighted mean position is accumulated in the fitted positions
+  // of the first plane, which are written last
+  double *meanPos = fitPos;
+  for (size_t iTrack = 0; iTrack < nTracks; ++iTrack) {
+    meanPos[iTrack] = 0.0;
+    fitSlope[iTrack] = 0.0;
+    chi2[iTrack] = 0.0;
+  }
+  for (size_t iPlane = 0; iPlane < nPlanes; ++iPlane) {
+    const double *planePos = pos + iPlane * nTracks;
+    for (size_t iTrack = 0; iTrack < nTracks; ++iTrack) {
+      meanPos[iTrack] += mean[iPlane] * planePos[iTrack];
+      fitSlope[iTrack] += slope[iPlane] * planePos[iTrack];
+    }
+  }
+
+  for (size_t iPlane = nPlanes; iPlane-- > 0;) {
+    const double *planePos = pos + iPlane * nTracks;
+    double *planeFit = fitPos + iPlane * nTracks;
+    for (size_t iTrack = 0; iTrack < nTracks; ++iTrack) {
+      planeFit[iTrack] = meanPos[iTrack] + dz[iPlane] * fitSlope[iTrack];
+      const double resid = planeFit[iTrack] - planePos[iTrack];
+      chi2[iTrack] += weight[iPlane] * resid * resid;
+    }
+  }
+}
@@ -0,0 +1,107 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelStripClusterer.h"
+
+using namespace eutelescope;
+
+EUTelStripClusterer::EUTelStripClusterer() : _nStrips(0), _words() {}
+
+void EUTelStripClusterer::reset(int nStrips) {
+  _nStrips = (nStrips > 0) ? nStrips : 0;
+  _words.assign((_nStrips + 63) / 64, 0);
+}
+
+void EUTelStripClusterer::setStrip(int strip) {
+  if (strip >= 0 && strip < _nStrips) {
+    _words[strip / 64] |= std::uint64_t(1) << (strip % 64);
+  }
+}
+
+void EUTelStripClusterer::setStrips(const float *values, int nStrips) {
+  reset(nStrips);
+
+  // full words have a fixed trip count so the compare and shift can be
+  // vectorised
+  const int fullWords = _nStrips / 64;
+  for (int iword = 0; iword < fullWords; iword++) {
+    const float *wordValues = values + iword * 64;
+    std::uint64_t word = 0;
+    for (int ibit = 0; ibit < 64; ibit++) {
+      word |= std::uint64_t(wordValues[ibit] > 0) << ibit;
+    }
+    _words[iword] = word;
+  }
+
+  // the rest of the strips
+  for (int strip = fullWords * 64; strip < _nStrips; strip++) {
+    if (values[strip] > 0) {
+      _words[fullWords] |= std::uint64_t(1) << (strip % 64);
+    }
+  }
+}
+
+int EUTelStripClusterer::getNumberOfHits() const {
+  int hits = 0;
+  for (size_t iword = 0; iword < _words.size(); iword++) {
+    hits += __builtin_popcountll(_words[iword]);
+  }
+  return hits;
+}
+
+void EUTelStripClusterer::findClusters(
+    int maxSize, std::vector<StripCluster> &clusters) const {
+  int runStart = 0;
+  const size_t nWords = _words.size();
+
+  for (size_t iword = 0; iword < nWords; iword++) {
+    const std::uint64_t word = _words[iword];
+    if (word == 0) {
+      continue;
+    }
+
+    // the neighbouring bits across the word boundaries
+    const std::uint64_t carryIn = (iword > 0) ? (_words[iword - 1] >> 63) : 0;
+    const std::uint64_t carryOut =
+        (iword + 1 < nWords) ? (_words[iword + 1] << 63) : 0;
+
+    // a run starts where the strip below is empty and ends where the strip
+    // above is empty
+    std::uint64_t starts = word & ~((word << 1) | carryIn);
+    std::uint64_t ends = word & ~((word >> 1) | carryOut);
+
+    const int base = static_cast<int>(iword * 64);
+    while ((starts | ends) != 0) {
+      const int startBit = (starts != 0) ? __builtin_ctzll(starts) : 64;
+      const int endBit = (ends != 0) ? __builtin_ctzll(ends) : 64;
+
+      // a single strip run starts and ends on the same bit, the start goes
+      // first
+      if (startBit <= endBit) {
+        runStart = base + startBit;
+        starts &= starts - 1;
+      } else {
+        addRun(runStart, base + endBit, maxSize, clusters);
+        ends &= ends - 1;
+      }
+    }
+  }
+}
+
+void EUTelStripClusterer::addRun(int first, int last, int maxSize,
+                                 std::vector<StripCluster> &clusters) {
+  const int step = (maxSize > 0) ? maxSize : (last - first + 1);
+  for (int strip = first; strip <= last; strip += step) {
+    StripCluster cluster;
+    cluster.first = strip;
+    cluster.size = (last - strip + 1 < step) ? (last - strip + 1) : step;
+    clusters.push_back(cluster);
+  }
+}
@@ -0,0 +1,147 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// eutelescope includes ".h"
+#include "EUTelThresholdCompaction.h"
+#include "EUTELESCOPE.h"
+
+// the AVX2 kernel is compiled for its own target and selected at run time,
+// so the library itself does not need to be built with -mavx2
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define EUTEL_THRESHOLD_COMPACTION_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace eutelescope;
+
+static size_t compactRange(const short *adcValues, const float *pedestalValues,
+                           const float *noiseValues, const short *statusValues,
+                           size_t first, size_t last, float sigmaCut,
+                           int *indices, float *signals) {
+  size_t count = 0;
+  for (size_t iPixel = first; iPixel < last; ++iPixel) {
+    if (statusValues[iPixel] == EUTELESCOPE::GOODPIXEL) {
+      float data = adcValues[iPixel] - pedestalValues[iPixel];
+      float threshold = sigmaCut * noiseValues[iPixel];
+      if (data > threshold) {
+        indices[count] = static_cast<int>(iPixel);
+        signals[count] = data;
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+#ifdef EUTEL_THRESHOLD_COMPACTION_AVX2
+
+//! Lane permutations moving the selected lanes of an 8 bit mask to the front
+struct CompactionPermutations {
+  int lanes[256][8];
+
+  CompactionPermutations() : lanes() {
+    for (int mask = 0; mask < 256; ++mask) {
+      int next = 0;
+      for (int lane = 0; lane < 8; ++lane) {
+        if (mask & (1 << lane)) {
+          lanes[mask][next++] = lane;
+        }
+      }
+      // the unused lanes are overwritten by the next store anyway
+      for (; next < 8; ++next) {
+        lanes[mask][next] = 0;
+      }
+    }
+  }
+};
+
+__attribute__((target("avx2"))) static size_t
+compactAVX2(const short *adcValues, const float *pedestalValues,
+            const float *noiseValues, const short *statusValues,
+            size_t noOfPixels, float sigmaCut, int *indices, float *signals) {
+  static const CompactionPermutations permutations;
+
+  const __m256 cut = _mm256_set1_ps(sigmaCut);
+  const __m128i good =
+      _mm_set1_epi16(static_cast<short>(EUTELESCOPE::GOODPIXEL));
+  const __m256i step = _mm256_set1_epi32(8);
+  __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  size_t count = 0;
+  size_t iPixel = 0;
+  for (; iPixel + 8 <= noOfPixels; iPixel += 8) {
+    // the adc values are exact in float, so the signal and the threshold
+    // are computed as in the scalar version
+    __m256 adc = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(adcValues + iPixel))));
+    __m256 data = _mm256_sub_ps(adc, _mm256_loadu_ps(pedestalValues + iPixel));
+    __m256 threshold =
+        _mm256_mul_ps(cut, _mm256_loadu_ps(noiseValues + iPixel));
+    __m256 above = _mm256_cmp_ps(data, threshold, _CMP_GT_OQ);
+
+    __m128i isGood16 = _mm_cmpeq_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(statusValues + iPixel)),
+        good);
+    __m256 isGood = _mm256_castsi256_ps(_mm256_cvtepi16_epi32(isGood16));
+
+    int mask = _mm256_movemask_ps(_mm256_and_ps(above, isGood));
+    if (mask != 0) {
+      // count <= iPixel, so the full 8 lane stores stay inside the buffers
+      __m256i lanes = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(permutations.lanes[mask]));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(indices + count),
+                          _mm256_permutevar8x32_epi32(index, lanes));
+      _mm256_storeu_ps(signals + count,
+                       _mm256_permutevar8x32_ps(data, lanes));
+      count += __builtin_popcount(mask);
+    }
+    index = _mm256_add_epi32(index, step);
+  }
+
+  return count + compactRange(adcValues, pedestalValues, noiseValues,
+                              statusValues, iPixel, noOfPixels, sigmaCut,
+                              indices + count, signals + count);
+}
+
+#endif
+
+size_t ThresholdCompaction::compact(const short *adcValues,
+                                    const float *pedestalValues,
+                                    const float *noiseValues,
+                                    const short *statusValues,
+                                    size_t noOfPixels, float sigmaCut,
+                                    int *indices, float *signals) {
+#ifdef EUTEL_THRESHOLD_COMPACTION_AVX2
+  if (hasAVX2()) {
+    return compactAVX2(adcValues, pedestalValues, noiseValues, statusValues,
+                       noOfPixels, sigmaCut, indices, signals);
+  }
+#endif
+  return compactScalar(adcValues, pedestalValues, noiseValues, statusValues,
+                       noOfPixels, sigmaCut, indices, signals);
+}
+
+size_t ThresholdCompaction::compactScalar(const short *adcValues,
+                                          const float *pedestalValues,
+                                          const float *noiseValues,
+                                          const short *statusValues,
+                                          size_t noOfPixels, float sigmaCut,
+                                          int *indices, float *signals) {
+  return compactRange(adcValues, pedestalValues, noiseValues, statusValues, 0,
+                      noOfPixels, sigmaCut, indices, signals);
+}
+
+bool ThresholdCompaction::hasAVX2() {
+#ifdef EUTEL_THRESHOLD_COMPACTION_AVX2
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+#else
+  return false;
+#endif
+}
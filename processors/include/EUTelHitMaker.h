@@ -28,11 +28,14 @@
 // AIDA includes <.h>
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 #include <AIDA/IBaseHistogram.h>
+#include <AIDA/IHistogram2D.h>
 #endif
 
 #include <IMPL/LCCollectionVec.h>
 
 // system includes <>
+#include <array>
+#include <cstddef>
 #include <map>
 #include <set>
 #include <string>
@@ -337,6 +340,42 @@ namespace eutelescope {
     std::map<int, AIDA::IBaseHistogram *> _hitLocalHistos;
     std::map<int, AIDA::IBaseHistogram *> _hitTelescopeHistos;
     #endif
+
+    //! Per-sensor hot-path context
+    /*! Everything the cluster loop needs to know about a sensor:
+     *  pitch, size, resolution, the local to global affine transform
+     *  and the histogram handles. It is resolved once per run and
+     *  sensor, so that the per-cluster path does neither query the
+     *  geometry maps nor go through the TGeo matrices.
+     */
+    struct SensorContext {
+      double xPitch;
+      double yPitch;
+      double xSize;
+      double ySize;
+      double xResolution;
+      double yResolution;
+      //! Global position of the local origin
+      std::array<double, 3> origin;
+      //! Global images of the local x and y unit vectors
+      std::array<double, 3> xAxis;
+      std::array<double, 3> yAxis;
+    #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+      AIDA::IHistogram2D *hitLocalHisto;
+      AIDA::IHistogram2D *hitTelescopeHisto;
+    #endif
+    };
+
+    //! Returns the context of a sensor, building it on first use in a run
+    SensorContext const &sensorContext(int sensorID);
+
+    //! Per-run sensor contexts, cleared at each run header
+    std::map<int, SensorContext> _sensorContextMap;
+
+    //! Per-event scratch buffers, reused to avoid reallocation
+    std::vector<int> _clusterSensorID;
+    std::vector<std::size_t> _clusterOrder;
+    std::vector<std::array<double, 3>> _clusterPosition;
   };
 
   //! A global instance of the processor
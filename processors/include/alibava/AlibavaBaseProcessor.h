@@ -25,10 +25,13 @@
 
 // ROOT includes <>
 #include "TObject.h"
+#include "TH1.h"
 
 // system includes <>
 #include <string>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace alibava
 {
@@ -46,6 +49,25 @@ namespace alibava
 	    // checks if the root object exists in _rootObjectMap
 	    bool doesRootObjectExists ( std::string aHistoName );
 
+	    // Histogram handle registry
+	    // Histograms filled in the event loop are additionally registered under a dense index made of
+	    // (kind, chip, channel), where kind is an enum of the derived processor. The hot loops then fill
+	    // them through a raw pointer instead of formatting a name and searching _rootObjectMap.
+
+	    // clears the registry and makes room for noOfKinds histogram kinds, to be called before booking
+	    void resetHistoHandles ( int noOfKinds );
+
+	    // inserts the histogram in _rootObjectMap and registers it under (kind, chip, channel).
+	    // As for _rootObjectMap, an earlier histogram with the same name is kept and registered instead.
+	    TH1 * registerHistoHandle ( std::string aHistoName, TH1 * histo, int kind, int chipnum = 0, int ichan = 0 );
+
+	    // returns the histogram registered under (kind, chip, channel) or a nullptr.
+	    // T has to be the type the histogram was booked with.
+	    template < class T > T * getHistoHandle ( int kind, int chipnum = 0, int ichan = 0 ) const
+	    {
+		return static_cast < T * > ( _histoHandles[ ( kind * ALIBAVA::NOOFCHIPS + chipnum ) * ALIBAVA::NOOFCHANNELS + ichan ] );
+	    }
+
 	    // Input/Output Collection
 	    // getter and setter for _inputCollectionName
 	    void setInputCollectionName ( std::string inputCollectionName );
@@ -209,6 +231,9 @@ namespace alibava
 
 	    bool _isCalibrationValid;
 
+	    // the histogram handles, index ( kind * NOOFCHIPS + chip ) * NOOFCHANNELS + channel
+	    std::vector < TH1 * > _histoHandles;
+
     };
 
     //! A global instance of the processor
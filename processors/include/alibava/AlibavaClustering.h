@@ -32,6 +32,7 @@
 // system includes <>
 #include <string>
 #include <list>
+#include <cstdint>
 
 using namespace std;
 
@@ -140,8 +141,58 @@ namespace alibava
 
 	    void fillclusterspereventhisto ( int a, int b );
 
+	    // copies noise and mask of the selected chips into the flat per-chip arrays below
+	    void cacheChannelInfo ( );
+
+	    // number of padding channels on each side of the flat data arrays in findSeedClusters
+	    static const int CHANNELPADDING = 3;
+
+	    // number of 64 bit words in a channel bit mask of one chip
+	    static const int CHANNELWORDS = ( ALIBAVA::NOOFCHANNELS + 63 ) / 64;
+
+	    // the noise of each channel
+	    float _channelNoise[ALIBAVA::NOOFCHIPS][ALIBAVA::NOOFCHANNELS];
+
+	    // bit mask of the unmasked channels, bit i is channel i
+	    uint64_t _usedChannels[ALIBAVA::NOOFCHIPS][CHANNELWORDS];
+
+	    // true if channel ichan is set in the bit mask, false for channels outside the chip
+	    static bool isChannelSet ( const uint64_t * bits, int ichan );
+
+	    // the first channel >= ichan set in the bit mask, nchan if there is none below nchan
+	    static int nextChannel ( const uint64_t * bits, int ichan, int nchan );
+
+	    // the number of consecutive channels set in the bit mask starting at ichan and going down
+	    static int runLengthDown ( const uint64_t * bits, int ichan );
+
 	protected:
 
+	    // Histogram kinds in the handle registry of AlibavaBaseProcessor
+	    enum ClusteringHistoKind
+	    {
+		kClustersVsEventsHisto,
+		kClusterSizeHisto,
+		kClusterCOGEtaHisto,
+		kClusterHitmapHisto,
+		kSeedHitmapHisto,
+		kEtaIntegralHisto,
+		kEtaHisto,
+		kNeighbourChargeHisto,
+		kClusterSignalHisto,
+		kClusterSNRHisto,
+		kSeedSignalHisto,
+		kRelativeCoGHisto,
+		kEtaTDCHisto,
+		kEtaPosHisto,
+		kSignalLeft2Histo,
+		kSignalLeft1Histo,
+		kSignalRight1Histo,
+		kSignalRight2Histo,
+		kZetaHisto,
+		kSigmaHisto,
+		kNoOfHistoKinds
+	    };
+
 	    IMPL::LCRunHeaderImpl* _runHeader;
 
     };
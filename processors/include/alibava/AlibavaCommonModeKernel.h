@@ -0,0 +1,75 @@
+/*
+ *  Common mode kernel for the Alibava chips
+ *
+ *  Works on one contiguous block of ALIBAVA::NOOFCHANNELS channels with a
+ *  precomputed channel mask, so that the inner loops are free of function
+ *  calls and branches and can be vectorised by the compiler.
+ */
+
+#ifndef ALIBAVACOMMONMODEKERNEL_H
+#define ALIBAVACOMMONMODEKERNEL_H 1
+
+// alibava includes ".h"
+#include "ALIBAVA.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+
+namespace alibava
+{
+
+    class AlibavaCommonModeKernel
+    {
+	public:
+	    AlibavaCommonModeKernel ( );
+
+	    // marks all channels of all chips as used
+	    void clearMask ( );
+
+	    // sets the mask of one channel
+	    void setMasked ( int chipnum, int ichan, bool masked );
+
+	    // Iterative common mode calculation on one chip: the first iteration uses all unmasked channels,
+	    // the following ones only channels within noiseDeviation sigma of the previous mean.
+	    // Afterwards getMean, getSigma, getOffset and getSlope return the result.
+	    void calculate ( int chipnum, const lcio::FloatVec & datavec, int noOfIterations, float noiseDeviation );
+
+	    // mean and standard deviation of the accepted channels in the last iteration
+	    double getMean ( ) const { return _mean; }
+	    double getSigma ( ) const { return _sigma; }
+
+	    // linear common mode a + b * channel fitted to the accepted channels in the last iteration
+	    double getOffset ( ) const { return _offset; }
+	    double getSlope ( ) const { return _slope; }
+
+	    // writes the common mode of the last calculation for all channels, either constant or slope
+	    void fillCommonMode ( bool useSlope, lcio::FloatVec & commonmodeVec ) const;
+
+	    // out = data - commonmode for unmasked channels, 0 for masked channels.
+	    // out is resized to the size of datavec.
+	    void subtract ( int chipnum, const lcio::FloatVec & datavec, const lcio::FloatVec & commonmodeVec, lcio::FloatVec & out ) const;
+
+	private:
+
+	    // number of partial sums used in the reductions
+	    static const int NOOFLANES = 4;
+
+	    // 1 for used channels, 0 for masked ones (or channels beyond the data)
+	    double _weight[ALIBAVA::NOOFCHIPS][ALIBAVA::NOOFCHANNELS];
+
+	    // channel number and its square as double, precomputed for the slope fit
+	    double _channel[ALIBAVA::NOOFCHANNELS];
+	    double _channelSquare[ALIBAVA::NOOFCHANNELS];
+
+	    // the data of the chip currently processed
+	    double _data[ALIBAVA::NOOFCHANNELS];
+
+	    double _mean;
+	    double _sigma;
+	    double _offset;
+	    double _slope;
+    };
+
+}
+
+#endif
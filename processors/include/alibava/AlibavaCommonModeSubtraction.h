@@ -10,6 +10,7 @@
 
 // alibava includes ".h"
 #include "AlibavaBaseProcessor.h"
+#include "AlibavaCommonModeKernel.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -57,12 +58,23 @@ namespace alibava
 
 	    protected:
 
+		// Histogram kinds in the handle registry of AlibavaBaseProcessor
+		enum CommonModeSubtractionHistoKind
+		{
+		    kChanDataHisto,
+		    kSignalHisto,
+		    kNoOfHistoKinds
+		};
+
 		std::string _chanDataHistoName;
 
 		std::string getChanDataHistoName ( int chipnum, int ichan );
 
 		std::string getSignalCorrectionName ( );
 
+		// holds the channel masks and does the subtraction
+		AlibavaCommonModeKernel _commonModeKernel;
+
 	};
 
 	//! A global instance of the processor
@@ -12,6 +12,7 @@
 
 // alibava includes ".h"
 #include "AlibavaBaseProcessor.h"
+#include "AlibavaCommonModeKernel.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -80,6 +81,14 @@ namespace alibava
 
 	protected:
 
+	    // Histogram kinds in the handle registry of AlibavaBaseProcessor
+	    enum ConstantCommonModeHistoKind
+	    {
+		kCorrectionHisto,
+		kCorrectionEventHisto,
+		kNoOfHistoKinds
+	    };
+
 	    std::string _commonmodeHistoName;
 
 	    std::string _commonmodeerrorHistoName;
@@ -92,6 +101,9 @@ namespace alibava
 
 	    EVENT::FloatVec _commonmodeerror;
 
+	    // clipped mean / slope calculation on one chip, holds the channel masks
+	    AlibavaCommonModeKernel _commonModeKernel;
+
     };
 
     AlibavaConstantCommonModeProcessor gAlibavaConstantCommonModeProcessor;
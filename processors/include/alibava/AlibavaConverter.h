@@ -20,6 +20,9 @@
 // lcio includes <.h>
 
 // system includes <>
+#include <cstddef>
+#include <cstring>
+#include <istream>
 #include <string>
 #include <vector>
 #include <ctime>
@@ -85,6 +88,32 @@ namespace alibava
 	    // To check if the chip selection is valid
 	    void checkIfChipSelectionIsValid();
 
+	    // Makes sure that at least nbytes unread bytes are available in the read buffer,
+	    // refilling it from the input stream in large blocks. Returns false if the
+	    // stream ends before that many bytes could be buffered.
+	    bool ensureBuffered ( std::istream & infile, std::size_t nbytes );
+
+	    // Copies the next sizeof ( T ) bytes of the read buffer into a T
+	    template < typename T > T takeFromBuffer ( )
+	    {
+		T value;
+		std::memcpy ( &value, _readBuffer.data ( ) + _bufferPos, sizeof ( T ) );
+		_bufferPos += sizeof ( T );
+		return value;
+	    }
+
+	    // Size of the blocks read from the input file
+	    static const std::size_t READBLOCKSIZE = 4 * 1024 * 1024;
+
+	    // The read buffer, and the positions of the first unread and one past the last valid byte
+	    std::vector < char > _readBuffer;
+	    std::size_t _bufferPos;
+	    std::size_t _bufferEnd;
+
+	    // Chip headers and channel data of the current event, as stored in the file:
+	    // for each chip first the header and then the channels
+	    std::vector < short > _eventBlock;
+
     };
 
     // A global instance of the processor
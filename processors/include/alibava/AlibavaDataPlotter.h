@@ -73,6 +73,24 @@ namespace alibava
 
 	protected:
 
+	    // Histogram kinds in the handle registry of AlibavaBaseProcessor
+	    enum DataPlotterHistoKind
+	    {
+		kTDCTimeHisto,
+		kTDCTimeEventsHisto,
+		kTemperatureHisto,
+		kTemperatureEventsHisto,
+		kCalChargeHisto,
+		kDelayHisto,
+		kSignalHisto,
+		kSignalTDCHisto,
+		kSignalTempHisto,
+		kSNRHisto,
+		kSNRTDCHisto,
+		kSNRTempHisto,
+		kNoOfHistoKinds
+	    };
+
 	};
 
 	//! A global instance of the processor
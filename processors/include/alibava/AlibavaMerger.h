@@ -10,6 +10,7 @@
 
 // alibava includes ".h"
 #include "AlibavaBaseProcessor.h"
+#include "AlibavaTelescopeReader.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -20,10 +21,12 @@
 
 // ROOT includes <>
 #include "TObject.h"
+#include "TH2D.h"
 
 // system includes <>
 #include <string>
 #include <list>
+#include <vector>
 
 namespace alibava
 {
@@ -85,17 +88,39 @@ namespace alibava
 	    //! Move telescope sensor id?
 	    int _teleplaneshift;
 
-	    //! The reading instance
-	    LCReader* lcReader;
+	    //! The indexed telescope file
+	    AlibavaTelescopeReader _telescopeReader;
 
-	    //! The flag if the file is open
-	    bool _telescopeopen;
+	    //! The position of the next telescope event in the file
+	    size_t _telescopePosition;
 
-	    //! The reading function
-	    LCEvent *readTelescope ( );
+	    //! Match the systems by event number instead of by position?
+	    bool _matchEventNumbers;
+
+	    //! How many telescope events are read ahead
+	    int _telescopeReadAhead;
+
+	    //! Telescope event number minus alibava event number when matching by number
+	    int _eventNumberOffset;
+
+	    //! The reading function, returns the telescope event for this alibava event
+	    LCEvent *readTelescope ( int alibavaEventNumber );
 
 	    void addCorrelation ( float ali_x, float ali_y, float ali_z, float tele_x, float tele_y, float tele_z, int event );
 
+	    //! Fills the hit correlation histogram from the per event buffers
+	    void fillHitCorrelation ( TH2D * histo );
+
+	    //! Centre of gravity of a generic sparse cluster
+	    static void getCenterOfGravity ( const lcio::FloatVec & charges, float & xCoG, float & yCoG );
+
+	    //! The window for the hit correlation
+	    double _correlationWindow;
+
+	    //! The hit coordinates of the current event
+	    std::vector < double > _aliCorrelation;
+	    std::vector < double > _teleCorrelation;
+
 	    //! The unsensitive axis of our strip sensor
 	    std::string _nonsensitiveaxis;
 
@@ -19,13 +19,19 @@
 #include <UTIL/LCTOOLS.h>
 #include <IMPL/LCRunHeaderImpl.h>
 #include <IMPL/LCCollectionVec.h>
+#include <IMPL/LCEventImpl.h>
 
 // system includes <>
 #include <string>
+#include <map>
 
 namespace alibava
 {
 
+    // Reads and writes the pedestal, noise and calibration files.
+    // All instances share one process-wide store: a file is read once, its per-chip vectors are kept in memory
+    // and served to every processor asking for them. addToFile only changes the store, the file is rewritten
+    // once per flush ( ).
     class AlibavaPedNoiCalIOManager
     {
 	public:
@@ -38,8 +44,34 @@ namespace alibava
 
 	    lcio::FloatVec getPedNoiCalForChip ( std::string filename, std::string collectionName, unsigned int chipnum );
 
+	    // writes all files changed by addToFile since the last flush
+	    void flush ( );
+
 	private:
 
+	    // a file in the store
+	    struct CalibrationFile
+	    {
+		// the run header and the event of the file, owned by the reader that read them
+		lcio::LCRunHeaderImpl* runHeader;
+		lcio::LCEventImpl* event;
+
+		// true if the event has been changed since the file was written
+		bool modified;
+
+		// the data vectors, decoded per collection on first access: collection name -> chip number -> data
+		std::map < std::string, std::map < int, lcio::FloatVec > > chipData;
+	    };
+
+	    // the process-wide store: file name -> file
+	    static std::map < std::string, CalibrationFile > _calibrationFiles;
+
+	    // returns the file from the store, reading it with a single open on first access
+	    CalibrationFile & getCalibrationFile ( std::string filename );
+
+	    // writes run header and event of a stored file
+	    void writeFile ( std::string filename, CalibrationFile & calFile );
+
 	    // gets data vector from an event
 	    lcio::FloatVec getDataFromEventForChip ( lcio::LCEvent* evt, std::string collectionName, unsigned int chipnum );
 
@@ -56,12 +88,6 @@ namespace alibava
 	    // to create a file with an empty runheader
 	    void createFile ( std::string filename );
 
-	    // returns a copy of runHeader of existing AlibavaPedNoiCalFile
-	    lcio::LCRunHeaderImpl* getRunHeader ( std::string filename );
-
-	    // returns a copy of lcevent of existing AlibavaPedNoiCalFile
-	    lcio::LCEventImpl* getEvent ( std::string filename );
-
     };
 }
 
@@ -24,8 +24,10 @@
 #include "TObject.h"
 
 // system includes <>
+#include <cstddef>
 #include <string>
 #include <list>
+#include <vector>
 
 namespace alibava
 {
@@ -53,10 +55,23 @@ namespace alibava
 
 	    void fillHistos ( TrackerDataImpl * trkdata );
 
+	    //! Adds the channel data of a chip to the streaming pedestal and noise estimator
+	    void accumulate ( TrackerDataImpl * trkdata );
+
 	    virtual void end ( );
 
 	protected:
 
+	    // Histogram kinds in the handle registry of AlibavaBaseProcessor
+	    enum PedestalNoiseHistoKind
+	    {
+		kChanDataHisto,
+		kPedestalHisto,
+		kNoiseHisto,
+		kTemperatureHisto,
+		kNoOfHistoKinds
+	    };
+
 	    // Name of the Pedestal histogram 
 	    std::string _pedestalHistoName;
 	    // Name of the Noise histogram 
@@ -86,6 +101,43 @@ namespace alibava
 	    //! Calculates and saves pedestal and noise values
 	    void calculatePedestalNoise ( );
 
+	    //! Switch to fill the per-channel ADC histograms
+	    bool _fillChannelHistos;
+
+	    //! Switch to determine pedestal and noise with a Gaussian fit to the per-channel histograms
+	    bool _gaussianFit;
+
+	    //! Samples further than _clippingSigma times the noise from the pedestal are not used, zero disables the clipping
+	    float _clippingSigma;
+
+	    //! Number of samples per channel kept to seed the sigma clipping
+	    int _reservoirSize;
+
+	    //! Number of sigma clipping iterations on the reservoir
+	    int _clippingIterations;
+
+	    //! Streaming estimator state, one entry per chip and channel ( index: ichip * NOOFCHANNELS + ichan )
+	    /*! Mean and the sum of squared deviations are updated with Welford's algorithm,
+	     *  samples outside [ _clipLow, _clipHigh ] are ignored.
+	     */
+	    std::vector < double > _sampleCount;
+	    std::vector < double > _sampleMean;
+	    std::vector < double > _sampleM2;
+	    std::vector < double > _clipLow;
+	    std::vector < double > _clipHigh;
+
+	    //! First _reservoirSize samples of each channel ( index: ( ichip * NOOFCHANNELS + ichan ) * _reservoirSize + isample )
+	    std::vector < float > _reservoir;
+
+	    //! Number of samples in the reservoir of each chip
+	    std::vector < int > _reservoirFill;
+
+	    //! Adds one sample to the Welford accumulator of a channel, if inside the clipping window
+	    void addSample ( std::size_t index, double value );
+
+	    //! Determines the clipping window of every channel of a chip from its reservoir and replays the reservoir into the accumulators
+	    void seedClipping ( int ichip );
+
     };
 
     //! A global instance of the processor
@@ -0,0 +1,156 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+#ifndef ALIBAVATELESCOPEREADER_H
+#define ALIBAVATELESCOPEREADER_H 1
+
+// lcio includes <.h>
+#include <lcio.h>
+#include <IO/LCReader.h>
+#include <EVENT/LCEvent.h>
+
+// the multi-threading reader hands out owned events, only then we can read ahead
+#if defined(LCIO_VERSION_GE)
+#if LCIO_VERSION_GE( 2, 13 )
+#define ALIBAVA_TELESCOPE_READAHEAD 1
+#endif
+#endif
+
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+#include <MT/LCReader.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#endif
+
+// system includes <>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace alibava
+{
+
+    // Random access to the events of a telescope file.
+    // An event at a position is always that very record of the file: the file is read sequentially, skipped forward
+    // and reopened to go back, so any event number sequence is read as it was written. On request the file is read
+    // once on open to index its (run, event) numbers in file order, so events can also be fetched by their event
+    // number. The LCIO random access records can not be used for this, they are sorted by (run, event) and hold a
+    // repeated number only once. With the index the (run, event) lookup of LCIO is used to jump back to a record whose
+    // (run, event) is unique in the file. If the LCIO version provides the multi-threading reader, a background thread
+    // reads the next events ahead of the position requested last.
+    // The event returned is owned by the reader and valid until the next call.
+    class AlibavaTelescopeReader
+    {
+	public:
+	    AlibavaTelescopeReader ( );
+	    ~AlibavaTelescopeReader ( );
+
+	    // opens the file, readAhead is the number of events kept in flight, indexEventNumbers reads the event number
+	    // index needed by getEventByNumber. Returns false on failure
+	    bool open ( std::string filename, unsigned int readAhead, bool indexEventNumbers );
+
+	    // stops the read ahead and closes the file
+	    void close ( );
+
+	    bool isOpen ( ) const;
+
+	    // the event at a position in the file, nullptr past the end of the file
+	    lcio::LCEvent * getEventAt ( size_t position );
+
+	    // the event with this event number, nullptr if the file has no such event or was opened without index
+	    lcio::LCEvent * getEventByNumber ( int eventNumber );
+
+	    // the number of repeated event numbers in the index
+	    int getNumberOfDuplicates ( ) const;
+
+	private:
+
+	    AlibavaTelescopeReader ( const AlibavaTelescopeReader & );
+	    AlibavaTelescopeReader & operator= ( const AlibavaTelescopeReader & );
+
+	    // (run, event) of every event in the file, in file order, empty without event number index
+	    std::vector < std::pair < int, int > > _index;
+
+	    // event number -> position in the index, the first occurence wins
+	    std::map < int, size_t > _positionOfEvent;
+
+	    // true if the (run, event) of this position is found only once in the file
+	    std::vector < bool > _uniqueInFile;
+
+	    std::string _filename;
+
+	    // the position the next sequential read of the reader returns, npos if unknown
+	    size_t _readPosition;
+
+	    // the number of events in the file, npos until the end of the file was read
+	    size_t _endPosition;
+
+	    static const size_t npos;
+
+	    int _duplicates;
+
+	    bool _open;
+
+	    // reads the (run, event) of every event in file order and rewinds the file
+	    void buildIndex ( );
+
+	    // prepares the reader for reading the event at a position: returns true if the next sequential read
+	    // returns it, false if it has to be read by its (run, event), which is then unique in the file
+	    bool seekSequential ( size_t position );
+
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+
+	    // reads the event at a position, called with _readerMutex held. endOfFile is set if the file has no such event
+	    std::unique_ptr < lcio::LCEvent > readAt ( size_t position, bool & endOfFile );
+
+	    // the loop of the read ahead thread
+	    void readAheadLoop ( );
+
+	    std::unique_ptr < MT::LCReader > _reader;
+
+	    // the events read ahead, _queue.front ( ) is at position _queueStart
+	    std::deque < std::unique_ptr < lcio::LCEvent > > _queue;
+	    size_t _queueStart;
+
+	    // the next position the thread will read
+	    size_t _nextToRead;
+
+	    // bumped whenever the queue is dropped, so a read in flight is not queued at the wrong position
+	    unsigned int _generation;
+
+	    size_t _readAhead;
+
+	    bool _stop;
+
+	    // the event handed out last
+	    std::unique_ptr < lcio::LCEvent > _current;
+
+	    std::thread _thread;
+	    std::mutex _mutex;
+	    std::mutex _readerMutex;
+	    std::condition_variable _condition;
+
+#else
+
+	    // reads the event at a position, the event is owned by the reader. endOfFile is set if the file has no such event
+	    lcio::LCEvent * readAt ( size_t position, bool & endOfFile );
+
+	    // the event is owned by the reader
+	    lcio::LCReader * _reader;
+
+#endif
+
+    };
+}
+
+#endif
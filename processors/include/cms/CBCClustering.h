@@ -11,8 +11,12 @@
 // marlin includes ".h"
 #include "marlin/Processor.h"
 
+// eutelescope includes ".h"
+#include "EUTelStripClusterer.h"
+
 // system includes <>
 #include <string>
+#include <vector>
 
 namespace eutelescope
 {
@@ -68,6 +72,12 @@ namespace eutelescope
 
 	    std::map < std::string, AIDA::IBaseHistogram * > _aidaHistoMap;
 
+	    //! The bit word clustering engine, reused for every sensor
+	    EUTelStripClusterer _stripClusterer;
+
+	    //! The clusters of the current sensor
+	    std::vector < EUTelStripClusterer::StripCluster > _stripClusters;
+
     };
 
     //! A global instance of the processor
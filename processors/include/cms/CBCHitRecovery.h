@@ -11,13 +11,23 @@
 // marlin includes ".h"
 #include "marlin/Processor.h"
 
+// aida includes <.h>
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+#include <AIDA/IBaseHistogram.h>
+#include <AIDA/IHistogram1D.h>
+#endif
+
 // gear includes <.h>
 #include <gear/SiPlanesParameters.h>
 #include <gear/SiPlanesLayerLayout.h>
 
+// eigen includes <>
+#include <Eigen/Core>
+
 // system includes <>
 #include <string>
 #include <map>
+#include <vector>
 
 namespace eutelescope
 {
@@ -49,10 +59,24 @@ namespace eutelescope
 
             void fillHistos();
 
-            void vector_set_length(double *& vec, double length);
-            double vector_get_length(const double *vec);
-            double cos_alpha(const double *vec1,const double *vec2);
-            double* hit_pos(const double track[],const double normal[],const double virtual_hit[], double distance);
+            //! A dut hit and its x position, the hits are searched sorted by x
+            struct SortedHit
+            {
+                double x;
+                int index;
+            };
+
+            //! Intersects all tracks with a plane at distance along the normal from their virtual hits
+            /*! The tracks are given by their direction from the virtual hit,
+             *  impacts is resized to the number of tracks and reused.
+             */
+            static void intersectTracks ( const std::vector < Eigen::Vector3d > & directions, const std::vector < Eigen::Vector3d > & virtualHits, const Eigen::Vector3d & normal, double distance, std::vector < Eigen::Vector3d > & impacts );
+
+            //! Fills the residuals of all hits and returns the closest one, -1 if there is none within the window around x
+            int recoverHit ( const std::vector < SortedHit > & hits, double x, AIDA::IHistogram1D * residualHisto ) const;
+
+            //! The window in x around the track impact in which the dut hits are recovered [mm]
+            double _recoveryWindow;
 
             virtual void end();
 
@@ -68,21 +92,32 @@ namespace eutelescope
 
             std::vector<int> _cbcRealDUTsVec;
 
-            double *_VirtualDutNormal_zplus;
-            double *_VirtualDutNormal_zminus;
-            double *_VirtualDutPos;
+            Eigen::Vector3d _VirtualDutNormal_zplus;
+            Eigen::Vector3d _VirtualDutNormal_zminus;
+            Eigen::Vector3d _VirtualDutPos;
 
             gear::SiPlanesParameters * _siPlanesParameters;
             gear::SiPlanesLayerLayout * _siPlanesLayerLayout;
 
             // map of the vectors
-            std::map < int, double* > _dutPosMap;
-            std::map < int, double* > _dutNormalMap;
+            std::map < int, Eigen::Vector3d > _dutPosMap;
+            std::map < int, Eigen::Vector3d > _dutNormalMap;
 
         protected:
 
             std::map < std::string, AIDA::IBaseHistogram * > _aidaHistoMap;
 
+            // per event buffers, kept to avoid allocating in every event
+            std::vector < Eigen::Vector3d > _trackVirtualHits;
+            std::vector < Eigen::Vector3d > _trackUpstream;
+            std::vector < Eigen::Vector3d > _trackDownstream;
+            std::vector < Eigen::Vector3d > _impactsDut0;
+            std::vector < Eigen::Vector3d > _impactsDut1;
+            std::vector < SortedHit > _virtualHits;
+            std::vector < SortedHit > _dut0Hits;
+            std::vector < SortedHit > _dut1Hits;
+            std::vector < bool > _hitRecovered;
+
     };
 
     //! A global instance of the processor
@@ -12,8 +12,12 @@
 #include "marlin/Processor.h"
 #include "marlin/DataSourceProcessor.h"
 
+// lcio includes <.h>
+#include <lcio.h>
+
 // system includes <>
 #include <string>
+#include <vector>
 
 namespace eutelescope
 {
@@ -35,22 +39,14 @@ namespace eutelescope
 
 	    bool _telescopeopen;
 
-	    LCEvent* _storeevt;
-
 	    std::string _telescopeFile;
 
-	    long _frametime;
-
 	    long _bunchtime;
 
 	    int _evtcount;
 
-	    bool _usestorageevent;
-
 	    int _singleframetime;
 
-	    int _maxevents;
-
 	    std::string _inputCollectionName;
 
 	    std::string _outputCollectionName;
@@ -61,6 +57,49 @@ namespace eutelescope
 
 	protected:
 
+	    //! A telescope frame, decoded into one charge vector per output sensor
+	    struct BufferedFrame
+	    {
+		long time;
+		std::vector < lcio::FloatVec > sensorData;
+
+		BufferedFrame ( ) : time ( 0 ), sensorData ( ) { }
+	    };
+
+	    //! Reads frames into the ring, in time order
+	    void fillFrameRing ( );
+
+	    //! Copies a frame into a ring slot
+	    void decodeFrame ( LCEvent * evt, BufferedFrame & frame );
+
+	    //! The ring of decoded frames, _ringCount frames starting at _ringFirst
+	    std::vector < BufferedFrame > _frameRing;
+
+	    size_t _ringFirst;
+
+	    size_t _ringCount;
+
+	    //! The size of the ring
+	    int _frameBufferSize;
+
+	    //! True once the telescope file has no more frames
+	    bool _telescopeDone;
+
+	    //! Returns the index in _sensorIDs of a sensor of the input, -1 if it is not written
+	    int sensorSlot ( int sensorID );
+
+	    //! The sensors we write, in the order they first appear in the input
+	    std::vector < int > _sensorIDs;
+
+	    //! sensorID -> index in _sensorIDs, -1 if not written
+	    std::vector < int > _sensorSlot;
+
+	    //! The indices in _sensorIDs by increasing sensorID, the order of the output
+	    std::vector < size_t > _outputOrder;
+
+	    //! The sensors of the geometry, only these are written. Empty without geometry
+	    std::vector < int > _geometrySensorIDs;
+
     };
 
     //! A global instance of the processor
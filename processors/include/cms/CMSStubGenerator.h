@@ -17,6 +17,7 @@
 // lcio includes <.h>
 #include <EVENT/LCRunHeader.h>
 #include <EVENT/LCEvent.h>
+#include <IMPL/LCCollectionVec.h>
 
 // system includes <>
 #include <string>
@@ -78,6 +79,27 @@ namespace eutelescope
 
 	    TrackerHitImpl* cloneHit ( TrackerHitImpl *inputHit );
 
+	    //! A DUT hit reduced to what the stub matching needs
+	    struct StubCandidate
+	    {
+		float x;
+		float y;
+		float q;
+		//! The hit position in the input collection
+		int index;
+	    };
+
+	    //! Centre of gravity and charge of a DUT hit
+	    static StubCandidate makeCandidate ( IMPL::LCCollectionVec * hitCollection, int index );
+
+	    //! The DUT hits of the current event
+	    std::vector < StubCandidate > _candidatesPlane1;
+
+	    std::vector < StubCandidate > _candidatesPlane2;
+
+	    //! Fill the all pairs plots?
+	    bool _fillPairHistos;
+
 	private:
 
     };
@@ -11,10 +11,14 @@
 // marlin includes ".h"
 #include "marlin/DataSourceProcessor.h"
 
+// lcio includes <.h>
+#include <lcio.h>
+
 // system includes <>
 #include <string>
 #include <vector>
 #include <ctime>
+#include <cstdint>
 
 namespace eutelescope
 {
@@ -35,6 +39,9 @@ namespace eutelescope
 
 	    virtual unsigned createMask ( unsigned a, unsigned b );
 
+	    // sets the fired strips of one chip and sensor, returns the number of hits
+	    static int unpackStrips ( const uint32_t * words, lcio::FloatVec & output, size_t offset );
+
 	protected:
 
 	    int _runNumber;
@@ -57,6 +64,17 @@ namespace eutelescope
 
 	    int _nChips;
 
+	    // the words of the event being decoded, kept between events
+	    std::vector < uint32_t > _eventBuffer;
+
+	    // the raw format layout in 32 bit words
+	    static const size_t HEADER1WORDS = 5;
+	    static const size_t HEADER2WORDS = 1;
+	    static const size_t CHIPWORDS = 11;
+
+	    // strips per sensor and chip
+	    static const size_t STRIPSPERCHIP = 127;
+
     };
 
     Ph2ACF2LCIOConverter gPh2ACF2LCIOConverter;
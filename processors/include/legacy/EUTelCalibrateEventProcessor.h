@@ -320,6 +320,32 @@ namespace eutelescope {
     std::string _histoInfoFileName;
 
   private:
+    //! Sums the pedestal subtracted signal of the good pixels
+    /*! Pixels above the hit rejection cut are counted in @a
+     *  skippedPixel, good pixels below it are added to @a pixelSum and
+     *  counted in @a goodPixel. The pixels are summed in order, so
+     *  the result does not depend on the vectorisation.
+     */
+    void sumGoodPixels(const short *adcValues, const float *pedestalValues,
+                       const float *noiseValues, const short *statusValues,
+                       size_t noOfPixels, double &pixelSum, int &goodPixel,
+                       int &skippedPixel) const;
+
+    //! Writes adc - pedestal - commonMode into @a correctedValues
+    static void subtractPedestal(const short *adcValues,
+                                 const float *pedestalValues,
+                                 double commonMode, size_t noOfPixels,
+                                 float *correctedValues);
+
+    //! Same as above with the common mode applied in float precision
+    /*! Used by the RowWise common mode, where the correction is
+     *  stored as float.
+     */
+    static void subtractPedestal(const short *adcValues,
+                                 const float *pedestalValues,
+                                 float commonMode, size_t noOfPixels,
+                                 float *correctedValues);
+
     //! First pixel along X
     /*! This array of int is used to store the number of the first
      *  pixel along the X direction
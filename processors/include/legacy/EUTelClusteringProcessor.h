@@ -17,6 +17,7 @@
 #include "EUTELESCOPE.h"
 #include "EUTelExceptions.h"
 #include "EUTelGeometryTelescopeGeoDescription.h"
+#include "EUTelPixelStatusMask.h"
 
 // marlin includes ".h"
 #include "marlin/EventModifier.h"
@@ -319,25 +320,19 @@ namespace eutelescope {
      */
     virtual void end();
 
-    //! Reset the status map
+    //! Reset the status mask of a sensor
     /*! This method is called at the beginning of the clustering
-     *  procedure because it is possibly containing the position of
-     *  the previous identified clusters. Hit pixels are identified by
-     *  the value EUTELESCOPE::HITPIXEL; during the reset all of them
-     *  are set to EUTELESCOPE::GOODPIXEL. This is not touching the
-     *  bad pixels since them are marked with EUTELESCOPE::BADPIXEL.
+     *  procedure because the mask is possibly containing the position
+     *  of the previous identified clusters. The status of the sensor
+     *  is loaded from the status collection into the mask the first
+     *  time and whenever the status values change; otherwise only the
+     *  hit and missing pixels of the previous event are cleared. The
+     *  status collection itself is never modified.
      *
-     *  @param status A pointer to the TrackerRawData with the status
-     *  to be reset
-     *
-     *  //todo Consider the possibility to use instead of
-     *  EUTELESCOPE::HITPIXEL, the clusterID to flag hit pixel. This
-     *  is offering a very easy way to show on a 2D histograms where
-     *  clusters have been found. It might be of any usefulness if we
-     *  will try to write a piece of code to deconvolve merging
-     *  clusters.
+     *  @param sensorID The sensor to be reset
+     *  @return The status mask of the sensor
      */
-    void resetStatus(IMPL::TrackerRawDataImpl *status);
+    EUTelPixelStatusMask &resetStatusMask(int sensorID);
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
     //! Book histograms
@@ -374,15 +369,9 @@ namespace eutelescope {
      */
     void initializeGeometry(LCEvent *evt);
 
-    //! initialize statusCollection
-    /*! values from hotpixel DB file are read into the statusCollection
-     * hot pixels get status FiringPixel
-     */
-    void initializeStatusCollection();
-
     //! initialize HotPixelMapVec
-    /*! values from hotpixel DB file are read into a vector of mapped
-     * unique pixel index
+    /*! values from hotpixel DB file are marked as hot pixels in the
+     * status mask of each sensor
      */
     void initializeHotPixelMapVec();
 
@@ -699,6 +688,9 @@ namespace eutelescope {
 
     void getMaxPixels(int sensorID, int &maxX, int &maxY);
 
+    //! True if the pixel is in the hot pixel DB
+    bool isHotPixel(int sensorID, int index) const;
+
     //! read secondary collections
     /*!
      */
@@ -847,14 +839,24 @@ namespace eutelescope {
     //! keep what we have: ZS data (true/false)
     bool hasZSData;
 
-    //! Vector of map arrays, keeps record of hit pixels
-    /*! The vector elements are sorted by Detector ID
-     *  For each Detector unique ID element a map of pixels is created.
-     *  Key <int> is the sequential (counter) id of a hit,
-     *  Value <int> - always status value = firing pixel
+    //! Status masks of the sensors
+    /*! The vector is indexed by the sensorID. Each mask keeps the bad
+     *  pixels of the status collection, the hot pixels of the hot
+     *  pixel DB and the pixels used or missing in the current event.
+     */
+    std::vector<EUTelPixelStatusMask> _statusMaskVec;
+
+    //! Fired pixels of the sensor under digital fixed frame clustering
+    /*! Pixel (x, y) is bit x * ny + y, so that scanning the bitmap
+     *  visits the pixels ordered by x and then by y.
      */
+    EUTelPixelBitmap _firedPixelBitmap;
 
-    std::vector<std::map<int, int>> _hitIndexMapVec;
+    //! Pixels above the seed cut of the sensor under zs clustering
+    /*! Indexed as the status mask, the seed candidates are the good
+     *  pixels among them, see EUTelPixelStatusMask::findGood.
+     */
+    EUTelPixelBitmap _seedCandidateBitmap;
 
     int ID;
   };
@@ -35,6 +35,8 @@ void EigenFitter<T,N>::calculatePlaneWeight(FitPlane<T>& plane, TrackEstimate<T,
   weights.resize(nMeas);
   if(nMeas > 0) weights.setZero();
   //Get the value exp( -chi2 / 2t) for each measurement
+  //The sums run in measurement order, the same as in calculatePlaneWeightBatch.
+  T sumWeights = 0;
   for(size_t m = 0; m < nMeas ; m++){
     const Measurement<T> &meas = plane.meas[m];
     resids = e.params.head(2) - meas.getM();
@@ -43,11 +45,14 @@ void EigenFitter<T,N>::calculatePlaneWeight(FitPlane<T>& plane, TrackEstimate<T,
     chi2s(1) /= plane.getSigmaY() * plane.getSigmaY() + e.cov(1,1);
     T chi2 = chi2s.sum();
     weights(m) = exp( -1 * chi2 / (2 * tval));
+    sumWeights += weights(m);
     //if(isnan(plane.weights(m))){exit(1);}
   }
   T cutWeight = exp( -1 * chi2cutoff / (2 * tval));
-  weights /= (cutWeight + weights.sum() + FLT_MIN);
-  plane.setTotWeight( weights.sum() );
+  weights /= (cutWeight + sumWeights + FLT_MIN);
+  sumWeights = 0;
+  for(size_t m = 0; m < nMeas ; m++){ sumWeights += weights(m); }
+  plane.setTotWeight( sumWeights );
 }
 
 template <typename T, size_t N>
@@ -257,3 +262,246 @@ inline void EigenFitter<T,N>::getAvg(TrackEstimate<T,N>& e1, TrackEstimate<T,N>&
   tmpState1 += tmpState2;
   result.params = result.cov * tmpState1;
 }
+
+//Batched information filter, one lane per track candidate. The kernels below do the same
+//arithmetic as their scalar counterparts, lane by lane.
+namespace daffitter{
+  template <typename T>
+  void EstimateBatch<T>::swapLanes(size_t a, size_t b){
+    //Swap the estimates of two lanes in all planes
+    size_t nRows = m_values.size() / m_nLanes;
+    for(size_t row = 0; row < nRows; row++){
+      std::swap(m_values[row * m_nLanes + a], m_values[row * m_nLanes + b]);
+    }
+  }
+
+  template <typename T, size_t N>
+  void EigenFitter<T,N>::initBatch(size_t nPlanes, size_t nLanes){
+    //Resize batch storage, keeps the allocation between batches
+    batchForward.resize(nPlanes, nLanes);
+    batchBackward.resize(nPlanes, nLanes);
+    batchSmoothed.resize(nPlanes, nLanes);
+    batchState.resize(1, nLanes);
+  }
+
+  template <typename T, size_t N>
+  inline void EigenFitter<T,N>::seedInfoBatch(EstimateBatch<T>& e, size_t nActive){
+    //Information filter seed in all active lanes
+    for(int el = 0; el < EstimateBatch<T>::NELEMENTS; el++){
+      T* v = e.get(0, static_cast<typename EstimateBatch<T>::Element>(el));
+      for(size_t l = 0; l < nActive; l++){ v[l] = 0; }
+    }
+  }
+
+  template <typename T, size_t N>
+  inline void EigenFitter<T,N>::predictInfoBatch(const T* prevZ, const T* curZ, EstimateBatch<T>& e, size_t nActive){
+    //Same as predictInfo, with the measurement z positions of each lane
+    T* x = e.get(0, EstimateBatch<T>::X);
+    T* y = e.get(0, EstimateBatch<T>::Y);
+    T* xdz = e.get(0, EstimateBatch<T>::XDZ);
+    T* ydz = e.get(0, EstimateBatch<T>::YDZ);
+    T* c00 = e.get(0, EstimateBatch<T>::C00);
+    T* c11 = e.get(0, EstimateBatch<T>::C11);
+    T* c22 = e.get(0, EstimateBatch<T>::C22);
+    T* c33 = e.get(0, EstimateBatch<T>::C33);
+    T* c02 = e.get(0, EstimateBatch<T>::C02);
+    T* c13 = e.get(0, EstimateBatch<T>::C13);
+    for(size_t l = 0; l < nActive; l++){
+      T dz = prevZ[l] - curZ[l];
+      T oldC02 = c02[l];
+      T oldC13 = c13[l];
+      c02[l] += dz * c00[l];
+      c13[l] += dz * c11[l];
+      c22[l] += dz * oldC02 + dz * c02[l];
+      c33[l] += dz * oldC13 + dz * c13[l];
+      xdz[l] += dz * x[l];
+      ydz[l] += dz * y[l];
+    }
+  }
+
+  template <typename T, size_t N>
+  inline void EigenFitter<T,N>::addScatteringInfoBatch(const FitPlane<T>& pl, EstimateBatch<T>& e, size_t nActive){
+    //Same as addScatteringInfo
+    T invScatter = 1.0f / pl.getScatterThetaSqr();
+    T* x = e.get(0, EstimateBatch<T>::X);
+    T* y = e.get(0, EstimateBatch<T>::Y);
+    T* xdz = e.get(0, EstimateBatch<T>::XDZ);
+    T* ydz = e.get(0, EstimateBatch<T>::YDZ);
+    T* c00 = e.get(0, EstimateBatch<T>::C00);
+    T* c11 = e.get(0, EstimateBatch<T>::C11);
+    T* c22 = e.get(0, EstimateBatch<T>::C22);
+    T* c33 = e.get(0, EstimateBatch<T>::C33);
+    T* c02 = e.get(0, EstimateBatch<T>::C02);
+    T* c13 = e.get(0, EstimateBatch<T>::C13);
+    for(size_t l = 0; l < nActive; l++){
+      T scattervar2 = 1.0f/(c22[l] + invScatter);
+      T scattervar3 = 1.0f/(c33[l] + invScatter);
+      T c20 = c02[l];
+      T c31 = c13[l];
+      T oldC22 = c22[l];
+      T oldC33 = c33[l];
+      c00[l] -= c20 * c20 * scattervar2;
+      c02[l] -= oldC22 * c20 * scattervar2;
+      c11[l] -= c31 * c31 * scattervar3;
+      c13[l] -= c31 * oldC33 * scattervar3;
+      c22[l] -= oldC22 * oldC22 * scattervar2;
+      c33[l] -= oldC33 * oldC33 * scattervar3;
+
+      T p2 = xdz[l];
+      T p3 = ydz[l];
+      x[l] -= scattervar2 * c20 * p2;
+      y[l] -= scattervar3 * c31 * p3;
+      xdz[l] -= scattervar2 * oldC22 * p2;
+      ydz[l] -= scattervar3 * oldC33 * p3;
+    }
+  }
+
+  template <typename T, size_t N>
+  inline void EigenFitter<T,N>::updateInfoDafBatch(const FitPlane<T>& pl, const T* totWeights, const T* weights,
+						 EstimateBatch<T>& e, size_t nActive){
+    //Same as updateInfoDaf, the measurements of a plane are shared by all lanes
+    if(pl.isExcluded()) { return;}
+    size_t nLanes = e.getNLanes();
+    T* x = e.get(0, EstimateBatch<T>::X);
+    T* y = e.get(0, EstimateBatch<T>::Y);
+    T* c00 = e.get(0, EstimateBatch<T>::C00);
+    T* c11 = e.get(0, EstimateBatch<T>::C11);
+    for(size_t l = 0; l < nActive; l++){
+      c00[l] += pl.invMeasVar(0) * totWeights[l];
+      c11[l] += pl.invMeasVar(1) * totWeights[l];
+    }
+    size_t nMeas = pl.meas.size();
+    for(size_t ii = 0 ; ii < nMeas; ii++){
+      T mx = pl.meas[ii].getX() * pl.invMeasVar(0);
+      T my = pl.meas[ii].getY() * pl.invMeasVar(1);
+      const T* w = weights + ii * nLanes;
+      for(size_t l = 0; l < nActive; l++){
+	x[l] += w[l] * mx;
+	y[l] += w[l] * my;
+      }
+    }
+  }
+
+  template <typename T, size_t N>
+  inline void EigenFitter<T,N>::storeBatch(const EstimateBatch<T>& e, EstimateBatch<T>& dest, size_t plane, size_t nActive){
+    //Copy the running estimate of the active lanes to a plane
+    for(int el = 0; el < EstimateBatch<T>::NELEMENTS; el++){
+      typename EstimateBatch<T>::Element element = static_cast<typename EstimateBatch<T>::Element>(el);
+      std::copy(e.get(0, element), e.get(0, element) + nActive, dest.get(plane, element));
+    }
+  }
+
+  template <typename T, size_t N>
+  void EigenFitter<T,N>::smoothInfoBatch(size_t nPlanes, size_t nActive){
+    //Same as smoothInfo, with the block inversion of fastInvert written out
+    for(size_t ii = 0 ; ii < nPlanes; ii++){
+      const T* fx = batchForward.get(ii, EstimateBatch<T>::X);
+      const T* fy = batchForward.get(ii, EstimateBatch<T>::Y);
+      const T* fxdz = batchForward.get(ii, EstimateBatch<T>::XDZ);
+      const T* fydz = batchForward.get(ii, EstimateBatch<T>::YDZ);
+      const T* f00 = batchForward.get(ii, EstimateBatch<T>::C00);
+      const T* f11 = batchForward.get(ii, EstimateBatch<T>::C11);
+      const T* f22 = batchForward.get(ii, EstimateBatch<T>::C22);
+      const T* f33 = batchForward.get(ii, EstimateBatch<T>::C33);
+      const T* f02 = batchForward.get(ii, EstimateBatch<T>::C02);
+      const T* f13 = batchForward.get(ii, EstimateBatch<T>::C13);
+      const T* bx = batchBackward.get(ii, EstimateBatch<T>::X);
+      const T* by = batchBackward.get(ii, EstimateBatch<T>::Y);
+      const T* bxdz = batchBackward.get(ii, EstimateBatch<T>::XDZ);
+      const T* bydz = batchBackward.get(ii, EstimateBatch<T>::YDZ);
+      const T* b00 = batchBackward.get(ii, EstimateBatch<T>::C00);
+      const T* b11 = batchBackward.get(ii, EstimateBatch<T>::C11);
+      const T* b22 = batchBackward.get(ii, EstimateBatch<T>::C22);
+      const T* b33 = batchBackward.get(ii, EstimateBatch<T>::C33);
+      const T* b02 = batchBackward.get(ii, EstimateBatch<T>::C02);
+      const T* b13 = batchBackward.get(ii, EstimateBatch<T>::C13);
+      T* x = batchSmoothed.get(ii, EstimateBatch<T>::X);
+      T* y = batchSmoothed.get(ii, EstimateBatch<T>::Y);
+      T* xdz = batchSmoothed.get(ii, EstimateBatch<T>::XDZ);
+      T* ydz = batchSmoothed.get(ii, EstimateBatch<T>::YDZ);
+      T* c00 = batchSmoothed.get(ii, EstimateBatch<T>::C00);
+      T* c11 = batchSmoothed.get(ii, EstimateBatch<T>::C11);
+      T* c22 = batchSmoothed.get(ii, EstimateBatch<T>::C22);
+      T* c33 = batchSmoothed.get(ii, EstimateBatch<T>::C33);
+      T* c02 = batchSmoothed.get(ii, EstimateBatch<T>::C02);
+      T* c13 = batchSmoothed.get(ii, EstimateBatch<T>::C13);
+      for(size_t l = 0; l < nActive; l++){
+	//"Block" [x, dx]
+	T a(f00[l] + b00[l]), d(f22[l] + b22[l]), b(f02[l] + b02[l]);
+	T det = 1.0f / (a * d - b * b);
+	c00[l] = det * d;
+	c22[l] = det * a;
+	c02[l] = det * -b;
+	//"Block" [y, dy]
+	a = f11[l] + b11[l]; d = f33[l] + b33[l]; b = f13[l] + b13[l];
+	det = 1.0f / (a * d - b * b);
+	c11[l] = det * d;
+	c33[l] = det * a;
+	c13[l] = det * -b;
+	//Weighted average
+	T px(fx[l] + bx[l]), py(fy[l] + by[l]), pdx(fxdz[l] + bxdz[l]), pdy(fydz[l] + bydz[l]);
+	x[l] = c00[l] * px + c02[l] * pdx;
+	y[l] = c11[l] * py + c13[l] * pdy;
+	xdz[l] = c02[l] * px + c22[l] * pdx;
+	ydz[l] = c13[l] * py + c33[l] * pdy;
+      }
+    }
+  }
+
+  template <typename T, size_t N>
+  void EigenFitter<T,N>::calculatePlaneWeightBatch(const FitPlane<T>& pl, size_t plane, T chi2cutoff,
+						   T* weights, T* totWeights, size_t nActive){
+    //Same as calculatePlaneWeight, based on the smoothed estimates of the active lanes
+    size_t nLanes = batchSmoothed.getNLanes();
+    const T* x = batchSmoothed.get(plane, EstimateBatch<T>::X);
+    const T* y = batchSmoothed.get(plane, EstimateBatch<T>::Y);
+    const T* c00 = batchSmoothed.get(plane, EstimateBatch<T>::C00);
+    const T* c11 = batchSmoothed.get(plane, EstimateBatch<T>::C11);
+    T varX = pl.getSigmaX() * pl.getSigmaX();
+    T varY = pl.getSigmaY() * pl.getSigmaY();
+    size_t nMeas = pl.meas.size();
+    //Get the value exp( -chi2 / 2t) for each measurement, and the sum per lane
+    for(size_t l = 0; l < nActive; l++){ totWeights[l] = 0; }
+    for(size_t m = 0; m < nMeas; m++){
+      T mx = pl.meas[m].getX();
+      T my = pl.meas[m].getY();
+      T* w = weights + m * nLanes;
+      for(size_t l = 0; l < nActive; l++){
+	T rx = x[l] - mx;
+	T ry = y[l] - my;
+	T chi2 = rx * rx / (varX + c00[l]) + ry * ry / (varY + c11[l]);
+	//Most measurements are far from the track, exp underflows to exactly 0 in T for those
+	T arg = -1 * chi2 / (2 * tval);
+	w[l] = (arg < -110) ? 0 : exp(arg);
+	totWeights[l] += w[l];
+      }
+    }
+    T cutWeight = exp( -1 * chi2cutoff / (2 * tval));
+    for(size_t l = 0; l < nActive; l++){ totWeights[l] = cutWeight + totWeights[l] + FLT_MIN; }
+    for(size_t m = 0; m < nMeas; m++){
+      T* w = weights + m * nLanes;
+      for(size_t l = 0; l < nActive; l++){ w[l] /= totWeights[l]; }
+    }
+    for(size_t l = 0; l < nActive; l++){ totWeights[l] = 0; }
+    for(size_t m = 0; m < nMeas; m++){
+      const T* w = weights + m * nLanes;
+      for(size_t l = 0; l < nActive; l++){ totWeights[l] += w[l]; }
+    }
+  }
+
+  template <typename T, size_t N>
+  void EigenFitter<T,N>::getBatchEstimate(const EstimateBatch<T>& batch, size_t plane, size_t lane, TrackEstimate<T,N>& e){
+    //Expand the estimate of one lane
+    e.params(0) = batch.get(plane, EstimateBatch<T>::X)[lane];
+    e.params(1) = batch.get(plane, EstimateBatch<T>::Y)[lane];
+    e.params(2) = batch.get(plane, EstimateBatch<T>::XDZ)[lane];
+    e.params(3) = batch.get(plane, EstimateBatch<T>::YDZ)[lane];
+    e.cov.setZero();
+    e.cov(0,0) = batch.get(plane, EstimateBatch<T>::C00)[lane];
+    e.cov(1,1) = batch.get(plane, EstimateBatch<T>::C11)[lane];
+    e.cov(2,2) = batch.get(plane, EstimateBatch<T>::C22)[lane];
+    e.cov(3,3) = batch.get(plane, EstimateBatch<T>::C33)[lane];
+    e.cov(0,2) = e.cov(2,0) = batch.get(plane, EstimateBatch<T>::C02)[lane];
+    e.cov(1,3) = e.cov(3,1) = batch.get(plane, EstimateBatch<T>::C13)[lane];
+  }
+}
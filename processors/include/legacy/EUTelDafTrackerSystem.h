@@ -4,7 +4,6 @@
 #include <Eigen/Core>
 #include <cmath>
 #include <iostream>
-#include <list>
 #include <vector>
 
 namespace daffitter {
@@ -142,12 +141,38 @@ namespace daffitter {
     }
     PlaneHit(Eigen::Matrix<T, 2, 1> xy, int plane, int index)
         : xy(xy), plane(plane), index(index) {}
-    const Eigen::Matrix<T, 2, 1> &getM() { return (xy); }
+    const Eigen::Matrix<T, 2, 1> &getM() const { return (xy); }
     int getPlane() const { return (plane); }
     int getIndex() const { return (index); };
     void print();
   };
 
+  template <typename T> class EstimateBatch {
+    // Information filter estimates of a batch of track candidates in
+    // structure of arrays layout, one lane per candidate. Only the elements
+    // populated by the information filter are stored, the weight matrix is
+    // block diagonal in [x, dx/dz] and [y, dy/dz].
+    size_t m_nLanes;
+    std::vector<T> m_values;
+
+  public:
+    enum Element { X, Y, XDZ, YDZ, C00, C11, C22, C33, C02, C13, NELEMENTS };
+    EstimateBatch() : m_nLanes(0), m_values() {}
+    void resize(size_t nPlanes, size_t nLanes) {
+      m_nLanes = nLanes;
+      m_values.resize(nPlanes * NELEMENTS * nLanes);
+    }
+    size_t getNLanes() const { return (m_nLanes); }
+    // The lanes of one element in one plane
+    T *get(size_t plane, Element el) {
+      return (&m_values[(plane * NELEMENTS + el) * m_nLanes]);
+    }
+    const T *get(size_t plane, Element el) const {
+      return (&m_values[(plane * NELEMENTS + el) * m_nLanes]);
+    }
+    void swapLanes(size_t a, size_t b);
+  };
+
   template <typename T, size_t N> class EigenFitter {
     // Eigen recommends fixed size matrixes up to 4x4
     Eigen::Matrix<T, N, N> transM, transMtranspose, tmpNxN, tmpNxN_2, tmpNxN_3;
@@ -164,9 +189,13 @@ namespace daffitter {
     std::vector<TrackEstimate<T, N>> forward;
     std::vector<TrackEstimate<T, N>> backward;
     std::vector<TrackEstimate<T, N>> smoothed;
+    // Batched information filter, the running estimate is kept in plane 0 of
+    // batchState
+    EstimateBatch<T> batchForward, batchBackward, batchSmoothed, batchState;
 
     EigenFitter();
     void init(int nPlanes);
+    void initBatch(size_t nPlanes, size_t nLanes);
     // daf weights
     void setT(T tval) { this->tval = tval; };
     T getT() { return (this->tval); };
@@ -188,6 +217,25 @@ namespace daffitter {
     void getAvgInfo(TrackEstimate<T, N> &e1, TrackEstimate<T, N> &e2,
                     TrackEstimate<T, N> &result);
     void smoothInfo();
+    // Batched information filter, working on the first nActive lanes.
+    // Per lane plane z positions, total weights and measurement weights are
+    // passed as lanes, weights with one row of lanes per measurement.
+    void seedInfoBatch(EstimateBatch<T> &e, size_t nActive);
+    void predictInfoBatch(const T *prevZ, const T *curZ, EstimateBatch<T> &e,
+                          size_t nActive);
+    void addScatteringInfoBatch(const FitPlane<T> &pl, EstimateBatch<T> &e,
+                                size_t nActive);
+    void updateInfoDafBatch(const FitPlane<T> &pl, const T *totWeights,
+                            const T *weights, EstimateBatch<T> &e,
+                            size_t nActive);
+    void storeBatch(const EstimateBatch<T> &e, EstimateBatch<T> &dest,
+                    size_t plane, size_t nActive);
+    void smoothInfoBatch(size_t nPlanes, size_t nActive);
+    void calculatePlaneWeightBatch(const FitPlane<T> &pl, size_t plane,
+                                   T chi2cutoff, T *weights, T *totWeights,
+                                   size_t nActive);
+    void getBatchEstimate(const EstimateBatch<T> &batch, size_t plane,
+                          size_t lane, TrackEstimate<T, N> &e);
     // Standard formulation
     void predict(const FitPlane<T> &prev, const FitPlane<T> &cur,
                  TrackEstimate<T, N> &e);
@@ -210,8 +258,8 @@ namespace daffitter {
     T m_dafChi2, m_ckfChi2, m_chi2OverNdof, m_sqrClusterRadius;
     size_t m_skipMax;
 
-    int addNeighbors(std::vector<PlaneHit<T>> &candidate,
-                     std::list<PlaneHit<T>> &hits);
+    void linkNeighbors(const std::vector<PlaneHit<T>> &hits,
+                       std::vector<size_t> &parents);
     T runTweight(T t, daffitter::TrackCandidate<T, N> &candidate);
     T fitPlanesInfoDafInner(daffitter::TrackCandidate<T, N> &candidate);
     T fitPlanesInfoDafBiased(daffitter::TrackCandidate<T, N> &candidate);
@@ -222,6 +270,37 @@ namespace daffitter {
                           int nMeas, T chi2);
     void fitPermutation(size_t plane, TrackEstimate<T, N> &est, size_t nSkipped,
                         std::vector<int> &indexes, int nMeas, T chi2);
+    void prepareCKF();
+    size_t ckfWindow(size_t plane, double lo, double hi);
+    bool ckfPruned(size_t plane, int nMeas, T chi2) const;
+    // CKF search buffers, kept between events so the search does not
+    // allocate. Hits are stored flat, plane by plane from m_ckfOffsets.
+    std::vector<size_t> m_ckfOffsets;
+    // Hits sorted by x, hits with a non finite x can never pass the cuts
+    // and are left out
+    std::vector<T> m_ckfSortedX;
+    std::vector<int> m_ckfSortedHits;
+    std::vector<size_t> m_ckfSortedEnd;
+    // Hits in the search window of the branch currently at a plane
+    std::vector<int> m_ckfWindow;
+    // Hits used by accepted tracks
+    std::vector<bool> m_ckfUsed;
+    // Number of planes that can still add a measurement after a plane
+    std::vector<int> m_ckfPlanesLeft;
+    // One branch estimate per plane
+    std::vector<TrackEstimate<T, N>> m_ckfEstimates;
+    // Batched DAF
+    void fitPlanesInfoDafInnerBatch(size_t nActive);
+    void runTweightBatch(T t, size_t nActive);
+    void intersectBatch(size_t nActive);
+    void swapBatchLanes(size_t a, size_t b);
+    // Per lane state of the batched DAF, stored as rows of lanes: one row
+    // per plane, weights one row per measurement starting at
+    // m_batchWeightRows[plane]. Lanes still annealing are kept in front.
+    size_t m_batchSize, m_nBatchLanes, m_batchFirst;
+    std::vector<size_t> m_batchCandidates, m_batchLanes;
+    std::vector<T> m_batchNdof, m_batchMeasZ, m_batchTotWeight, m_batchWeights;
+    std::vector<size_t> m_batchWeightRows;
 
   public:
     EigenFitter<T, N> m_fitter;
@@ -279,6 +358,15 @@ namespace daffitter {
     void fitPlanesInfoBiased(daffitter::TrackCandidate<T, N> &candidate);
     void fitPlanesInfoUnBiased(daffitter::TrackCandidate<T, N> &candidate);
     void fitPlanesInfoDaf(daffitter::TrackCandidate<T, N> &candidate);
+    // Fit a batch of candidates from tracks, starting at first, with the
+    // DAF. Returns the number of candidates fitted.
+    size_t fitPlanesInfoDafBatch(size_t first);
+    // Restore the plane z positions and weights of a candidate of the last
+    // batch, as left by fitPlanesInfoDaf. For a candidate that left the
+    // annealing early the z positions may differ: there fitPlanesInfoDaf
+    // moves the planes with the smoothed estimates of an earlier fit.
+    void loadBatchPlanes(size_t candidate);
+    void setDafBatchSize(size_t n) { m_batchSize = n; }
     void fitPlanesKF(daffitter::TrackCandidate<T, N> &candidate);
     // partial fitters
     void fitInfoFWBiased(TrackCandidate<T, N> &candidate);
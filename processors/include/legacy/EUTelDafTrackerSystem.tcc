@@ -147,7 +147,8 @@ void PlaneHit<T>::print() {
 
 template <typename T, size_t N>
 TrackerSystem<T, N>::TrackerSystem() : m_inited(false), m_maxCandidates(100), m_minClusterSize(3), m_nXdz(0.0f), m_nYdz(0.0),
-				       m_nXdzdeviance(0.01),m_nYdzdeviance(0.01), m_skipMax(2) {
+				       m_nXdzdeviance(0.01),m_nYdzdeviance(0.01), m_skipMax(2),
+				       m_batchSize(16), m_nBatchLanes(0), m_batchFirst(0) {
   //Constructor for the system of detector planes.
 }
 
@@ -158,7 +159,8 @@ TrackerSystem<T, N>::TrackerSystem(const TrackerSystem<T,N>& sys) : m_inited(fal
 								    m_nXdzdeviance(sys.m_nXdzdeviance), m_nYdzdeviance(sys.m_nYdzdeviance),
 								    m_dafChi2(sys.m_dafChi2), m_ckfChi2(sys.m_ckfChi2), 
 								    m_chi2OverNdof(sys.m_chi2OverNdof), m_sqrClusterRadius(sys.m_sqrClusterRadius),
-								    m_skipMax(sys.m_skipMax){
+								    m_skipMax(sys.m_skipMax), m_batchSize(sys.m_batchSize),
+								    m_nBatchLanes(0), m_batchFirst(0){
   //Copy constructor. Copy relevant info from sys, add planes and init.
   for(size_t ii = 0; ii < sys.planes.size(); ii++){
     //const FitPlane<T>& pl = sys.planes.at(ii);
@@ -257,21 +259,75 @@ inline bool clusterSort(PlaneHit<T>& a, PlaneHit<T>& b) {
   return( a.getM().squaredNorm() > b.getM().squaredNorm()  ); 
 }
 
+inline size_t clusterRoot(vector<size_t>& parents, size_t hit){
+  //Union-find root of a hit, with path halving
+  while(parents[hit] != hit){
+    parents[hit] = parents[parents[hit]];
+    hit = parents[hit];
+  }
+  return(hit);
+}
+
+inline void clusterUnion(vector<size_t>& parents, size_t a, size_t b){
+  //Join the clusters of two hits, the lower root wins so the result does not depend on the order of the links
+  a = clusterRoot(parents, a);
+  b = clusterRoot(parents, b);
+  if(a < b){ parents[b] = a; }
+  else if(b < a){ parents[a] = b; }
+}
+
 template <typename T,size_t N>
-inline int TrackerSystem<T, N>::addNeighbors(vector<PlaneHit<T> > &candidate, list<PlaneHit<T> > &hits){
-  // Part of the cluster tracker. Checks distances to measurements, and adds measurement to cluster maybe.
-  int counter(0); //How many hits are added to the cluster this iteration?
-  for(typename list<PlaneHit<T> >::iterator hit = hits.begin(); hit != hits.end(); hit++ ){
-    for(typename vector<PlaneHit<T> >::iterator cand = candidate.begin(); cand != candidate.end(); cand++){
-      Eigen::Matrix<T, 2, 1> resids = (*hit).getM() - (*cand).getM();
-      if(resids.squaredNorm() > m_sqrClusterRadius ) { continue;}
-      candidate.push_back((*hit));
-      hit = hits.erase(hit);
-      counter ++;
+void TrackerSystem<T, N>::linkNeighbors(const vector<PlaneHit<T> >& hits, vector<size_t>& parents){
+  // Part of the cluster tracker. Links all pairs of hits closer than the cluster radius.
+  // Hits are bucketed in a grid with the cluster radius as cell size, so only the 3x3 cells around a hit are searched.
+  // The cells are a bit larger than the radius so rounding in the cell index can not lose a pair.
+  const size_t nHits = hits.size();
+  const T radius = std::sqrt(m_sqrClusterRadius);
+  const double cellSize = (radius > 0) ? 1.001 * radius : 1.0;
+  // Non finite or absurdly large coordinates don't fit in the grid, compare all pairs as the old tracker did
+  bool useGrid = (radius == 0 or radius > 0) and std::isfinite(cellSize);
+  for(size_t ii = 0; ii < nHits and useGrid; ii++){
+    if(not (std::abs(hits[ii].getM()(0) / cellSize) < 1e15 and std::abs(hits[ii].getM()(1) / cellSize) < 1e15)){
+      useGrid = false;
       break;
     }
   }
-  return (counter);
+  if(not useGrid){
+    for(size_t ii = 0; ii < nHits; ii++){
+      for(size_t jj = ii + 1; jj < nHits; jj++){
+	Eigen::Matrix<T, 2, 1> resids = hits[jj].getM() - hits[ii].getM();
+	if(resids.squaredNorm() > m_sqrClusterRadius ) { continue;}
+	clusterUnion(parents, ii, jj);
+      }
+    }
+    return;
+  }
+
+  // (cell x, cell y, hit), sorted so that the cells of one grid column are contiguous and ordered in y
+  typedef std::pair<std::pair<long long, long long>, size_t> CellHit;
+  vector<CellHit> cells(nHits);
+  for(size_t ii = 0; ii < nHits; ii++){
+    long long cx = static_cast<long long>(std::floor(hits[ii].getM()(0) / cellSize));
+    long long cy = static_cast<long long>(std::floor(hits[ii].getM()(1) / cellSize));
+    cells[ii] = make_pair(make_pair(cx, cy), ii);
+  }
+  sort(cells.begin(), cells.end());
+
+  for(size_t ii = 0; ii < nHits; ii++){
+    const long long cx = cells[ii].first.first;
+    const long long cy = cells[ii].first.second;
+    const PlaneHit<T>& hit = hits[cells[ii].second];
+    for(long long dx = -1; dx <= 1; dx++){
+      typename vector<CellHit>::const_iterator other =
+	lower_bound(cells.begin(), cells.end(), make_pair(make_pair(cx + dx, cy - 1), static_cast<size_t>(0)));
+      for(; other != cells.end() and other->first.first == cx + dx and other->first.second <= cy + 1; other++){
+	if(other->second <= cells[ii].second) { continue;}
+	Eigen::Matrix<T, 2, 1> resids = hits[other->second].getM() - hit.getM();
+	if(resids.squaredNorm() > m_sqrClusterRadius ) { continue;}
+	clusterUnion(parents, cells[ii].second, other->second);
+      }
+    }
+  }
 }
 
 template <typename T,size_t N>
@@ -290,7 +346,8 @@ void TrackerSystem<T, N>::index0tracker(){
 template <typename T,size_t N>
 void TrackerSystem<T, N>::clusterTracker(){
   //A track fitter that propagates measurements into z = 0, then assumes measurement clusters are track candidates.
-  list<PlaneHit<T> > availableHits;
+  //A cluster is the set of hits connected by steps shorter than the cluster radius.
+  vector<PlaneHit<T> > availableHits;
   //Add all meas points to list
   for(size_t ii = 0; ii < planes.size(); ii++){
     if(planes.at(ii).isExcluded()) { continue;}
@@ -301,16 +358,31 @@ void TrackerSystem<T, N>::clusterTracker(){
       availableHits.push_back( a );
     }
   }
-  //Sort by radius from origin
-  //availableHits.sort(clusterSort<T>);
-  while( not availableHits.empty() ){
-    vector<PlaneHit<T> > candidate;
-    candidate.push_back( availableHits.front() );
-    availableHits.pop_front();
-    while( addNeighbors( candidate , availableHits ) > 0) {;}
+
+  const size_t nHits = availableHits.size();
+  vector<size_t> parents(nHits);
+  for(size_t ii = 0; ii < nHits; ii++){ parents[ii] = ii; }
+  linkNeighbors(availableHits, parents);
+
+  //The root of a cluster is its first hit, so walking the hits in order gives the clusters in the order they were
+  //seeded before. Collect the hits of each cluster behind its root.
+  vector<size_t> roots(nHits);
+  vector<size_t> clusterStart(nHits + 1, 0);
+  for(size_t ii = 0; ii < nHits; ii++){
+    roots[ii] = clusterRoot(parents, ii);
+    clusterStart[roots[ii] + 1]++;
+  }
+  for(size_t ii = 0; ii < nHits; ii++){ clusterStart[ii + 1] += clusterStart[ii]; }
+  vector<size_t> clusterHits(nHits);
+  vector<size_t> clusterFill(clusterStart.begin(), clusterStart.end() - 1);
+  for(size_t ii = 0; ii < nHits; ii++){ clusterHits[clusterFill[roots[ii]]++] = ii; }
+
+  for(size_t root = 0; root < nHits; root++){
+    if(roots[root] != root){ continue; }
+    const size_t clusterSize = clusterStart[root + 1] - clusterStart[root];
     //If we find enough hits, we make a candidate
 
-    if(candidate.size() < getMinClusterSize() ){ continue; }
+    if(clusterSize < getMinClusterSize() ){ continue; }
     if(m_nTracks >= m_maxCandidates) {
       std::cout << "Maximum number of track candidates(" << m_maxCandidates 
 		<< ") reached in DAF fitter! If this happens a lot, your configuration is probably off." 
@@ -328,8 +400,8 @@ void TrackerSystem<T, N>::clusterTracker(){
 	cnd.weights.at(ii).setZero();
       }
     }
-    for(size_t ii = 0; ii < candidate.size(); ii++){
-      PlaneHit<T>& hit = candidate.at(ii);
+    for(size_t ii = clusterStart[root]; ii < clusterStart[root + 1]; ii++){
+      const PlaneHit<T>& hit = availableHits.at(clusterHits[ii]);
       cnd.weights.at( hit.getPlane() )( hit.getIndex()) = 1.0;
     }
     tracks.push_back(cnd);
@@ -625,6 +697,207 @@ void TrackerSystem<T, N>::fitPlanesInfoDaf(TrackCandidate<T, N>& candidate){
   }
 }
 
+template <typename T,size_t N>
+size_t TrackerSystem<T, N>::fitPlanesInfoDafBatch(size_t first){
+  // Same as fitPlanesInfoDaf for up to m_batchSize candidates at once, one lane per candidate.
+  // Every lane starts from the plane z positions at the start of the batch. Lanes are reordered
+  // between the DAF iterations so the ones still annealing are in front, m_batchCandidates keeps
+  // track of the candidate in each lane.
+  size_t nPlanes = planes.size();
+  size_t nLanes = min(m_batchSize, m_nTracks - first);
+  m_nBatchLanes = nLanes;
+  m_batchFirst = first;
+  if(nLanes == 0) { return(0); }
+
+  m_fitter.initBatch(nPlanes, nLanes);
+  m_batchCandidates.resize(nLanes);
+  m_batchNdof.resize(nLanes);
+  m_batchMeasZ.resize(nPlanes * nLanes);
+  m_batchTotWeight.resize(nPlanes * nLanes);
+  m_batchWeightRows.resize(nPlanes);
+  size_t nRows = 0;
+  for(size_t plane = 0; plane < nPlanes; plane++){
+    m_batchWeightRows.at(plane) = nRows;
+    nRows += planes.at(plane).meas.size();
+  }
+  m_batchWeights.resize(nRows * nLanes);
+
+  for(size_t lane = 0; lane < nLanes; lane++){
+    TrackCandidate<T, N>& candidate = tracks.at(first + lane);
+    m_batchCandidates.at(lane) = first + lane;
+    T ndof = -4.0f;
+    for(size_t plane = 0; plane < nPlanes; plane++ ){
+      //set tot weight per plane
+      T totWeight = 0.0f;
+      if ( candidate.weights.at(plane).size() > 0 ){
+	totWeight = candidate.weights.at(plane).sum();
+      }
+      if( totWeight > 1.0f){
+	candidate.weights.at(plane) *= 1.0f / totWeight;
+	totWeight = 1.0f;
+      }
+      ndof += totWeight * 2.0;
+      m_batchTotWeight.at(plane * nLanes + lane) = totWeight;
+      m_batchMeasZ.at(plane * nLanes + lane) = planes.at(plane).getMeasZ();
+      for(size_t m = 0; m < planes.at(plane).meas.size(); m++){
+	m_batchWeights.at((m_batchWeightRows.at(plane) + m) * nLanes + lane) = candidate.weights.at(plane)(m);
+      }
+    }
+    if(isnan(ndof)) { ndof = -10.0; }
+    m_batchNdof.at(lane) = ndof;
+  }
+  //Unlike the scalar fitter, the inner fit always smooths. This only matters for lanes where it
+  //returns an ndof < -2.1, which end the annealing anyway.
+  std::vector<T> startNdof(m_batchNdof);
+  fitPlanesInfoDafInnerBatch(nLanes);
+  m_batchNdof.swap(startNdof);
+
+  // Running with fixed annealing schedule.
+  const T temperatures[] = {25.0, 20.0, 14.0, 8.0, 4.0, 1.0};
+  const T ndofCuts[] = {-1.0f, -1.0f, -1.9f, -1.9f, -1.9f, -1.9f};
+  for(size_t step = 0; step < 6; step++){
+    size_t nActive = 0;
+    for(size_t lane = 0; lane < nLanes; lane++){
+      if(not (m_batchNdof.at(lane) > ndofCuts[step])) { continue; }
+      if(lane != nActive) { swapBatchLanes(lane, nActive); }
+      nActive++;
+    }
+    if(nActive > 0) { runTweightBatch(temperatures[step], nActive); }
+  }
+
+  m_batchLanes.resize(nLanes);
+  for(size_t lane = 0; lane < nLanes; lane++){
+    TrackCandidate<T, N>& candidate = tracks.at(m_batchCandidates.at(lane));
+    m_batchLanes.at(m_batchCandidates.at(lane) - first) = lane;
+    for(size_t plane = 0; plane < nPlanes; plane++ ){
+      for(size_t m = 0; m < planes.at(plane).meas.size(); m++){
+	candidate.weights.at(plane)(m) = m_batchWeights.at((m_batchWeightRows.at(plane) + m) * nLanes + lane);
+      }
+    }
+    T ndof = m_batchNdof.at(lane);
+    if(ndof > -1.9f) {
+      for(size_t ii = 0; ii < nPlanes ; ii++ ){
+	//Store estimates and weights in candidate
+	m_fitter.getBatchEstimate(m_fitter.batchSmoothed, ii, lane, candidate.estimates.at(ii));
+	m_fitter.getBatchEstimate(m_fitter.batchForward, ii, lane, m_fitter.forward.at(ii));
+      }
+      getChi2UnBiasedInfoDaf(candidate);
+      weightToIndex(candidate);
+    } else{
+      candidate.ndof = ndof;
+      candidate.chi2 = 0;
+    }
+  }
+  return(nLanes);
+}
+
+template <typename T,size_t N>
+void TrackerSystem<T, N>::loadBatchPlanes(size_t candidate){
+  //Set the plane z positions and total weights to the ones of a candidate in the last batch
+  size_t lane = m_batchLanes.at(candidate - m_batchFirst);
+  for(size_t plane = 0; plane < planes.size(); plane++){
+    planes.at(plane).setMeasZ( m_batchMeasZ.at(plane * m_nBatchLanes + lane) );
+    planes.at(plane).setTotWeight( m_batchTotWeight.at(plane * m_nBatchLanes + lane) );
+  }
+}
+
+template <typename T,size_t N>
+void TrackerSystem<T, N>::swapBatchLanes(size_t a, size_t b){
+  //Swap the state of two lanes in the batched DAF
+  m_fitter.batchForward.swapLanes(a, b);
+  m_fitter.batchBackward.swapLanes(a, b);
+  m_fitter.batchSmoothed.swapLanes(a, b);
+  std::swap(m_batchCandidates.at(a), m_batchCandidates.at(b));
+  std::swap(m_batchNdof.at(a), m_batchNdof.at(b));
+  size_t nLanes = m_nBatchLanes;
+  for(size_t plane = 0; plane < planes.size(); plane++){
+    std::swap(m_batchMeasZ.at(plane * nLanes + a), m_batchMeasZ.at(plane * nLanes + b));
+    std::swap(m_batchTotWeight.at(plane * nLanes + a), m_batchTotWeight.at(plane * nLanes + b));
+  }
+  size_t nRows = m_batchWeights.size() / nLanes;
+  for(size_t row = 0; row < nRows; row++){
+    std::swap(m_batchWeights.at(row * nLanes + a), m_batchWeights.at(row * nLanes + b));
+  }
+}
+
+template <typename T,size_t N>
+void TrackerSystem<T, N>::runTweightBatch(T t, size_t nActive){
+  //A DAF iteration with temperature t for the first nActive lanes.
+  size_t nLanes = m_nBatchLanes;
+  m_fitter.setT(t);
+  for(size_t plane = 0; plane < planes.size(); plane++){
+    m_fitter.calculatePlaneWeightBatch( planes.at(plane), plane, getDAFChi2Cut(),
+					m_batchWeights.data() + m_batchWeightRows.at(plane) * nLanes,
+					m_batchTotWeight.data() + plane * nLanes, nActive);
+  }
+  fitPlanesInfoDafInnerBatch(nActive);
+  intersectBatch(nActive);
+}
+
+template <typename T,size_t N>
+void TrackerSystem<T, N>::intersectBatch(size_t nActive){
+  //Same as intersect, for the first nActive lanes
+  size_t nLanes = m_nBatchLanes;
+  for(size_t plane = 0; plane < planes.size(); plane++ ){
+    FitPlane<T>& pl = planes.at(plane);
+    const T* x = m_fitter.batchSmoothed.get(plane, EstimateBatch<T>::X);
+    const T* y = m_fitter.batchSmoothed.get(plane, EstimateBatch<T>::Y);
+    const T* xdz = m_fitter.batchSmoothed.get(plane, EstimateBatch<T>::XDZ);
+    const T* ydz = m_fitter.batchSmoothed.get(plane, EstimateBatch<T>::YDZ);
+    T* measZ = m_batchMeasZ.data() + plane * nLanes;
+    T r0(pl.getRef0()(0)), r1(pl.getRef0()(1)), r2(pl.getRef0()(2));
+    T n0(pl.getPlaneNorm()(0)), n1(pl.getPlaneNorm()(1)), n2(pl.getPlaneNorm()(2));
+    for(size_t l = 0; l < nActive; l++){
+      //Sums grouped as in the Eigen dot products of intersect, the intersection is sensitive to rounding
+      T len = std::sqrt(xdz[l] * xdz[l] + (ydz[l] * ydz[l] + 1.0f));
+      T dir0(xdz[l] / len), dir1(ydz[l] / len), dir2(1.0f / len);
+      T d = (n0 * (r0 - x[l]) + (n1 * (r1 - y[l]) + n2 * (r2 - measZ[l]))) / (n0 * dir0 + (n1 * dir1 + n2 * dir2));
+      measZ[l] += d * dir2;
+    }
+  }
+}
+
+template <typename T,size_t N>
+void TrackerSystem<T, N>::fitPlanesInfoDafInnerBatch(size_t nActive){
+  // Same as fitPlanesInfoDafInner for the first nActive lanes, the ndof goes to m_batchNdof
+  size_t nPlanes = planes.size();
+  size_t nLanes = m_nBatchLanes;
+  EstimateBatch<T>& e = m_fitter.batchState;
+  m_fitter.seedInfoBatch(e, nActive);
+
+  //Forward fitter
+  m_fitter.storeBatch(e, m_fitter.batchForward, 0, nActive);
+  m_fitter.updateInfoDafBatch( planes.at(0), m_batchTotWeight.data(), m_batchWeights.data(), e, nActive);
+  for(size_t l = 0; l < nActive; l++){
+    m_batchNdof[l] = -4.0f + 2 * m_batchTotWeight[l];
+  }
+  for(size_t ii = 1; ii < nPlanes ; ii++ ){
+    const T* totWeights = m_batchTotWeight.data() + ii * nLanes;
+    if(not planes.at(ii).isExcluded()){
+      for(size_t l = 0; l < nActive; l++){ m_batchNdof[l] += 2 * totWeights[l]; }
+    }
+    m_fitter.predictInfoBatch( m_batchMeasZ.data() + (ii - 1) * nLanes, m_batchMeasZ.data() + ii * nLanes, e, nActive);
+    m_fitter.storeBatch(e, m_fitter.batchForward, ii, nActive);
+    m_fitter.updateInfoDafBatch( planes.at(ii), totWeights, m_batchWeights.data() + m_batchWeightRows.at(ii) * nLanes, e, nActive);
+    m_fitter.addScatteringInfoBatch( planes.at(ii), e, nActive);
+  }
+
+  //Backward fitter, never bias
+  m_fitter.seedInfoBatch(e, nActive);
+  m_fitter.storeBatch(e, m_fitter.batchBackward, nPlanes - 1, nActive);
+  m_fitter.updateInfoDafBatch( planes.at(nPlanes - 1), m_batchTotWeight.data() + (nPlanes - 1) * nLanes,
+			       m_batchWeights.data() + m_batchWeightRows.at(nPlanes - 1) * nLanes, e, nActive);
+  for(int ii = nPlanes -2; ii >= 0; ii-- ){
+    m_fitter.predictInfoBatch( m_batchMeasZ.data() + (ii + 1) * nLanes, m_batchMeasZ.data() + ii * nLanes, e, nActive);
+    m_fitter.addScatteringInfoBatch( planes.at(ii), e, nActive);
+    m_fitter.storeBatch(e, m_fitter.batchBackward, ii, nActive);
+    m_fitter.updateInfoDafBatch( planes.at(ii), m_batchTotWeight.data() + ii * nLanes,
+				 m_batchWeights.data() + m_batchWeightRows.at(ii) * nLanes, e, nActive);
+  }
+
+  m_fitter.smoothInfoBatch(nPlanes, nActive);
+}
+
 template <typename T,size_t N>
 void TrackerSystem<T, N>::checkNan(TrackEstimate<T, N>& e){
   //See if there are any nans in the estimate. For debugging numerical problems.
@@ -809,9 +1082,81 @@ void TrackerSystem<T, N>::fitPlanesKF(TrackCandidate<T, N>& candidate){
 }
 
 //Combinatorial KF
+template <typename T,size_t N>
+void TrackerSystem<T, N>::prepareCKF(){
+  //Fill the CKF search buffers for this event. The buffers only grow, so after the first events nothing is allocated.
+  const size_t nPlanes = planes.size();
+  m_ckfOffsets.resize(nPlanes + 1);
+  m_ckfSortedEnd.resize(nPlanes);
+  m_ckfPlanesLeft.resize(nPlanes + 1);
+  m_ckfEstimates.resize(nPlanes);
+
+  m_ckfOffsets.at(0) = 0;
+  for(size_t ii = 0; ii < nPlanes; ii++){
+    m_ckfOffsets.at(ii + 1) = m_ckfOffsets.at(ii) + planes.at(ii).meas.size();
+  }
+  const size_t nHits = m_ckfOffsets.at(nPlanes);
+  m_ckfSortedX.resize(nHits);
+  m_ckfSortedHits.resize(nHits);
+  m_ckfWindow.resize(nHits);
+  m_ckfUsed.assign(nHits, false);
+
+  m_ckfPlanesLeft.at(nPlanes) = 0;
+  for(size_t ii = nPlanes; ii-- > 0; ){
+    m_ckfPlanesLeft.at(ii) = m_ckfPlanesLeft.at(ii + 1) + (planes.at(ii).isExcluded() ? 0 : 1);
+  }
+
+  for(size_t ii = 0; ii < nPlanes; ii++){
+    const vector<Measurement<T> >& meas = planes.at(ii).meas;
+    typename vector<int>::iterator first = m_ckfSortedHits.begin() + m_ckfOffsets.at(ii);
+    typename vector<int>::iterator last = first;
+    for(size_t hit = 0; hit < meas.size(); hit++){
+      if(std::isfinite(meas.at(hit).getX())){ *last++ = hit; }
+    }
+    sort(first, last, [&meas](int a, int b){ return( meas[a].getX() < meas[b].getX() ); });
+    m_ckfSortedEnd.at(ii) = last - m_ckfSortedHits.begin();
+    for(size_t jj = m_ckfOffsets.at(ii); jj < m_ckfSortedEnd.at(ii); jj++){
+      m_ckfSortedX[jj] = meas[m_ckfSortedHits[jj]].getX();
+    }
+  }
+
+  //Hits of tracks already found in this event count as used
+  for(size_t track = 0; track < getNtracks(); track++){
+    for(size_t ii = 0; ii < nPlanes; ii++){
+      int index = tracks.at(track).indexes.at(ii);
+      if(index >= 0 and static_cast<size_t>(index) < planes.at(ii).meas.size()){
+	m_ckfUsed[m_ckfOffsets.at(ii) + index] = true;
+      }
+    }
+  }
+}
+
+template <typename T,size_t N>
+size_t TrackerSystem<T, N>::ckfWindow(size_t plane, double lo, double hi){
+  //Collect the hits of a plane with lo <= x <= hi, in the order of their index
+  typename vector<T>::const_iterator begin = m_ckfSortedX.begin();
+  typename vector<T>::const_iterator from = lower_bound(begin + m_ckfOffsets.at(plane), begin + m_ckfSortedEnd.at(plane), lo);
+  typename vector<T>::const_iterator to = upper_bound(from, begin + m_ckfSortedEnd.at(plane), hi);
+  typename vector<int>::iterator window = m_ckfWindow.begin() + m_ckfOffsets.at(plane);
+  copy(m_ckfSortedHits.begin() + (from - begin), m_ckfSortedHits.begin() + (to - begin), window);
+  sort(window, window + (to - from));
+  return(to - from);
+}
+
+template <typename T,size_t N>
+bool TrackerSystem<T, N>::ckfPruned(size_t plane, int nMeas, T chi2) const{
+  //The chi2 of a branch only grows, and the ndof can at most grow by the planes left. If even that fails the
+  //chi2/ndof cut, no track can come out of the branch.
+  if(not (chi2 > 0)){ return(false); }
+  int maxNdof = 2 * (nMeas + m_ckfPlanesLeft.at(plane)) - 4;
+  if(maxNdof <= 0){ return(false); }
+  return( chi2 / maxNdof > getChi2OverNdofCut() );
+}
+
 template <typename T,size_t N>
 void TrackerSystem<T, N>::combinatorialKF(){
   // Combinatorial Kalman filter track finder.
+  prepareCKF();
   vector<int> indexes(planes.size(), -1);
   TrackEstimate<T,N> e;
 
@@ -819,16 +1164,8 @@ void TrackerSystem<T, N>::combinatorialKF(){
   for(size_t ii = 0; ii < m_skipMax + 1; ii++){
     if( ii > 0){ indexes.at(ii -1 ) = -1;}
     for(size_t hit = 0; hit < planes.at(ii).meas.size(); hit++){
-      if( ii > 0){
-	bool doContinue(false);
-	//Look for accepted track including hit
-	for(size_t track = 0; track < getNtracks() ; track++){
-	  if(tracks.at(track).indexes.at(ii) == static_cast<int>(hit)){
-	    doContinue = true; break;
-	  }
-	}
-	if(doContinue){ continue; } //Skip if measurement is included in another track
-      }
+      //Skip if measurement is included in another track
+      if( ii > 0 and m_ckfUsed[m_ckfOffsets.at(ii) + hit]){ continue; }
       e.makeSeedInfo();
       indexes.at(ii) = hit;
       m_fitter.updateInfo(planes.at(ii), hit, e);
@@ -847,15 +1184,17 @@ void TrackerSystem<T, N>::finalizeCKFTrack(TrackEstimate<T, N>& est, vector<int>
     return;
   }
   // Either reject the track, or save it
-  TrackCandidate<T,N> candidate(planes.size());
+  T ndof = nMeas * 2 - 4;
+  if(chi2/ndof > getChi2OverNdofCut()) { return;}
 
-  candidate.ndof = nMeas * 2 - 4;
+  TrackCandidate<T,N> candidate(planes.size());
+  candidate.ndof = ndof;
   candidate.chi2 = chi2;
-  if(candidate.chi2/candidate.ndof > getChi2OverNdofCut()) { return;}
   
   //Copy indexes, assign weights
   for(size_t plane = 0; plane < planes.size(); plane++){
     candidate.indexes.at(plane) = indexes.at(plane);
+    if(indexes.at(plane) >= 0){ m_ckfUsed[m_ckfOffsets.at(plane) + indexes.at(plane)] = true; }
   }
   indexToWeight( candidate );
   tracks.push_back(candidate);
@@ -874,6 +1213,7 @@ void TrackerSystem<T, N>::fitPermutation(size_t plane, TrackEstimate<T, N> &est,
     finalizeCKFTrack(est, indexes, nMeas, chi2);
     return;
   }
+  if(ckfPruned(plane, nMeas, chi2)){ return; }
   //Propagate
   if(nMeas > 1) { m_fitter.addScatteringInfo( planes.at(plane - 1), est);}
   m_fitter.predictInfo(planes.at( plane - 1), planes.at(plane), est);
@@ -891,12 +1231,22 @@ void TrackerSystem<T, N>::fitPermutation(size_t plane, TrackEstimate<T, N> &est,
   Eigen::Matrix<T,4,1> state;
   double chi2m = 0;
   double oldX(0.0), oldY(0.0), oldZ(0.0);
+  //Search window in x. The window is a bit wider than the cuts, the cuts themselves are applied below.
+  bool useWindow = false;
+  double lo(0.0), hi(0.0);
   //Get prediction explicitly if needed
   if(nMeas > 1){
     Eigen::Matrix<T, N, N> tmp4x4 = est.cov;
     fastInvert(tmp4x4);
     state = tmp4x4 * est.params;
     errv = planes.at(plane).getSigmas().array().square() + tmp4x4.diagonal().head(2).array();
+    //chi2 < cut needs dx^2 < cut * errv(0), as long as both errors are positive
+    if(errv(0) > 0 and errv(1) > 0){
+      double halfWidth = 1.001 * std::sqrt(getCKFChi2Cut() * static_cast<double>(errv(0)));
+      lo = state(0) - halfWidth;
+      hi = state(0) + halfWidth;
+      useWindow = std::isfinite(lo) and std::isfinite(hi);
+    }
   }
   //If only one measurement has been read in. prepare for checking angles
   if(nMeas == 1){
@@ -909,9 +1259,21 @@ void TrackerSystem<T, N>::fitPermutation(size_t plane, TrackEstimate<T, N> &est,
 	break;
       }
     }
+    //The x slope cut gives an x range
+    double dz = planes.at(plane).getZpos() - oldZ;
+    if(dz > 0){
+      lo = oldX + (getNominalXdz() - getXdzMaxDeviance()) * dz;
+      hi = oldX + (getNominalXdz() + getXdzMaxDeviance()) * dz;
+      double margin = 1e-6 * (fabs(lo) + fabs(hi));
+      lo -= margin;
+      hi += margin;
+      useWindow = std::isfinite(lo) and std::isfinite(hi);
+    }
   }
 
-  for(size_t hit = 0; hit < planes.at(plane).meas.size(); hit++){
+  size_t nCandidates = useWindow ? ckfWindow(plane, lo, hi) : planes.at(plane).meas.size();
+  for(size_t candidate = 0; candidate < nCandidates; candidate++){
+    size_t hit = useWindow ? m_ckfWindow[m_ckfOffsets.at(plane) + candidate] : candidate;
     Measurement<T>& mm = planes.at(plane).meas.at(hit);
     bool filterMeas = false;
     if( nMeas > 1) { 
@@ -928,13 +1290,16 @@ void TrackerSystem<T, N>::fitPermutation(size_t plane, TrackEstimate<T, N> &est,
       if ( (fabs((mm.getX() - oldX)/(newZ - oldZ) - getNominalXdz()) < getXdzMaxDeviance()) and
 	   (fabs((mm.getY() - oldY)/(newZ - oldZ) - getNominalYdz()) < getYdzMaxDeviance())){ filterMeas = true;}
     }
-    //Did the measurement pass cuts? If so propagate branch
+    //Did the measurement pass cuts? If so propagate branch, on the estimate kept for this plane
     if ( filterMeas ){ 
-      TrackEstimate<T,N> clone(est);
+      T newChi2 = chi2 + chi2m;
+      if(ckfPruned(plane + 1, nMeas + 1, newChi2)){ continue; }
+      TrackEstimate<T,N>& clone = m_ckfEstimates.at(plane);
+      clone = est;
 
       m_fitter.updateInfo(planes.at(plane), hit, clone);
       indexes.at(plane)= hit;
-      fitPermutation(plane + 1, clone, nSkipped, indexes, nMeas + 1, chi2 + chi2m);
+      fitPermutation(plane + 1, clone, nSkipped, indexes, nMeas + 1, newChi2);
     }
   }
   //Skip plane if we are allowed to skip more measurements, and including a measurement did not lead to 
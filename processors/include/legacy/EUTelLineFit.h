@@ -13,6 +13,7 @@
 // built only if GEAR is available
 #ifdef USE_GEAR
 // eutelescope includes ".h"
+#include "EUTelStraightLineFit.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -137,15 +138,16 @@ namespace eutelescope {
     //! Event number
     int _iEvt;
 
-    //! Conversion ID map.
+    //! Conversion table from sensor ID to layer index
     /*! In the data file, each cluster is tagged with a detector ID
      *  identify the sensor it belongs to. In the geometry
      *  description, there are along with the sensors also "passive"
-     *  layers and other stuff. Those are identify by a layerindex. So
-     *  we need a conversion table to go from the detectorID to the
-     *  layerindex.
+     *  layers and other stuff. Those are identify by a layerindex.
+     *
+     *  The table is filled in init() and indexed directly by the
+     *  sensor ID, with -1 for the IDs without layer.
      */
-    std::map<int, int> _conversionIdMap;
+    std::vector<int> _layerIndexTable;
 
     //! Silicon planes parameters as described in GEAR
     /*! This structure actually contains the following:
@@ -191,15 +193,46 @@ namespace eutelescope {
 #endif
 
     int _nPlanes;
-    double *_xPos;
-    double *_yPos;
-    double *_zPos;
-    double *_waferResidX;
-    double *_waferResidY;
-    double *_intrResolX;
-    double *_intrResolY;
-    double *_xFitPos;
-    double *_yFitPos;
+
+    //! Alignment correction of one layer
+    /*! The rotation coefficients computed from the alignment
+     *  constants, see EUTelAlign, and the offsets.
+     */
+    struct LayerAlignment {
+      double xx, xy, yx, yy;
+      double offX, offY;
+    };
+
+    //! Alignment correction of each layer, computed in init()
+    std::vector<LayerAlignment> _layerAlignment;
+
+    //! Straight line fit for the current plane positions
+    EUTelStraightLineFit _lineFit;
+
+    //! Maximum number of hit combinations fitted in an event
+    int _maxHitCombinations;
+
+    //! Aligned hit positions of the event on each layer
+    std::vector<std::vector<double> > _layerHitsX;
+    std::vector<std::vector<double> > _layerHitsY;
+
+    //! Hit and fit positions of the hit combinations, plane by plane
+    std::vector<double> _xPos;
+    std::vector<double> _yPos;
+    std::vector<double> _xFitPos;
+    std::vector<double> _yFitPos;
+
+    //! Fit results of the hit combinations
+    std::vector<double> _slopeX;
+    std::vector<double> _slopeY;
+    std::vector<double> _chi2X;
+    std::vector<double> _chi2Y;
+
+    std::vector<double> _zPos;
+    std::vector<double> _waferResidX;
+    std::vector<double> _waferResidY;
+    std::vector<double> _intrResolX;
+    std::vector<double> _intrResolY;
 
     //! Fill histogram switch
     /*! Only for debug reason
@@ -13,6 +13,7 @@
 // built only if GEAR is available
 #ifdef USE_GEAR
 // eutelescope includes ".h"
+#include "EUTelMilleTrackFinder.h"
 #include "EUTelUtility.h"
 
 //#include "TrackerHitImpl2.h"
@@ -221,17 +222,6 @@ namespace eutelescope {
                           double residXFit[], double residYFit[],
                           double angleFit[2]);
 
-    // recursive method which searches for track candidates - with omits!
-    virtual void findtracks2(
-        int missinghits,
-        std::vector<IntVec> &indexarray, // resulting vector of hit indizes
-        IntVec vec,                      // for internal use
-        std::vector<std::vector<EUTelMille::HitsInPlane>>
-            &_hitsArray, // contains all hits for each plane
-        unsigned int i,  // plane number
-        int y            // hit index number
-        );
-
     // recursive method which searches for track candidates
     virtual void findtracks(
         std::vector<IntVec> &indexarray, // resulting vector of hit indizes
@@ -421,6 +411,9 @@ namespace eutelescope {
 
     int _inputMode;
     int _allowedMissingHits;
+
+    //! Track candidate search with omits, used in input mode 0 and 2
+    EUTelMilleTrackFinder _trackFinder;
     int _mimosa26ClusterChargeMin;
 
     float _testModeSensorResolution;
@@ -171,6 +171,12 @@ namespace eutelescope {
    *  @param OutputPedeFile Name of the output pedestal file
    *  @param ASCIIOutputSwitch To enable/disable the generation of
    *  ASCII output files
+   *  @param CacheRawFrames Keep the raw frames of the first pass over
+   *  the pedestal events in memory and run all the other loops on
+   *  them, so the input file is read only once.
+   *  @param FrameCacheMaxSize Maximum size in MB of the frame cache;
+   *  if it is exceeded the processor goes back to re-reading the
+   *  input file.
    *
    *  Note that you don't need a LCIOOutputProcessor or an
    *  EUTelOutputProcessor at the end since
@@ -489,6 +495,21 @@ namespace eutelescope {
      */
     virtual void initializeGeometry(LCEvent *event);
 
+    //! Rewind the input or run the remaining loops on the frame cache
+    /*! Without the frame cache a RewindDataFilesException is
+     *  thrown. Otherwise the remaining loops are done by
+     *  replayFrameCache() from the cached frames.
+     */
+    void rewindOrReplay();
+
+    //! Run all the remaining loops on the cached frames
+    /*! The frames are passed through the same per detector methods as
+     *  the events of the input file, with _iEvt set to the event
+     *  number each frame was taken from. The last loop ends with the
+     *  StopProcessingException thrown by finalizeProcessor().
+     */
+    void replayFrameCache();
+
   protected:
     //! Input collection names.
     /*! A vector containing all the collection names to be used in the
@@ -777,7 +798,38 @@ namespace eutelescope {
      */
     bool _preLoopSwitch;
 
+    //! Switch to keep the raw frames in memory
+    /*! When true the raw data of the first pass over the pedestal
+     *  events are cached, and all the common mode and masking loops
+     *  run on the cache instead of rewinding the input file.
+     */
+    bool _frameCacheSwitch;
+
+    //! Maximum size of the frame cache in MB
+    int _frameCacheMaxSize;
+
   private:
+    //! Per detector part of the first event of firstLoop(LCEvent*)
+    void initializeDetector(size_t iDetector, const short *adcValues,
+                            size_t noOfPixels);
+
+    //! Per detector part of firstLoop(LCEvent*)
+    void firstLoopDetector(size_t iDetector, const short *adcValues);
+
+    //! Per detector part of otherLoop(LCEvent*)
+    void otherLoopDetector(size_t iDetector, const short *adcValues);
+
+    //! Per detector part of additionalMaskingLoop(LCEvent*)
+    void additionalMaskingLoopDetector(size_t iDetector,
+                                       const short *adcValues,
+                                       size_t noOfPixels);
+
+    //! Append the raw data of all detectors of this event to the cache
+    void cacheFrame(LCEvent *evt);
+
+    //! Drop the frame cache and fall back to re-reading the input
+    void clearFrameCache(const std::string &reason);
+
     //! Detector name
     /*! This string is used to copy the detector name from the run
      *  header to the event "header"
@@ -995,6 +1047,27 @@ namespace eutelescope {
 
     //! Additional bad masking loop
     bool _additionalMaskingLoop;
+
+    //! True while the frames are cached and can be used
+    bool _useFrameCache;
+
+    //! True while the loops are run on the frame cache
+    bool _replayingFrames;
+
+    //! The cached raw frames, one after the other
+    /*! Each frame holds the ADC values of all detectors, detector
+     *  iDetector starting at _frameOffsetVec[iDetector].
+     */
+    ShortVec _frameCache;
+
+    //! Offset of each detector within a frame
+    std::vector<size_t> _frameOffsetVec;
+
+    //! Number of ADC values in one frame
+    size_t _frameSize;
+
+    //! Number of frames in the cache
+    size_t _noOfCachedFrames;
   };
 
   //! A global instance of the processor
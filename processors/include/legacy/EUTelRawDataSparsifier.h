@@ -255,6 +255,15 @@ namespace eutelescope {
      *  file
      */
     size_t _noOfDetector;
+
+    //! Index of the pixels passing the threshold
+    /*! Filled by the threshold compaction for one detector at the
+     *  time. Kept across events so that it is allocated only once.
+     */
+    std::vector<int> _sparseIndices;
+
+    //! Signal of the pixels passing the threshold
+    std::vector<float> _sparseSignals;
   };
 
   //! A global instance of the processor
@@ -15,6 +15,7 @@
 // eutelescope includes ".h"
 #include "EUTELESCOPE.h"
 #include "EUTelAlignmentConstant.h"
+#include "EUTelHitSelectionSearch.h"
 
 #include "marlin/Processor.h"
 
@@ -85,7 +86,7 @@ namespace eutelescope {
    *  \li Calculate number of fit hypothesis (including missing hit possibility)
    *  \li Search the list of fit hypotheses to find the one with best
    *     \f$ \chi^{2} \f$ (including ``penalties'' for missing hits or
-   *     skipped planes)
+   *     skipped planes), see EUTelHitSelectionSearch
    *  \li Accept the fit if \f$ \chi^{2} \f$ is below threshold
    *  \li Write fitted track to output \c Track collection; measured
    *     particle positions corrected for alignment and fitted positions
@@ -360,6 +361,9 @@ namespace eutelescope {
   private:
     DISALLOW_COPY_AND_ASSIGN(EUTelTestFitter) // See #define just above
 
+    //! Fit of the hit selections of one event, for _hitSelectionSearch
+    class SelectionFitter;
+
     //!
     /*!
      *
@@ -553,9 +557,10 @@ namespace eutelescope {
 
     // Arrays for selecting different hit combinations
 
-    int *_planeHits;
-    int *_planeChoice;
-    type_fitcount *_planeMod;
+    std::vector<int> _planeHits;
+
+    //! Search of the hit selections to fit
+    EUTelHitSelectionSearch _hitSelectionSearch;
 
     // Fitting algorithm arrays
 
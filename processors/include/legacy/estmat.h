@@ -4,12 +4,18 @@
 #include <TFile.h>
 #include <TH1D.h>
 #include <TMath.h>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
+#include <thread>
 #include <time.h>
 #include <vector>
 
@@ -17,12 +23,6 @@
 #include <Eigen/Core>
 #include <Eigen/LU>
 
-#ifdef DOTHREAD
-#include <boost/bind.hpp>
-#include <boost/thread.hpp>
-#include <boost/thread/detail/thread_group.hpp>
-#endif
-
 #include "EUTelDafTrackerSystem.h"
 //#include "simutils.h"
 #include <stdexcept>
@@ -36,6 +36,49 @@ typedef float FITTERTYPE;
 class Minimizer;
 class FwBw;
 
+//! Persistent pool of worker threads for the Minimizer evaluations
+/*! The threads are started once and wait between evaluations. An
+ *  evaluation is split into chunks, which are dealt out to the workers
+ *  in contiguous ranges; a worker that has finished its own range steals
+ *  the remaining chunks of the others. The calling thread takes part as
+ *  worker 0, so a pool of size one runs everything in the caller.
+ */
+class WorkerPool {
+public:
+  typedef std::function<void(size_t worker, size_t chunk)> Job;
+
+  WorkerPool();
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  //! Number of workers, including the calling thread
+  size_t size() const { return (m_threads.size() + 1); }
+  void resize(size_t nWorkers);
+  //! Run job on all chunks in [0, nChunks), returns when all are done
+  void run(size_t nChunks, const Job &job);
+
+private:
+  struct Range {
+    std::atomic<size_t> next;
+    size_t end;
+    Range() : next(0), end(0) { ; }
+  };
+  void stop();
+  void workerLoop(size_t worker, unsigned long generation);
+  void work(size_t worker);
+
+  std::vector<std::thread> m_threads;
+  std::vector<Range> m_ranges;
+  std::mutex m_mutex;
+  std::condition_variable m_start, m_done;
+  const Job *m_job;
+  size_t m_busy;
+  unsigned long m_generation;
+  bool m_stop;
+  std::exception_ptr m_error;
+};
+
 class EstMat {
 private:
   // simplex search functions
@@ -65,6 +108,8 @@ public:
   // ebeam
   double eBeam;
   TrackerSystem<FITTERTYPE, 4> system;
+  // workers for the Minimizer evaluations
+  WorkerPool pool;
 
   // Fake constructor
   void init(double eBeam, size_t nPlanes) {
@@ -111,6 +156,21 @@ public:
   void printAllFreeParams();
 };
 
+//! Partial sums of the pull distributions over a chunk of tracks
+struct PullSums {
+  std::vector<double> sqrPullXFW, sqrPullXBW, sqrPullYFW, sqrPullYBW;
+  std::vector<std::vector<double>> sqrParams;
+  double logL;
+  int nTracks;
+  PullSums()
+      : sqrPullXFW(), sqrPullXBW(), sqrPullYFW(), sqrPullYBW(), sqrParams(),
+        logL(0.0), nTracks(0) {
+    ;
+  }
+  void reset(size_t nPlanes);
+  void add(const PullSums &other);
+};
+
 class Minimizer {
   bool inited;
 
@@ -119,18 +179,28 @@ public:
   FITTERTYPE retVal2;
   size_t nThreads;
   FITTERTYPE result;
-#ifdef DOTHREAD
-  boost::mutex resultGurad;
-#endif
+  // Tracks per chunk. Does not depend on nThreads, so the partial sums and
+  // their reduction are the same whatever the number of threads.
+  size_t chunkSize;
   vector<TrackerSystem<FITTERTYPE, 4>> systems;
+  // Partial results per chunk, summed in chunk order by reduce()
+  std::vector<double> chunkResults, chunkResults2;
 
   // Minimizer(EstMat& mat) : mat(mat) {;}
-  Minimizer(EstMat &mat) : inited(false), mat(mat), nThreads(4) { ; }
+  Minimizer(EstMat &mat)
+      : inited(false), mat(mat), retVal2(0.0), nThreads(4), result(0.0),
+        chunkSize(256), systems(), chunkResults(), chunkResults2() {
+    ;
+  }
   virtual ~Minimizer() { ; };
 
   FITTERTYPE operator()(void);
-  virtual void operator()(size_t offset, size_t stride) = 0;
+  //! Fit the tracks [first, last) with system, into the partials of chunk
+  virtual void operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                          int first, int last) = 0;
   void prepareThreads();
+  virtual void prepareChunks(size_t nChunks);
+  virtual void reduce();
   virtual void init();
   virtual bool twoRetVals() { return (false); }
 };
@@ -138,7 +208,8 @@ public:
 class Chi2 : public Minimizer {
 public:
   Chi2(EstMat &mat) : Minimizer(mat) { ; }
-  virtual void operator()(size_t offset, size_t stride);
+  virtual void operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                          int first, int last);
 };
 
 class FakeChi2 : public Minimizer {
@@ -153,30 +224,45 @@ public:
   FakeChi2(EstMat &mat) : Minimizer(mat), firstRun(false) { ; }
   void calibrate(TrackerSystem<FITTERTYPE, 4> &system);
   virtual void init();
-  virtual void operator()(size_t offset, size_t stride);
+  virtual void prepareChunks(size_t nChunks);
+  virtual void operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                          int first, int last);
 };
 
 class FakeAbsDev : public FakeChi2 {
 public:
   FakeAbsDev(EstMat &mat) : FakeChi2(mat) { ; }
-  virtual void operator()(size_t offset, size_t stride);
+  virtual void operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                          int first, int last);
 };
 
 class SDR : public Minimizer {
 public:
   bool SDR1, SDR2, cholDec;
+  std::vector<PullSums> chunkPulls;
   SDR(bool SDR1, bool SDR2, bool cholDec, EstMat &mat)
-      : Minimizer(mat), SDR1(SDR1), SDR2(SDR2), cholDec(cholDec) {
+      : Minimizer(mat), SDR1(SDR1), SDR2(SDR2), cholDec(cholDec),
+        chunkPulls() {
     ;
   }
-  virtual void operator()(size_t offset, size_t stride);
+  virtual void operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                          int first, int last);
+  virtual void prepareChunks(size_t nChunks);
+  virtual void reduce();
 };
 
 class FwBw : public Minimizer {
 public:
   vector<FITTERTYPE> results2;
-  FwBw(EstMat &mat) : Minimizer(mat), results2(vector<FITTERTYPE>(4, 0.0)) { ; }
-  virtual void operator()(size_t offset, size_t stride);
+  std::vector<PullSums> chunkPulls;
+  FwBw(EstMat &mat)
+      : Minimizer(mat), results2(vector<FITTERTYPE>(4, 0.0)), chunkPulls() {
+    ;
+  }
+  virtual void operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                          int first, int last);
+  virtual void prepareChunks(size_t nChunks);
+  virtual void reduce();
   virtual bool twoRetVals() { return (true); };
 };
 
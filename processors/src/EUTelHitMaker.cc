@@ -58,7 +58,12 @@ using namespace eutelescope;
 
 EUTelHitMaker::EUTelHitMaker ():Processor ("EUTelHitMaker"), _pulseCollectionName (),
 _hitCollectionName (), _switchLocalCoordinates (false),
-_histogramSwitch (true), _iRun (0), _iEvt (0), _alreadyBookedSensorID ()
+_histogramSwitch (true), _iRun (0), _iEvt (0), _alreadyBookedSensorID (),
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+_hitLocalHistos (), _hitTelescopeHistos (),
+#endif
+_sensorContextMap (), _clusterSensorID (), _clusterOrder (),
+_clusterPosition ()
 {
 
   _description = "EUTelHitMaker is responsible to translate cluster "
@@ -120,6 +125,9 @@ EUTelHitMaker::processRunHeader (LCRunHeader * rdr)
       << "The geometry ID in the run header is set to zero." << std::endl
       << "This may mean that the GeoID parameter was not set" << std::endl;
 
+  //the sensor contexts are rebuilt for every run
+  _sensorContextMap.clear ();
+
   //increment run counter
   ++_iRun;
 }
@@ -167,136 +175,129 @@ EUTelHitMaker::processEvent (LCEvent * event)
     hitCollection = new LCCollectionVec (LCIO::TRACKERHIT);
   }
 
-  //prepare an encoder for the hit collection
+  //prepare an encoder for the hit collection and the decoders, once
+  //per event
   CellIDEncoder < TrackerHitImpl > idHitEncoder (EUTELESCOPE::HITENCODING,
 						 hitCollection);
   CellIDDecoder < TrackerPulseImpl > clusterCellDecoder (pulseCollection);
   CellIDDecoder < TrackerDataImpl >
     cellDecoder (EUTELESCOPE::ZSDATADEFAULTENCODING);
 
-  int oldDetectorID = -100;
-  double xSize = 0., ySize = 0.;
-  double resolutionX = 0., resolutionY = 0.;
-  double xPitch = 0., yPitch = 0.;
+  const size_t nClusters =
+    static_cast < size_t > (pulseCollection->getNumberOfElements ());
 
-  //[START] loop over cluster
-  for (int iCluster = 0; iCluster < pulseCollection->getNumberOfElements ();
-       iCluster++)
+  //first pass: decode the sensorID of every cluster and group the
+  //clusters by sensor, keeping their original order within a group
+  _clusterSensorID.resize (nClusters);
+  _clusterOrder.resize (nClusters);
+  _clusterPosition.resize (nClusters);
+  for (size_t iCluster = 0; iCluster < nClusters; ++iCluster)
     {
       TrackerPulseImpl *pulse =
 	dynamic_cast <
-	TrackerPulseImpl * >(pulseCollection->getElementAt (iCluster));
-      TrackerDataImpl *trackerData =
-	dynamic_cast < TrackerDataImpl * >(pulse->getTrackerData ());
-
-      int sensorID = clusterCellDecoder (pulse)["sensorID"];
-      ClusterType clusterType =
-	static_cast < ClusterType > (static_cast <
-				     int
-				     >(clusterCellDecoder (pulse)["type"]));
-      SparsePixelType pixelType =
-	static_cast < SparsePixelType > (static_cast <
-					 int
-					 >(cellDecoder (trackerData)
-					   ["sparsePixelType"]));
+	TrackerPulseImpl * >(pulseCollection->
+			     getElementAt (static_cast < int >(iCluster)));
+      _clusterSensorID[iCluster] = clusterCellDecoder (pulse)["sensorID"];
+      _clusterOrder[iCluster] = iCluster;
+    }
+  std::stable_sort (_clusterOrder.begin (), _clusterOrder.end (),
+		    [this] (size_t a, size_t b) {
+		    return _clusterSensorID[a] < _clusterSensorID[b];
+		    });
+
+  //second pass: per sensor group, compute the local cluster centres and
+  //convert the whole group to the telescope frame in one go
+  size_t groupBegin = 0;
+  while (groupBegin < nClusters)
+    {
+      const int sensorID = _clusterSensorID[_clusterOrder[groupBegin]];
+      size_t groupEnd = groupBegin + 1;
+      while (groupEnd < nClusters
+	     && _clusterSensorID[_clusterOrder[groupEnd]] == sensorID)
+	++groupEnd;
 
-      //there could be several clusters belonging to the same
-      //detector. So update the geometry information only if this new
-      //cluster belongs to a different detector
+      SensorContext const &context = sensorContext (sensorID);
 
-      if (sensorID != oldDetectorID)
+      //[START] loop over the clusters of this sensor
+      for (size_t iGroup = groupBegin; iGroup < groupEnd; ++iGroup)
 	{
-	  oldDetectorID = sensorID;
-	  //check if the histos for this sensor ID have been booked already.
-	  if (_alreadyBookedSensorID.find (sensorID) ==
-	      _alreadyBookedSensorID.end ())
-	    {
-	      bookHistos (sensorID);
-	    }
+	  const size_t iCluster = _clusterOrder[iGroup];
+	  TrackerPulseImpl *pulse =
+	    dynamic_cast <
+	    TrackerPulseImpl * >(pulseCollection->
+				 getElementAt (static_cast < int >(iCluster)));
+	  TrackerDataImpl *trackerData =
+	    dynamic_cast < TrackerDataImpl * >(pulse->getTrackerData ());
 
-	  //all values given in mm
-	  resolutionX = geo::gGeometry ().getPlaneXResolution (sensorID);
-	  resolutionY = geo::gGeometry ().getPlaneYResolution (sensorID);
-	  xSize = geo::gGeometry ().getPlaneXSize (sensorID);
-	  ySize = geo::gGeometry ().getPlaneYSize (sensorID);
-	  xPitch = geo::gGeometry ().getPlaneXPitch (sensorID);
-	  yPitch = geo::gGeometry ().getPlaneYPitch (sensorID);
-	}
+	  ClusterType clusterType =
+	    static_cast < ClusterType > (static_cast <
+					 int
+					 >(clusterCellDecoder (pulse)
+					   ["type"]));
 
-      //LOCAL coordinate system!
-      double telPos[3];
+	  //LOCAL coordinate system!
+	  std::array < double, 3 > &telPos = _clusterPosition[iCluster];
 
-      //[IF] cluster type
-      if (clusterType == kEUTelGenericSparseClusterImpl)
-	{
-	  float xPos = 0;
-	  float yPos = 0;
-
-	  //for genericSparseCluster: need to know underlying pixel type
-	  if (pixelType == kEUTelGenericSparsePixel)
+	  //[IF] cluster type
+	  if (clusterType == kEUTelGenericSparseClusterImpl)
 	    {
-	      EUTelGenericSparseClusterImpl < EUTelGenericSparsePixel >
-		cluster (trackerData);
-	      cluster.getCenterOfGravity (xPos, yPos);
+	      SparsePixelType pixelType =
+		static_cast < SparsePixelType > (static_cast <
+						 int
+						 >(cellDecoder (trackerData)
+						   ["sparsePixelType"]));
+	      float xPos = 0;
+	      float yPos = 0;
+
+	      //for genericSparseCluster: need to know underlying pixel type
+	      if (pixelType == kEUTelGenericSparsePixel)
+		{
+		  EUTelGenericSparseClusterImpl < EUTelGenericSparsePixel >
+		    cluster (trackerData);
+		  cluster.getCenterOfGravity (xPos, yPos);
 
-	      //for non-geometric clusters: getCenterOfGravity will return it in
-	      //pixel indices space, i.e have to transform into mm via the dimensions
-	      xPos = (xPos + 0.5) * xPitch - xSize / 2.;
-	      yPos = (yPos + 0.5) * yPitch - ySize / 2.;
+		  //for non-geometric clusters: getCenterOfGravity will return it in
+		  //pixel indices space, i.e have to transform into mm via the dimensions
+		  xPos = (xPos + 0.5) * context.xPitch - context.xSize / 2.;
+		  yPos = (yPos + 0.5) * context.yPitch - context.ySize / 2.;
 
-	    }
-	  else if (pixelType == kEUTelGeometricPixel)
-	    {
-	      EUTelGeometricClusterImpl cluster (trackerData);
-	      cluster.getGeometricCenterOfGravity (xPos, yPos);
+		}
+	      else if (pixelType == kEUTelGeometricPixel)
+		{
+		  EUTelGeometricClusterImpl cluster (trackerData);
+		  cluster.getGeometricCenterOfGravity (xPos, yPos);
 
+		}
+	      else
+		{
+		  streamlog_out (ERROR4) << "We do not support pixel type: " <<
+		    pixelType << " for kEUTelGenericSparseClusterImpl" <<
+		    std::endl;
+		  throw
+		    UnknownDataTypeException
+		    ("Pixel type not supported for kEUTelGenericSparseClusterImpl");
+		}
+
+	      telPos[0] = xPos;
+	      telPos[1] = yPos;
+	      telPos[2] = 0;
 	    }
+	  //[ELSE] cluster type
 	  else
 	    {
-	      streamlog_out (ERROR4) << "We do not support pixel type: " <<
-		pixelType << " for kEUTelGenericSparseClusterImpl" << std::
-		endl;
-	      throw
-		UnknownDataTypeException
-		("Pixel type not supported for kEUTelGenericSparseClusterImpl");
-	    }
+	      EUTelSparseClusterImpl < EUTelGenericSparsePixel >
+		cluster (trackerData);
 
-	  telPos[0] = xPos;
-	  telPos[1] = yPos;
-	  telPos[2] = 0;
-	}
-      //[ELSE] cluster type
-      else
-	{
-	  EUTelSparseClusterImpl < EUTelGenericSparsePixel > *cluster =
-	    new EUTelSparseClusterImpl < EUTelGenericSparsePixel >
-	    (trackerData);
-
-	  // get the position of the seed pixel (in pixel number)
-	  int xCluSeed = 0;
-	  int yCluSeed = 0;
-	  cluster->getSeedCoord (xCluSeed, yCluSeed);
-
-	  //with the charge center of gravity calculation, we get a shift
-	  //from the seed pixel center due to the charge distribution. Those
-	  //two numbers are the correction values in the case the Eta
-	  //correction is not applied.
-
-	  //!HACK TAKI:
-	  //! In case of a bricked cluster, we have to make sure to get the normal
-	  //! CoG first.
-	  //! The one without the global seed coordinate correction (caused by pixel
-	  //! rows being skewed).
-	  //! That one has to be eta-corrected and the global coordinate correction
-	  //! has to be applied on top of that!
-	  //! So prepare a brickedCluster pointer now:
-
-	  EUTelBrickedClusterImpl *p_tmpBrickedCluster = nullptr;
-	  if (clusterType == kEUTelBrickedClusterImpl)
-	    {
-	      p_tmpBrickedCluster =
-		dynamic_cast < EUTelBrickedClusterImpl * >(cluster);
-	      if (p_tmpBrickedCluster == nullptr)
+	      //!HACK TAKI:
+	      //! In case of a bricked cluster, we have to make sure to get the normal
+	      //! CoG first.
+	      //! The one without the global seed coordinate correction (caused by pixel
+	      //! rows being skewed).
+	      //! That one has to be eta-corrected and the global coordinate correction
+	      //! has to be applied on top of that!
+	      if (clusterType == kEUTelBrickedClusterImpl
+		  && dynamic_cast < EUTelBrickedClusterImpl * >(&cluster) ==
+		  nullptr)
 		{
 		  streamlog_out (ERROR4) <<
 		    " .COULD NOT CREATE EUTelBrickedClusterImpl* !!!" << std::
@@ -305,58 +306,48 @@ EUTelHitMaker::processEvent (LCEvent * event)
 		    UnknownDataTypeException
 		    ("COULD NOT CREATE EUTelBrickedClusterImpl* !!!");
 		}
-	    }
 
-	  float xShift = 0.;
-	  float yShift = 0.;
-	  cluster->getCenterOfGravityShift (xShift, yShift);
-	  double xCorrection = static_cast < double >(xShift);
-	  double yCorrection = static_cast < double >(yShift);
-
-	  //rescale the pixel number in millimeter
-	  double xDet =
-	    (static_cast < double >(xCluSeed) + xCorrection + 0.5) *xPitch;
-	  double yDet =
-	    (static_cast < double >(yCluSeed) + yCorrection + 0.5) *yPitch;
-
-	  //FIXME? check the hack from Havard:
-	  float xCoG (0.0f), yCoG (0.0f);
-	  cluster->getCenterOfGravity (xCoG, yCoG);
-	  xDet = (xCoG + 0.5) * xPitch;
-	  yDet = (yCoG + 0.5) * yPitch;
-
-	  streamlog_out (DEBUG1)
-	    << "cluster[" << setw (4) << iCluster << "] on sensor[" <<
-	    setw (3) << sensorID << "] at [" << setw (8) << setprecision (3)
-	    << xCoG << ":" << setw (8) << setprecision (3) << yCoG << "]" <<
-	    " ->  [" << setw (8) << setprecision (3) << xDet << ":" <<
-	    setw (8) << setprecision (3) << yDet << "]" << std::endl;
-
-	  //We have calculated the cluster hit position in terms of distance along
-	  //the X and Y axis.
-	  //However we still do not have the sensor centre as the origin of the
-	  //coordinate system.
-	  //To do this we need to deduct xSize/2 and ySize/2 for the respective
-	  //cluster X/Y position
-
-	  telPos[0] = xDet - xSize / 2.;
-	  telPos[1] = yDet - ySize / 2.;
-	  telPos[2] = 0.;
-
-	  delete cluster;
-	  cluster = nullptr;
-	}			//[END] cluster type
+	      //FIXME? check the hack from Havard: the seed position plus the
+	      //CoG shift is superseded by the plain CoG
+	      float xCoG (0.0f), yCoG (0.0f);
+	      cluster.getCenterOfGravity (xCoG, yCoG);
+	      double xDet = (xCoG + 0.5) * context.xPitch;
+	      double yDet = (yCoG + 0.5) * context.yPitch;
+
+	      streamlog_out (DEBUG1)
+		<< "cluster[" << setw (4) << iCluster << "] on sensor[" <<
+		setw (3) << sensorID << "] at [" << setw (8) <<
+		setprecision (3) << xCoG << ":" << setw (8) <<
+		setprecision (3) << yCoG << "]" << " ->  [" << setw (8) <<
+		setprecision (3) << xDet << ":" << setw (8) <<
+		setprecision (3) << yDet << "]" << std::endl;
+
+	      //We have calculated the cluster hit position in terms of distance along
+	      //the X and Y axis.
+	      //However we still do not have the sensor centre as the origin of the
+	      //coordinate system.
+	      //To do this we need to deduct xSize/2 and ySize/2 for the respective
+	      //cluster X/Y position
+
+	      telPos[0] = xDet - context.xSize / 2.;
+	      telPos[1] = yDet - context.ySize / 2.;
+	      telPos[2] = 0.;
+	    }			//[END] cluster type
+	}			//[END] loop over the clusters of this sensor
 
       //plot hits in the EUTelescope local frame; this frame has the
       //coordinate centre at the sensor centre
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
       if (_histogramSwitch)
 	{
-	  AIDA::IHistogram2D * histo_loc =
-	    dynamic_cast < AIDA::IHistogram2D * >(_hitLocalHistos[sensorID]);
-	  if (histo_loc)
+	  if (context.hitLocalHisto)
 	    {
-	      histo_loc->fill (telPos[0], telPos[1]);
+	      for (size_t iGroup = groupBegin; iGroup < groupEnd; ++iGroup)
+		{
+		  std::array < double, 3 > const &pos =
+		    _clusterPosition[_clusterOrder[iGroup]];
+		  context.hitLocalHisto->fill (pos[0], pos[1]);
+		}
 	    }
 	  else
 	    {
@@ -373,19 +364,35 @@ EUTelHitMaker::processEvent (LCEvent * event)
 	{
 	  // NOW !!
 	  // GLOBAL coordinate system !!!
-	  const double localPos[3] = { telPos[0], telPos[1], telPos[2] };
-	  geo::gGeometry ().local2Master (sensorID, localPos, telPos);
+	  // The local z is always zero, so the affine transform reduces to
+	  // the origin plus the images of the local x and y axes; the terms
+	  // are summed in the same order as TGeoHMatrix::LocalToMaster.
+	  for (size_t iGroup = groupBegin; iGroup < groupEnd; ++iGroup)
+	    {
+	      std::array < double, 3 > &pos =
+		_clusterPosition[_clusterOrder[iGroup]];
+	      const double xLocal = pos[0];
+	      const double yLocal = pos[1];
+	      for (size_t i = 0; i < 3; ++i)
+		{
+		  pos[i] =
+		    context.origin[i] + xLocal * context.xAxis[i] +
+		    yLocal * context.yAxis[i];
+		}
+	    }
 	}
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
       if (_histogramSwitch)
 	{
-	  AIDA::IHistogram2D * histo_tel =
-	    dynamic_cast <
-	    AIDA::IHistogram2D * >(_hitTelescopeHistos[sensorID]);
-	  if (histo_tel)
+	  if (context.hitTelescopeHisto)
 	    {
-	      histo_tel->fill (telPos[0], telPos[1]);
+	      for (size_t iGroup = groupBegin; iGroup < groupEnd; ++iGroup)
+		{
+		  std::array < double, 3 > const &pos =
+		    _clusterPosition[_clusterOrder[iGroup]];
+		  context.hitTelescopeHisto->fill (pos[0], pos[1]);
+		}
 	    }
 	  else
 	    {
@@ -399,21 +406,34 @@ EUTelHitMaker::processEvent (LCEvent * event)
 	}
 #endif
 
+      groupBegin = groupEnd;
+    }
+
+  //third pass: create the hits in the original cluster order
+  for (size_t iCluster = 0; iCluster < nClusters; ++iCluster)
+    {
+      TrackerPulseImpl *pulse =
+	dynamic_cast <
+	TrackerPulseImpl * >(pulseCollection->
+			     getElementAt (static_cast < int >(iCluster)));
+      const int sensorID = _clusterSensorID[iCluster];
+      SensorContext const &context = _sensorContextMap.at (sensorID);
+
       //create new hit
       TrackerHitImpl *hit = new TrackerHitImpl;
-      hit->setPosition (&telPos[0]);
+      hit->setPosition (_clusterPosition[iCluster].data ());
       float cov[TRKHITNCOVMATRIX] = { 0., 0., 0., 0., 0., 0. };
-      double resx = resolutionX;
-      double resy = resolutionY;
+      double resx = context.xResolution;
+      double resy = context.yResolution;
       cov[0] = resx * resx;	//cov(x,x)
       cov[2] = resy * resy;	//cov(y,y)
       hit->setCovMatrix (cov);
-      hit->setType (clusterType);
+      hit->setType (static_cast < int >(clusterCellDecoder (pulse)["type"]));
       hit->setTime (pulse->getTime ());
 
       //prepare a LCObjectVec to store the current cluster
       LCObjectVec clusterVec;
-      clusterVec.push_back (trackerData);
+      clusterVec.push_back (pulse->getTrackerData ());
 
       //add the clusterVec to the hit
       hit->rawHits () = clusterVec;
@@ -430,8 +450,7 @@ EUTelHitMaker::processEvent (LCEvent * event)
 
       //add new hit to hit collection
       hitCollection->push_back (hit);
-
-    }				//[END] loop over cluster
+    }
 
   try
   {
@@ -446,6 +465,49 @@ EUTelHitMaker::processEvent (LCEvent * event)
     _isFirstEvent = false;
 }
 
+EUTelHitMaker::SensorContext const &
+EUTelHitMaker::sensorContext (int sensorID)
+{
+  auto it = _sensorContextMap.find (sensorID);
+  if (it != _sensorContextMap.end ())
+    return it->second;
+
+  //check if the histos for this sensor ID have been booked already.
+  if (_alreadyBookedSensorID.find (sensorID) == _alreadyBookedSensorID.end ())
+    {
+      bookHistos (sensorID);
+    }
+
+  SensorContext context;
+
+  //all values given in mm
+  context.xResolution = geo::gGeometry ().getPlaneXResolution (sensorID);
+  context.yResolution = geo::gGeometry ().getPlaneYResolution (sensorID);
+  context.xSize = geo::gGeometry ().getPlaneXSize (sensorID);
+  context.ySize = geo::gGeometry ().getPlaneYSize (sensorID);
+  context.xPitch = geo::gGeometry ().getPlaneXPitch (sensorID);
+  context.yPitch = geo::gGeometry ().getPlaneYPitch (sensorID);
+
+  //decompose the local to global transform: the translation is the
+  //image of the origin, the rotation columns the images of the axes
+  const double zero[3] = { 0., 0., 0. };
+  const double xUnit[3] = { 1., 0., 0. };
+  const double yUnit[3] = { 0., 1., 0. };
+  geo::gGeometry ().local2Master (sensorID, zero, context.origin.data ());
+  geo::gGeometry ().local2MasterVec (sensorID, xUnit, context.xAxis.data ());
+  geo::gGeometry ().local2MasterVec (sensorID, yUnit, context.yAxis.data ());
+
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+  context.hitLocalHisto =
+    dynamic_cast < AIDA::IHistogram2D * >(_hitLocalHistos[sensorID]);
+  context.hitTelescopeHisto =
+    dynamic_cast < AIDA::IHistogram2D * >(_hitTelescopeHistos[sensorID]);
+#endif
+
+  return _sensorContextMap.insert (std::make_pair (sensorID, context)).first->
+    second;
+}
+
 void
 EUTelHitMaker::end ()
 {
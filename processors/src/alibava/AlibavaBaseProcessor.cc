@@ -30,6 +30,7 @@
 
 // ROOT includes ".h"
 #include "TObject.h"
+#include "TH1.h"
 
 // system includes <>
 #include <string>
@@ -60,7 +61,8 @@ _noiseMap ( ),
 _chargeCalMap ( ),
 _isPedestalValid ( false ),
 _isNoiseValid ( false ),
-_isCalibrationValid ( false )
+_isCalibrationValid ( false ),
+_histoHandles ( )
 {
     // Modify processor description
     _description = "AlibavaBaseProcessor";
@@ -76,6 +78,21 @@ bool AlibavaBaseProcessor::doesRootObjectExists ( std::string aHistoName )
     return it != _rootObjectMap.end ( );
 }
 
+// Clears the histogram handle registry and sizes it for noOfKinds kinds
+void AlibavaBaseProcessor::resetHistoHandles ( int noOfKinds )
+{
+    _histoHandles.assign ( noOfKinds * ALIBAVA::NOOFCHIPS * ALIBAVA::NOOFCHANNELS, nullptr );
+}
+
+// Inserts a histogram in _rootObjectMap and registers its handle
+TH1 * AlibavaBaseProcessor::registerHistoHandle ( std::string aHistoName, TH1 * histo, int kind, int chipnum, int ichan )
+{
+    map < string, TObject * > ::iterator it = _rootObjectMap.insert ( make_pair ( aHistoName, histo ) ) .first;
+    TH1 * handle = dynamic_cast < TH1* > ( it -> second );
+    _histoHandles.at ( ( kind * ALIBAVA::NOOFCHIPS + chipnum ) * ALIBAVA::NOOFCHANNELS + ichan ) = handle;
+    return handle;
+}
+
 // Input/Output Collection
 // Getter and setter for _inputCollectionName
 void AlibavaBaseProcessor::setInputCollectionName ( std::string inputCollectionName )
@@ -72,7 +72,9 @@ using namespace eutelescope;
 AlibavaClustering::AlibavaClustering ( ) : AlibavaBaseProcessor ( "AlibavaClustering" ),
 _clusterCollectionName ( ALIBAVA::NOTSET ),
 _clustercharge ( ),
-_clustercount ( 0 )
+_clustercount ( 0 ),
+_channelNoise ( ),
+_usedChannels ( )
 {
 
     // modify processor description
@@ -187,10 +189,100 @@ void AlibavaClustering::processRunHeader ( LCRunHeader * rdr )
 
     setPedestals ( );
 
+    cacheChannelInfo ( );
+
     bookHistos ( );
 
 }
 
+void AlibavaClustering::cacheChannelInfo ( )
+{
+    // chips which are not selected keep zero noise and all channels in use
+    for ( int ichip = 0; ichip < ALIBAVA::NOOFCHIPS; ichip++ )
+    {
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	{
+	    _channelNoise[ichip][ichan] = 0.0f;
+	}
+	for ( int iword = 0; iword < CHANNELWORDS; iword++ )
+	{
+	    _usedChannels[ichip][iword] = ~uint64_t ( 0 );
+	}
+    }
+
+    EVENT::IntVec chipSelection = getChipSelection ( );
+    for ( unsigned int i = 0; i < chipSelection.size ( ); i++ )
+    {
+	int chipnum = chipSelection[i];
+	if ( chipnum < 0 || chipnum >= ALIBAVA::NOOFCHIPS )
+	{
+	    continue;
+	}
+
+	EVENT::FloatVec noiseVec;
+	if ( isNoiseValid ( ) )
+	{
+	    noiseVec = getNoiseOfChip ( chipnum );
+	}
+
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	{
+	    if ( ichan < int ( noiseVec.size ( ) ) )
+	    {
+		_channelNoise[chipnum][ichan] = noiseVec[ichan];
+	    }
+	    if ( isMasked ( chipnum, ichan ) )
+	    {
+		_usedChannels[chipnum][ichan >> 6] &= ~ ( uint64_t ( 1 ) << ( ichan & 63 ) );
+	    }
+	}
+    }
+}
+
+bool AlibavaClustering::isChannelSet ( const uint64_t * bits, int ichan )
+{
+    if ( ichan < 0 || ichan >= ALIBAVA::NOOFCHANNELS )
+    {
+	return false;
+    }
+    return ( bits[ichan >> 6] >> ( ichan & 63 ) ) & 1;
+}
+
+int AlibavaClustering::nextChannel ( const uint64_t * bits, int ichan, int nchan )
+{
+    while ( ichan < nchan )
+    {
+	// the remaining bits of this word
+	uint64_t word = bits[ichan >> 6] >> ( ichan & 63 );
+	if ( word != 0 )
+	{
+	    ichan += __builtin_ctzll ( word );
+	    return ichan < nchan ? ichan : nchan;
+	}
+	// continue at the start of the next word
+	ichan = ( ( ichan >> 6 ) + 1 ) << 6;
+    }
+    return nchan;
+}
+
+int AlibavaClustering::runLengthDown ( const uint64_t * bits, int ichan )
+{
+    int length = 0;
+    while ( ichan >= 0 )
+    {
+	// move channel ichan to the top bit, the leading ones are the run
+	uint64_t inverted = ~ ( bits[ichan >> 6] << ( 63 - ( ichan & 63 ) ) );
+	int run = ( inverted == 0 ) ? ( ichan & 63 ) + 1 : __builtin_clzll ( inverted );
+	length += run;
+	if ( run <= ( ichan & 63 ) )
+	{
+	    break;
+	}
+	ichan -= run;
+    }
+    return length;
+}
+
 void AlibavaClustering::processEvent ( LCEvent * anEvent )
 {
     if ( anEvent -> getEventNumber ( ) % 1000 == 0 )
@@ -370,280 +462,282 @@ void AlibavaClustering::findSeedClusters(TrackerDataImpl * trkdata, LCCollection
     std::vector < int > clusterNumber;
     clusterNumber.assign ( datavec.size ( ), 0 );
 
-    // go through all channels
-    for ( size_t ichan = 0; ichan < datavec.size ( );ichan++ )
+    // flat copies of data and noise of this chip, padded on both sides so that
+    // the neighbour look-ups around a seed never leave the arrays
+    const int nchan = int ( datavec.size ( ) ) < ALIBAVA::NOOFCHANNELS ? int ( datavec.size ( ) ) : ALIBAVA::NOOFCHANNELS;
+    const bool validChip = ( chipnum >= 0 && chipnum < ALIBAVA::NOOFCHIPS );
+    float dataBlock[ALIBAVA::NOOFCHANNELS + 2 * CHANNELPADDING] = { };
+    float noiseBlock[ALIBAVA::NOOFCHANNELS + 2 * CHANNELPADDING] = { };
+    float * data = dataBlock + CHANNELPADDING;
+    float * noise = noiseBlock + CHANNELPADDING;
+    for ( int ichan = 0; ichan < nchan; ichan++ )
     {
-	streamlog_out ( DEBUG3 ) << "Channel loop " << ichan << endl;
-
-	float noise = 0.0;
-	float seedlevel = 0.0;
-	float clusterlevel = 0.0;
+	data[ichan] = datavec[ichan];
+	noise[ichan] = validChip ? _channelNoise[chipnum][ichan] : 0.0f;
+    }
 
-	// this is the noise level we get from the previous steps
-	if ( isMasked ( chipnum, ichan ) == false )
-	{
-	    // get the noise levels
-	    noise = getNoiseAtChannel ( chipnum, ichan );
-	    streamlog_out ( DEBUG4 ) << "Channel " << ichan << " has a noise level of | " << noise << " | ADCs" << endl;
-	    streamlog_out ( DEBUG4 ) << "Channel " << ichan << " has a signal level of " << datavec[ichan] << " ADCs" << endl;
+    // One comparison pass over the chip gives bit masks (bit i = channel i) of the
+    // channels above seed and above cluster level
+    uint64_t aboveSeed[CHANNELWORDS] = { };
+    uint64_t aboveCluster[CHANNELWORDS] = { };
+    for ( int ichan = 0; ichan < nchan; ichan++ )
+    {
+	const float signal = data[ichan] * _polarity;
+	aboveSeed[ichan >> 6] |= uint64_t ( signal >= _seedcut * noise[ichan] ) << ( ichan & 63 );
+	aboveCluster[ichan >> 6] |= uint64_t ( signal >= _clustercut * noise[ichan] ) << ( ichan & 63 );
+    }
 
-	    // the level for a seed
-	    seedlevel = _seedcut * noise;
-	    streamlog_out ( DEBUG4 ) << "Seed level is " << seedlevel * _polarity << endl;
+    // unmasked channels; channels of chips without a mask are all used
+    uint64_t used[CHANNELWORDS];
+    for ( int iword = 0; iword < CHANNELWORDS; iword++ )
+    {
+	used[iword] = validChip ? _usedChannels[chipnum][iword] : ~uint64_t ( 0 );
+    }
 
-	    // the level for a cluster
-	    clusterlevel = _clustercut * noise;
-	    streamlog_out ( DEBUG4 ) << "Cluster level is " << clusterlevel * _polarity << endl;
+    // we disalow a seed next to a bad channel, the (non existing) neighbours of the first and last channel count as good;
+    // the masks of the neighbours are the used mask shifted by one channel, carrying the bit across the words
+    uint64_t leftUsed[CHANNELWORDS];
+    uint64_t rightUsed[CHANNELWORDS];
+    for ( int iword = 0; iword < CHANNELWORDS; iword++ )
+    {
+	leftUsed[iword] = ( used[iword] << 1 ) | ( iword > 0 ? used[iword - 1] >> 63 : uint64_t ( 1 ) );
+	rightUsed[iword] = ( used[iword] >> 1 ) | ( iword + 1 < CHANNELWORDS ? used[iword + 1] << 63 : uint64_t ( 1 ) << 63 );
+    }
 
-	}
-	else
-	{
-	    // all levels should be 0
-	    streamlog_out ( DEBUG3 ) << "Channel " << ichan << " is masked. Setting noise level to " << noise << endl;
-	}
+    uint64_t seeds[CHANNELWORDS];
+    uint64_t growRight[CHANNELWORDS];
+    uint64_t growLeft[CHANNELWORDS];
+    for ( int iword = 0; iword < CHANNELWORDS; iword++ )
+    {
+	seeds[iword] = aboveSeed[iword] & used[iword] & leftUsed[iword] & rightUsed[iword];
+	// right of a seed any unmasked channel above cluster level is added
+	growRight[iword] = aboveCluster[iword] & used[iword];
+	// left of a seed the channel must also stay below the seed cut, so that we don't refind clusters after splitting
+	growLeft[iword] = aboveCluster[iword] & used[iword] & ~aboveSeed[iword];
+    }
 
-	// if a channel passes the seed cluster clut, use only positive ADCs to check! The noise levels from previous steps will always be positive!
-	// we also disalow a seed next to a bad channel
-	if ( ( datavec[ichan] * _polarity ) >= seedlevel && ( isMasked ( chipnum, ichan ) == false ) && ( isMasked ( chipnum, ichan + 1 ) == false ) && ( isMasked ( chipnum, ichan - 1 ) == false ) )
-	{
+    // go through all seeds
+    for ( int ichan = nextChannel ( seeds, 0, nchan ); ichan < nchan; ichan = nextChannel ( seeds, ichan + 1, nchan ) )
+    {
+	// the level for a seed
+	float seedlevel = _seedcut * noise[ichan];
 
-	    streamlog_out ( DEBUG4 ) << "Found seed on channel " << ichan << " with seed of " << datavec[ichan] * _polarity << endl;
+	streamlog_out ( DEBUG4 ) << "Found seed on channel " << ichan << " with seed of " << data[ichan] * _polarity << endl;
 
-	    // now check if any neighbours pass the cluster cut
-	    // the cluster starts out with size 1, so nothing left or right
-	    int posclustersize = 0;
-	    int negclustersize = 0;
+	// now check if any neighbours pass the cluster cut
+	// the cluster starts out with size 1, so nothing left or right
+	int posclustersize = 0;
+	int negclustersize = 0;
 
-	    // look right
-	    bool posdir = true;
-	    // does this channel exist?
-	    while ( ( ichan + posclustersize + 1 ) < datavec.size ( ) && posdir == true )
+	// look right
+	bool posdir = true;
+	// does this channel exist?
+	while ( ( ichan + posclustersize + 1 ) < nchan && posdir == true )
+	{
+	    if ( isChannelSet ( growRight, ichan + posclustersize + 1 ) )
 	    {
-		if ( ( datavec[ichan + posclustersize + 1] * _polarity ) >= ( _clustercut * getNoiseAtChannel ( chipnum, ichan + posclustersize + 1 ) ) && ( isMasked ( chipnum, ichan + posclustersize + 1 ) == false ) )
-		{
-
-		    posclustersize += 1;
-		    streamlog_out ( DEBUG3 ) << "Found large cluster in event: " << alibavaEvent -> getEventNumber ( ) << endl;
-		    // if this happens, we have found a second seed in this cluster with a higher ADC count
-		    // since ichan goes to the right, this feature can only be found here.
 
-		    // don't compare ACDs, look for ADC/seedlevel
-		    if ( ( ( datavec[ichan + posclustersize + 1] * _polarity ) / ( getNoiseAtChannel ( chipnum, ichan + posclustersize + 1 ) * _seedcut )  ) > ( ( datavec[ichan] * _polarity ) / seedlevel ) )
-		    {
-
-			streamlog_out ( DEBUG4 ) << "Found multiple seeds in a cluster in event " << alibavaEvent -> getEventNumber ( ) << " ... splitting!" << endl;
-			streamlog_out ( DEBUG4 ) << ( ( datavec[ichan + posclustersize + 1] * _polarity ) / ( getNoiseAtChannel ( chipnum, ichan + posclustersize + 1 ) * _seedcut )  ) << " > " << ( ( datavec[ichan] * _polarity ) / seedlevel ) << endl;
-			// two options: if they touch, we simply move the seed position to the right one and inc negativesize, if they don't touch, we split:
-			if ( posclustersize == 1 )
-			{
+		posclustersize += 1;
+		streamlog_out ( DEBUG3 ) << "Found large cluster in event: " << alibavaEvent -> getEventNumber ( ) << endl;
+		// if this happens, we have found a second seed in this cluster with a higher ADC count
+		// since ichan goes to the right, this feature can only be found here.
 
-			    streamlog_out ( DEBUG5 ) << "Moving the seed in event: " << alibavaEvent -> getEventNumber ( ) << endl;
+		// don't compare ACDs, look for ADC/seedlevel
+		const int inext = ichan + posclustersize + 1;
+		if ( ( ( data[inext] * _polarity ) / ( noise[inext] * _seedcut ) ) > ( ( data[ichan] * _polarity ) / seedlevel ) )
+		{
 
-			    // move ichan and negclustersize
-			    ichan++;
-			    negclustersize++;
+		    streamlog_out ( DEBUG4 ) << "Found multiple seeds in a cluster in event " << alibavaEvent -> getEventNumber ( ) << " ... splitting!" << endl;
+		    // two options: if they touch, we simply move the seed position to the right one and inc negativesize, if they don't touch, we split:
+		    if ( posclustersize == 1 )
+		    {
 
-			    // now posclustersize has to go down, since we shifted the cluster seed position 
-			    posclustersize--;
-			}
+			streamlog_out ( DEBUG5 ) << "Moving the seed in event: " << alibavaEvent -> getEventNumber ( ) << endl;
 
-			// if there are clusters below the seed between two seeds, we give them to the highest and split
-			if ( posclustersize >= 2 )
-			{
-			    streamlog_out ( DEBUG5 ) << "Splitting the cluster between seeds in event: " << alibavaEvent -> getEventNumber ( ) << endl;
+			// move ichan and negclustersize
+			ichan++;
+			negclustersize++;
 
-			    // setting this to zero, let the higher seed find the inbetween strip when looping
-			    posclustersize = 0;
-			    posdir = false;
-			}
+			// now posclustersize has to go down, since we shifted the cluster seed position 
+			posclustersize--;
+		    }
 
-			if ( posclustersize >= 3 )
-			{
-			    // just report 
-			    streamlog_out ( WARNING5 ) << "Multiple clusters between seeds in event: " << alibavaEvent -> getEventNumber ( ) << " ! The noise levels could be false!" << endl;
-			}
+		    // if there are clusters below the seed between two seeds, we give them to the highest and split
+		    if ( posclustersize >= 2 )
+		    {
+			streamlog_out ( DEBUG5 ) << "Splitting the cluster between seeds in event: " << alibavaEvent -> getEventNumber ( ) << endl;
 
+			// setting this to zero, let the higher seed find the inbetween strip when looping
+			posclustersize = 0;
+			posdir = false;
 		    }
-		}
-		else
-		{
-		    posdir = false;
+
 		}
 	    }
-
-	    // look left
-	    bool negdir = true;
-	    // does this channel exist?
-	    while ( negdir == true )
+	    else
 	    {
-		// the channel has to fullfill 3 conditions: a) be above cluster level, b) not be masked and c) not be above the seed cut. c) is so that we don't refind clusters after splitting.
-		if ( ( datavec[ichan - negclustersize - 1] * _polarity ) >= ( _clustercut * getNoiseAtChannel ( chipnum, ichan - negclustersize - 1 ) ) && ( isMasked ( chipnum, ichan - negclustersize - 1 ) == false ) && ( datavec[ichan - negclustersize - 1] * _polarity ) < ( _seedcut * getNoiseAtChannel ( chipnum, ichan - negclustersize - 1 ) ) )
-		{
-		    streamlog_out ( DEBUG3 ) << "Found large cluster in event: " << alibavaEvent -> getEventNumber ( ) << endl;
-		    negclustersize += 1;
-		}
-		else
-		{
-		    negdir = false;
-		}
+		posdir = false;
 	    }
+	}
 
-	    // save the cluster information
-	    int lowerlimit = ichan - negclustersize;
-	    int upperlimit = ichan + posclustersize;
-	    int clusize = upperlimit - lowerlimit + 1;
+	// look left: the run of channels passing the left cluster condition next to the cluster
+	negclustersize += runLengthDown ( growLeft, ichan - negclustersize - 1 );
 
-	    // allow a cut on the clustersize
-	    if ( ( clusize >= _clusterminsize ) && ( clusize <= _clustermaxsize ) )
-	    {
+	// save the cluster information
+	int lowerlimit = ichan - negclustersize;
+	int upperlimit = ichan + posclustersize;
+	int clusize = upperlimit - lowerlimit + 1;
 
-		// anything past here is an accepted cluster
-		streamlog_out ( DEBUG5 ) << "Found a cluster in event: " << alibavaEvent -> getEventNumber ( ) << endl;
+	// allow a cut on the clustersize
+	if ( ( clusize >= _clusterminsize ) && ( clusize <= _clustermaxsize ) )
+	{
 
-		// increment cluster count
-		nClusters++;
+	    // anything past here is an accepted cluster
+	    streamlog_out ( DEBUG5 ) << "Found a cluster in event: " << alibavaEvent -> getEventNumber ( ) << endl;
 
-		// debug output
-		if ( clusize > 1 )
-		{
-		    streamlog_out ( DEBUG4 ) << "Clustersize: " << clusize << endl;
-		}
+	    // increment cluster count
+	    nClusters++;
 
-		// fill the clusterNumber vector with the position of the individual clusters
-		for ( int icluster = lowerlimit; icluster <= upperlimit; icluster++ )
-		{
-		    clusterNumber.at ( icluster ) = nClusters;
-		    streamlog_out ( DEBUG3 ) << "Wrote cluster to clusterNumber at position(s): " <<  icluster << endl;
-		}
+	    // debug output
+	    if ( clusize > 1 )
+	    {
+		streamlog_out ( DEBUG4 ) << "Clustersize: " << clusize << endl;
+	    }
+
+	    // fill the clusterNumber vector with the position of the individual clusters
+	    for ( int icluster = lowerlimit; icluster <= upperlimit; icluster++ )
+	    {
+		clusterNumber.at ( icluster ) = nClusters;
+		streamlog_out ( DEBUG3 ) << "Wrote cluster to clusterNumber at position(s): " <<  icluster << endl;
+	    }
+
+	    // record the charge to the left and right of the seed to spot asymetries:
+	    if ( isChannelSet ( used, ichan - 2 ) && isChannelSet ( used, ichan - 1 ) && isChannelSet ( used, ichan + 1 ) && isChannelSet ( used, ichan + 2 ) )
+	    {
+		_clustercharge[0] += fabs ( data[ichan - 2] );
+		_clustercharge[1] += fabs ( data[ichan - 1] );
+		_clustercharge[2] += fabs ( data[ichan] );
+		_clustercharge[3] += fabs ( data[ichan + 1] );
+		_clustercharge[4] += fabs ( data[ichan + 2] );
+		fillChargeDistHisto ( data[ichan - 3] * _polarity, data[ichan - 2] * _polarity, data[ichan - 1] * _polarity, data[ichan] * _polarity, data[ichan + 1] * _polarity, data[ichan + 2] * _polarity, data[ichan + 3] * _polarity );
+	    }
 
-		// record the charge to the left and right of the seed to spot asymetries:
-		if ( isMasked ( chipnum, ichan - 2 ) == false && isMasked ( chipnum, ichan - 1 ) == false && isMasked ( chipnum, ichan + 1 ) == false && isMasked ( chipnum, ichan + 2 ) == false )
+	    // let's calculate the eta distribution, only works for clustersize >1
+	    // actually this is not the official definition of eta, but this helps nonetheless
+	    if ( clusize > 1 )
+	    {
+		float etaleft = 0;
+		float etaright = 0;
+		float cogpos = 0;
+		float totalsignal = 0;
+		float weight = 0;
+		for ( int i = lowerlimit; i <= upperlimit; i++ )
 		{
-		    _clustercharge[0] += fabs ( datavec[ichan - 2] );
-		    _clustercharge[1] += fabs ( datavec[ichan - 1] );
-		    _clustercharge[2] += fabs ( datavec[ichan] );
-		    _clustercharge[3] += fabs ( datavec[ichan + 1] );
-		    _clustercharge[4] += fabs ( datavec[ichan + 2] );
-		    fillChargeDistHisto ( datavec[ichan - 3] * _polarity, datavec[ichan - 2] * _polarity, datavec[ichan - 1] * _polarity, datavec[ichan] * _polarity, datavec[ichan + 1] * _polarity, datavec[ichan + 2] * _polarity, datavec[ichan + 3] * _polarity );
+		    totalsignal += fabs ( data[i] );
+		    weight += fabs ( data[i] * i );
 		}
-
-		// let's calculate the eta distribution, only works for clustersize >1
-		// actually this is not the official definition of eta, but this helps nonetheless
-		if ( clusize > 1 )
+		cogpos = weight / totalsignal;
+		for ( int j = lowerlimit; j <= upperlimit; j++ )
 		{
-		    float etaleft = 0;
-		    float etaright = 0;
-		    float cogpos = 0;
-		    float totalsignal = 0;
-		    float weight = 0;
-		    for ( int i = lowerlimit; i <= upperlimit; i++ )
-		    {
-			totalsignal += fabs ( datavec[i] );
-			weight += fabs ( datavec[i] * i );
-		    }
-		    cogpos = weight / totalsignal;
-		    for ( int j = lowerlimit; j <= upperlimit; j++ )
+		    if ( float ( j ) < cogpos )
 		    {
-			if ( float ( j ) < cogpos )
-			{
-			    etaleft += fabs ( datavec[j] );
-			}
-			else if ( float ( j ) > cogpos )
-			{
-			    etaright += fabs ( datavec[j] );
-			}
+			etaleft += fabs ( data[j] );
 		    }
-		    float etaratio = etaleft / ( etaleft + etaright );
-		    fillEtaHisto ( etaratio );
-
-		    // CoG control plot:
-		    if ( clusize >= 2 )
+		    else if ( float ( j ) > cogpos )
 		    {
-			fillCogHisto ( cogpos - ichan );
+			etaright += fabs ( data[j] );
 		    }
 		}
+		float etaratio = etaleft / ( etaleft + etaright );
+		fillEtaHisto ( etaratio );
 
-		// do the real calculation of eta:
-		// require good channels left and right so we don't bias
-		if ( isMasked ( chipnum, ichan - 1 ) == false && isMasked ( chipnum, ichan + 1 ) == false )
+		// CoG control plot:
+		if ( clusize >= 2 )
 		{
-		    float etaleft_a = 0;
-		    float etaright_a = 0;
-		    float etaleft_b = 0;
-		    float etaright_b = 0;
-		    float etaratio = -1;
+		    fillCogHisto ( cogpos - ichan );
+		}
+	    }
 
-		    // divison by noise can be added by removeing comments
-		    etaleft_a = datavec[ichan - 1] * _polarity;// / getNoiseAtChannel(chipnum,ichan-1);
-		    etaright_a = datavec[ichan] * _polarity;// / getNoiseAtChannel(chipnum,ichan);
+	    // do the real calculation of eta:
+	    // require good channels left and right so we don't bias
+	    if ( isChannelSet ( used, ichan - 1 ) && isChannelSet ( used, ichan + 1 ) )
+	    {
+		float etaleft_a = 0;
+		float etaright_a = 0;
+		float etaleft_b = 0;
+		float etaright_b = 0;
+		float etaratio = -1;
 
-		    etaright_b = datavec[ichan + 1] * _polarity;// / getNoiseAtChannel(chipnum,ichan+1);
-		    etaleft_b = datavec[ichan] * _polarity;// / getNoiseAtChannel(chipnum,ichan);
+		// divison by noise can be added by removeing comments
+		etaleft_a = data[ichan - 1] * _polarity;// / noise[ichan-1];
+		etaright_a = data[ichan] * _polarity;// / noise[ichan];
 
-		    if ( etaleft_a > etaright_b )
-		    {
-			etaratio = etaleft_a / ( etaleft_a + etaright_a );
-			fillEtaHisto2 ( etaratio );
-			fillEtaHisto2TDC ( etaratio, tdc );
-			fillEtaHistoPos ( etaratio, ichan + dchip );
-			streamlog_out ( DEBUG2 ) << "Eta2: left side ratio written: " << etaratio << endl; 
-		    }
-		    else if ( etaright_b > etaleft_a )
-		    {
-			etaratio = etaleft_b / ( etaleft_b + etaright_b );
-			fillEtaHisto2 ( etaratio );
-			fillEtaHisto2TDC ( etaratio, tdc );
-			fillEtaHistoPos ( etaratio, ichan + dchip );
-			streamlog_out ( DEBUG2 ) << "Eta2: right side ratio written:" << etaratio << endl;
-		    }
-		    else
-		    {
-			streamlog_out ( DEBUG2 ) << "Eta2: no eta here (" << alibavaEvent -> getEventNumber ( ) << ") because fail! ela:" << etaleft_a << " era: " << etaright_a << " elb: "<< etaleft_b << " erb: " << etaright_b << endl;
-		    }
-		}
+		etaright_b = data[ichan + 1] * _polarity;// / noise[ichan+1];
+		etaleft_b = data[ichan] * _polarity;// / noise[ichan];
 
-		// fill the cluster signal and snr histos
-		float clustersignal = 0.0;
-		float clusternoise = 0.0;
-		for ( int i = ( lowerlimit ); i <= ( upperlimit ); i++ )
+		if ( etaleft_a > etaright_b )
+		{
+		    etaratio = etaleft_a / ( etaleft_a + etaright_a );
+		    fillEtaHisto2 ( etaratio );
+		    fillEtaHisto2TDC ( etaratio, tdc );
+		    fillEtaHistoPos ( etaratio, ichan + dchip );
+		    streamlog_out ( DEBUG2 ) << "Eta2: left side ratio written: " << etaratio << endl; 
+		}
+		else if ( etaright_b > etaleft_a )
+		{
+		    etaratio = etaleft_b / ( etaleft_b + etaright_b );
+		    fillEtaHisto2 ( etaratio );
+		    fillEtaHisto2TDC ( etaratio, tdc );
+		    fillEtaHistoPos ( etaratio, ichan + dchip );
+		    streamlog_out ( DEBUG2 ) << "Eta2: right side ratio written:" << etaratio << endl;
+		}
+		else
 		{
-		    clustersignal += _polarity * datavec[i];
-		    clusternoise += getNoiseAtChannel ( chipnum, i );
+		    streamlog_out ( DEBUG2 ) << "Eta2: no eta here (" << alibavaEvent -> getEventNumber ( ) << ") because fail! ela:" << etaleft_a << " era: " << etaright_a << " elb: "<< etaleft_b << " erb: " << etaright_b << endl;
 		}
-		fillSignalHisto ( clustersignal );
-		fillSNRHisto ( clustersignal / clusternoise );
+	    }
 
-		// fill the seed charge histogram
-		fillSeedChargeHisto ( _polarity * datavec[ichan] );
+	    // fill the cluster signal and snr histos
+	    float clustersignal = 0.0;
+	    float clusternoise = 0.0;
+	    for ( int i = ( lowerlimit ); i <= ( upperlimit ); i++ )
+	    {
+		clustersignal += _polarity * data[i];
+		clusternoise += noise[i];
+	    }
+	    fillSignalHisto ( clustersignal );
+	    fillSNRHisto ( clustersignal / clusternoise );
 
-		// the overall cluster count in this run
-		_clustercount++;
+	    // fill the seed charge histogram
+	    fillSeedChargeHisto ( _polarity * data[ichan] );
 
-		// fill the clustersize histo
-		fillClusterHisto ( clusize );
+	    // the overall cluster count in this run
+	    _clustercount++;
 
-		// fill the hitmap histogram
-		fillHitmapHisto ( ichan + dchip, negclustersize, posclustersize );
+	    // fill the clustersize histo
+	    fillClusterHisto ( clusize );
 
-		// fill the seed histogram
-		fillSeedHisto ( ichan + dchip );
+	    // fill the hitmap histogram
+	    fillHitmapHisto ( ichan + dchip, negclustersize, posclustersize );
 
-		// final: move the ichan var so that we dont include a seed channel in multiple clusters
-		if ( ( ichan + posclustersize + 1 ) < datavec.size ( ) )
-		{
-		    // this channel is the first one next to a previous cluster and below
-		    // the clustercut so it will fail the  seed check in the next check
-		    ichan = ichan + posclustersize + 1;
-		}
+	    // fill the seed histogram
+	    fillSeedHisto ( ichan + dchip );
 
-	    }
-	    else
+	    // final: move the ichan var so that we dont include a seed channel in multiple clusters
+	    if ( ( ichan + posclustersize + 1 ) < nchan )
 	    {
-		streamlog_out ( DEBUG5 ) << "Failed clustersize cut! Limits are: " << _clusterminsize << " to " << _clustermaxsize << " , this cluster has size: " << clusize << " !" << endl;
-	    } // done clustersize cut
+		// this channel is the first one next to a previous cluster and below
+		// the clustercut so it will fail the  seed check in the next check
+		ichan = ichan + posclustersize + 1;
+	    }
+
+	}
+	else
+	{
+	    streamlog_out ( DEBUG5 ) << "Failed clustersize cut! Limits are: " << _clusterminsize << " to " << _clustermaxsize << " , this cluster has size: " << clusize << " !" << endl;
+	} // done clustersize cut
 
-	} // done going over all seeds
-    } // done going over all channels in this event
+    } // done going over all seeds in this event
 
     // more debug output
     if ( nClusters >= 1 )
@@ -772,7 +866,7 @@ void AlibavaClustering::check ( LCEvent * /* evt */ )
 
 void AlibavaClustering::fillclusterspereventhisto ( int clusters, int event )
 {
-    if ( TH2D * histo = dynamic_cast < TH2D* > ( _rootObjectMap["ClustersVsEvents"] ) )
+    if ( TH2D * histo = getHistoHandle < TH2D > ( kClustersVsEventsHisto ) )
     {
 	histo -> Fill ( event, clusters );
     }
@@ -780,7 +874,7 @@ void AlibavaClustering::fillclusterspereventhisto ( int clusters, int event )
 
 void AlibavaClustering::fillHitmapHisto ( int ichan, int negclustersize, int posclustersize )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["ClusterHitmap"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kClusterHitmapHisto ) )
     {
 	for ( int i = ( ichan - negclustersize ); i <= ( ichan + posclustersize ); i++ )
 	{
@@ -791,7 +885,7 @@ void AlibavaClustering::fillHitmapHisto ( int ichan, int negclustersize, int pos
 
 void AlibavaClustering::fillClusterHisto ( int clusize )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["ClusterSize"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kClusterSizeHisto ) )
     {
 	histo -> Fill ( clusize );
     }
@@ -799,7 +893,7 @@ void AlibavaClustering::fillClusterHisto ( int clusize )
 
 void AlibavaClustering::fillEtaHisto ( float etaratio )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["ClusterCOGEta"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kClusterCOGEtaHisto ) )
     {
 	histo -> Fill ( etaratio );
     }
@@ -807,7 +901,7 @@ void AlibavaClustering::fillEtaHisto ( float etaratio )
 
 void AlibavaClustering::fillEtaHisto2(float etaratio)
 {
-	if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["EtaDistribution"] ) )
+	if ( TH1D * histo = getHistoHandle < TH1D > ( kEtaHisto ) )
 	{
 		histo->Fill(etaratio);
 	}
@@ -815,7 +909,7 @@ void AlibavaClustering::fillEtaHisto2(float etaratio)
 
 void AlibavaClustering::fillEtaHisto2TDC ( float etaratio, float tdc )
 {
-    if ( TH2D * histo = dynamic_cast < TH2D* > ( _rootObjectMap["EtaDistributionTDC"] ) )
+    if ( TH2D * histo = getHistoHandle < TH2D > ( kEtaTDCHisto ) )
     {
 	histo -> Fill ( etaratio, tdc );
     }
@@ -823,7 +917,7 @@ void AlibavaClustering::fillEtaHisto2TDC ( float etaratio, float tdc )
 
 void AlibavaClustering::fillEtaHistoPos ( float etaratio, int ichan )
 {
-    if ( TH2D * histo = dynamic_cast < TH2D* > ( _rootObjectMap["EtaDistributionPos"] ) )
+    if ( TH2D * histo = getHistoHandle < TH2D > ( kEtaPosHisto ) )
     {
 	histo -> Fill ( etaratio, ichan );
     }
@@ -831,7 +925,7 @@ void AlibavaClustering::fillEtaHistoPos ( float etaratio, int ichan )
 
 void AlibavaClustering::fillSeedHisto ( int ichan )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SeedHitmap"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kSeedHitmapHisto ) )
     {
 	histo -> Fill ( ichan );
     }
@@ -839,7 +933,7 @@ void AlibavaClustering::fillSeedHisto ( int ichan )
 
 void AlibavaClustering::fillChargeDistHisto (float a, float b, float c, float d, float e, float f, float g )
 {
-    if ( TH2D * histo = dynamic_cast < TH2D* > ( _rootObjectMap["NeighbourChargeDistribution"] ) )
+    if ( TH2D * histo = getHistoHandle < TH2D > ( kNeighbourChargeHisto ) )
     {
 	histo -> Fill ( -3.0, a / d );
 	histo -> Fill ( -2.0, b / d );
@@ -850,32 +944,32 @@ void AlibavaClustering::fillChargeDistHisto (float a, float b, float c, float d,
 	histo -> Fill ( 3.0, g / d );
     }
 
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SignalLeft2"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kSignalLeft2Histo ) )
     {
 	histo -> Fill ( b / d );
     }
 
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SignalLeft1"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kSignalLeft1Histo ) )
     {
 	histo -> Fill ( c / d );
     }
 
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SignalRight1"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kSignalRight1Histo ) )
     {
 	histo -> Fill ( e / d );
     }
 
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SignalRight2"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kSignalRight2Histo ) )
     {
 	histo -> Fill ( f / d );
     }
 
     // also fill some alternative histos: see thesis of Erik Butz
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["ZetaHisto"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kZetaHisto ) )
     {
 	histo -> Fill ( ( c + e ) / ( c + d + e ) );
     }
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SigmaHisto"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kSigmaHisto ) )
     {
 	histo -> Fill ( ( c + e ) / ( 2 * d ) );
     }
@@ -883,7 +977,7 @@ void AlibavaClustering::fillChargeDistHisto (float a, float b, float c, float d,
 
 void AlibavaClustering::fillSignalHisto ( float signal )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SignalfromClusters"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kClusterSignalHisto ) )
     {
 	histo -> Fill ( signal );
     }
@@ -891,7 +985,7 @@ void AlibavaClustering::fillSignalHisto ( float signal )
 
 void AlibavaClustering::fillSNRHisto ( float signal )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SNRfromClusters"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kClusterSNRHisto ) )
     {
 	histo -> Fill ( signal );
     }
@@ -899,7 +993,7 @@ void AlibavaClustering::fillSNRHisto ( float signal )
 
 void AlibavaClustering::fillSeedChargeHisto ( float signal )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["SignalfromSeeds"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kSeedSignalHisto ) )
     {
 	histo -> Fill ( signal );
     }
@@ -907,7 +1001,7 @@ void AlibavaClustering::fillSeedChargeHisto ( float signal )
 
 void AlibavaClustering::fillCogHisto ( float cog )
 {
-    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap["RelativeCoGPosition"] ) )
+    if ( TH1D * histo = getHistoHandle < TH1D > ( kRelativeCoGHisto ) )
     {
 	histo -> Fill ( cog );
     }
@@ -1000,9 +1094,10 @@ void AlibavaClustering::fillHistos ( )
 void AlibavaClustering::bookHistos ( )
 {
     AIDAProcessor::tree ( this ) -> cd ( this -> name ( ) );
+    resetHistoHandles ( kNoOfHistoKinds );
 
     TH2D * cluevent = new TH2D ( "ClustersVsEvents", "", 5000, 0, 500000, 10, 0, 9 );
-    _rootObjectMap.insert ( make_pair ( "ClustersVsEvents", cluevent ) );
+    registerHistoHandle ( "ClustersVsEvents", cluevent, kClustersVsEventsHisto );
     cluevent -> SetTitle ( "Clusters per Event vs. Event Nr;Event Nr.;Clusters in this Event");
 
     // a histogram showing the clustersize
@@ -1011,7 +1106,7 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle << tempHistoName << ";Clustersize;NumberofEntries";
 
     TH1D * clusterHisto = new TH1D ( tempHistoName.c_str ( ), "", 4, 1, 5 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName, clusterHisto ) );
+    registerHistoHandle ( tempHistoName, clusterHisto, kClusterSizeHisto );
     string tmp_string = tempHistoTitle.str ( );
     clusterHisto -> SetTitle ( tmp_string.c_str ( ) );
 
@@ -1021,7 +1116,7 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle2 << tempHistoName2 << ";Eta;NumberofEntries";
 
     TH1D * etaHisto = new TH1D ( tempHistoName2.c_str ( ), "", 100, 0, 1 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName2, etaHisto ) );
+    registerHistoHandle ( tempHistoName2, etaHisto, kClusterCOGEtaHisto );
     string tmp_string2 = tempHistoTitle2.str ( );
     etaHisto -> SetTitle ( tmp_string2.c_str ( ) );
 
@@ -1031,7 +1126,7 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle3 << tempHistoName3 << ";Channel;NumberofEntries";
 
     TH1D * hitmapHisto = new TH1D ( tempHistoName3.c_str ( ), "", 256, 0, 255 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName3, hitmapHisto ) );
+    registerHistoHandle ( tempHistoName3, hitmapHisto, kClusterHitmapHisto );
     string tmp_string3 = tempHistoTitle3.str ( );
     hitmapHisto -> SetTitle ( tmp_string3.c_str ( ) );
 
@@ -1041,18 +1136,18 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle4 << tempHistoName4 << ";Channel;NumberofEntries";
 
     TH1D * seedHisto = new TH1D ( tempHistoName4.c_str ( ), "", 256, 0, 255 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName4, seedHisto ) );
+    registerHistoHandle ( tempHistoName4, seedHisto, kSeedHitmapHisto );
     string tmp_string4 = tempHistoTitle4.str ( );
     seedHisto -> SetTitle ( tmp_string4.c_str ( ) );
 
     // a histogram showing the eta distribution - alternative calculation
     TH1D * etaintegral = new TH1D ( "EtaDistributionIntegral", "", 120, -1, 2 );
-    _rootObjectMap.insert ( make_pair ( "EtaDistributionIntegral", etaintegral ) );
+    registerHistoHandle ( "EtaDistributionIntegral", etaintegral, kEtaIntegralHisto );
     etaintegral -> SetTitle ( "Eta Distribution Integral;Eta;NumberofEntries" );
 
     // an integral over this plot
     TH1D * etaHisto2 = new TH1D ( "EtaDistribution", "", 120, -1, 2 );
-    _rootObjectMap.insert ( make_pair ( "EtaDistribution", etaHisto2 ) );
+    registerHistoHandle ( "EtaDistribution", etaHisto2, kEtaHisto );
     etaHisto2 -> SetTitle ( "Eta Distribution;Eta;NumberofEntries" );
 
     // two fits for this eta plot
@@ -1068,7 +1163,7 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle6 << tempHistoName6 << ";Distance to seed;Strip charge / Seed charge";
 
     TH2D * chargehisto = new TH2D ( tempHistoName6.c_str ( ), "", 7, -3.5, 3.5, 1000, -1, 1 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName6, chargehisto ) );
+    registerHistoHandle ( tempHistoName6, chargehisto, kNeighbourChargeHisto );
     string tmp_string6 = tempHistoTitle6.str ( );
     chargehisto -> SetTitle ( tmp_string6.c_str ( ) );
 
@@ -1078,7 +1173,7 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle7 << tempHistoName7 << ";Cluster signal (ADCs) * (-1);Number of Entries";
 
     TH1D * clustersignalhisto = new TH1D ( tempHistoName7.c_str ( ), "", 1000, 0, 100 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName7, clustersignalhisto ) );
+    registerHistoHandle ( tempHistoName7, clustersignalhisto, kClusterSignalHisto );
     string tmp_string7 = tempHistoTitle7.str ( );
     clustersignalhisto -> SetTitle ( tmp_string7.c_str ( ) );
 
@@ -1088,7 +1183,7 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle8 << tempHistoName8 << ";Cluster SNR;Number of Entries";
 
     TH1D * clustersnrhisto = new TH1D ( tempHistoName8.c_str ( ), "", 500, 0, 50 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName8, clustersnrhisto ) );
+    registerHistoHandle ( tempHistoName8, clustersnrhisto, kClusterSNRHisto );
     string tmp_string8 = tempHistoTitle8.str ( );
     clustersnrhisto -> SetTitle ( tmp_string8.c_str ( ) );
 
@@ -1098,40 +1193,40 @@ void AlibavaClustering::bookHistos ( )
     tempHistoTitle9 << tempHistoName9 << ";Seed charge (ADCs) * (-1);Number of Entries";
 
     TH1D * seedchargehisto = new TH1D ( tempHistoName9.c_str ( ), "", 1000, 0, 100 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName9, seedchargehisto ) );
+    registerHistoHandle ( tempHistoName9, seedchargehisto, kSeedSignalHisto );
     string tmp_string9 = tempHistoTitle9.str ( );
     seedchargehisto -> SetTitle ( tmp_string9.c_str ( ) );
 
     // a cog control plot
     TH1D * cogplot = new TH1D ( "RelativeCoGPosition", "", 1000, -2, 2 );
-    _rootObjectMap.insert ( make_pair ( "RelativeCoGPosition", cogplot ) );
+    registerHistoHandle ( "RelativeCoGPosition", cogplot, kRelativeCoGHisto );
     cogplot -> SetTitle ( "Relative CoG Position;Relative CoG;Number of Entries" );
 
     // eta vs tdc
     TH2D * etatdc = new TH2D ( "EtaDistributionTDC", "", 100, 0, 1, 20, 0, 100 );
-    _rootObjectMap.insert ( make_pair ( "EtaDistributionTDC", etatdc ) );
+    registerHistoHandle ( "EtaDistributionTDC", etatdc, kEtaTDCHisto );
     etatdc -> SetTitle ( "Eta distribution vs. Event TDC;Eta;TDC time [ns]" );
 
     // eta vs pos
     TH2D * etapos = new TH2D ( "EtaDistributionPos", "", 100, 0, 1, 256, 0, 255 );
-    _rootObjectMap.insert ( make_pair ( "EtaDistributionPos", etapos ) );
+    registerHistoHandle ( "EtaDistributionPos", etapos, kEtaPosHisto );
     etapos -> SetTitle ( "Eta distribution vs. Seed Position;Eta;Seed Strip" );
 
     // charge distribution plots for 2 neighbours left and right of a seed
     TH1D * neighbour2left = new TH1D ( "SignalLeft2", "", 100, -2, 2 );
-    _rootObjectMap.insert ( make_pair ( "SignalLeft2", neighbour2left ) );
+    registerHistoHandle ( "SignalLeft2", neighbour2left, kSignalLeft2Histo );
     neighbour2left -> SetTitle ( "Signal Left 2;Relative Charge to Seed;Number of Entries" );
 
     TH1D * neighbour1left = new TH1D ( "SignalLeft1", "", 100, -2, 2 );
-    _rootObjectMap.insert ( make_pair ( "SignalLeft1", neighbour1left ) );
+    registerHistoHandle ( "SignalLeft1", neighbour1left, kSignalLeft1Histo );
     neighbour1left -> SetTitle ( "Signal Left 1;Relative Charge to Seed;Number of Entries" );
 
     TH1D * neighbour1right = new TH1D ("SignalRight1", "", 100, -2, 2 );
-    _rootObjectMap.insert ( make_pair ( "SignalRight1", neighbour1right ) );
+    registerHistoHandle ( "SignalRight1", neighbour1right, kSignalRight1Histo );
     neighbour1right -> SetTitle ( "Signal Right 1;Relative Charge to Seed;Number of Entries" );
 
     TH1D * neighbour2right = new TH1D ( "SignalRight2", "", 100, -2, 2 );
-    _rootObjectMap.insert ( make_pair ( "SignalRight2", neighbour2right ) );
+    registerHistoHandle ( "SignalRight2", neighbour2right, kSignalRight2Histo );
     neighbour2right-> SetTitle ( "Signal Right 2;Relative Charge to Seed;Number of Entries" );
 
     TF1 * nl2 = new TF1 ( "Signal Left 2 Fit", "gaus" );
@@ -1147,11 +1242,11 @@ void AlibavaClustering::bookHistos ( )
     _rootObjectMap.insert ( make_pair ( "Signal Right 2 Fit", nr2 ) );
 
     TH1D * zetahisto = new TH1D ( "ZetaHisto", "", 600, -3, 3 );
-    _rootObjectMap.insert ( make_pair ( "ZetaHisto", zetahisto ) );
+    registerHistoHandle ( "ZetaHisto", zetahisto, kZetaHisto );
     zetahisto -> SetTitle ( "Zeta Distribution;Zeta;Number of Entries" );
 
     TH1D * sigmahisto = new TH1D ( "SigmaHisto", "", 600, -3, 3 );
-    _rootObjectMap.insert ( make_pair ( "SigmaHisto", sigmahisto ) );
+    registerHistoHandle ( "SigmaHisto", sigmahisto, kSigmaHisto );
     sigmahisto -> SetTitle ( "Sigma Distribution;Sigma;Number of Entries" );
 
     streamlog_out ( MESSAGE1 )  << "End of Booking histograms. " << endl;
@@ -0,0 +1,190 @@
+/*
+ *  Common mode kernel for the Alibava chips
+ */
+
+// alibava includes ".h"
+#include "ALIBAVA.h"
+#include "AlibavaCommonModeKernel.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+
+// system includes <>
+#include <cmath>
+
+using namespace std;
+using namespace lcio;
+using namespace alibava;
+
+AlibavaCommonModeKernel::AlibavaCommonModeKernel ( ) :
+_weight ( ),
+_channel ( ),
+_channelSquare ( ),
+_data ( ),
+_mean ( 0 ),
+_sigma ( 0 ),
+_offset ( 0 ),
+_slope ( 0 )
+{
+    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+    {
+	_channel[ichan] = ichan;
+	_channelSquare[ichan] = ichan * ichan;
+    }
+    clearMask ( );
+}
+
+void AlibavaCommonModeKernel::clearMask ( )
+{
+    for ( int ichip = 0; ichip < ALIBAVA::NOOFCHIPS; ichip++ )
+    {
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	{
+	    _weight[ichip][ichan] = 1.0;
+	}
+    }
+}
+
+void AlibavaCommonModeKernel::setMasked ( int chipnum, int ichan, bool masked )
+{
+    if ( chipnum >= 0 && chipnum < ALIBAVA::NOOFCHIPS && ichan >= 0 && ichan < ALIBAVA::NOOFCHANNELS )
+    {
+	_weight[chipnum][ichan] = masked ? 0.0 : 1.0;
+    }
+}
+
+void AlibavaCommonModeKernel::calculate ( int chipnum, const FloatVec & datavec, int noOfIterations, float noiseDeviation )
+{
+    _mean = 0;
+    _sigma = 0;
+    _offset = 0;
+    _slope = 0;
+
+    // Load the chip into the block. Masked channels, channels missing in the data
+    // and chips without a mask row are handled by the weight only.
+    const bool validChip = ( chipnum >= 0 && chipnum < ALIBAVA::NOOFCHIPS );
+    const int nchan = int ( datavec.size ( ) ) < ALIBAVA::NOOFCHANNELS ? int ( datavec.size ( ) ) : ALIBAVA::NOOFCHANNELS;
+    double weight[ALIBAVA::NOOFCHANNELS];
+    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+    {
+	weight[ichan] = 0.0;
+	_data[ichan] = 0.0;
+	if ( ichan < nchan )
+	{
+	    weight[ichan] = validChip ? _weight[chipnum][ichan] : 1.0;
+	    _data[ichan] = datavec[ichan];
+	}
+    }
+
+    for ( int i = 0; i < noOfIterations; i++ )
+    {
+	// partial sums, one per lane, so that the loop body has no dependency between neighbouring channels
+	double count[NOOFLANES] = { };
+	double total[NOOFLANES] = { };
+	double totalSquare[NOOFLANES] = { };
+	double channelcount[NOOFLANES] = { };
+	double channelcountSquare[NOOFLANES] = { };
+	double chanSig[NOOFLANES] = { };
+
+	const double mean = _mean;
+	const double sigma = _sigma;
+	const bool firstIteration = ( i == 0 );
+
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan += NOOFLANES )
+	{
+	    for ( int lane = 0; lane < NOOFLANES; lane++ )
+	    {
+		const double sig = _data[ichan + lane];
+
+		// First iteration: take everything, afterwards exclude outliers.
+		// Same expression as the channel loop this replaces, so that the selection does not change.
+		const bool inside = firstIteration || ( fabs ( ( sig - mean ) / sigma ) < noiseDeviation );
+		const double w = inside ? weight[ichan + lane] : 0.0;
+		const double s = ( w != 0.0 ) ? sig : 0.0;
+
+		count[lane] += w;
+		total[lane] += s;
+		totalSquare[lane] += s * s;
+		channelcount[lane] += w * _channel[ichan + lane];
+		channelcountSquare[lane] += w * _channelSquare[ichan + lane];
+		chanSig[lane] += s * _channel[ichan + lane];
+	    }
+	}
+
+	double n = 0, total_signal = 0, total_signal_square = 0, cc = 0, ccs = 0, cs = 0;
+	for ( int lane = 0; lane < NOOFLANES; lane++ )
+	{
+	    n += count[lane];
+	    total_signal += total[lane];
+	    total_signal_square += totalSquare[lane];
+	    cc += channelcount[lane];
+	    ccs += channelcountSquare[lane];
+	    cs += chanSig[lane];
+	}
+
+	// slope corrections: commonmode = a + b * channr.
+	const double delta = n * ccs - cc * cc;
+	_offset = ( ccs * total_signal - cc * cs ) / delta;
+	_slope = ( n * cs - cc * total_signal ) / delta;
+
+	// standard deviation = SQRT( E[x^2] - E[x]^2 )
+	if ( n > 0 )
+	{
+	    _mean = total_signal / n;
+	    _sigma = sqrt ( total_signal_square / n - _mean * _mean );
+	}
+    }
+}
+
+void AlibavaCommonModeKernel::fillCommonMode ( bool useSlope, FloatVec & commonmodeVec ) const
+{
+    commonmodeVec.resize ( ALIBAVA::NOOFCHANNELS );
+    float * out = commonmodeVec.data ( );
+    if ( useSlope )
+    {
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	{
+	    out[ichan] = float ( _offset + _slope * _channel[ichan] );
+	}
+    }
+    else
+    {
+	const float mean = float ( _mean );
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	{
+	    out[ichan] = mean;
+	}
+    }
+}
+
+void AlibavaCommonModeKernel::subtract ( int chipnum, const FloatVec & datavec, const FloatVec & commonmodeVec, FloatVec & out ) const
+{
+    out.assign ( datavec.size ( ), 0.0f );
+
+    size_t nchan = datavec.size ( ) < commonmodeVec.size ( ) ? datavec.size ( ) : commonmodeVec.size ( );
+    if ( nchan > size_t ( ALIBAVA::NOOFCHANNELS ) )
+    {
+	nchan = ALIBAVA::NOOFCHANNELS;
+    }
+
+    const bool validChip = ( chipnum >= 0 && chipnum < ALIBAVA::NOOFCHIPS );
+    const float * data = datavec.data ( );
+    const float * cmmd = commonmodeVec.data ( );
+    float * result = out.data ( );
+
+    if ( validChip )
+    {
+	const double * weight = _weight[chipnum];
+	for ( size_t ichan = 0; ichan < nchan; ichan++ )
+	{
+	    result[ichan] = ( weight[ichan] != 0.0 ) ? data[ichan] - cmmd[ichan] : 0.0f;
+	}
+    }
+    else
+    {
+	for ( size_t ichan = 0; ichan < nchan; ichan++ )
+	{
+	    result[ichan] = data[ichan] - cmmd[ichan];
+	}
+    }
+}
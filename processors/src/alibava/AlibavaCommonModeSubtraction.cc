@@ -54,7 +54,8 @@ using namespace alibava;
 AlibavaCommonModeSubtraction::AlibavaCommonModeSubtraction ( ) : AlibavaBaseProcessor ( "AlibavaCommonModeSubtraction" ),
 _commonmodeCollectionName ( ALIBAVA::NOTSET ),
 _commonmodeerrorCollectionName ( ALIBAVA::NOTSET ),
-_chanDataHistoName ( "Common_and_Pedestal_subtracted_data_channel" )
+_chanDataHistoName ( "Common_and_Pedestal_subtracted_data_channel" ),
+_commonModeKernel ( )
 {
 
     // modify processor description
@@ -109,6 +110,17 @@ void AlibavaCommonModeSubtraction::processRunHeader ( LCRunHeader * rdr )
     // set channels to be used (if it is defined)
     setChannelsToBeUsed ( );
 
+    // copy the channel masks of the selected chips into the common mode kernel
+    _commonModeKernel.clearMask ( );
+    EVENT::IntVec chipSelection = getChipSelection ( );
+    for ( unsigned int i = 0; i < chipSelection.size ( ); i++ )
+    {
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	{
+	    _commonModeKernel.setMasked ( chipSelection[i], ichan, isMasked ( chipSelection[i], ichan ) );
+	}
+    }
+
     // if you want
     bookHistos ( );
 
@@ -165,10 +177,8 @@ void AlibavaCommonModeSubtraction::processEvent ( LCEvent * anEvent )
 		// set chip number for newdataImpl
 		chipIDEncoder[ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] = chipnum;
 		chipIDEncoder.setCellID ( newdataImpl );
-		FloatVec datavec, cmmdvec, newdatavec;
-		datavec = dataImpl -> getChargeValues ( );
-		cmmdvec = cmmdImpl -> getChargeValues ( );
-		newdatavec.clear ( );
+		const FloatVec & datavec = dataImpl -> getChargeValues ( );
+		const FloatVec & cmmdvec = cmmdImpl -> getChargeValues ( );
 		// check size of data sets are equal to ALIBAVA::NOOFCHANNELS
 		if ( int ( datavec.size ( ) ) != ALIBAVA::NOOFCHANNELS )
 		{
@@ -179,21 +189,9 @@ void AlibavaCommonModeSubtraction::processEvent ( LCEvent * anEvent )
 		    streamlog_out ( ERROR5 ) << "Number of channels in common mode data is not equal to ALIBAVA::NOOFCHANNELS! " << endl;
 		}
 
-		// now subtract common mode values from all channels
-		for ( size_t ichan = 0; ichan < datavec.size ( ); ichan++ )
-		{
-		    if ( isMasked ( chipnum, ichan ) )
-		    {
-			newdatavec.push_back ( 0 );
-			continue;
-		    }
-
-		    float newdata = datavec[ichan] - cmmdvec[ichan];
-
-		    //store it in new data vector
-		    newdatavec.push_back ( newdata );
-		}
-		newdataImpl -> setChargeValues ( newdatavec );
+		// now subtract common mode values from all channels, masked channels are set to 0.
+		// The result is written directly into the charge vector of the new data.
+		_commonModeKernel.subtract ( chipnum, datavec, cmmdvec, newdataImpl -> chargeValues ( ) );
 		newColVec -> push_back ( newdataImpl );
 		fillHistos ( newdataImpl );
 	    }
@@ -225,25 +223,29 @@ void AlibavaCommonModeSubtraction::end ( )
 void AlibavaCommonModeSubtraction::fillHistos ( TrackerDataImpl * trkdata )
 {
     // Fill the histograms with the corrected data
-    FloatVec datavec;
-    datavec = trkdata -> getChargeValues ( );
+    const FloatVec & datavec = trkdata -> getChargeValues ( );
     int chipnum = getChipNum ( trkdata );
+    int nchan = int ( datavec.size ( ) );
+    if ( nchan > ALIBAVA::NOOFCHANNELS )
+    {
+	nchan = ALIBAVA::NOOFCHANNELS;
+    }
+
+    TH1D * signalHisto = getHistoHandle < TH1D > ( kSignalHisto );
 
-    for ( size_t ichan = 0 ; ichan < datavec.size ( ) ; ichan++ )
+    for ( int ichan = 0 ; ichan < nchan ; ichan++ )
     {
 	if ( isMasked ( chipnum, ichan ) )
 	{
 	    continue;
 	}
-	string tempHistoName = getChanDataHistoName ( chipnum, ichan );
-	if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap[tempHistoName] ) )
+	if ( TH1D * histo = getHistoHandle < TH1D > ( kChanDataHisto, chipnum, ichan ) )
 	{
 	    histo -> Fill ( datavec[ichan] );
 	}
-	string tempHistoName1 = getSignalCorrectionName ( );
-	if ( TH1D * histo1 = dynamic_cast < TH1D* > ( _rootObjectMap[tempHistoName1] ) )
+	if ( signalHisto )
 	{
-	    histo1 -> Fill ( datavec[ichan] );
+	    signalHisto -> Fill ( datavec[ichan] );
 	}
     }
 }
@@ -266,6 +268,7 @@ void AlibavaCommonModeSubtraction::bookHistos ( )
 {
 
     string tempHistoName;
+    resetHistoHandles ( kNoOfHistoKinds );
 
     // a histogram showing the corrected signals
     tempHistoName = getSignalCorrectionName ( );
@@ -273,7 +276,7 @@ void AlibavaCommonModeSubtraction::bookHistos ( )
     tempHistoTitle1 << tempHistoName << ";ADCs;NumberofEntries";
 
     TH1D * signalHisto = new TH1D ( tempHistoName.c_str ( ), "", 2000, -1000, 1000 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName, signalHisto ) );
+    registerHistoHandle ( tempHistoName, signalHisto, kSignalHisto );
     string tmp_string1 = tempHistoTitle1.str ( );
     signalHisto -> SetTitle ( tmp_string1.c_str ( ) );
 
@@ -294,7 +297,7 @@ void AlibavaCommonModeSubtraction::bookHistos ( )
 	    stringstream tempHistoTitle;
 	    tempHistoTitle << tempHistoName << ";ADCs;NumberofEntries";
 	    TH1D * chanDataHisto = new TH1D ( tempHistoName.c_str ( ), "", 2000, -1000, 1000 );
-	    _rootObjectMap.insert ( make_pair ( tempHistoName, chanDataHisto ) );
+	    registerHistoHandle ( tempHistoName, chanDataHisto, kChanDataHisto, chipnum, ichan );
 	    string tmp_string = tempHistoTitle.str ( );
 	    chanDataHisto -> SetTitle ( tmp_string.c_str ( ) );
 	}
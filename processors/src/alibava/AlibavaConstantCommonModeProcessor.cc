@@ -13,6 +13,7 @@
 #include "AlibavaEventImpl.h"
 #include "ALIBAVA.h"
 #include "AlibavaPedNoiCalIOManager.h"
+#include "AlibavaCommonModeKernel.h"
 
 // marlin includes ".h"
 #include "marlin/Processor.h"
@@ -63,7 +64,8 @@ _NoiseDeviation ( 2.5 ),
 _commonmodeHistoName ( "hcommonmode" ),
 _commonmodeerrorHistoName ( "hcommonmodeerror" ),
 _commonmode ( ),
-_commonmodeerror ( )
+_commonmodeerror ( ),
+_commonModeKernel ( )
 {
     // modify processor description
     _description = "AlibavaConstantCommonModeProcessor computes the common mode values of each chip and their errors";
@@ -119,6 +121,17 @@ void AlibavaConstantCommonModeProcessor::processRunHeader ( LCRunHeader * rdr )
     setChipSelection ( arunHeader -> getChipSelection ( ) );
     setChannelsToBeUsed ( );
 
+    // copy the channel masks of the selected chips into the common mode kernel
+    _commonModeKernel.clearMask ( );
+    EVENT::IntVec chipSelection = getChipSelection ( );
+    for ( unsigned int i = 0; i < chipSelection.size ( ); i++ )
+    {
+	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	{
+	    _commonModeKernel.setMasked ( chipSelection[i], ichan, isMasked ( chipSelection[i], ichan ) );
+	}
+    }
+
     bookHistos ( );
 
     // set number of skipped events to zero (defined in AlibavaBaseProcessor)
@@ -209,108 +222,35 @@ void AlibavaConstantCommonModeProcessor::end ( )
 
 void AlibavaConstantCommonModeProcessor::calculateConstantCommonMode ( TrackerDataImpl *trkdata )
 {
-    EVENT::FloatVec commonmodeVec;
-    EVENT::FloatVec commonmodeerrorVec;
-
-    FloatVec datavec;
-    datavec = trkdata -> getChargeValues ( );
+    const FloatVec & datavec = trkdata -> getChargeValues ( );
 
     int chipnum = getChipNum ( trkdata );
 
     streamlog_out ( DEBUG0 ) << "Chip " << chipnum << " of " << getNumberOfChips ( ) << ", now iterating..." << endl;
 
-    double sig = 0, tmpdouble = 0;
-    double mean_signal = 0;
-    double sigma_mean_signal = 0;
-    double delta = 0;
-    double a = 0;
-    double b = 0;
-
-    for ( int i = 0; i < _Niteration; i++ )
-    {
-	int nchan = 0;
-	double total_signal = 0;
-	double total_signal_square = 0;
-	double channelcount = 0;
-	double channelcount_square = 0;
-	double chan_sig = 0;
-
-	// find mean value of signals
-	for ( int ichan = 0; ichan < int ( datavec.size ( ) ); ichan++ )
-	{
-	    if ( isMasked ( chipnum, ichan ) )
-	    {
-		continue;
-	    }
-
-	    sig = datavec[ichan];
-
-	    // First iteration: take everything
-	    if ( i == 0 )
-	    {
-		total_signal += sig;
-		total_signal_square += sig * sig;
-		nchan++;
-		channelcount += ichan;
-		channelcount_square += ichan * ichan;
-		chan_sig += ichan * sig;
-	    }
-	    else // exclude outliers
-	    {
-		tmpdouble = fabs ( ( sig - mean_signal ) / sigma_mean_signal );
-		if ( tmpdouble < _NoiseDeviation )
-		{
-		    total_signal += sig;
-		    total_signal_square += sig * sig;
-		    nchan++;
-		    channelcount += ichan;
-		    channelcount_square += ichan * ichan;
-		    chan_sig += ichan * sig;
-		}
-	    }
-	} // end of loop over channels
-
-	// slope corrections: commonmode = a + b * channr.
-	delta = nchan * channelcount_square - channelcount * channelcount;
-	a = ( channelcount_square * total_signal - channelcount * chan_sig ) / delta;
-	b = ( nchan * chan_sig - channelcount * total_signal ) / delta;
-
-	streamlog_out ( DEBUG0 ) << "Slop calculation: delta = " << delta << " , a = " << a << " , b = " << b << " !" << endl;
+    // iterative clipped mean, RMS and slope over the unmasked channels
+    _commonModeKernel.calculate ( chipnum, datavec, _Niteration, _NoiseDeviation );
 
-	// here find the deviation from mean value
-	// standard deviation = SQRT( E[x^2] - E[x]^2 )
-	// where E denotes average value
-	if ( nchan > 0 )
-	{
-	    mean_signal = total_signal / nchan;
-	    sigma_mean_signal = sqrt ( total_signal_square / nchan - mean_signal * mean_signal );
-	}
-
-    } // end of iterations
+    double mean_signal = _commonModeKernel.getMean ( );
+    double sigma_mean_signal = _commonModeKernel.getSigma ( );
 
+    streamlog_out ( DEBUG0 ) << "Slope calculation: a = " << _commonModeKernel.getOffset ( ) << " , b = " << _commonModeKernel.getSlope ( ) << " !" << endl;
     streamlog_out ( DEBUG0 ) << "===============================================================================" << endl;
     streamlog_out ( DEBUG0 ) << "Chip " << chipnum << " : CommonModeCorrection = " << mean_signal << ", CommonModeCorrectionError = " << sigma_mean_signal << endl;
 
     streamlog_out ( DEBUG0 ) << "===============================================================================" << endl;
 
-    // Now reloop over all channels and create the output vector. This will be the same for all channels if constant is used, otherwise the slope values are calculated.
-    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+    // Now create the output vector. This will be the same for all channels if constant is used, otherwise the slope values are calculated.
+    if ( _commonmodeMethod == "constant" || _commonmodeMethod == "slope" )
     {
-	if ( _commonmodeMethod == "constant" )
-	{
-	    commonmodeVec.push_back ( mean_signal );
-	    commonmodeerrorVec.push_back ( sigma_mean_signal );
-	}
-
-	if ( _commonmodeMethod == "slope" )
-	{
-	    commonmodeVec.push_back ( a + b * ichan );
-	    commonmodeerrorVec.push_back ( sigma_mean_signal );
-	}
+	_commonModeKernel.fillCommonMode ( _commonmodeMethod == "slope", _commonmode );
+	_commonmodeerror.assign ( ALIBAVA::NOOFCHANNELS, float ( sigma_mean_signal ) );
+    }
+    else
+    {
+	setCommonModeVec ( EVENT::FloatVec ( ) );
+	setCommonModeErrorVec ( EVENT::FloatVec ( ) );
     }
-
-    setCommonModeVec ( commonmodeVec );
-    setCommonModeErrorVec ( commonmodeerrorVec );
 }
 
 string AlibavaConstantCommonModeProcessor::getCommonCorrectionName ( )
@@ -324,25 +264,31 @@ void AlibavaConstantCommonModeProcessor::fillHistos ( TrackerDataImpl * trkdata,
 {
 
     // Fill the histograms with the corrected data
-    FloatVec datavec;
-    datavec = trkdata -> getChargeValues ( );
+    const FloatVec & datavec = trkdata -> getChargeValues ( );
 
     int chipnum = getChipNum ( trkdata );
+    int nchan = int ( datavec.size ( ) );
+    if ( nchan > ALIBAVA::NOOFCHANNELS )
+    {
+	nchan = ALIBAVA::NOOFCHANNELS;
+    }
+
+    TH1D * correctionHisto = getHistoHandle < TH1D > ( kCorrectionHisto );
+    TH2D * correctionEventHisto = getHistoHandle < TH2D > ( kCorrectionEventHisto );
 
-    for ( size_t ichan = 0; ichan < datavec.size ( ); ichan++ )
+    for ( int ichan = 0; ichan < nchan; ichan++ )
     {
 	    if ( isMasked ( chipnum, ichan ) )
 	    {
 		continue;
 	    }
-	    string tempHistoName = getCommonCorrectionName ( );
-	    if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap[tempHistoName] ) )
+	    if ( correctionHisto )
 	    {
-		histo -> Fill ( datavec[ichan] );
+		correctionHisto -> Fill ( datavec[ichan] );
 	    }
-	    if ( TH2D * histo = dynamic_cast < TH2D* > ( _rootObjectMap["Common Mode Correction Values over Events"] ) )
+	    if ( correctionEventHisto )
 	    {
-		histo -> Fill ( event, datavec[ichan] );
+		correctionEventHisto -> Fill ( event, datavec[ichan] );
 	    }
     }
 }
@@ -401,6 +347,7 @@ void AlibavaConstantCommonModeProcessor::bookHistos ( )
     AIDAProcessor::tree ( this ) -> cd ( this -> name ( ) );
 
     string tempHistoName;
+    resetHistoHandles ( kNoOfHistoKinds );
 
     // a histogram showing the corrected signals
     tempHistoName = getCommonCorrectionName ( );
@@ -408,7 +355,7 @@ void AlibavaConstantCommonModeProcessor::bookHistos ( )
     tempHistoTitle << tempHistoName << ";ADCs;NumberofEntries";
 
     TH1D * signalHisto = new TH1D ( tempHistoName.c_str ( ), "", 1000, -500, 500 );
-    _rootObjectMap.insert ( make_pair ( tempHistoName, signalHisto ) );
+    registerHistoHandle ( tempHistoName, signalHisto, kCorrectionHisto );
     string tmp_string = tempHistoTitle.str ( );
     signalHisto -> SetTitle ( tmp_string.c_str ( ) );
 
@@ -417,7 +364,7 @@ void AlibavaConstantCommonModeProcessor::bookHistos ( )
     tempHistoTitle2 << "Common Mode Correction Values over Events" << ";ADCs;NumberofEntries";
 
     TH2D * signalHisto2 = new TH2D ( "Common Mode Correction Values over Events", "", 5000, 0, 500000, 1000, -500, 500 );
-    _rootObjectMap.insert ( make_pair ( "Common Mode Correction Values over Events", signalHisto2 ) );
+    registerHistoHandle ( "Common Mode Correction Values over Events", signalHisto2, kCorrectionEventHisto );
     string tmp_string2 = tempHistoTitle2.str ( );
     signalHisto2 -> SetTitle ( tmp_string2.c_str ( ) );
 
@@ -33,6 +33,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cassert>
+#include <cstring>
 #include <memory>
 #include <stdlib.h>
 #include <algorithm>
@@ -51,7 +52,11 @@ _rawChipHeaderCollectionName ( "chipheader" ),
 _chipSelection ( ),
 _startEventNum ( -1 ),
 _stopEventNum ( -1 ),
-_storeHeaderPedestalNoise ( false )
+_storeHeaderPedestalNoise ( false ),
+_readBuffer ( ),
+_bufferPos ( 0 ),
+_bufferEnd ( 0 ),
+_eventBlock ( ALIBAVA::NOOFCHIPS * ( ALIBAVA::CHIPHEADERLENGTH + ALIBAVA::NOOFCHANNELS ) )
 {
     // initialize few variables
     _description = "Reads data streams produced by an ALiBaVa and produces the corresponding LCIO output";
@@ -117,7 +122,7 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 
     //  Open File
     ifstream infile;
-    infile.open ( _fileName.c_str ( ) );
+    infile.open ( _fileName.c_str ( ), ios::in | ios::binary );
     if ( !infile.is_open ( ) )
     {
 	streamlog_out ( ERROR5 ) << "AlibavaConverter could not read the file " << _fileName << " correctly. Please check the path and file names that have been input" << endl;
@@ -128,6 +133,11 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	streamlog_out ( MESSAGE4 ) << "Input file " << _fileName << " is opened!" << endl;
     }
 
+    // the file is read in large blocks and every event is decoded from the read buffer
+    _readBuffer.resize ( READBLOCKSIZE );
+    _bufferPos = 0;
+    _bufferEnd = 0;
+
     time_t date;
     int type;
     unsigned int lheader; // length of the header
@@ -135,17 +145,24 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
     int version; // Alibava firmware version
 
     // Read Header
-    infile.read ( reinterpret_cast < char * > ( &date ), sizeof ( time_t ) );
-    infile.read ( reinterpret_cast < char * > ( &type ), sizeof ( int ) );
+    if ( !ensureBuffered ( infile, sizeof ( time_t ) + sizeof ( int ) + sizeof ( unsigned int ) ) )
+    {
+	streamlog_out ( ERROR5 ) << "AlibavaConverter could not read the header of " << _fileName << endl;
+	return;
+    }
+    date = takeFromBuffer < time_t > ( );
+    type = takeFromBuffer < int > ( );
+    lheader = takeFromBuffer < unsigned int > ( ); //length of header
 
-    header.clear ( );
-    infile.read ( reinterpret_cast < char * > ( &lheader ), sizeof ( unsigned int ) ); //length of header
-    for ( unsigned int ic = 0; ic < lheader; ic++ )
+    // the header string is followed by the header pedestal and noise, NOOFCHIPS * NOOFCHANNELS doubles each
+    const size_t noofHeaderChannels = ALIBAVA::NOOFCHIPS * ALIBAVA::NOOFCHANNELS;
+    if ( !ensureBuffered ( infile, lheader + 2 * noofHeaderChannels * sizeof ( double ) ) )
     {
-	char tmp_c;
-	infile.read ( &tmp_c, sizeof ( char ) );
-	header.append ( 1, tmp_c );
+	streamlog_out ( ERROR5 ) << "AlibavaConverter could not read the header of " << _fileName << endl;
+	return;
     }
+    header.assign ( _readBuffer.data ( ) + _bufferPos, lheader );
+    _bufferPos += lheader;
 
     header = trim_str ( header );
 
@@ -161,22 +178,13 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 
     // Read header pedestal and noise
     // Alibava stores a pedestal and noise set in the run header. These values are not used in te rest of the analysis, so it is optional to store it. By default it will not be stored, but it you want you can set _storeHeaderPedestalNoise variable to true.
-    float tmp_float;
-    FloatVec headerPedestal;
-    FloatVec headerNoise;
+    vector < double > headerValues ( 2 * noofHeaderChannels );
+    memcpy ( headerValues.data ( ), _readBuffer.data ( ) + _bufferPos, headerValues.size ( ) * sizeof ( double ) );
+    _bufferPos += headerValues.size ( ) * sizeof ( double );
 
-    // first pedestal
-    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHIPS * ALIBAVA::NOOFCHANNELS; ichan++ )
-    {
-	infile.read ( reinterpret_cast < char * > ( &tmp_float ), sizeof ( double ) );
-	headerPedestal.push_back ( tmp_float );
-    }
-    // now noise
-    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHIPS * ALIBAVA::NOOFCHANNELS; ichan++ )
-    {
-	infile.read ( reinterpret_cast < char * > ( &tmp_float ), sizeof ( double ) );
-	headerNoise.push_back ( tmp_float );
-    }
+    // first pedestal, then noise
+    FloatVec headerPedestal ( headerValues.begin ( ), headerValues.begin ( ) + noofHeaderChannels );
+    FloatVec headerNoise ( headerValues.begin ( ) + noofHeaderChannels, headerValues.end ( ) );
 
     // Process Header
     LCRunHeaderImpl * arunHeader = new LCRunHeaderImpl ( );
@@ -216,6 +224,13 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	return;
     }
 
+    // event layout after the header code: event size, value, (clock), tdc time, temperature and
+    // one block per chip made of the chip header followed by the channel data
+    const size_t chipBlockLength = ALIBAVA::CHIPHEADERLENGTH + ALIBAVA::NOOFCHANNELS;
+    const size_t eventBlockBytes = _eventBlock.size ( ) * sizeof ( short );
+    const size_t eventBodyBytes = sizeof ( unsigned int ) + sizeof ( double ) + ( version == 3 ? sizeof ( unsigned int ) : 0 )
+	+ sizeof ( unsigned int ) + sizeof ( unsigned short ) + eventBlockBytes;
+
     do
     {
 	if ( eventCounter % 1000 == 0 )
@@ -226,11 +241,11 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	unsigned int headerCode, eventSize, userEventTypeCode = 0, eventTypeCode = 0;
 	do
 	{
-	    infile.read ( reinterpret_cast < char * > ( &headerCode ), sizeof ( unsigned int ) );
-	    if ( infile.bad ( ) || infile.eof ( ) )
+	    if ( !ensureBuffered ( infile, sizeof ( unsigned int ) ) )
 	    {
 		return;
 	    }
+	    headerCode = takeFromBuffer < unsigned int > ( );
 	    eventTypeCode = ( headerCode >> 16 ) & 0xFFFF;
 	}
 	while ( eventTypeCode != 0xcafe );
@@ -244,10 +259,17 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	    return;
 	}
 
-	infile.read ( reinterpret_cast < char * > ( &eventSize ), sizeof ( unsigned int ) );
+	// the whole event is decoded from the buffer in one go, a truncated last event is dropped
+	if ( !ensureBuffered ( infile, eventBodyBytes ) )
+	{
+	    streamlog_out ( WARNING5 ) << "Truncated event found at the end of " << _fileName << ". It is not saved!" << endl;
+	    break;
+	}
+
+	eventSize = takeFromBuffer < unsigned int > ( );
 
 	double value, charge, delay;
-	infile.read ( reinterpret_cast < char * > ( &value ), sizeof ( double ) );
+	value = takeFromBuffer < double > ( );
 
 	//see AlibavaGUI.cc
 	charge = int ( value ) & 0xff;
@@ -255,7 +277,7 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	charge = charge * 1024;
 
 	// timestamp
-	unsigned int clock;
+	unsigned int clock = 0;
 	unsigned int tdcTime;
 	// temperature measured on Daughter board
 	unsigned short temp;
@@ -263,44 +285,24 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	// firmware v3 introduces the clock to the header
 	if ( version == 3 )
 	{
-	    infile.read ( reinterpret_cast < char * > ( &clock ), sizeof ( unsigned int ) );
+	    clock = takeFromBuffer < unsigned int > ( );
 	}
 
-	infile.read ( reinterpret_cast < char * > ( &tdcTime ), sizeof ( unsigned int ) );
-	infile.read ( reinterpret_cast < char * > ( &temp ), sizeof ( unsigned short ) );
-
-	unsigned short chipHeader[2][ALIBAVA::CHIPHEADERLENGTH];
-	short tmp_short;
+	tdcTime = takeFromBuffer < unsigned int > ( );
+	temp = takeFromBuffer < unsigned short > ( );
 
-	// vector for data
-	FloatVec all_data;
-	all_data.reserve ( ALIBAVA::NOOFCHIPS * ALIBAVA::NOOFCHANNELS );
+	// chip headers and data of all chips in a single copy
+	memcpy ( _eventBlock.data ( ), _readBuffer.data ( ) + _bufferPos, eventBlockBytes );
+	_bufferPos += eventBlockBytes;
 
-	// vector for chip header
-	FloatVec all_chipheaders;
-	all_chipheaders.reserve ( ALIBAVA::NOOFCHIPS * ALIBAVA::CHIPHEADERLENGTH );
-
-	// iterate over number of chips
-	FloatVec::iterator it;
 	for ( int ichip = 0; ichip < ALIBAVA::NOOFCHIPS; ichip++ )
 	{
-	    infile.read ( reinterpret_cast < char * > ( chipHeader[ichip] ), ALIBAVA::CHIPHEADERLENGTH * sizeof ( unsigned short ) );
-
-	    // store chip header in all_chipheaders vector
 	    streamlog_out ( DEBUG0 ) << "Chip " << ichip << " Header: " ;
 	    for ( int j = 0; j < ALIBAVA::CHIPHEADERLENGTH; j++ )
 	    {
-		streamlog_out ( DEBUG0 ) << " " << chipHeader[ichip][j];
-		all_chipheaders.push_back ( float ( chipHeader[ichip][j] ) );
+		streamlog_out ( DEBUG0 ) << " " << static_cast < unsigned short > ( _eventBlock[ichip * chipBlockLength + j] );
 	    }
 	    streamlog_out ( DEBUG0 ) << endl;
-
-	    // store data in all_data vector
-	    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
-	    {
-		infile.read ( reinterpret_cast < char * > ( &tmp_short ), sizeof ( unsigned short ) );
-		all_data.push_back ( float ( tmp_short ) );
-	    }
 	}
 
 	// Process Event
@@ -333,26 +335,29 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	// for this to work the _chipselection has to be sorted in ascending order
 	for ( unsigned int ichip = 0; ichip < _chipSelection.size ( ); ichip++ )
 	{
-	    // store raw data
-	    FloatVec chipdata;
-	    chipdata.clear ( );
+	    const short * chipBlock = _eventBlock.data ( ) + _chipSelection[ichip] * chipBlockLength;
 
-	    // separate data for each chip
-	    chipdata.insert ( chipdata.end ( ), all_data.begin ( ) + _chipSelection[ichip] * ALIBAVA::NOOFCHANNELS, all_data.begin ( ) + ( _chipSelection[ichip] + 1 ) * ALIBAVA::NOOFCHANNELS );
+	    // store raw data, the charge vector is sized once and filled in place
 	    TrackerDataImpl * arawdata = new TrackerDataImpl ( );
-	    arawdata -> setChargeValues ( chipdata );
+	    FloatVec & chipdata = arawdata -> chargeValues ( );
+	    chipdata.resize ( ALIBAVA::NOOFCHANNELS );
+	    const short * channels = chipBlock + ALIBAVA::CHIPHEADERLENGTH;
+	    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+	    {
+		chipdata[ichan] = float ( channels[ichan] );
+	    }
 	    chipIDEncoder[ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] = _chipSelection[ichip];
 	    chipIDEncoder.setCellID ( arawdata );
 	    rawDataCollection -> push_back ( arawdata );
 
-	    // store chip header
-	    FloatVec chipHeader_vec;
-	    chipHeader_vec.clear ( );
-
-	    //separate chip headers for each chip
-	    chipHeader_vec.insert ( chipHeader_vec.end ( ), all_chipheaders.begin ( ) + _chipSelection[ichip] * ALIBAVA::CHIPHEADERLENGTH, all_chipheaders.begin ( ) + ( _chipSelection[ichip] + 1 ) * ALIBAVA::CHIPHEADERLENGTH );
+	    // store chip header, the header words are unsigned
 	    TrackerDataImpl * achipheader = new TrackerDataImpl ( );
-	    achipheader -> setChargeValues ( chipHeader_vec );
+	    FloatVec & chipHeader_vec = achipheader -> chargeValues ( );
+	    chipHeader_vec.resize ( ALIBAVA::CHIPHEADERLENGTH );
+	    for ( int j = 0; j < ALIBAVA::CHIPHEADERLENGTH; j++ )
+	    {
+		chipHeader_vec[j] = float ( static_cast < unsigned short > ( chipBlock[j] ) );
+	    }
 	    chipIDEncoder2[ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] = _chipSelection[ichip];
 	    chipIDEncoder2.setCellID ( achipheader );
 	    rawChipHeaderCollection -> push_back ( achipheader );
@@ -380,7 +385,7 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
 	delete anEvent;
 
     }
-    while ( !( infile.bad ( ) || infile.eof ( ) ) );
+    while ( !infile.bad ( ) );
 
     infile.close ( );
 
@@ -390,6 +395,31 @@ void AlibavaConverter::readDataSource ( int /* numEvents */ )
     }
 }
 
+bool AlibavaConverter::ensureBuffered ( istream & infile, size_t nbytes )
+{
+    size_t available = _bufferEnd - _bufferPos;
+    if ( available >= nbytes )
+    {
+	return true;
+    }
+
+    // move the unread tail to the front and refill the rest of the buffer
+    memmove ( _readBuffer.data ( ), _readBuffer.data ( ) + _bufferPos, available );
+    _bufferPos = 0;
+    _bufferEnd = available;
+    if ( _readBuffer.size ( ) < nbytes )
+    {
+	_readBuffer.resize ( nbytes );
+    }
+
+    while ( _bufferEnd < nbytes && infile.good ( ) )
+    {
+	infile.read ( _readBuffer.data ( ) + _bufferEnd, _readBuffer.size ( ) - _bufferEnd );
+	_bufferEnd += static_cast < size_t > ( infile.gcount ( ) );
+    }
+    return _bufferEnd >= nbytes;
+}
+
 void AlibavaConverter::end ( )
 {
     streamlog_out ( MESSAGE5 )  << "AlibavaConverter successfully finished!" << endl;
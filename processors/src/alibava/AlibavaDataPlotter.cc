@@ -221,23 +221,23 @@ void AlibavaDataPlotter::processEvent ( LCEvent * anEvent )
     float temperature = alibavaEvent -> getEventTemp ( );
 
     // TDC time
-    TH1D * alibavaTDCTime = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaTDCTime"] );
+    TH1D * alibavaTDCTime = getHistoHandle < TH1D > ( kTDCTimeHisto );
     alibavaTDCTime -> Fill ( tdctime );
-    TH2D * alibavaTDCTimeEvents = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaTDCTimeEvents"] );
+    TH2D * alibavaTDCTimeEvents = getHistoHandle < TH2D > ( kTDCTimeEventsHisto );
     alibavaTDCTimeEvents -> Fill ( eventnum, tdctime );
 
     // Temperature
-    TH1D * alibavaEventTemperature = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaEventTemperature"] );
+    TH1D * alibavaEventTemperature = getHistoHandle < TH1D > ( kTemperatureHisto );
     alibavaEventTemperature -> Fill ( temperature );
-    TH2D * alibavaEventTemperatureEvents = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaEventTemperatureEvents"] );
+    TH2D * alibavaEventTemperatureEvents = getHistoHandle < TH2D > ( kTemperatureEventsHisto );
     alibavaEventTemperatureEvents -> Fill ( eventnum, temperature );
 
     // Calibration
-    TH1D * alibavaCalCharges = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaCalCharges"] );
+    TH1D * alibavaCalCharges = getHistoHandle < TH1D > ( kCalChargeHisto );
     alibavaCalCharges -> Fill ( alibavaEvent -> getCalCharge ( ) );
 
     // Delay
-    TH1D * alibavaDelayValues = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaDelayValues"] );
+    TH1D * alibavaDelayValues = getHistoHandle < TH1D > ( kDelayHisto );
     alibavaDelayValues -> Fill ( alibavaEvent -> getCalDelay ( ) );
 
     bool plotThisEvent = false;
@@ -281,6 +281,8 @@ void AlibavaDataPlotter::processEvent ( LCEvent * anEvent )
 void AlibavaDataPlotter::bookHistos ( )
 {
 
+    resetHistoHandles ( kNoOfHistoKinds );
+
     #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
 
     try
@@ -293,75 +295,75 @@ void AlibavaDataPlotter::bookHistos ( )
 
 	TH1D * alibavaTDCTime = new TH1D ( "alibavaTDCTime", "", 100, 0, 99 );
 	alibavaTDCTime -> SetTitle ( "Event TDC Time;TDC Time [nS];Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaTDCTime", alibavaTDCTime ) );
+	registerHistoHandle ( "alibavaTDCTime", alibavaTDCTime, kTDCTimeHisto );
 
 	TH2D * alibavaTDCTimeEvents = new TH2D ( "alibavaTDCTimeEvents", "", 1000, 0, 10000, 100, 0, 99 );
 	alibavaTDCTimeEvents -> SetTitle ( "TDC Time over Events;Event Nr;TDC Time [ns]" );
-	_rootObjectMap.insert ( make_pair ( "alibavaTDCTimeEvents", alibavaTDCTimeEvents ) );
+	registerHistoHandle ( "alibavaTDCTimeEvents", alibavaTDCTimeEvents, kTDCTimeEventsHisto );
 
 	TH1D * alibavaEventTemperature = new TH1D ( "alibavaEventTemperature", "", 150, -50, 99 );
 	alibavaEventTemperature -> SetTitle ( "Event Temperature;Temperature [#circC];Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaEventTemperature", alibavaEventTemperature ) );
+	registerHistoHandle ( "alibavaEventTemperature", alibavaEventTemperature, kTemperatureHisto );
 
 	TH2D * alibavaEventTemperatureEvents = new TH2D ( "alibavaEventTemperatureEvents", "", 1000, 0, 10000, 150, -50, 99 );
 	alibavaEventTemperatureEvents -> SetTitle ( "Temperature over Events;Event Nr;Temperature [#circC]" );
-	_rootObjectMap.insert ( make_pair ( "alibavaEventTemperatureEvents", alibavaEventTemperatureEvents ) );
+	registerHistoHandle ( "alibavaEventTemperatureEvents", alibavaEventTemperatureEvents, kTemperatureEventsHisto );
 
 	TH1D * alibavaCalCharges = new TH1D ( "alibavaCalCharges", "", 1000, 0, 100000 );
 	alibavaCalCharges -> SetTitle ( "Calibration Charge Values;Charge [e];Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaCalCharges", alibavaCalCharges ) );
+	registerHistoHandle ( "alibavaCalCharges", alibavaCalCharges, kCalChargeHisto );
 
 	TH1D * alibavaDelayValues = new TH1D ( "alibavaDelayValues", "", 251, 0, 250 );
 	alibavaDelayValues -> SetTitle ( "Calibration Delay Values;Delay [ns];Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaDelayValues", alibavaDelayValues ) );
+	registerHistoHandle ( "alibavaDelayValues", alibavaDelayValues, kDelayHisto );
 
 	TH1D * alibavaSignalChip0 = new TH1D ( "alibavaSignalChip0", "", 401, -200, 200 );
 	alibavaSignalChip0 -> SetTitle ( "Chip 0 Signal;Signal [ADCs];Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSignalChip0", alibavaSignalChip0 ) );
+	registerHistoHandle ( "alibavaSignalChip0", alibavaSignalChip0, kSignalHisto, 0 );
 
 	TH1D * alibavaSignalChip1 = new TH1D ( "alibavaSignalChip1", "", 401, -200, 200 );
 	alibavaSignalChip1 -> SetTitle ( "Chip 1 Signal;Signal [ADCs];Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSignalChip1", alibavaSignalChip1 ) );
+	registerHistoHandle ( "alibavaSignalChip1", alibavaSignalChip1, kSignalHisto, 1 );
 
 	TH2D * alibavaSignalTDCChip0 = new TH2D ( "alibavaSignalTDCChip0", "", 100, 0, 99, 401, -200, 200 );
 	alibavaSignalTDCChip0 -> SetTitle ( "Chip 0 Signal vs TDC Time;Time [ns];Signal [ADCs]" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSignalTDCChip0", alibavaSignalTDCChip0 ) );
+	registerHistoHandle ( "alibavaSignalTDCChip0", alibavaSignalTDCChip0, kSignalTDCHisto, 0 );
 
 	TH2D * alibavaSignalTDCChip1 = new TH2D ( "alibavaSignalTDCChip1", "", 100, 0, 99, 401, -200, 200 );
 	alibavaSignalTDCChip1 -> SetTitle ( "Chip 1 Signal vs TDC Time;Time [ns];Signal [ADCs]" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSignalTDCChip1", alibavaSignalTDCChip1 ) );
+	registerHistoHandle ( "alibavaSignalTDCChip1", alibavaSignalTDCChip1, kSignalTDCHisto, 1 );
 
 	TH2D * alibavaSignalTempChip0 = new TH2D ( "alibavaSignalTempChip0", "", 150, -50, 99, 401, -200, 200 );
 	alibavaSignalTempChip0 -> SetTitle ( "Chip 0 Signal vs Temperature;Temperature [#circC];Signal [ADCs]" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSignalTempChip0", alibavaSignalTempChip0 ) );
+	registerHistoHandle ( "alibavaSignalTempChip0", alibavaSignalTempChip0, kSignalTempHisto, 0 );
 
 	TH2D * alibavaSignalTempChip1 = new TH2D ( "alibavaSignalTempChip1", "", 150, -50, 99, 401, -200, 200 );
 	alibavaSignalTempChip1 -> SetTitle ( "Chip 1 Signal vs Temperature;Temperature [#circC];Signal [ADCs]" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSignalTempChip1", alibavaSignalTempChip1 ) );
+	registerHistoHandle ( "alibavaSignalTempChip1", alibavaSignalTempChip1, kSignalTempHisto, 1 );
 
 	TH1D * alibavaSNRChip0 = new TH1D ( "alibavaSNRChip0", "", 401, -200, 200 );
 	alibavaSNRChip0 -> SetTitle ( "Chip 0 SNR;SNR;Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSNRChip0", alibavaSNRChip0 ) );
+	registerHistoHandle ( "alibavaSNRChip0", alibavaSNRChip0, kSNRHisto, 0 );
 
 	TH1D * alibavaSNRChip1 = new TH1D ( "alibavaSNRChip1", "", 401, -200, 200 );
 	alibavaSNRChip1 -> SetTitle ( "Chip 1 SNR;SNR;Entries" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSNRChip1", alibavaSNRChip1 ) );
+	registerHistoHandle ( "alibavaSNRChip1", alibavaSNRChip1, kSNRHisto, 1 );
 
 	TH2D * alibavaSNRTDCChip0 = new TH2D ( "alibavaSNRTDCChip0", "", 100, 0, 99, 401, -200, 200 );
 	alibavaSNRTDCChip0 -> SetTitle ( "Chip 0 SNR vs TDC Time;Time [ns];SNR" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSNRTDCChip0", alibavaSNRTDCChip0 ) );
+	registerHistoHandle ( "alibavaSNRTDCChip0", alibavaSNRTDCChip0, kSNRTDCHisto, 0 );
 
 	TH2D * alibavaSNRTDCChip1 = new TH2D ( "alibavaSNRTDCChip1", "", 100, 0, 99, 401, -200, 200 );
 	alibavaSNRTDCChip1 -> SetTitle ( "Chip 1 SNR vs TDC Time;Time [ns];SNR" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSNRTDCChip1", alibavaSNRTDCChip1 ) );
+	registerHistoHandle ( "alibavaSNRTDCChip1", alibavaSNRTDCChip1, kSNRTDCHisto, 1 );
 
 	TH2D * alibavaSNRTempChip0 = new TH2D ( "alibavaSNRTempChip0", "", 150, -50, 99, 401, -200, 200 );
 	alibavaSNRTempChip0 -> SetTitle ( "Chip 0 SNR vs Temperature;Temperature [#circC];SNR" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSNRTempChip0", alibavaSNRTempChip0 ) );
+	registerHistoHandle ( "alibavaSNRTempChip0", alibavaSNRTempChip0, kSNRTempHisto, 0 );
 
 	TH2D * alibavaSNRTempChip1 = new TH2D ( "alibavaSNRTempChip1", "", 150, -50, 99, 401, -200, 200 );
 	alibavaSNRTempChip1 -> SetTitle ( "Chip 1 SNR vs Temperature;Temperature [#circC];SNR" );
-	_rootObjectMap.insert ( make_pair ( "alibavaSNRTempChip1", alibavaSNRTempChip1 ) );
+	registerHistoHandle ( "alibavaSNRTempChip1", alibavaSNRTempChip1, kSNRTempHisto, 1 );
 
     }
     catch ( ... )
@@ -394,16 +396,28 @@ void AlibavaDataPlotter::fillHistos ( TrackerDataImpl * /* trkdata */ )
 void AlibavaDataPlotter::fillOtherHistos ( TrackerDataImpl * trkdata, float tdctime, float temperature )
 {
 
-    FloatVec datavec;
-    datavec = trkdata -> getChargeValues ( );
+    const FloatVec & datavec = trkdata -> getChargeValues ( );
     int ichip = getChipNum ( trkdata );
 
+    // histograms are only booked for chip 0 and 1
+    if ( ichip < 0 || ichip >= ALIBAVA::NOOFCHIPS )
+    {
+	return;
+    }
+
     FloatVec noiseVec;
     if ( isNoiseValid ( ) )
     {
 	noiseVec = getNoiseOfChip ( ichip );
     }
 
+    TH1D * alibavaSignal = getHistoHandle < TH1D > ( kSignalHisto, ichip );
+    TH2D * alibavaSignalTDC = getHistoHandle < TH2D > ( kSignalTDCHisto, ichip );
+    TH2D * alibavaSignalTemp = getHistoHandle < TH2D > ( kSignalTempHisto, ichip );
+    TH1D * alibavaSNR = getHistoHandle < TH1D > ( kSNRHisto, ichip );
+    TH2D * alibavaSNRTDC = getHistoHandle < TH2D > ( kSNRTDCHisto, ichip );
+    TH2D * alibavaSNRTemp = getHistoHandle < TH2D > ( kSNRTempHisto, ichip );
+
     for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
     {
 	// if channel is masked, do not fill histo
@@ -414,50 +428,18 @@ void AlibavaDataPlotter::fillOtherHistos ( TrackerDataImpl * trkdata, float tdct
 
 	float data = _multiplySignalby * datavec[ichan];
 
-	if ( ichip == 0 )
-	{
-	    TH1D * alibavaSignalChip0 = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaSignalChip0"] );
-	    alibavaSignalChip0 -> Fill ( data );
-	    TH2D * alibavaSignalTDCChip0 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSignalTDCChip0"] );
-	    alibavaSignalTDCChip0 -> Fill ( tdctime, data );
-	    TH2D * alibavaSignalTempChip0 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSignalTempChip0"] );
-	    alibavaSignalTempChip0 -> Fill ( temperature, data );
-
-	    if ( isNoiseValid ( ) )
-	    {
-		float noise = noiseVec[ichan];
-		if ( noise != 0 )
-		{
-		    TH1D * alibavaSNRChip0 = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaSNRChip0"] );
-		    alibavaSNRChip0 -> Fill ( data / noise );
-		    TH2D * alibavaSNRTDCChip0 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSNRTDCChip0"] );
-		    alibavaSNRTDCChip0 -> Fill ( tdctime, data / noise );
-		    TH2D * alibavaSNRTempChip0 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSNRTempChip0"] );
-		    alibavaSNRTempChip0 -> Fill ( temperature, data / noise );
-		}
-	    }
-	}
-	else if ( ichip == 1 )
+	alibavaSignal -> Fill ( data );
+	alibavaSignalTDC -> Fill ( tdctime, data );
+	alibavaSignalTemp -> Fill ( temperature, data );
+
+	if ( isNoiseValid ( ) )
 	{
-	    TH1D * alibavaSignalChip1 = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaSignalChip1"] );
-	    alibavaSignalChip1 -> Fill ( data );
-	    TH2D * alibavaSignalTDCChip1 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSignalTDCChip1"] );
-	    alibavaSignalTDCChip1 -> Fill ( tdctime, data );
-	    TH2D * alibavaSignalTempChip1 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSignalTempChip1"] );
-	    alibavaSignalTempChip1 -> Fill ( temperature, data );
-
-	    if ( isNoiseValid ( ) )
+	    float noise = noiseVec[ichan];
+	    if ( noise != 0 )
 	    {
-		float noise = noiseVec[ichan];
-		if ( noise != 0 )
-		{
-		    TH1D * alibavaSNRChip1 = dynamic_cast < TH1D* > ( _rootObjectMap["alibavaSNRChip1"] );
-		    alibavaSNRChip1 -> Fill ( data / noise );
-		    TH2D * alibavaSNRTDCChip1 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSNRTDCChip1"] );
-		    alibavaSNRTDCChip1 -> Fill ( tdctime, data / noise );
-		    TH2D * alibavaSNRTempChip1 = dynamic_cast < TH2D* > ( _rootObjectMap["alibavaSNRTempChip1"] );
-		    alibavaSNRTempChip1 -> Fill ( temperature, data / noise );
-		}
+		alibavaSNR -> Fill ( data / noise );
+		alibavaSNRTDC -> Fill ( tdctime, data / noise );
+		alibavaSNRTemp -> Fill ( temperature, data / noise );
 	    }
 	}
 
@@ -50,6 +50,7 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <algorithm>
 
 // eutelescope includes ""
 #include "EUTelVirtualCluster.h"
@@ -73,7 +74,15 @@ using namespace alibava;
 using namespace IMPL;
 using namespace eutelescope;
 
-AlibavaMerger::AlibavaMerger ( ) : AlibavaBaseProcessor ( "AlibavaMerger" )
+AlibavaMerger::AlibavaMerger ( ) : AlibavaBaseProcessor ( "AlibavaMerger" ),
+_telescopeReader ( ),
+_telescopePosition ( 0 ),
+_matchEventNumbers ( false ),
+_telescopeReadAhead ( 16 ),
+_eventNumberOffset ( 0 ),
+_correlationWindow ( 0.0 ),
+_aliCorrelation ( ),
+_teleCorrelation ( )
 {
 
     _description = "AlibavaMerger merges the Alibava cluster data stream with the telescope data stream.";
@@ -84,10 +93,14 @@ AlibavaMerger::AlibavaMerger ( ) : AlibavaBaseProcessor ( "AlibavaMerger" )
 
     registerProcessorParameter ( "AlibavaFile", "The filename where the alibava data is stored", _alibavaFile, string ( "alibava.slcio" ) );
 
+    registerOptionalParameter ( "CorrelationWindow", "Only fill hit pairs into the correlation histogram if their positions, in fractions of the sensor, differ by less than this. 0 fills all pairs", _correlationWindow, 0.0 );
+
     registerProcessorParameter ( "EventdifferenceAlibava", "The event count the Alibava is behind (read: earlier than) the Telescope. 1 means alibava event 1 == telescope event 0, etc.", _eventdifferenceAlibava, 0 );
 
     registerProcessorParameter ( "EventdifferenceTelescope", "The event count the telescope is behind (read: earlier than) the Alibava. 1 means alibava event 0 == telescope event 1, etc.", _eventdifferenceTelescope, 0 );
 
+    registerOptionalParameter ( "MatchEventNumbers", "Take the telescope event by its event number (alibava event number + EventdifferenceTelescope - EventdifferenceAlibava) instead of by its position in the file. Use this if triggers were lost or duplicated. The telescope file is then read once on open to index its event numbers", _matchEventNumbers, false );
+
     registerProcessorParameter ( "OutputCollectionName", "The name of the output collection we want to create", _outputCollectionName, string ( "original_zsdata" ) );
 
     registerProcessorParameter ( "OutputCollectionName2", "The name of the secondary output collection we want to create", _outputCollectionName2, string ( "combinedcluster" ) );
@@ -104,6 +117,8 @@ AlibavaMerger::AlibavaMerger ( ) : AlibavaBaseProcessor ( "AlibavaMerger" )
 
     registerProcessorParameter ( "TelescopeFile", "The filename where the telescope data is stored", _telescopeFile , string ( "telescope.slcio" ) );
 
+    registerOptionalParameter ( "TelescopeReadAhead", "The number of telescope events read ahead in a background thread, 0 to read on demand", _telescopeReadAhead, 16 );
+
     registerProcessorParameter ( "UnsensitiveAxis", "The unsensitive axis of our strip sensor", _nonsensitiveaxis, string ( "x" ) );
 
 }
@@ -126,52 +141,39 @@ void AlibavaMerger::processRunHeader ( LCRunHeader * rdr )
     auto arunHeader = std::make_unique < AlibavaRunHeaderImpl > ( rdr );
     arunHeader -> addProcessor ( type ( ) );
 
-    // so we only open the telescope file once...
-    _telescopeopen = false;
-
     bookHistos ( );
 
-    for ( int i = 0; i < _eventdifferenceTelescope; i++ )
+    // so we only open the telescope file once...
+    if ( _telescopeReader.isOpen ( ) == false )
     {
-	LCEvent *evt = readTelescope ( );
-	streamlog_out ( MESSAGE4 ) << "Skipped " << i + 1 << " telescope events!" << endl;
-	streamlog_out ( MESSAGE4 ) << "Event skipped was " << evt -> getEventNumber ( ) << endl;
+	_telescopeReader.open ( _telescopeFile, static_cast < unsigned int > ( max ( _telescopeReadAhead, 0 ) ), _matchEventNumbers );
+	_telescopePosition = 0;
+	_eventNumberOffset = _eventdifferenceTelescope - _eventdifferenceAlibava;
+
+	// the first events are skipped without being unpacked, the rest is read in file order as before
+	if ( _matchEventNumbers == false && _eventdifferenceTelescope > 0 )
+	{
+	    _telescopePosition = static_cast < size_t > ( _eventdifferenceTelescope );
+	    streamlog_out ( MESSAGE4 ) << "Skipped " << _eventdifferenceTelescope << " telescope events!" << endl;
+	}
     }
 }
 
 
 // the telescope file is read here:
-LCEvent *AlibavaMerger::readTelescope ( )
+LCEvent *AlibavaMerger::readTelescope ( int alibavaEventNumber )
 {
-    if ( _telescopeopen == false )
-    {
-	lcReader = LCFactory::getInstance ( ) -> createLCReader ( IO::LCReader::directAccess ) ;
-	try
-	{
-	    lcReader -> open ( _telescopeFile ) ;
-	    _telescopeopen = true;
-	}
-	catch ( IOException& e )
-	{
-	    streamlog_out ( ERROR1 ) << "Can't open the telescope file: " << e.what ( ) << endl ;
-	}
-    }
-
-    try
+    if ( _matchEventNumbers )
     {
-	LCEvent *evt = lcReader -> readNextEvent ( );
+	LCEvent *evt = _telescopeReader.getEventByNumber ( alibavaEventNumber + _eventNumberOffset );
 	if ( evt == nullptr )
 	{
-	    return nullptr;
-	    streamlog_out ( ERROR1 ) << "FAIL: " << endl ;
+	    streamlog_out ( DEBUG5 ) << "No telescope event " << alibavaEventNumber + _eventNumberOffset << " for alibava event " << alibavaEventNumber << endl;
 	}
-	return ( evt );
-    }
-    catch ( IOException& e )
-    {
-	    streamlog_out ( ERROR1 ) << "FAIL: " << e.what ( ) << endl ;
-	    return nullptr;
+	return evt;
     }
+
+    return _telescopeReader.getEventAt ( _telescopePosition++ );
 }
 
 void AlibavaMerger::addCorrelation ( float ali_x, float ali_y, float ali_z, float tele_x, float tele_y, float tele_z, int event )
@@ -225,8 +227,9 @@ void AlibavaMerger::processEvent ( LCEvent * anEvent )
     float telescope_y = 0.0;
     float telescope_z = 0.0;
 
-    std::vector < double > ali_corr;
-    std::vector < double > tele_corr;
+    // the per hit coordinates for the correlation, the buffers are kept between events
+    _aliCorrelation.clear ( );
+    _teleCorrelation.clear ( );
 
     // here we have to merge two collections: the trackerdata and the trackerpulse. We also keep the zsdata for reference -> 3 collections in total
 
@@ -295,12 +298,12 @@ void AlibavaMerger::processEvent ( LCEvent * anEvent )
 
 	    if ( _nonsensitiveaxis == "x" )
 	    {
-		ali_corr.push_back ( inputPulseColDecoder2 ( inputPulseFrame ) ["ySeed"] );
+		_aliCorrelation.push_back ( inputPulseColDecoder2 ( inputPulseFrame ) ["ySeed"] );
 	    }
 
 	    if ( _nonsensitiveaxis == "y" )
 	    {
-		ali_corr.push_back ( inputPulseColDecoder2 ( inputPulseFrame ) ["xSeed"] );
+		_aliCorrelation.push_back ( inputPulseColDecoder2 ( inputPulseFrame ) ["xSeed"] );
 	    }
 
 	}
@@ -316,7 +319,11 @@ void AlibavaMerger::processEvent ( LCEvent * anEvent )
 	{
 
 	    // the telescope is read by the function
-	    LCEvent* evt = readTelescope ( );
+	    LCEvent* evt = readTelescope ( anEvent -> getEventNumber ( ) );
+	    if ( evt == nullptr )
+	    {
+		throw lcio::DataNotAvailableException ( "No telescope event" );
+	    }
 	    telescopeCollectionVec = dynamic_cast < LCCollectionVec * > ( evt -> getCollection ( _telescopeCollectionName ) ) ;
 	    telescopesize = telescopeCollectionVec -> getNumberOfElements ( );
 	    streamlog_out ( DEBUG1 ) << telescopesize << " Elements in Telescope event!" << endl;
@@ -373,26 +380,23 @@ void AlibavaMerger::processEvent ( LCEvent * anEvent )
 		outputTrackerPulseVec -> push_back ( outputPulseFrame );
 
 		// get these for the correlation plots
-		EUTelVirtualCluster * tempCluster;
-		tempCluster = new EUTelSparseClusterImpl < EUTelGenericSparsePixel > ( static_cast < TrackerDataImpl *> ( inputPulseFrame -> getTrackerData ( ) ) );
 		float tempx = 0.0;
 		float tempy = 0.0;
-		tempCluster -> getCenterOfGravity ( tempx, tempy ) ;
+		getCenterOfGravity ( inputSparseFrame -> getChargeValues ( ), tempx, tempy );
 		telescope_x += tempx;
 		telescope_y += tempy;
 		streamlog_out ( DEBUG0 ) << "Plot x is " << tempx << endl;
 		streamlog_out ( DEBUG0 ) << "Plot y is " << tempy << endl;
 		telescope_z = 0.0;
-		delete tempCluster;
 
 		if ( _nonsensitiveaxis == "x" )
 		{
-		    tele_corr.push_back ( tempy );
+		    _teleCorrelation.push_back ( tempy );
 		}
 
 		if ( _nonsensitiveaxis == "y" )
 		{
-		    tele_corr.push_back ( tempx );
+		    _teleCorrelation.push_back ( tempx );
 		}
 
 	    } // end of loop over input clusters
@@ -425,15 +429,9 @@ void AlibavaMerger::processEvent ( LCEvent * anEvent )
 	addCorrelation ( ( alibava_x / alibavasize ), ( alibava_y / alibavasize ),( alibava_z / alibavasize ), ( telescope_x / telescopesize ), ( telescope_y / telescopesize ), ( telescope_z / telescopesize ), anEvent -> getEventNumber ( ) );
 	streamlog_out ( DEBUG0 ) << "Filling histogram with: Ali_X: " << ( alibava_x / alibavasize ) << " Ali_Y: " << ( alibava_y / alibavasize ) << " Ali_Z: " << ( alibava_z / alibavasize ) << " Tele_X: " << ( telescope_x / telescopesize ) << " Tele_Y: " << ( telescope_y /telescopesize ) << " Tele_Z: " << ( telescope_z / telescopesize ) << endl;
 
-	for ( size_t i = 0; i < ali_corr.size ( ); i ++ )
+	if ( TH2D * histo = dynamic_cast < TH2D* > ( _rootObjectMap["Correlation"] ) )
 	{
-	    for ( size_t j = 0; j < tele_corr.size ( ); j++ )
-	    {
-		if ( TH2D * histo = dynamic_cast < TH2D* > ( _rootObjectMap["Correlation"] ) )
-		{
-		    histo -> Fill ( ali_corr.at ( i ), tele_corr.at ( j ) );
-		}
-	    }
+	    fillHitCorrelation ( histo );
 	}
     }
 
@@ -486,6 +484,63 @@ void AlibavaMerger::processEvent ( LCEvent * anEvent )
     }
 }
 
+// the centre of gravity of a generic sparse cluster, read straight from the x, y, signal, time quadruplets
+void AlibavaMerger::getCenterOfGravity ( const FloatVec & charges, float & xCoG, float & yCoG )
+{
+    float xPos = 0.0;
+    float yPos = 0.0;
+    float totWeight = 0.0;
+
+    for ( size_t index = 0; index + 3 < charges.size ( ); index += 4 )
+    {
+	const float curSignal = charges[index + 2];
+	xPos += static_cast < short > ( charges[index] ) * curSignal;
+	yPos += static_cast < short > ( charges[index + 1] ) * curSignal;
+	totWeight += curSignal;
+    }
+
+    xCoG = xPos / totWeight;
+    yCoG = yPos / totWeight;
+}
+
+// fills the hit correlation of this event. Without a window every alibava hit is paired with every telescope hit,
+// with a window both sides are sorted and only pairs closer than the window (in fractions of the sensor) are filled
+void AlibavaMerger::fillHitCorrelation ( TH2D * histo )
+{
+    if ( _correlationWindow <= 0.0 )
+    {
+	for ( size_t i = 0; i < _aliCorrelation.size ( ); i++ )
+	{
+	    for ( size_t j = 0; j < _teleCorrelation.size ( ); j++ )
+	    {
+		histo -> Fill ( _aliCorrelation[i], _teleCorrelation[j] );
+	    }
+	}
+	return;
+    }
+
+    // the same normalisation as the event correlation in addCorrelation
+    const double aliScale = 1.0 / 256.0;
+    const double teleScale = ( _nonsensitiveaxis == "x" ) ? 1.0 / 576.0 : 1.0 / 1152.0;
+
+    std::sort ( _aliCorrelation.begin ( ), _aliCorrelation.end ( ) );
+    std::sort ( _teleCorrelation.begin ( ), _teleCorrelation.end ( ) );
+
+    size_t first = 0;
+    for ( size_t i = 0; i < _aliCorrelation.size ( ); i++ )
+    {
+	const double aliPos = _aliCorrelation[i] * aliScale;
+	while ( first < _teleCorrelation.size ( ) && _teleCorrelation[first] * teleScale < aliPos - _correlationWindow )
+	{
+	    first++;
+	}
+	for ( size_t j = first; j < _teleCorrelation.size ( ) && _teleCorrelation[j] * teleScale <= aliPos + _correlationWindow; j++ )
+	{
+	    histo -> Fill ( _aliCorrelation[i], _teleCorrelation[j] );
+	}
+    }
+}
+
 void AlibavaMerger::check ( LCEvent * /* evt */ )
 {
 
@@ -494,8 +549,7 @@ void AlibavaMerger::check ( LCEvent * /* evt */ )
 void AlibavaMerger::end( )
 {
     // the telescope file is still open, we can now close it
-    lcReader -> close ( ) ;
-    delete lcReader ;
+    _telescopeReader.close ( );
     streamlog_out ( MESSAGE4 ) << "Successfully finished" << endl;
 }
 
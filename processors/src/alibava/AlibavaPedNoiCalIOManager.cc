@@ -27,12 +27,16 @@
 
 // system includes <>
 #include <string>
+#include <map>
 #include <sys/stat.h>
 
 using namespace std;
 using namespace lcio;
 using namespace alibava;
 
+// the process-wide store shared by all instances
+std::map < std::string, AlibavaPedNoiCalIOManager::CalibrationFile > AlibavaPedNoiCalIOManager::_calibrationFiles;
+
 AlibavaPedNoiCalIOManager::AlibavaPedNoiCalIOManager ( )
 {
 
@@ -80,43 +84,94 @@ int AlibavaPedNoiCalIOManager::getElementNumberOfChip ( LCCollectionVec* col, in
     return ielement;
 }
 
-EVENT::FloatVec AlibavaPedNoiCalIOManager::getPedNoiCalForChip ( string filename, string collectionName, unsigned int chipnum )
+AlibavaPedNoiCalIOManager::CalibrationFile & AlibavaPedNoiCalIOManager::getCalibrationFile ( string filename )
 {
-    // open pedestal file
-    LCReader* lcReader = LCFactory::getInstance ( ) -> createLCReader ( );
+    map < string, CalibrationFile > ::iterator it = _calibrationFiles.find ( filename );
+    if ( it != _calibrationFiles.end ( ) )
+    {
+	return it -> second;
+    }
 
-    EVENT::FloatVec tmp_vec;
-    tmp_vec.clear ( );
+    CalibrationFile calFile;
+    calFile.runHeader = nullptr;
+    calFile.event = nullptr;
+    calFile.modified = false;
 
+    // read run header and event with a single open. The objects belong to the reader, which is kept alive for this.
+    LCReader* lcReader = LCFactory::getInstance ( ) -> createLCReader ( );
     try
     {
 	lcReader -> open ( filename );
 	// check if there is only one run and only one event as it is supposed to
 	if ( lcReader -> getNumberOfRuns ( ) != 1 )
 	{
-	    streamlog_out ( ERROR5 ) << " There is more than one run in AlibavaPedNoiCalFile: " << filename << endl;
+	    streamlog_out ( ERROR5 ) << " There is not exactly one run in AlibavaPedNoiCalFile: " << filename << endl;
+	    streamlog_out ( ERROR5 ) << " Using only the first one! Might cause problems!" << endl;
 	}
-	if ( lcReader -> getNumberOfEvents ( ) !=1 )
+	if ( lcReader -> getNumberOfEvents ( ) > 1 )
 	{
-	    streamlog_out( ERROR5 ) << " There is more than one event in AlibavaPedNoiCalFile: " << filename << endl ;
+	    streamlog_out ( ERROR5 ) << " There is more than one event in AlibavaPedNoiCalFile: " << filename << endl;
+	    streamlog_out ( ERROR5 ) << " Using only the first one! Might cause problems!" << endl;
 	}
-	LCEvent*  evt = lcReader -> readNextEvent ( );
-	tmp_vec = getDataFromEventForChip ( evt, collectionName, chipnum );
-	// if datavec is empty
-	if ( tmp_vec.size ( ) == 0 )
+	if ( lcReader -> getNumberOfRuns ( ) > 0 )
 	{
-	    streamlog_out ( ERROR5 ) << "Trying to access" << collectionName << " for non existing chip (" << chipnum << ")." << endl;
+	    calFile.runHeader = dynamic_cast < LCRunHeaderImpl* > ( lcReader -> readNextRunHeader ( LCIO::UPDATE ) );
 	}
-
-	lcReader -> close ( ) ;
+	if ( lcReader -> getNumberOfEvents ( ) > 0 )
+	{
+	    calFile.event = dynamic_cast < LCEventImpl* > ( lcReader -> readNextEvent ( LCIO::UPDATE ) );
+	}
+	lcReader -> close ( );
     }
     catch ( IOException& e )
     {
-	streamlog_out ( ERROR5 ) << " Unable to read the AlibavaPedNoiCal file - " << filename << e.what ( ) << endl ;
+	streamlog_out ( ERROR5 ) << " Unable to read the AlibavaPedNoiCal file - " << filename << e.what ( ) << endl;
     }
 
-    //delete lcReader;
-    return tmp_vec;
+    if ( calFile.runHeader == nullptr )
+    {
+	calFile.runHeader = new LCRunHeaderImpl ( );
+	calFile.runHeader -> setRunNumber ( 0 );
+    }
+    if ( calFile.event == nullptr )
+    {
+	calFile.event = new LCEventImpl ( );
+    }
+
+    return _calibrationFiles.insert ( make_pair ( filename, calFile ) ) .first -> second;
+}
+
+EVENT::FloatVec AlibavaPedNoiCalIOManager::getPedNoiCalForChip ( string filename, string collectionName, unsigned int chipnum )
+{
+    CalibrationFile & calFile = getCalibrationFile ( filename );
+
+    // decode all chips of the collection on first access
+    map < string, map < int, FloatVec > > ::iterator colIt = calFile.chipData.find ( collectionName );
+    if ( colIt == calFile.chipData.end ( ) )
+    {
+	map < int, FloatVec > chips;
+	if ( doesCollectionExist ( calFile.event, collectionName ) )
+	{
+	    LCCollectionVec* col = dynamic_cast < LCCollectionVec * > ( calFile.event -> getCollection ( collectionName ) );
+	    CellIDDecoder < TrackerDataImpl > chipIDDecoder ( col );
+	    for ( int i = 0; i < col -> getNumberOfElements ( ); ++i )
+	    {
+		TrackerDataImpl * trkdata = dynamic_cast < TrackerDataImpl * > ( col -> getElementAt ( i ) ) ;
+		const int ichip = static_cast < int > ( chipIDDecoder ( trkdata ) [ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] );
+		// as in getElementNumberOfChip the last element of a chip is used
+		chips[ichip] = trkdata -> getChargeValues ( );
+	    }
+	}
+	colIt = calFile.chipData.insert ( make_pair ( collectionName, chips ) ) .first;
+    }
+
+    map < int, FloatVec > ::const_iterator chipIt = colIt -> second.find ( chipnum );
+    if ( chipIt == colIt -> second.end ( ) || chipIt -> second.size ( ) == 0 )
+    {
+	streamlog_out ( ERROR5 ) << "Trying to access" << collectionName << " for non existing chip (" << chipnum << ")." << endl;
+	return EVENT::FloatVec ( );
+    }
+    return chipIt -> second;
 }
 
 void AlibavaPedNoiCalIOManager::createFile ( string filename, IMPL::LCRunHeaderImpl* runHeader )
@@ -134,64 +189,84 @@ void AlibavaPedNoiCalIOManager::createFile ( string filename, IMPL::LCRunHeaderI
 
     lcWriter -> writeRunHeader ( runHeader );
     lcWriter -> close ( );
+
+    // the next access has to read the new file
+    _calibrationFiles.erase ( filename );
 }
 
 void AlibavaPedNoiCalIOManager::addToFile ( string filename, string collectionName, int chipnum, EVENT::FloatVec datavec )
 {
     // if file doesn't exist
-    if ( !doesFileExist ( filename ) )
+    if ( _calibrationFiles.find ( filename ) == _calibrationFiles.end ( ) && !doesFileExist ( filename ) )
     {
 	streamlog_out ( WARNING5 ) << " The AlibavaPedNoiCalFile: " << filename << " doesn't exist." << endl ;
 	streamlog_out ( WARNING5 ) << " Creating new AlibavaPedNoiCalFile" << endl;
 	createFile ( filename );
     }
 
-    LCRunHeaderImpl* runHeader = getRunHeader ( filename );
-    LCEventImpl*  evt = getEvent ( filename );
+    CalibrationFile & calFile = getCalibrationFile ( filename );
+    LCEventImpl* evt = calFile.event;
 
-    FloatVec tmp_vec;
-    tmp_vec.clear ( );
-    LCWriter * lcWriter = LCFactory::getInstance ( ) -> createLCWriter ( );
-    // we will write a new lcio file with the copied run header and event
-    try
+    // check if the collection exists
+    LCCollectionVec* newCol = new LCCollectionVec ( LCIO::TRACKERDATA );
+
+    if ( doesCollectionExist ( evt, collectionName ) )
     {
-	lcWriter -> open ( filename, LCIO::WRITE_NEW );
-	// first write runheader
-	lcWriter -> writeRunHeader ( runHeader );
-	// check if the collection exists
-	LCCollectionVec* newCol = new LCCollectionVec ( LCIO::TRACKERDATA );
+	LCCollectionVec* col = dynamic_cast < LCCollectionVec * > ( evt -> getCollection ( collectionName ) );
+	*newCol = *col;
+	evt -> removeCollection ( collectionName );
+    }
 
-	if ( doesCollectionExist ( evt, collectionName ) )
+    // check if the data exists for this chip in this event
+    // if exists remove it
+    int ielement = 0;
+    do
+    {
+	ielement = getElementNumberOfChip ( newCol, chipnum );
+	if ( ielement != -1 )
 	{
-	    LCCollectionVec* col = dynamic_cast < LCCollectionVec * > ( evt -> getCollection ( collectionName ) );
-	    *newCol = *col;
-	    evt -> removeCollection ( collectionName );
+	    newCol -> removeElementAt ( ielement );
 	}
+    }
+    while ( ielement != -1 );
+
+    // now, add data vector to the collecton
+    TrackerDataImpl * tmp_data = new TrackerDataImpl ( );
+    tmp_data -> setChargeValues ( datavec );
+    // set Cell ID encode
+    CellIDEncoder < TrackerDataImpl > chipIDEncoder ( ALIBAVA::ALIBAVADATA_ENCODE, newCol );
+    chipIDEncoder[ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] = chipnum;
+    chipIDEncoder.setCellID ( tmp_data );
+
+    newCol -> push_back ( tmp_data );
+    evt -> addCollection ( newCol, collectionName );
+
+    // the file is written on flush, readers in this process see the new data right away
+    calFile.chipData.erase ( collectionName );
+    calFile.modified = true;
+}
 
-	// check if the data exists for this chip in this event
-	// if exists remove it
-	int ielement = 0;
-	do
+void AlibavaPedNoiCalIOManager::flush ( )
+{
+    for ( map < string, CalibrationFile > ::iterator it = _calibrationFiles.begin ( ); it != _calibrationFiles.end ( ); ++it )
+    {
+	if ( it -> second.modified )
 	{
-	    ielement = getElementNumberOfChip ( newCol, chipnum );
-	    if ( ielement != -1 )
-	    {
-		newCol -> removeElementAt ( ielement );
-	    }
+	    writeFile ( it -> first, it -> second );
+	    it -> second.modified = false;
 	}
-	while ( ielement != -1 );
-
-	// now, add data vector to the collecton
-	TrackerDataImpl * tmp_data = new TrackerDataImpl ( );
-	tmp_data -> setChargeValues ( datavec );
-	// set Cell ID encode
-	CellIDEncoder < TrackerDataImpl > chipIDEncoder ( ALIBAVA::ALIBAVADATA_ENCODE, newCol );
-	chipIDEncoder[ALIBAVA::ALIBAVADATA_ENCODE_CHIPNUM] = chipnum;
-	chipIDEncoder.setCellID ( tmp_data );
-
-	newCol -> push_back ( tmp_data );
-	evt -> addCollection ( newCol, collectionName );
-	lcWriter -> writeEvent ( evt );
+    }
+}
+
+void AlibavaPedNoiCalIOManager::writeFile ( string filename, CalibrationFile & calFile )
+{
+    LCWriter * lcWriter = LCFactory::getInstance ( ) -> createLCWriter ( );
+    // we will write a new lcio file with the stored run header and event
+    try
+    {
+	lcWriter -> open ( filename, LCIO::WRITE_NEW );
+	lcWriter -> writeRunHeader ( calFile.runHeader );
+	lcWriter -> writeEvent ( calFile.event );
 	lcWriter -> close ( );
     }
     catch ( IOException& e )
@@ -231,75 +306,3 @@ void AlibavaPedNoiCalIOManager::createFile ( string filename )
     createFile ( filename, runHeader );
     streamlog_out ( WARNING5 ) << " New AlibavaPedNoiCalFile is created with empty header. File is: " << filename << endl;
 }
-
-LCRunHeaderImpl* AlibavaPedNoiCalIOManager::getRunHeader ( string filename )
-{
-    LCRunHeaderImpl* newRunHeader = new LCRunHeaderImpl ( );
-
-    // first try to access file and get run header and the event
-    LCReader* lcReader = LCFactory::getInstance ( ) -> createLCReader ( );
-
-    try
-    {
-	// first try to access file
-	lcReader -> open ( filename ) ;
-
-	// read run header
-	if ( ( lcReader -> getNumberOfRuns ( ) ) > 0 )
-	{
-	    if ( ( lcReader -> getNumberOfRuns ( ) ) > 1 )
-	    {
-		streamlog_out ( ERROR5 ) << " There are more than one run in AlibavaPedNoiCalFile: " << filename << endl;
-		streamlog_out ( ERROR5 ) << " Using only one of them (probably first one)! Might cause problems!" << endl ;
-	    }
-	    newRunHeader = dynamic_cast < LCRunHeaderImpl* > ( lcReader -> readNextRunHeader ( LCIO::UPDATE ) );
-	}
-	else if ( ( lcReader -> getNumberOfRuns ( ) ) == 0 )
-	{
-	    streamlog_out ( ERROR5 ) << " There is no run header in AlibavaPedNoiCalFile: " << filename << endl;
-	}
-	lcReader -> close ( );
-    }
-    catch ( IOException& e )
-    {
-	cerr << e.what ( ) << endl;
-    }
-    //delete lcReader;
-    return newRunHeader;
-}
-
-LCEventImpl* AlibavaPedNoiCalIOManager::getEvent ( string filename )
-{
-    LCEventImpl* newEvent = new LCEventImpl ( );
-
-    // first try to access file and get run header and the event
-    LCReader* lcReader = LCFactory::getInstance ( ) -> createLCReader ( );
-
-    try
-    {
-	// first try to access file
-	lcReader -> open ( filename );
-	// read the event
-	if ( lcReader -> getNumberOfEvents ( ) > 0 )
-	{
-	    if ( lcReader -> getNumberOfEvents ( ) > 1 )
-	    {
-		streamlog_out ( ERROR5 ) << " There are more than one event in AlibavaPedNoiCalFile: " << filename << endl;
-		streamlog_out ( ERROR5 ) << " Using only one of them (probably first one)! Might cause problems!" << endl;
-	    }
-	    newEvent = dynamic_cast < LCEventImpl* > ( lcReader -> readNextEvent ( LCIO::UPDATE ) );
-	}
-	else if ( lcReader -> getNumberOfEvents ( ) == 0 )
-	{
-	    streamlog_out ( MESSAGE5 ) << " New event created in AlibavaPedNoiCalFile: " << filename << endl ;
-	}
-	lcReader -> close ( );
-    }
-    catch ( IOException& e )
-    {
-	cerr << e.what ( ) << endl;
-    }
-    // clean up
-    //delete lcReader;
-    return newEvent;
-}
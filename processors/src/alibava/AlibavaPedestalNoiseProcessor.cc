@@ -46,6 +46,9 @@
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <cmath>
+#include <limits>
+#include <algorithm>
 
 using namespace std;
 using namespace lcio;
@@ -57,7 +60,19 @@ _pedestalHistoName ( "hpedestal" ),
 _noiseHistoName ( "hnoise" ),
 _temperatureHistoName ( "htemperature" ),
 _chanDataHistoName ( "Data_chan" ),
-_chanDataFitName ( "Fit_chan" )
+_chanDataFitName ( "Fit_chan" ),
+_fillChannelHistos ( false ),
+_gaussianFit ( false ),
+_clippingSigma ( 3.0 ),
+_reservoirSize ( 200 ),
+_clippingIterations ( 3 ),
+_sampleCount ( ),
+_sampleMean ( ),
+_sampleM2 ( ),
+_clipLow ( ),
+_clipHigh ( ),
+_reservoir ( ),
+_reservoirFill ( )
 {
 
     // modify processor description
@@ -73,6 +88,16 @@ _chanDataFitName ( "Fit_chan" )
 
     registerOptionalParameter ( "NoiseCollectionName", "Noise collection name, better not to change", _noiseCollectionName, string ( "noise" ) );
 
+    registerOptionalParameter ( "FillChannelHistograms", "Fill the ADC histogram of each channel. These are only needed for debugging, they are always filled if GaussianFit is set", _fillChannelHistos, false );
+
+    registerOptionalParameter ( "GaussianFit", "Determine pedestal and noise with a Gaussian fit to the ADC histogram of each channel instead of the streaming mean and RMS estimator", _gaussianFit, false );
+
+    registerOptionalParameter ( "ClippingSigma", "Samples further than this many times the noise away from the pedestal are not used by the streaming estimator. Set to 0 to disable the clipping", _clippingSigma, float ( 3.0 ) );
+
+    registerOptionalParameter ( "ClippingReservoirSize", "Number of first samples of each channel used to determine the clipping window", _reservoirSize, 200 );
+
+    registerOptionalParameter ( "ClippingIterations", "Number of iterations used to determine the clipping window", _clippingIterations, 3 );
+
 }
 
 void AlibavaPedestalNoiseProcessor::init ( )
@@ -97,6 +122,17 @@ void AlibavaPedestalNoiseProcessor::init ( )
 	streamlog_out ( MESSAGE4 ) << "The Global Parameter " << ALIBAVA::SKIPMASKEDEVENTS << " is not set! Masked events will be used!" << endl;
     }
 
+    if ( _gaussianFit )
+    {
+	_fillChannelHistos = true;
+    }
+
+    if ( _reservoirSize < 1 )
+    {
+	streamlog_out ( WARNING5 ) << "ClippingReservoirSize has to be positive, the sigma clipping is disabled!" << endl;
+	_clippingSigma = 0;
+    }
+
     printParameters ( );
 
 }
@@ -115,6 +151,19 @@ void AlibavaPedestalNoiseProcessor::processRunHeader ( LCRunHeader * rdr )
 
     bookHistos ( );
 
+    // reset the streaming estimator
+    const size_t noOfChannels = ALIBAVA::NOOFCHIPS * ALIBAVA::NOOFCHANNELS;
+    _sampleCount.assign ( noOfChannels, 0.0 );
+    _sampleMean.assign ( noOfChannels, 0.0 );
+    _sampleM2.assign ( noOfChannels, 0.0 );
+    _clipLow.assign ( noOfChannels, -numeric_limits < double >::infinity ( ) );
+    _clipHigh.assign ( noOfChannels, numeric_limits < double >::infinity ( ) );
+    _reservoirFill.assign ( ALIBAVA::NOOFCHIPS, 0 );
+    if ( _clippingSigma > 0 )
+    {
+	_reservoir.assign ( noOfChannels * _reservoirSize, 0.0f );
+    }
+
     // set number of skipped events to zero (defined in AlibavaBaseProcessor)
     _numberOfSkippedEvents = 0;
 
@@ -139,13 +188,20 @@ void AlibavaPedestalNoiseProcessor::processEvent ( LCEvent * anEvent )
 	noOfDetector = collectionVec -> getNumberOfElements ( );
 
 	// fill temperature histogram
-	TH1D * temperatureHisto = dynamic_cast < TH1D* > ( _rootObjectMap[_temperatureHistoName] );
+	TH1D * temperatureHisto = getHistoHandle < TH1D > ( kTemperatureHisto );
 	temperatureHisto -> Fill ( alibavaEvent -> getEventTemp ( ) );
 
 	for ( size_t i = 0; i < noOfDetector; ++i )
 	{
 	    TrackerDataImpl * trkdata = dynamic_cast < TrackerDataImpl * > ( collectionVec -> getElementAt ( i ) ) ;
-	    fillHistos ( trkdata );
+	    if ( !_gaussianFit )
+	    {
+		accumulate ( trkdata );
+	    }
+	    if ( _fillChannelHistos )
+	    {
+		fillHistos ( trkdata );
+	    }
 	}
     }
     catch ( lcio::DataNotAvailableException& )
@@ -172,15 +228,23 @@ void AlibavaPedestalNoiseProcessor::end ( )
 
 void AlibavaPedestalNoiseProcessor::calculatePedestalNoise ( )
 {
-    string tempHistoName,tempFitName;
+    string tempFitName;
     TCanvas *cc = new TCanvas ( "cc", "cc", 800, 600 );
 
+    AlibavaPedNoiCalIOManager man;
     EVENT::IntVec chipSelection = getChipSelection ( );
     for ( unsigned int i = 0; i < chipSelection.size ( ); i++ )
     {
 	unsigned int ichip = chipSelection[i];
-	TH1D * hped = dynamic_cast < TH1D* > ( _rootObjectMap[getPedestalHistoName ( ichip ) ] );
-	TH1D * hnoi = dynamic_cast < TH1D* > ( _rootObjectMap[getNoiseHistoName ( ichip ) ] );
+	TH1D * hped = getHistoHandle < TH1D > ( kPedestalHisto, ichip );
+	TH1D * hnoi = getHistoHandle < TH1D > ( kNoiseHisto, ichip );
+
+	// a short run may not have filled the reservoir yet
+	if ( !_gaussianFit && _clippingSigma > 0 && _reservoirFill[ichip] < _reservoirSize )
+	{
+	    seedClipping ( ichip );
+	}
+
 	EVENT::FloatVec pedestalVec,noiseVec;
 	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
 	{
@@ -193,26 +257,123 @@ void AlibavaPedestalNoiseProcessor::calculatePedestalNoise ( )
 	    }
 	    else
 	    {
-		tempFitName = getChanDataFitName ( ichip, ichan );
-		tempHistoName = getChanDataHistoName ( ichip, ichan );
-		TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap[tempHistoName] );
-		TF1 * tempfit = dynamic_cast < TF1* > ( _rootObjectMap[tempFitName] );
-		histo -> Fit ( tempfit, "Q" );
-		ped = tempfit -> GetParameter ( 1 );
-		noi = tempfit -> GetParameter ( 2 );
+		if ( _gaussianFit )
+		{
+		    tempFitName = getChanDataFitName ( ichip, ichan );
+		    TH1D * histo = getHistoHandle < TH1D > ( kChanDataHisto, ichip, ichan );
+		    TF1 * tempfit = dynamic_cast < TF1* > ( _rootObjectMap[tempFitName] );
+		    histo -> Fit ( tempfit, "Q" );
+		    ped = tempfit -> GetParameter ( 1 );
+		    noi = tempfit -> GetParameter ( 2 );
+		}
+		else
+		{
+		    const size_t index = ichip * ALIBAVA::NOOFCHANNELS + ichan;
+		    const double n = _sampleCount[index];
+		    ped = _sampleMean[index];
+		    noi = n > 1 ? sqrt ( _sampleM2[index] / ( n - 1 ) ) : 0;
+		}
 		hped -> SetBinContent ( ichan + 1, ped );
 		hnoi -> SetBinContent ( ichan + 1, noi );
 	    }
 	    pedestalVec.push_back ( ped );
 	    noiseVec.push_back ( noi );
 	}
-	AlibavaPedNoiCalIOManager man;
 	man.addToFile ( _pedestalFile, _pedestalCollectionName, ichip, pedestalVec );
 	man.addToFile ( _pedestalFile, _noiseCollectionName, ichip, noiseVec );
     }
+    // pedestal and noise of all chips are written in one go
+    man.flush ( );
     delete cc;
 }
 
+void AlibavaPedestalNoiseProcessor::accumulate ( TrackerDataImpl * trkdata )
+{
+    const FloatVec & datavec = trkdata -> getChargeValues ( );
+    const int chipnum = getChipNum ( trkdata );
+    const size_t nchan = min ( datavec.size ( ), size_t ( ALIBAVA::NOOFCHANNELS ) );
+    const size_t offset = chipnum * ALIBAVA::NOOFCHANNELS;
+
+    // until the reservoir of this chip is full, the samples are only stored
+    if ( _clippingSigma > 0 && _reservoirFill[chipnum] < _reservoirSize )
+    {
+	const int isample = _reservoirFill[chipnum];
+	for ( size_t ichan = 0; ichan < nchan; ichan++ )
+	{
+	    _reservoir[ ( offset + ichan ) * _reservoirSize + isample] = datavec[ichan];
+	}
+	_reservoirFill[chipnum]++;
+	if ( _reservoirFill[chipnum] == _reservoirSize )
+	{
+	    seedClipping ( chipnum );
+	}
+	return;
+    }
+
+    for ( size_t ichan = 0; ichan < nchan; ichan++ )
+    {
+	addSample ( offset + ichan, datavec[ichan] );
+    }
+}
+
+void AlibavaPedestalNoiseProcessor::addSample ( size_t index, double value )
+{
+    if ( value < _clipLow[index] || value > _clipHigh[index] )
+    {
+	return;
+    }
+    _sampleCount[index] += 1;
+    const double delta = value - _sampleMean[index];
+    _sampleMean[index] += delta / _sampleCount[index];
+    _sampleM2[index] += delta * ( value - _sampleMean[index] );
+}
+
+void AlibavaPedestalNoiseProcessor::seedClipping ( int ichip )
+{
+    const int nsample = _reservoirFill[ichip];
+    for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
+    {
+	const size_t index = ichip * ALIBAVA::NOOFCHANNELS + ichan;
+	const float * samples = &_reservoir[index * _reservoirSize];
+
+	// iterative clipped mean and RMS of the reservoir
+	double low = -numeric_limits < double >::infinity ( );
+	double high = numeric_limits < double >::infinity ( );
+	for ( int iter = 0; iter < _clippingIterations; iter++ )
+	{
+	    double sum = 0, sum2 = 0, n = 0;
+	    for ( int isample = 0; isample < nsample; isample++ )
+	    {
+		const double x = samples[isample];
+		if ( x >= low && x <= high )
+		{
+		    sum += x;
+		    sum2 += x * x;
+		    n += 1;
+		}
+	    }
+	    if ( n < 2 )
+	    {
+		break;
+	    }
+	    const double mean = sum / n;
+	    const double rms = sqrt ( max ( 0.0, sum2 / n - mean * mean ) );
+	    low = mean - _clippingSigma * rms;
+	    high = mean + _clippingSigma * rms;
+	}
+	_clipLow[index] = low;
+	_clipHigh[index] = high;
+
+	// the reservoir samples are the first samples of the run
+	for ( int isample = 0; isample < nsample; isample++ )
+	{
+	    addSample ( index, samples[isample] );
+	}
+    }
+    // from now on the samples of this chip go straight into the accumulators
+    _reservoirFill[ichip] = _reservoirSize;
+}
+
 string AlibavaPedestalNoiseProcessor::getChanDataHistoName ( unsigned int ichip, unsigned int ichan )
 {
     stringstream s;
@@ -243,20 +404,15 @@ string AlibavaPedestalNoiseProcessor::getNoiseHistoName ( unsigned int ichip )
 
 void AlibavaPedestalNoiseProcessor::fillHistos ( TrackerDataImpl * trkdata )
 {
-    FloatVec datavec;
-    datavec = trkdata -> getChargeValues ( );
+    const FloatVec & datavec = trkdata -> getChargeValues ( );
 
     int chipnum = getChipNum ( trkdata );
+    int nchan = min ( int ( datavec.size ( ) ), ALIBAVA::NOOFCHANNELS );
 
-    for ( size_t ichan = 0; ichan < datavec.size ( ); ichan++ )
+    // masked channels have no histogram booked
+    for ( int ichan = 0; ichan < nchan; ichan++ )
     {
-	if ( isMasked ( chipnum, ichan ) )
-	{
-	    continue;
-	}
-
-	string tempHistoName = getChanDataHistoName ( chipnum, ichan );
-	if ( TH1D * histo = dynamic_cast < TH1D* > ( _rootObjectMap[tempHistoName] ) )
+	if ( TH1D * histo = getHistoHandle < TH1D > ( kChanDataHisto, chipnum, ichan ) )
 	{
 	    histo -> Fill ( datavec[ichan] );
 	}
@@ -267,20 +423,21 @@ void AlibavaPedestalNoiseProcessor::bookHistos ( )
 {
     AIDAProcessor::tree ( this ) -> cd ( this -> name ( ) );
     EVENT::IntVec chipSelection = getChipSelection ( );
+    resetHistoHandles ( kNoOfHistoKinds );
 
     //the chipSelection should be in ascending order!
     //this is guaranteed with AlibavaConverter::checkIfChipSelectionIsValid()
 
     // temperature of event
     TH1D * temperatureHisto = new TH1D ( _temperatureHistoName.c_str ( ), "Temperature", 1000, -50, 50 );
-    _rootObjectMap.insert ( make_pair ( _temperatureHistoName, temperatureHisto ) );
+    registerHistoHandle ( _temperatureHistoName, temperatureHisto, kTemperatureHisto );
 
     for ( unsigned int i = 0; i < chipSelection.size ( ); i++ )
     {
 	unsigned int ichip = chipSelection[i];
 
 	TH1D * pedestalHisto = new TH1D ( getPedestalHistoName ( ichip ) .c_str ( ), "", ALIBAVA::NOOFCHANNELS, -0.5, ALIBAVA::NOOFCHANNELS - 0.5 );
-	_rootObjectMap.insert ( make_pair ( getPedestalHistoName ( ichip ), pedestalHisto ) );
+	registerHistoHandle ( getPedestalHistoName ( ichip ), pedestalHisto, kPedestalHisto, ichip );
 
 	//title string for pedestal histogram
 	stringstream sp;
@@ -289,7 +446,7 @@ void AlibavaPedestalNoiseProcessor::bookHistos ( )
 
 	TH1D * noiseHisto = new TH1D ( getNoiseHistoName ( ichip ) .c_str ( ), "", ALIBAVA::NOOFCHANNELS, -0.5, ALIBAVA::NOOFCHANNELS - 0.5 );
 
-	_rootObjectMap.insert ( make_pair ( getNoiseHistoName ( ichip ), noiseHisto ) );
+	registerHistoHandle ( getNoiseHistoName ( ichip ), noiseHisto, kNoiseHisto, ichip );
 
 	//title string for noise histogram
 	stringstream sn;
@@ -308,7 +465,7 @@ void AlibavaPedestalNoiseProcessor::bookHistos ( )
 
 	for ( int ichan = 0; ichan < ALIBAVA::NOOFCHANNELS; ichan++ )
 	{
-	    if ( isMasked ( ichip, ichan ) )
+	    if ( isMasked ( ichip, ichan ) || !_fillChannelHistos )
 	    {
 		continue;
 	    }
@@ -318,7 +475,7 @@ void AlibavaPedestalNoiseProcessor::bookHistos ( )
 	    tempHistoTitle << tempHistoName << ";ADCs;NumberofEntries";
 
 	    TH1D * chanDataHisto = new TH1D ( tempHistoName.c_str ( ), "", 2000, -1000, 1000 );
-	    _rootObjectMap.insert ( make_pair ( tempHistoName, chanDataHisto ) );
+	    registerHistoHandle ( tempHistoName, chanDataHisto, kChanDataHisto, ichip, ichan );
 	    string tmp_string = tempHistoTitle.str ( );
 	    chanDataHisto -> SetTitle ( tmp_string.c_str ( ) );
 
@@ -0,0 +1,424 @@
+/*
+ *   This source code is part of the Eutelescope package of Marlin.
+ *   You are free to use this source files for your own development as
+ *   long as it stays in a public research context. You are not
+ *   allowed to use it for commercial purpose. You must put this
+ *   header with author names in all development based on this file.
+ *
+ */
+
+// alibava includes ".h"
+#include "AlibavaTelescopeReader.h"
+
+// marlin includes ".h"
+#include "marlin/Processor.h"
+
+// lcio includes <.h>
+#include <lcio.h>
+#include <IO/LCReader.h>
+#include <IOIMPL/LCFactory.h>
+#include <Exceptions.h>
+
+// system includes <>
+#include <string>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+using namespace lcio;
+using namespace alibava;
+
+const size_t AlibavaTelescopeReader::npos = std::numeric_limits < size_t >::max ( );
+
+AlibavaTelescopeReader::AlibavaTelescopeReader ( ) :
+_index ( ),
+_positionOfEvent ( ),
+_uniqueInFile ( ),
+_filename ( ),
+_readPosition ( 0 ),
+_endPosition ( npos ),
+_duplicates ( 0 ),
+_open ( false ),
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+_reader ( ),
+_queue ( ),
+_queueStart ( 0 ),
+_nextToRead ( 0 ),
+_generation ( 0 ),
+_readAhead ( 1 ),
+_stop ( false ),
+_current ( ),
+_thread ( ),
+_mutex ( ),
+_readerMutex ( ),
+_condition ( )
+#else
+_reader ( nullptr )
+#endif
+{
+
+}
+
+AlibavaTelescopeReader::~AlibavaTelescopeReader ( )
+{
+    close ( );
+}
+
+bool AlibavaTelescopeReader::open ( std::string filename, unsigned int readAhead, bool indexEventNumbers )
+{
+    close ( );
+
+    _index.clear ( );
+    _positionOfEvent.clear ( );
+    _uniqueInFile.clear ( );
+    _duplicates = 0;
+    _filename = filename;
+    _endPosition = npos;
+    try
+    {
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+	_reader = std::make_unique < MT::LCReader > ( MT::LCReader::directAccess );
+#else
+	_reader = LCFactory::getInstance ( ) -> createLCReader ( IO::LCReader::directAccess );
+#endif
+	_reader -> open ( filename );
+	if ( indexEventNumbers )
+	{
+	    buildIndex ( );
+	}
+    }
+    catch ( IOException& e )
+    {
+	streamlog_out ( ERROR1 ) << "Can't open the telescope file: " << e.what ( ) << endl;
+	return false;
+    }
+    _readPosition = 0;
+    _open = true;
+
+    if ( indexEventNumbers )
+    {
+	streamlog_out ( MESSAGE4 ) << "Indexed " << _index.size ( ) << " telescope events in " << filename << endl;
+    }
+
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+    _queue.clear ( );
+    _queueStart = 0;
+    _nextToRead = 0;
+    _generation = 0;
+    _readAhead = ( readAhead > 0 ) ? readAhead : 1;
+    _stop = false;
+    if ( readAhead > 0 )
+    {
+	_thread = std::thread ( &AlibavaTelescopeReader::readAheadLoop, this );
+    }
+#else
+    if ( readAhead > 0 )
+    {
+	streamlog_out ( WARNING2 ) << "This LCIO version has no multi-threading reader, telescope events are not read ahead!" << endl;
+    }
+#endif
+
+    return true;
+}
+
+void AlibavaTelescopeReader::close ( )
+{
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+    {
+	std::lock_guard < std::mutex > lock ( _mutex );
+	_stop = true;
+    }
+    _condition.notify_all ( );
+    if ( _thread.joinable ( ) )
+    {
+	_thread.join ( );
+    }
+    _queue.clear ( );
+    _current.reset ( );
+    if ( _reader )
+    {
+	_reader -> close ( );
+	_reader.reset ( );
+    }
+#else
+    if ( _reader != nullptr )
+    {
+	_reader -> close ( );
+	delete _reader;
+	_reader = nullptr;
+    }
+#endif
+    _open = false;
+}
+
+bool AlibavaTelescopeReader::isOpen ( ) const
+{
+    return _open;
+}
+
+int AlibavaTelescopeReader::getNumberOfDuplicates ( ) const
+{
+    return _duplicates;
+}
+
+LCEvent * AlibavaTelescopeReader::getEventByNumber ( int eventNumber )
+{
+    std::map < int, size_t >::const_iterator it = _positionOfEvent.find ( eventNumber );
+    if ( it == _positionOfEvent.end ( ) )
+    {
+	return nullptr;
+    }
+    return getEventAt ( it -> second );
+}
+
+void AlibavaTelescopeReader::buildIndex ( )
+{
+    // one sequential pass, so every record is indexed at its position in the file
+    std::map < std::pair < int, int >, int > occurences;
+    while ( true )
+    {
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+	std::unique_ptr < LCEvent > evt = _reader -> readNextEvent ( );
+#else
+	LCEvent * evt = _reader -> readNextEvent ( );
+#endif
+	if ( evt == nullptr )
+	{
+	    break;
+	}
+	const int eventNumber = evt -> getEventNumber ( );
+	if ( _positionOfEvent.insert ( make_pair ( eventNumber, _index.size ( ) ) ).second == false )
+	{
+	    _duplicates++;
+	    streamlog_out ( WARNING2 ) << "Telescope event " << eventNumber << " is in the file more than once, matching by event number uses the first one!" << endl;
+	}
+	_index.push_back ( make_pair ( evt -> getRunNumber ( ), eventNumber ) );
+	occurences[_index.back ( )]++;
+    }
+    _uniqueInFile.resize ( _index.size ( ) );
+    for ( size_t i = 0; i < _index.size ( ); i++ )
+    {
+	_uniqueInFile[i] = ( occurences[_index[i]] == 1 );
+    }
+    _endPosition = _index.size ( );
+
+    // back to the first event
+    _reader -> close ( );
+    _reader -> open ( _filename );
+}
+
+bool AlibavaTelescopeReader::seekSequential ( size_t position )
+{
+    if ( position == _readPosition )
+    {
+	return true;
+    }
+
+    // going forward we skip, this keeps every record, also the ones with a duplicated event number
+    if ( _readPosition != npos && position > _readPosition )
+    {
+	_reader -> skipNEvents ( static_cast < int > ( position - _readPosition ) );
+	_readPosition = position;
+	return true;
+    }
+
+    // going back, an indexed unique record can be looked up directly, any other one only by reading from the start
+    if ( position < _uniqueInFile.size ( ) && _uniqueInFile[position] )
+    {
+	return false;
+    }
+    _reader -> close ( );
+    _reader -> open ( _filename );
+    if ( position > 0 )
+    {
+	_reader -> skipNEvents ( static_cast < int > ( position ) );
+    }
+    _readPosition = position;
+    return true;
+}
+
+#ifdef ALIBAVA_TELESCOPE_READAHEAD
+
+std::unique_ptr < LCEvent > AlibavaTelescopeReader::readAt ( size_t position, bool & endOfFile )
+{
+    endOfFile = false;
+    try
+    {
+	if ( seekSequential ( position ) )
+	{
+	    std::unique_ptr < LCEvent > evt = _reader -> readNextEvent ( );
+	    _readPosition = position + 1;
+	    if ( evt == nullptr )
+	    {
+		endOfFile = true;
+		_readPosition = npos;
+	    }
+	    return evt;
+	}
+	_readPosition = npos;
+	return _reader -> readEvent ( _index[position].first, _index[position].second );
+    }
+    catch ( EndOfDataException& )
+    {
+	// skipped past the last event
+	endOfFile = true;
+	_readPosition = npos;
+	return std::unique_ptr < LCEvent > ( );
+    }
+    catch ( IOException& e )
+    {
+	_readPosition = npos;
+	streamlog_out ( ERROR1 ) << "FAIL: " << e.what ( ) << endl;
+	return std::unique_ptr < LCEvent > ( );
+    }
+}
+
+void AlibavaTelescopeReader::readAheadLoop ( )
+{
+    std::unique_lock < std::mutex > lock ( _mutex );
+    while ( true )
+    {
+	_condition.wait ( lock, [this] { return _stop || ( _nextToRead < _endPosition && _queue.size ( ) < _readAhead ); } );
+	if ( _stop )
+	{
+	    return;
+	}
+
+	const size_t position = _nextToRead;
+	const unsigned int generation = _generation;
+	_nextToRead++;
+
+	// the file is read without blocking the consumer
+	lock.unlock ( );
+	std::unique_ptr < LCEvent > evt;
+	bool endOfFile = false;
+	{
+	    std::lock_guard < std::mutex > readerLock ( _readerMutex );
+	    evt = readAt ( position, endOfFile );
+	}
+	lock.lock ( );
+
+	if ( endOfFile && position < _endPosition )
+	{
+	    _endPosition = position;
+	}
+	if ( generation == _generation )
+	{
+	    _queue.push_back ( std::move ( evt ) );
+	    _condition.notify_all ( );
+	}
+    }
+}
+
+LCEvent * AlibavaTelescopeReader::getEventAt ( size_t position )
+{
+    if ( !_open )
+    {
+	return nullptr;
+    }
+
+    if ( !_thread.joinable ( ) )
+    {
+	if ( position >= _endPosition )
+	{
+	    return nullptr;
+	}
+	std::lock_guard < std::mutex > readerLock ( _readerMutex );
+	bool endOfFile = false;
+	_current = readAt ( position, endOfFile );
+	if ( endOfFile )
+	{
+	    _endPosition = position;
+	}
+	return _current.get ( );
+    }
+
+    std::unique_lock < std::mutex > lock ( _mutex );
+    if ( position >= _endPosition )
+    {
+	return nullptr;
+    }
+
+    // anything not queued or in flight means we jump: drop the queue and restart the thread there
+    if ( position < _queueStart || position >= _nextToRead )
+    {
+	_queue.clear ( );
+	_queueStart = position;
+	_nextToRead = position;
+	_generation++;
+	_condition.notify_all ( );
+    }
+
+    _condition.wait ( lock, [this, position] { return _stop || position >= _endPosition || position < _queueStart + _queue.size ( ); } );
+    if ( _stop || position >= _endPosition )
+    {
+	return nullptr;
+    }
+
+    // events we skipped over are dropped, the one we want is handed out
+    while ( _queueStart < position )
+    {
+	_queue.pop_front ( );
+	_queueStart++;
+    }
+    _current = std::move ( _queue.front ( ) );
+    _queue.pop_front ( );
+    _queueStart++;
+    _condition.notify_all ( );
+
+    return _current.get ( );
+}
+
+#else
+
+LCEvent * AlibavaTelescopeReader::readAt ( size_t position, bool & endOfFile )
+{
+    endOfFile = false;
+    try
+    {
+	if ( seekSequential ( position ) )
+	{
+	    LCEvent * evt = _reader -> readNextEvent ( );
+	    _readPosition = position + 1;
+	    if ( evt == nullptr )
+	    {
+		endOfFile = true;
+		_readPosition = npos;
+	    }
+	    return evt;
+	}
+	_readPosition = npos;
+	return _reader -> readEvent ( _index[position].first, _index[position].second );
+    }
+    catch ( EndOfDataException& )
+    {
+	// skipped past the last event
+	endOfFile = true;
+	_readPosition = npos;
+	return nullptr;
+    }
+    catch ( IOException& e )
+    {
+	_readPosition = npos;
+	streamlog_out ( ERROR1 ) << "FAIL: " << e.what ( ) << endl;
+	return nullptr;
+    }
+}
+
+LCEvent * AlibavaTelescopeReader::getEventAt ( size_t position )
+{
+    if ( !_open || position >= _endPosition )
+    {
+	return nullptr;
+    }
+
+    bool endOfFile = false;
+    LCEvent * evt = readAt ( position, endOfFile );
+    if ( endOfFile )
+    {
+	_endPosition = position;
+    }
+    return evt;
+}
+
+#endif
@@ -59,6 +59,7 @@
 #include "EUTELESCOPE.h"
 #include "EUTelEventImpl.h"
 #include "EUTelRunHeaderImpl.h"
+#include "EUTelStripClusterer.h"
 
 #include "CBCClustering.h"
 
@@ -71,7 +72,9 @@ using namespace eutelescope;
 
 
 CBCClustering::CBCClustering ( ) : Processor ( "CBCClustering" ),
-_aidaHistoMap ( )
+_aidaHistoMap ( ),
+_stripClusterer ( ),
+_stripClusters ( )
 {
 
     _description = "CBCClustering clusters the CBC data stream.";
@@ -172,8 +175,7 @@ void CBCClustering::processEvent ( LCEvent * anEvent )
                 {
 		    TrackerDataImpl * trkdata = dynamic_cast < TrackerDataImpl * > ( inputCollectionVec -> getElementAt ( i ) );
 
-		    FloatVec datavec;
-		    datavec = trkdata -> getChargeValues ( );
+		    const FloatVec & datavec = trkdata -> getChargeValues ( );
 
 		    /*
 		    if ( _zsmode != 0 && ( _zsmode != ( i + 1 ) ) )
@@ -263,133 +265,44 @@ void CBCClustering::processEvent ( LCEvent * anEvent )
 		    }
 		    */
 
-		    std::vector < int > clusterNumber;
-		    
-		    
-		    
-		    if ( _zsmode == 0 )
-		    {
-			clusterNumber.assign ( datavec.size ( ), 0 );
+		    // the histograms of this sensor
+		    AIDA::IHistogram1D * hitmapHisto = dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["Hitmap_" + to_string ( _outputSensorID + i ) ] );
+		    AIDA::IHistogram1D * chargeHisto = dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ClusterCharge_" + to_string ( _outputSensorID + i ) ] );
+		    AIDA::IHistogram1D * sizeHisto = dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ClusterSize_" + to_string ( _outputSensorID + i ) ] );
 
-			for ( size_t ichan = 0; ichan < datavec.size ( ); ichan++ )
+		    // pack the hit strips into bit words, in ZS mode the data is x,y,q,t
+		    const bool zsData = ( _zsmode > 0 );
+		    if ( zsData )
+		    {
+			streamlog_out ( DEBUG4 ) << "Using ZS mode, sensor " << i << endl;
+			_stripClusterer.reset ( _chancount );
+			const size_t coordinate = ( _nonsensitiveaxis == "y" ) ? 0 : 1;
+			for ( size_t ix = 0; ix + 3 < datavec.size ( ); ix = ix + 4 )
 			{
-			    int cluleft = 0;
-			    int cluright = 0;
-			    int clusize = 0;
-
-			    if ( datavec[ichan] * 1.0 > 0 )
-			    {
-				streamlog_out ( DEBUG0 ) << "Chan " << ichan << " over threshold" << endl;
-				cluleft = ichan;
-				cluright = ichan;
-				bool search = true;
-				nClusters++;
-				clusize++;
-				dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["Hitmap_" + to_string ( _outputSensorID + i ) ] ) -> fill ( ichan );
-				while ( search == true )
-				{
-				    if ( ( ichan + 1 ) < ( datavec.size ( ) - 1 ) )
-				    {
-					ichan++;
-					if ( datavec[ichan] > 0 )
-					{
-					    if ( clusize < _maxclustersize )
-					    {
-						cluright = ichan;
-						clusize++;
-						dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["Hitmap_" + to_string ( _outputSensorID + i ) ] ) -> fill ( ichan );
-						streamlog_out ( DEBUG1 ) << "Chan " << ichan << " added to cluster, size now " << clusize << endl;
-					    }
-					    else
-					    {
-						streamlog_out ( DEBUG4 ) << "Cluster size larger than allowed max cluster size of " << _maxclustersize << "! Discarding cluster in event " << anEvent -> getEventNumber ( ) << "!" << endl;
-						search = false;
-					    }
-					}
-					else
-					{
-					    search = false;
-					}
-				    }
-				    else
-				    {
-					search = false;
-				    }
-				}
-				for ( int k = cluleft; k <= cluright; k++ )
-				{
-				    clusterNumber.at ( k ) = nClusters;
-				}
-			    }
+			    _stripClusterer.setStrip ( static_cast < int > ( datavec[ix + coordinate] ) );
 			}
-
 		    }
+		    else
+		    {
+			_stripClusterer.setStrips ( datavec.data ( ), static_cast < int > ( datavec.size ( ) ) );
+		    }
+
+		    _stripClusters.clear ( );
+		    _stripClusterer.findClusters ( _maxclustersize, _stripClusters );
+		    nClusters = static_cast < int > ( _stripClusters.size ( ) );
 
-		    if ( _zsmode > 0 )
+		    for ( size_t icluster = 0; icluster < _stripClusters.size ( ); icluster++ )
 		    {
-			streamlog_out ( DEBUG4 ) << "Using ZS mode, sensor " << i << endl;
-			clusterNumber.assign ( _chancount, 0 );
-			int clupos = -2;
-			int temppos = -2;
-			int clusize = 0;
-			if ( datavec.size ( ) > 0 )
-			{
-			    if ( _nonsensitiveaxis == "y" )
-			    {
-				for ( size_t ix = 0; ix <= ( datavec.size ( ) - 4 ); ix = ix + 4 )
-				{
-				    clupos = datavec[ix];
-				    if ( ( ( clupos - temppos ) == 1 ) && clusize < _maxclustersize )
-				    {
-					clusterNumber.at ( clupos ) = nClusters;
-					temppos = clupos;
-					clusize++;
-					streamlog_out ( DEBUG4 ) << "Enlarged cluster at " << clupos << endl;
-					dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["Hitmap_" + to_string ( _outputSensorID + i ) ] ) -> fill ( clupos );
-				    }
-				    else
-				    {
-					nClusters++;
-					clusterNumber.at ( clupos ) = nClusters;
-					streamlog_out ( DEBUG4 ) << "Found new cluster at " << clupos << endl;
-					temppos = clupos;
-					clusize = 1;
-					dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["Hitmap_" + to_string ( _outputSensorID + i ) ] ) -> fill ( clupos );
-				    }
-				}
-			    }
-			    if ( _nonsensitiveaxis == "x" )
-			    {
-				for ( size_t ix = 0; ix <= ( datavec.size ( ) - 4 ); ix = ix + 4 )
-				{
-				    clupos = datavec[ix + 1];
-				    if ( ( ( clupos - temppos ) == 1 ) && clusize < _maxclustersize )
-				    {
-					clusterNumber.at ( clupos ) = nClusters;
-					temppos = clupos;
-					clusize++;
-				    }
-				    else
-				    {
-					nClusters++;
-					clusterNumber.at ( clupos ) = nClusters;
-					temppos = clupos;
-					clusize = 1;
-				    }
-				}
-			    }
-			}
-			datavec.clear ( );
-			for ( size_t ii = 0; ii < clusterNumber.size ( ); ii++ )
+			const EUTelStripClusterer::StripCluster & cluster = _stripClusters[icluster];
+			for ( int strip = cluster.first; strip < cluster.first + cluster.size; strip++ )
 			{
-			    datavec.push_back ( clusterNumber.at ( ii ) );
+			    hitmapHisto -> fill ( strip );
 			}
-			
 		    }
 
 		    if ( nClusters > _maxclusters )
 		    {
-			clusterNumber.assign ( _chancount, 0 );
+			_stripClusters.clear ( );
 			streamlog_out ( DEBUG4 ) << "Found " << nClusters << " clusters in event " << anEvent -> getEventNumber ( ) << "! Discarding all of them!" << endl;
 		    }
 
@@ -397,108 +310,84 @@ void CBCClustering::processEvent ( LCEvent * anEvent )
 		    CellIDEncoder < TrackerPulseImpl > zsDataEncoder ( eutelescope::EUTELESCOPE::PULSEDEFAULTENCODING, clusterCollection );
 		    CellIDEncoder < TrackerDataImpl > idClusterEncoder ( eutelescope::EUTELESCOPE::ZSCLUSTERDEFAULTENCODING, sparseClusterCollectionVec );
 
-		    // decode datavec into pixelvec, each chan goes into a pixel
-		    //std::vector < eutelescope::EUTelGenericSparsePixel* > PixelVec;
-		    std::vector<EUTelGenericSparsePixel> PixelVec;
-		    eutelescope::EUTelGenericSparsePixel Pixel;
-		    std::unique_ptr < EUTelTrackerDataInterfacerImpl < EUTelGenericSparsePixel > > pixelData = std::make_unique < EUTelTrackerDataInterfacerImpl < EUTelGenericSparsePixel > > ( trkdata );
-		    for ( unsigned int iPixel = 0; iPixel < datavec.size ( ); iPixel++ )
+		    for ( size_t icluster = 0; icluster < _stripClusters.size ( ); icluster++ )
 		    {
-			if ( _nonsensitiveaxis == "x" )
-			{
-			    Pixel.setXCoord ( 0.0 );
-			    Pixel.setYCoord ( iPixel );
-			}
-			else
-			{
-			    Pixel.setXCoord ( iPixel );
-			    Pixel.setYCoord ( 0.0 );
-			}
-			Pixel.setSignal ( datavec[iPixel] * 1.0 );
-			PixelVec.push_back ( Pixel );
-			streamlog_out ( DEBUG0 ) << "Decoded pixel with coordinates: ( " << Pixel.getXCoord ( ) << " , " << Pixel.getYCoord ( ) << " ) and charge: " << datavec[iPixel] << " !" << endl;
-			streamlog_out ( DEBUG0 ) << "Input was: " << PixelVec.at ( iPixel ) << endl;
-		    }
+			const EUTelStripClusterer::StripCluster & cluster = _stripClusters[icluster];
 
-		    std::vector < int > ::iterator it;
-		    for ( it = clusterNumber.begin ( ); it != clusterNumber.end ( ); ++it )
-		    {
-			lcio::TrackerPulseImpl * pulseFrame = new lcio::TrackerPulseImpl ( );
+			// the strips go straight into the sparse data as x, y, q, t. ZS data is binary, dense data keeps its strip values
 			lcio::TrackerDataImpl * clusterFrame = new lcio::TrackerDataImpl ( );
-			eutelescope::EUTelSparseClusterImpl < eutelescope::EUTelGenericSparsePixel > *pixelCluster = new eutelescope::EUTelSparseClusterImpl < eutelescope::EUTelGenericSparsePixel > ( clusterFrame );
-			
-			for ( size_t j = 0; j < datavec.size ( ); j++ )
-			{
-			    if ( clusterNumber.at ( j ) == *it ) 
-			    {
-				if ( clusterNumber.at ( j ) > 0 )
-				{
-				    // put only these pixels in that ClusterCollection that belong to that cluster
-				    auto temppix = PixelVec.at(i);
-				    pixelCluster -> push_back ( temppix );
-				    streamlog_out ( DEBUG1 ) << "Evt " << anEvent -> getEventNumber ( )<<" Adding channel " << j << " to cluster " << clusterNumber.at ( j ) << endl;
-				    if ( it != clusterNumber.end ( ) - 1 )
-				    {
-					++it;
-				    }
-				}
-			    }
-			}
-
-			// now we have pixelClusters with the corresponding pixels (which have the xy and q info) in them
-			// this if stops making the "zero" cluster with all strips not in a cluster...
-			unsigned int clumin = 1;
-			unsigned int clumax = 99;
-			if ( ( pixelCluster -> size ( ) >= clumin ) && ( pixelCluster -> size ( ) <= clumax ) && ( pixelCluster -> getTotalCharge ( ) >= 1 ) ) 
+			FloatVec & pixels = clusterFrame -> chargeValues ( );
+			pixels.reserve ( 4 * cluster.size );
+			float charge = 0.0;
+			float position = 0.0;
+			for ( int strip = cluster.first; strip < cluster.first + cluster.size; strip++ )
 			{
-
-			    // make a frame of each cluster and give it position, charge, etc. Then push back into clusterCollection and sparseClusterCollectionVec.
-			    float x, y = 0;
-			    int xsize, ysize = 0;
-			    float charge = 0.0;
-			    charge = pixelCluster -> getTotalCharge ( );
-			    pulseFrame -> setCharge ( charge );
-			    pixelCluster -> getCenterOfGravity ( x, y );
-			    pixelCluster -> getClusterSize ( xsize, ysize );
-
-			    streamlog_out( DEBUG1 ) << "Cluster: " << *it << ", Q: " << charge << " , x: " << x << " , y: " << y << " , dx: " << xsize << " , dy: " << ysize << " in event: " << anEvent -> getEventNumber ( ) << endl;
-
-			    dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ClusterCharge_" + to_string ( _outputSensorID + i ) ] ) -> fill ( charge );
+			    const float signal = zsData ? 1.0f : datavec[strip];
 			    if ( _nonsensitiveaxis == "x" )
 			    {
-				dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ClusterSize_" + to_string ( _outputSensorID + i ) ] ) -> fill ( ysize );
+				pixels.push_back ( 0.0 );
+				pixels.push_back ( strip );
 			    }
-			    if ( _nonsensitiveaxis == "y" )
+			    else
 			    {
-				dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ClusterSize_" + to_string ( _outputSensorID + i ) ] ) -> fill ( xsize );
+				pixels.push_back ( strip );
+				pixels.push_back ( 0.0 );
 			    }
-
-			    zsDataEncoder["sensorID"] = _outputSensorID + i;
-			    zsDataEncoder["xSeed"] = static_cast < long > ( x );
-			    zsDataEncoder["ySeed"] = static_cast < long > ( y );
-			    zsDataEncoder["xCluSize"] = xsize;
-			    zsDataEncoder["yCluSize"] = ysize;
-			    zsDataEncoder["type"] = static_cast < int > ( kEUTelSparseClusterImpl );
-			    zsDataEncoder["quality"] =  0;
-			    zsDataEncoder.setCellID ( pulseFrame );
-			    pulseFrame -> setTrackerData ( clusterFrame );
-			    clusterCollection -> push_back ( pulseFrame );
-
-			    idClusterEncoder["sensorID"] = _outputSensorID + i;
-			    idClusterEncoder["sparsePixelType"] = 2;
-			    idClusterEncoder["quality"] = 0;
-			    idClusterEncoder.setCellID ( clusterFrame );
-			    sparseClusterCollectionVec -> push_back ( clusterFrame );
+			    pixels.push_back ( signal );
+			    pixels.push_back ( 0.0 );
+			    charge += signal;
+			    position += strip * signal;
+			    streamlog_out ( DEBUG1 ) << "Evt " << anEvent -> getEventNumber ( ) << " Adding channel " << strip << " to cluster " << icluster + 1 << endl;
 			}
-			else // clean up
+
+			// this stops making clusters without charge
+			if ( charge < 1 )
 			{
-			    delete pulseFrame;
 			    delete clusterFrame;
+			    continue;
 			}
 
-			delete pixelCluster;
+			// make a frame of each cluster and give it position, charge, etc. Then push back into clusterCollection and sparseClusterCollectionVec.
+			float x = 0.0;
+			float y = 0.0;
+			int xsize = 1;
+			int ysize = 1;
+			if ( _nonsensitiveaxis == "x" )
+			{
+			    y = position / charge;
+			    ysize = cluster.size;
+			    sizeHisto -> fill ( ysize );
+			}
+			else
+			{
+			    x = position / charge;
+			    xsize = cluster.size;
+			    sizeHisto -> fill ( xsize );
+			}
+			chargeHisto -> fill ( charge );
 
-		    } // done clusterNumber iteration
+			streamlog_out( DEBUG1 ) << "Cluster: " << icluster + 1 << ", Q: " << charge << " , x: " << x << " , y: " << y << " , dx: " << xsize << " , dy: " << ysize << " in event: " << anEvent -> getEventNumber ( ) << endl;
+
+			lcio::TrackerPulseImpl * pulseFrame = new lcio::TrackerPulseImpl ( );
+			pulseFrame -> setCharge ( charge );
+			zsDataEncoder["sensorID"] = _outputSensorID + i;
+			zsDataEncoder["xSeed"] = static_cast < long > ( x );
+			zsDataEncoder["ySeed"] = static_cast < long > ( y );
+			zsDataEncoder["xCluSize"] = xsize;
+			zsDataEncoder["yCluSize"] = ysize;
+			zsDataEncoder["type"] = static_cast < int > ( kEUTelSparseClusterImpl );
+			zsDataEncoder["quality"] =  0;
+			zsDataEncoder.setCellID ( pulseFrame );
+			pulseFrame -> setTrackerData ( clusterFrame );
+			clusterCollection -> push_back ( pulseFrame );
+
+			idClusterEncoder["sensorID"] = _outputSensorID + i;
+			idClusterEncoder["sparsePixelType"] = 2;
+			idClusterEncoder["quality"] = 0;
+			idClusterEncoder.setCellID ( clusterFrame );
+			sparseClusterCollectionVec -> push_back ( clusterFrame );
+
+		    } // done cluster loop
 
 		}
 	    }
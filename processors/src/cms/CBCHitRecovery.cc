@@ -69,7 +69,22 @@ using namespace eutelescope;
 
 
 CBCHitRecovery::CBCHitRecovery ( ) : Processor ( "CBCHitRecovery" ),
-_aidaHistoMap ( )
+_recoveryWindow ( 1.5 ),
+_VirtualDutNormal_zplus ( Eigen::Vector3d::Zero ( ) ),
+_VirtualDutNormal_zminus ( Eigen::Vector3d::Zero ( ) ),
+_VirtualDutPos ( Eigen::Vector3d::Zero ( ) ),
+_dutPosMap ( ),
+_dutNormalMap ( ),
+_aidaHistoMap ( ),
+_trackVirtualHits ( ),
+_trackUpstream ( ),
+_trackDownstream ( ),
+_impactsDut0 ( ),
+_impactsDut1 ( ),
+_virtualHits ( ),
+_dut0Hits ( ),
+_dut1Hits ( ),
+_hitRecovered ( )
 {
 
     _description = "CBCHitRecovery recovers the real hit positions from the virtual dut and track.";
@@ -85,6 +100,8 @@ _aidaHistoMap ( )
     registerProcessorParameter ( "CBCVirtualDUTId", "The id of the virtual CBC DUT", _cbcVirtualDUTId, 0 );
     
     registerProcessorParameter ( "CBCRealDUTsVec", "The ids of the real DUTs (has to be two)", _cbcRealDUTsVec, std::vector < int > () );
+
+    registerOptionalParameter ( "RecoveryWindow", "The window in x around the track impact in which DUT hits are recovered [mm], 0 uses all hits", _recoveryWindow, 1.5 );
 }
 
 
@@ -106,28 +123,21 @@ void CBCHitRecovery::init ( )
                         double beta  = _siPlanesLayerLayout -> getLayerRotationZX ( i );
 
                         // we need to calculate the normal vectors 
-                        double *normalvector = new double[3];
-                        normalvector[0] = sin ( beta * PI / 180.0 );
-                        normalvector[1] = -sin ( alpha * PI / 180.0 );
-                        normalvector[2] = cos ( alpha * PI / 180.0 ) * cos ( beta * PI / 180.0 );
+                        Eigen::Vector3d normalvector;
+                        normalvector << sin ( beta * PI / 180.0 ), -sin ( alpha * PI / 180.0 ), cos ( alpha * PI / 180.0 ) * cos ( beta * PI / 180.0 );
 
                         // put it to the map now
-                        _dutNormalMap.insert ( make_pair ( cPlaneID, normalvector ) );
+                        _dutNormalMap[cPlaneID] = normalvector;
 
-                        // we need to calculate the normal vectors 
-                        double *posvector = new double[3];
-                        posvector[0] = _siPlanesLayerLayout -> getLayerPositionX( i );
-                        posvector[1] = _siPlanesLayerLayout -> getLayerPositionY( i );
-                        posvector[2] = _siPlanesLayerLayout -> getLayerPositionZ( i ) + 0.5 *_siPlanesLayerLayout -> getSensitiveThickness( i );
+                        // and the position of the sensor centre
+                        Eigen::Vector3d posvector;
+                        posvector << _siPlanesLayerLayout -> getLayerPositionX( i ), _siPlanesLayerLayout -> getLayerPositionY( i ), _siPlanesLayerLayout -> getLayerPositionZ( i ) + 0.5 *_siPlanesLayerLayout -> getSensitiveThickness( i );
 
                         // put it to the map now
-                        _dutPosMap.insert ( make_pair ( cPlaneID, posvector ) );
+                        _dutPosMap[cPlaneID] = posvector;
 
-                        // test if it was saved properly
-                        double *pos_test = _dutPosMap.at(cPlaneID);
-                        streamlog_out ( MESSAGE2 ) << "The position vector of the DUT" << cPlaneID << " is: X = " << pos_test[0] << ", Y = " << pos_test[1] << ", Z = " << pos_test[2] << endl;
-                        double *normal_test = _dutNormalMap.at(cPlaneID);
-                        streamlog_out ( MESSAGE2 ) << "The normal vector of the DUT" << cPlaneID << " is: X = " << normal_test[0] << ", Y = " << normal_test[1] << ", Z = " << normal_test[2] << endl;
+                        streamlog_out ( MESSAGE2 ) << "The position vector of the DUT" << cPlaneID << " is: X = " << posvector[0] << ", Y = " << posvector[1] << ", Z = " << posvector[2] << endl;
+                        streamlog_out ( MESSAGE2 ) << "The normal vector of the DUT" << cPlaneID << " is: X = " << normalvector[0] << ", Y = " << normalvector[1] << ", Z = " << normalvector[2] << endl;
                 }               
         }
 }
@@ -154,12 +164,13 @@ void CBCHitRecovery::processEvent ( LCEvent * anEvent )
     }
 
         // the collection we read
-        //LCCollectionVec * inputTrackVec;
+        LCCollectionVec * inputTrackVec = nullptr;
         LCCollectionVec * inputFitPointVec;
         LCCollectionVec * inputHitsVec;
         
         // the collection we output
         LCCollectionVec * outputCollectionVec;
+        bool outputIsNew = false;
 
         try
         {
@@ -168,15 +179,20 @@ void CBCHitRecovery::processEvent ( LCEvent * anEvent )
         catch ( lcio::DataNotAvailableException& e )
         {
             outputCollectionVec = new LCCollectionVec(LCIO::TRACKERHIT);
+            outputIsNew = true;
         }
 
         // find process the tracks
         try
         {
                 // give the collection vec its data
-                //inputTrackVec = dynamic_cast < LCCollectionVec * > ( anEvent -> getCollection ( _InputTrackCollectionName ) );
                 inputFitPointVec = dynamic_cast < LCCollectionVec * > ( anEvent -> getCollection ( _InputFitHitsCollectionName ) );
                 inputHitsVec = dynamic_cast < LCCollectionVec * > ( anEvent -> getCollection ( _cbcInputCollectionName ) );
+
+                if ( outputIsNew )
+                {
+                        outputCollectionVec -> parameters ( ).setValue ( LCIO::CellIDEncoding, inputHitsVec -> getParameters ( ).getStringVal ( LCIO::CellIDEncoding ) );
+                }
                 
                 // getting the DUT normal vector in the first event
                 if( anEvent -> getEventNumber ( ) == 0 ) {
@@ -185,51 +201,42 @@ void CBCHitRecovery::processEvent ( LCEvent * anEvent )
                         // get object
                         LCGenericObjectImpl* dutnormalvec = dynamic_cast < LCGenericObjectImpl * > (dutnormalvec_collection->at(0));
 
-                        // allocare
-                        _VirtualDutNormal_zplus = new double[3];
-                        _VirtualDutNormal_zminus = new double[3];
-                        _VirtualDutPos = new double[3];
-
                         // dut normal vec                       
                         for(int i = 0; i < 3; i++) {
                                 _VirtualDutNormal_zplus[i] = dutnormalvec->getDoubleVal(i+3);   
-                                _VirtualDutNormal_zminus[i] = dutnormalvec->getDoubleVal(i+3);  
                                 _VirtualDutPos[i] = dutnormalvec->getDoubleVal(i)/1000.0;       
                         }
                         // we need to get the opposite normal vec for pointing upstream
+                        _VirtualDutNormal_zminus = _VirtualDutNormal_zplus;
                         _VirtualDutNormal_zminus[2] = -1*_VirtualDutNormal_zminus[2];
 
                         streamlog_out ( MESSAGE4 ) << "Loaded the DUT Pos Vector: X = " << _VirtualDutPos[0] << ", Y = " << _VirtualDutPos[1] << ", Z = " << _VirtualDutPos[2] << endl;
                         streamlog_out ( MESSAGE4 ) << "Loaded the DUT Normal Vector: X = " << _VirtualDutNormal_zplus[0] << ", Y = " << _VirtualDutNormal_zplus[1] << ", Z = " << _VirtualDutNormal_zplus[2] << endl;
-                
-                        //delete dutnormalvec;
-                        //delete dutnormalvec_collection;
                 }
 
-                
-                /*// loop over the tracks in the event
-                int nTracks = inputTrackVec -> getNumberOfElements ( );
-                for ( int i = 0; i < nTracks; ++i ) 
+                // the track collection is optional, without it the fit hits are taken as one track
+                try
+                {
+                        inputTrackVec = dynamic_cast < LCCollectionVec * > ( anEvent -> getCollection ( _InputTrackCollectionName ) );
+                }
+                catch ( lcio::DataNotAvailableException& )
                 {
-                    TrackImpl * track = dynamic_cast < TrackImpl * > ( inputTrackVec -> getElementAt ( i ) );
+                        inputTrackVec = nullptr;
+                }
 
-                    //delete track;
-                }*/
+                // collect the virtual hit and the telescope planes 2 and 3 of every track
+                _trackVirtualHits.clear ( );
+                _trackUpstream.clear ( );
+                _trackDownstream.clear ( );
 
-                // variables
+                CellIDDecoder < TrackerHitImpl > fitHitDecoder ( inputFitPointVec );
                 const double *cTelescope2Pos = nullptr;
                 const double *cVirtualHitPos = nullptr;
                 const double *cTelescope3Pos = nullptr;
 
-                // find the fit hit points of the track (needed to calculate the fir hits in the dut
-                int nEntries = inputFitPointVec -> getNumberOfElements ( );
-                for ( int i = 0; i < nEntries; ++i ) 
+                auto collectFitHit = [&] ( TrackerHitImpl * hit )
                 {
-                    TrackerHitImpl * hit = dynamic_cast < TrackerHitImpl * > ( inputFitPointVec -> getElementAt ( i ) );
-
-                    // sensor id decoder
-                    CellIDDecoder < TrackerHitImpl > inputCellIDDecoder ( inputFitPointVec );
-                    int sensorID = inputCellIDDecoder ( hit ) ["sensorID"];
+                    int sensorID = fitHitDecoder ( hit ) ["sensorID"];
                     // check that we are on the virtual cbc hit
                     if (sensorID == _cbcVirtualDUTId) {
                         cVirtualHitPos = hit->getPosition();
@@ -242,94 +249,124 @@ void CBCHitRecovery::processEvent ( LCEvent * anEvent )
                     } else if (sensorID == 3) {
                         cTelescope3Pos = hit->getPosition();
                     }
+                };
 
-                    //delete hit;
-                }
+                auto storeTrack = [&] ( )
+                {
+                    if (cTelescope2Pos == nullptr || cVirtualHitPos == nullptr || cTelescope3Pos == nullptr) {
+                            streamlog_out ( WARNING ) << "No fit hit for some of the planes in the event " <<  anEvent -> getEventNumber ( ) << endl;
+                    } else {
+                            const Eigen::Map < const Eigen::Vector3d > virtualHit ( cVirtualHitPos );
+                            _trackVirtualHits.push_back ( virtualHit );
+                            // track from upstream (it pointed from dut to the telescope plane 2, then we will reconstruct sensor 60 hit)
+                            _trackUpstream.push_back ( Eigen::Map < const Eigen::Vector3d > ( cTelescope2Pos ) - virtualHit );
+                            // track to downstream
+                            _trackDownstream.push_back ( Eigen::Map < const Eigen::Vector3d > ( cTelescope3Pos ) - virtualHit );
+                    }
+                    cTelescope2Pos = nullptr;
+                    cVirtualHitPos = nullptr;
+                    cTelescope3Pos = nullptr;
+                };
 
-                // check that there are tracks in the event
-                if (nEntries != 0) {
-                        // and that we have succeeded to get the track positions
-                        if (cTelescope2Pos == nullptr || cVirtualHitPos == nullptr || cTelescope3Pos == nullptr) {
-                                streamlog_out ( WARNING ) << "No fit hit for some of the planes in the event " <<  anEvent -> getEventNumber ( ) << endl;
-                        } else {
-                                // track from upstream (it pointed from dut to the telescope plane 2, then we will reconstruct sensor 60 hit)
-                                double cTrackVecUpstream[3];
-                                for(int i = 0; i < 3; i++) cTrackVecUpstream[i] = cTelescope2Pos[i] - cVirtualHitPos[i];
-
-                                // track to downstream
-                                double cTrackVecDownstream[3];
-                                for(int i = 0; i < 3; i++) cTrackVecDownstream[i] = cTelescope3Pos[i] - cVirtualHitPos[i];
-
-                                // print more for debugging
-                                /*if (anEvent->getEventNumber() < 50) {
-                                        streamlog_out (DEBUG1) << "vec up: " << cTrackVecUpstream[0] << ", " << cTrackVecUpstream[1] << ", " << cTrackVecUpstream[2] << endl;
-                                        streamlog_out (DEBUG1) << "vec down: " << cTrackVecDownstream[0] << ", " << cTrackVecDownstream[1] << ", " << cTrackVecDownstream[2] << endl;
-                                }*/
-
-                                // cos phi between the vectors
-                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["cosPhi"] ) -> fill (cos_alpha(cTrackVecUpstream,cTrackVecDownstream));
-
-                                // fit hit pos in dut 0
-                                double *fit_hit_pos_dut0 = this->hit_pos(cTrackVecUpstream, _VirtualDutNormal_zminus, cVirtualHitPos, -2.0);
-                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosX_DUT0"] ) -> fill (fit_hit_pos_dut0[0]);
-                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosY_DUT0"] ) -> fill (fit_hit_pos_dut0[1]);
-                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosZ_DUT0"] ) -> fill (fit_hit_pos_dut0[2]);
-
-
-                                // fit hit pos in dut 1
-                                double *fit_hit_pos_dut1 = this->hit_pos(cTrackVecDownstream, _VirtualDutNormal_zplus, cVirtualHitPos, 2.0);
-                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosX_DUT1"] ) -> fill (fit_hit_pos_dut1[0]);
-                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosY_DUT1"] ) -> fill (fit_hit_pos_dut1[1]);
-                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosZ_DUT1"] ) -> fill (fit_hit_pos_dut1[2]);
-
-                                // now calculate the residuals
-                                int nHits = inputHitsVec -> getNumberOfElements ( );
-                                for ( int iHit = 0; iHit < nHits; ++iHit ) {
-                                        TrackerHitImpl * hit = dynamic_cast < TrackerHitImpl * > ( inputHitsVec -> getElementAt ( iHit ) );
-
-                                        // sensor id decoder
-                                        CellIDDecoder < TrackerHitImpl > inputCellIDDecoder ( inputFitPointVec );
-                                        int sensorID = inputCellIDDecoder ( hit ) ["sensorID"];
-
-                                        // virtual
-                                        if (sensorID == _cbcVirtualDUTId) {
-                                                const double *pos = hit->getPosition();
-                                                double resX = (cVirtualHitPos[0] - pos[0])*1000;
-                                                //double resY = (cVirtualHitPos[1] - pos[1])*1000;
-                                                //double resZ = (cVirtualHitPos[2] - pos[2])*1000;
-
-                                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["VirtualResidualX"] ) -> fill (resX);
-                                        }
-
-                                        // first sensor
-                                        if (sensorID == _cbcRealDUTsVec.at(0)) {
-                                                const double *pos = hit->getPosition();
-                                                double resX = (fit_hit_pos_dut0[0] - pos[0])*1000;
-                                                //double resY = (fit_hit_pos_dut0[1] - pos[1])*1000;
-                                                //double resZ = (fit_hit_pos_dut0[2] - pos[2])*1000;
-
-                                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ResidualX_DUT0"] ) -> fill (resX);
-                                        }
-
-                                        // second sensor
-                                        if (sensorID == _cbcRealDUTsVec.at(1)) {
-                                                const double *pos = hit->getPosition();
-                                                double resX = (fit_hit_pos_dut1[0] - pos[0])*1000;
-                                                //double resY = (fit_hit_pos_dut1[1] - pos[1])*1000;
-                                                //double resZ = (fit_hit_pos_dut1[2] - pos[2])*1000;
-
-                                                dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ResidualX_DUT1"] ) -> fill (resX);
-                                        }
+                if ( inputTrackVec != nullptr )
+                {
+                        int nTracks = inputTrackVec -> getNumberOfElements ( );
+                        for ( int i = 0; i < nTracks; ++i ) 
+                        {
+                                TrackImpl * track = dynamic_cast < TrackImpl * > ( inputTrackVec -> getElementAt ( i ) );
+                                const TrackerHitVec & trackHits = track -> getTrackerHits ( );
+                                for ( size_t j = 0; j < trackHits.size ( ); ++j )
+                                {
+                                        collectFitHit ( dynamic_cast < TrackerHitImpl * > ( trackHits[j] ) );
                                 }
+                                storeTrack ( );
+                        }
+                }
+                else
+                {
+                        int nEntries = inputFitPointVec -> getNumberOfElements ( );
+                        for ( int i = 0; i < nEntries; ++i ) 
+                        {
+                                collectFitHit ( dynamic_cast < TrackerHitImpl * > ( inputFitPointVec -> getElementAt ( i ) ) );
+                        }
+                        // check that there are tracks in the event
+                        if ( nEntries != 0 )
+                        {
+                                storeTrack ( );
+                        }
+                }
+
+                // the impact points of all tracks on both duts in one go
+                intersectTracks ( _trackUpstream, _trackVirtualHits, _VirtualDutNormal_zminus, -2.0, _impactsDut0 );
+                intersectTracks ( _trackDownstream, _trackVirtualHits, _VirtualDutNormal_zplus, 2.0, _impactsDut1 );
+
+                // sort the cbc hits of each dut by x for the window search
+                _virtualHits.clear ( );
+                _dut0Hits.clear ( );
+                _dut1Hits.clear ( );
 
-                                // delete the hist positions
-                                delete fit_hit_pos_dut0;
-                                delete fit_hit_pos_dut1;
+                CellIDDecoder < TrackerHitImpl > hitDecoder ( inputHitsVec );
+                int nHits = inputHitsVec -> getNumberOfElements ( );
+                for ( int iHit = 0; iHit < nHits; ++iHit ) {
+                        TrackerHitImpl * hit = dynamic_cast < TrackerHitImpl * > ( inputHitsVec -> getElementAt ( iHit ) );
+                        int sensorID = hitDecoder ( hit ) ["sensorID"];
 
-                                // clear pos vectors
-                                //delete cTelescope2Pos;
-                                //delete cVirtualHitPos;
-                                //delete cTelescope3Pos;
+                        SortedHit sortedHit;
+                        sortedHit.x = hit -> getPosition ( ) [0];
+                        sortedHit.index = iHit;
+
+                        if (sensorID == _cbcVirtualDUTId) {
+                                _virtualHits.push_back ( sortedHit );
+                        }
+                        if (sensorID == _cbcRealDUTsVec.at(0)) {
+                                _dut0Hits.push_back ( sortedHit );
+                        }
+                        if (sensorID == _cbcRealDUTsVec.at(1)) {
+                                _dut1Hits.push_back ( sortedHit );
+                        }
+                }
+
+                auto byX = [] ( const SortedHit & a, const SortedHit & b ) { return a.x < b.x; };
+                std::sort ( _virtualHits.begin ( ), _virtualHits.end ( ), byX );
+                std::sort ( _dut0Hits.begin ( ), _dut0Hits.end ( ), byX );
+                std::sort ( _dut1Hits.begin ( ), _dut1Hits.end ( ), byX );
+
+                _hitRecovered.assign ( nHits, false );
+
+                AIDA::IHistogram1D * cosPhiHisto = dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["cosPhi"] );
+                AIDA::IHistogram1D * virtualResidualHisto = dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["VirtualResidualX"] );
+                AIDA::IHistogram1D * dut0ResidualHisto = dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ResidualX_DUT0"] );
+                AIDA::IHistogram1D * dut1ResidualHisto = dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["ResidualX_DUT1"] );
+
+                for ( size_t iTrack = 0; iTrack < _trackVirtualHits.size ( ); ++iTrack )
+                {
+                        const Eigen::Vector3d & up = _trackUpstream[iTrack];
+                        const Eigen::Vector3d & down = _trackDownstream[iTrack];
+                        const Eigen::Vector3d & dut0 = _impactsDut0[iTrack];
+                        const Eigen::Vector3d & dut1 = _impactsDut1[iTrack];
+
+                        // cos phi between the vectors
+                        cosPhiHisto -> fill ( up.dot ( down ) / ( up.norm ( ) * down.norm ( ) ) );
+
+                        dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosX_DUT0"] ) -> fill (dut0[0]);
+                        dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosY_DUT0"] ) -> fill (dut0[1]);
+                        dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosZ_DUT0"] ) -> fill (dut0[2]);
+
+                        dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosX_DUT1"] ) -> fill (dut1[0]);
+                        dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosY_DUT1"] ) -> fill (dut1[1]);
+                        dynamic_cast < AIDA::IHistogram1D* > ( _aidaHistoMap["FitHitPosZ_DUT1"] ) -> fill (dut1[2]);
+
+                        // the residuals, and the closest hit on each real dut is recovered
+                        recoverHit ( _virtualHits, _trackVirtualHits[iTrack][0], virtualResidualHisto );
+                        const int recovered[2] = { recoverHit ( _dut0Hits, dut0[0], dut0ResidualHisto ), recoverHit ( _dut1Hits, dut1[0], dut1ResidualHisto ) };
+                        for ( int i = 0; i < 2; ++i )
+                        {
+                                if ( recovered[i] >= 0 && !_hitRecovered[recovered[i]] )
+                                {
+                                        _hitRecovered[recovered[i]] = true;
+                                        TrackerHitImpl * hit = dynamic_cast < TrackerHitImpl * > ( inputHitsVec -> getElementAt ( recovered[i] ) );
+                                        outputCollectionVec -> push_back ( new TrackerHitImpl ( *hit ) );
+                                }
                         }
                 }
 
@@ -427,51 +464,39 @@ void CBCHitRecovery::bookHistos ( )
 
 }
 
-// get the module of vector
-double CBCHitRecovery::vector_get_length(const double *vec) {
-        double length = 0;
-        for(int i = 0; i < 3; i++) length += vec[i]*vec[i];
-        return sqrt(length);
-}
+// finds the positions of the fit hits in a real plane, distance is along the normal from the virtual hits
+void CBCHitRecovery::intersectTracks ( const std::vector < Eigen::Vector3d > & directions, const std::vector < Eigen::Vector3d > & virtualHits, const Eigen::Vector3d & normal, double distance, std::vector < Eigen::Vector3d > & impacts )
+{
+        // the track is scaled to the length distance/cos(alpha), alpha - angle between normal and track,
+        // so hit = virtual + track * |distance| * |normal| / (track . normal)
+        const double scale = std::abs ( distance ) * normal.norm ( );
 
-// set certain length of the vector
-void CBCHitRecovery::vector_set_length(double *& vec, double length) {
-        // we also need to normalize it
-        double current_length = vector_get_length(vec);
-        // now set the new length
-        for(int i = 0; i < 3; i++) vec[i] = vec[i]*length/current_length;
+        impacts.resize ( directions.size ( ) );
+        for ( size_t i = 0; i < directions.size ( ); ++i )
+        {
+                impacts[i].noalias ( ) = virtualHits[i] + directions[i] * ( scale / directions[i].dot ( normal ) );
+        }
 }
 
-// angle between two vector
-double CBCHitRecovery::cos_alpha(const double *vec1, const double *vec2) {
-        // variable 
-        double angle = 0;
-        // calculate the scalar
-        for(int i = 0; i < 3; i++) angle += vec1[i]*vec2[i];
-        // now divide by modules
-        angle = angle/(vector_get_length(vec1)*vector_get_length(vec2));
-        // return
-        return angle;   
-}
+// fills the residuals of all hits and returns the index of the closest hit, if it is within the window around x
+int CBCHitRecovery::recoverHit ( const std::vector < SortedHit > & hits, double x, AIDA::IHistogram1D * residualHisto ) const
+{
+        for ( std::vector < SortedHit >::const_iterator it = hits.begin ( ); it != hits.end ( ); ++it )
+        {
+                residualHisto -> fill ( ( x - it -> x ) * 1000 );
+        }
 
-// finds the position of fithit in real plane
-double* CBCHitRecovery::hit_pos(const double track[],const double normal[],const double virtual_hit[], double distance) {
-        // init vector
-        double *pos = new double[3];
-        // module of distance
-        double abs_distance = distance;
-        if(abs_distance < 0) abs_distance = -abs_distance;
-        // create copies of the vectors to modify them
-        double *track1 = new double[3];
-        for(int i = 0; i < 3; i++) {
-                track1[i] = track[i];
+        // the hits are sorted in x, the closest one is the first at or above x or the one before it
+        std::vector < SortedHit >::const_iterator above = std::lower_bound ( hits.begin ( ), hits.end ( ), x, [] ( const SortedHit & hit, double value ) { return hit.x < value; } );
+        std::vector < SortedHit >::const_iterator closest = above;
+        if ( above != hits.begin ( ) && ( above == hits.end ( ) || x - ( above - 1 ) -> x <= above -> x - x ) )
+        {
+                closest = above - 1;
+        }
+
+        if ( closest == hits.end ( ) || ( _recoveryWindow > 0 && std::abs ( x - closest -> x ) > _recoveryWindow ) )
+        {
+                return -1;
         }
-        // set the length of the track vector to distance/cos(alpha), alpha - angle between normal and track
-        vector_set_length(track1, abs_distance/cos_alpha(track, normal));
-        // add two to get the position
-        for(int i = 0; i < 3; i++) pos[i] = track1[i] + virtual_hit[i];
-        // clear
-        delete track1;
-        // return
-        return pos;
+        return closest -> index;
 }
@@ -44,6 +44,8 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <utility>
+#include <algorithm>
 
 // eutelescope includes ""
 #include "anyoption.h"
@@ -51,6 +53,8 @@
 #include "EUTelEventImpl.h"
 #include "EUTelRunHeaderImpl.h"
 
+#include "EUTelGeometryTelescopeGeoDescription.h"
+
 #include "CMSBuncher.h"
 
 
@@ -61,7 +65,16 @@ using namespace IMPL;
 using namespace eutelescope;
 
 
-CMSBuncher::CMSBuncher ( ) : DataSourceProcessor ( "CMSBuncher" )
+CMSBuncher::CMSBuncher ( ) : DataSourceProcessor ( "CMSBuncher" ),
+_frameRing ( ),
+_ringFirst ( 0 ),
+_ringCount ( 0 ),
+_frameBufferSize ( 16 ),
+_telescopeDone ( false ),
+_sensorIDs ( ),
+_sensorSlot ( ),
+_outputOrder ( ),
+_geometrySensorIDs ( )
 {
 
     _description = "CMSBuncher groups events together, based on LCIO time stamps. This mimics a long read-out frame.";
@@ -74,6 +87,8 @@ CMSBuncher::CMSBuncher ( ) : DataSourceProcessor ( "CMSBuncher" )
 
     registerProcessorParameter ( "SingleFrameTime", "The time of a frame. Unit is micro seconds", _singleframetime, 115 );
 
+    registerOptionalParameter ( "FrameBufferSize", "The number of decoded telescope frames kept in the time ordered buffer. Frames arriving this many frames late are still sorted in", _frameBufferSize, 16 );
+
 }
 
 
@@ -89,15 +104,37 @@ void CMSBuncher::init ( )
     printParameters ( );
 
     // set time
-    _frametime = 1;
     _bunchtime = 0;
 
     _evtcount = 0;
 
-    _maxevents = 5;
-
     _telescopeopen = false;
-    _usestorageevent = false;
+    _telescopeDone = false;
+
+    // we write the sensors found in the telescope frames, of these only the ones in the geometry if there is one
+    _geometrySensorIDs.clear ( );
+    if ( Global::GEAR != nullptr )
+    {
+	geo::gGeometry ( ).initializeTGeoDescription ( EUTELESCOPE::GEOFILENAME, EUTELESCOPE::DUMPGEOROOT );
+	_geometrySensorIDs = geo::gGeometry ( ).sensorIDsVec ( );
+	std::sort ( _geometrySensorIDs.begin ( ), _geometrySensorIDs.end ( ) );
+    }
+    else
+    {
+	streamlog_out ( WARNING5 ) << "No geometry, writing all sensors of the telescope frames!" << endl;
+    }
+    _sensorIDs.clear ( );
+    _sensorSlot.clear ( );
+    _outputOrder.clear ( );
+
+    // the ring of decoded frames
+    if ( _frameBufferSize < 1 )
+    {
+	_frameBufferSize = 1;
+    }
+    _frameRing.assign ( _frameBufferSize, BufferedFrame ( ) );
+    _ringFirst = 0;
+    _ringCount = 0;
 }
 
 
@@ -111,8 +148,7 @@ LCEvent *CMSBuncher::readTelescope ( )
 	{
 	    lcReader -> open ( _telescopeFile );
 	    _telescopeopen = true;
-	    _maxevents = lcReader -> getNumberOfEvents ( );
-	     streamlog_out ( MESSAGE4 ) << "Running over " << _maxevents << " events!" << endl;
+	    streamlog_out ( MESSAGE4 ) << "Running over " << lcReader -> getNumberOfEvents ( ) << " events!" << endl;
 	}
 	catch ( IOException& e )
 	{
@@ -138,6 +174,119 @@ LCEvent *CMSBuncher::readTelescope ( )
 }
 
 
+// reads telescope frames into the ring until it is full or the file has ended. Each frame is sorted in by time,
+// usually it just goes to the back
+void CMSBuncher::fillFrameRing ( )
+{
+    while ( _ringCount < _frameRing.size ( ) && _telescopeDone == false )
+    {
+	LCEvent* evt = readTelescope ( );
+	if ( evt == nullptr )
+	{
+	    _telescopeDone = true;
+	    break;
+	}
+
+	size_t slot = ( _ringFirst + _ringCount ) % _frameRing.size ( );
+	decodeFrame ( evt, _frameRing[slot] );
+	_ringCount++;
+
+	for ( size_t k = _ringCount - 1; k > 0; k-- )
+	{
+	    size_t before = ( slot + _frameRing.size ( ) - 1 ) % _frameRing.size ( );
+	    if ( _frameRing[before].time <= _frameRing[slot].time )
+	    {
+		break;
+	    }
+	    std::swap ( _frameRing[before], _frameRing[slot] );
+	    slot = before;
+	}
+    }
+}
+
+// the output slot of a sensor, a sensor is added when it first shows up in a telescope frame
+int CMSBuncher::sensorSlot ( int sensorID )
+{
+    if ( sensorID < 0 )
+    {
+	return -1;
+    }
+    if ( static_cast < size_t > ( sensorID ) < _sensorSlot.size ( ) && _sensorSlot[sensorID] >= 0 )
+    {
+	return _sensorSlot[sensorID];
+    }
+    if ( !_geometrySensorIDs.empty ( ) && !std::binary_search ( _geometrySensorIDs.begin ( ), _geometrySensorIDs.end ( ), sensorID ) )
+    {
+	return -1;
+    }
+
+    if ( static_cast < size_t > ( sensorID ) >= _sensorSlot.size ( ) )
+    {
+	_sensorSlot.resize ( sensorID + 1, -1 );
+    }
+    _sensorSlot[sensorID] = static_cast < int > ( _sensorIDs.size ( ) );
+    _sensorIDs.push_back ( sensorID );
+
+    // the sensors are written by increasing sensorID
+    _outputOrder.clear ( );
+    for ( size_t i = 0; i < _sensorSlot.size ( ); i++ )
+    {
+	if ( _sensorSlot[i] >= 0 )
+	{
+	    _outputOrder.push_back ( static_cast < size_t > ( _sensorSlot[i] ) );
+	}
+    }
+    streamlog_out ( MESSAGE4 ) << "Bunching sensor " << sensorID << ", " << _sensorIDs.size ( ) << " sensors now!" << endl;
+
+    return _sensorSlot[sensorID];
+}
+
+// copies the charge values of a telescope frame into a ring slot, the slot keeps its capacity from frame to frame
+void CMSBuncher::decodeFrame ( LCEvent * evt, BufferedFrame & frame )
+{
+    frame.time = evt -> getTimeStamp ( );
+    for ( size_t i = 0; i < frame.sensorData.size ( ); i++ )
+    {
+	frame.sensorData[i].clear ( );
+    }
+
+    streamlog_out ( DEBUG2 ) << "Read telescope frame has a time of " << frame.time << endl;
+
+    try
+    {
+	LCCollectionVec * telescopeCollectionVec = dynamic_cast < LCCollectionVec * > ( evt -> getCollection ( _inputCollectionName ) );
+	CellIDDecoder < TrackerDataImpl > inputDecoder ( telescopeCollectionVec );
+	int readsize = telescopeCollectionVec -> getNumberOfElements ( );
+	for ( int j = 0; j < readsize; j++ )
+	{
+	    lcio::TrackerDataImpl * input  = dynamic_cast < lcio::TrackerDataImpl * > ( telescopeCollectionVec -> getElementAt ( j ) );
+	    int sensorID = inputDecoder ( input )["sensorID"];
+	    streamlog_out ( DEBUG0 ) << "Reading sensorID " << sensorID << endl;
+
+	    const int slot = sensorSlot ( sensorID );
+	    if ( slot < 0 )
+	    {
+		streamlog_out ( DEBUG1 ) << "Sensor " << sensorID << " is not in the geometry, skipping it" << endl;
+		continue;
+	    }
+
+	    // a sensor showing up for the first time gets its slot in this frame
+	    if ( static_cast < size_t > ( slot ) >= frame.sensorData.size ( ) )
+	    {
+		frame.sensorData.resize ( _sensorIDs.size ( ) );
+	    }
+	    const FloatVec & inputvec = input -> getChargeValues ( );
+	    FloatVec & data = frame.sensorData[slot];
+	    data.insert ( data.end ( ), inputvec.begin ( ), inputvec.end ( ) );
+	}
+    }
+    catch ( lcio::DataNotAvailableException& )
+    {
+	streamlog_out( ERROR1 ) << "Collection " << _inputCollectionName << " not found" << endl;
+    }
+}
+
+
 void CMSBuncher::readDataSource ( int /*numEvents*/ )
 {
     // write an almost empty run header
@@ -146,12 +295,12 @@ void CMSBuncher::readDataSource ( int /*numEvents*/ )
     ProcessorMgr::instance ( ) -> processRunHeader ( lcHeader ) ;
     delete lcHeader;
 
-    // the input collections
-    LCCollectionVec * telescopeCollectionVec;
+    // the size of the last bunch per sensor, to reserve the next one
+    std::vector < size_t > lastSize;
 
-    int bunchcount = 0;
+    fillFrameRing ( );
 
-    while ( bunchcount < ( _maxevents - 1 ) )
+    while ( _ringCount > 0 )
     {
 
 	_bunchtime += _singleframetime;
@@ -166,99 +315,58 @@ void CMSBuncher::readDataSource ( int /*numEvents*/ )
 	event -> parameters ( ) .setValue ( "EventType", 2 );
 	event -> setTimeStamp ( _bunchtime );
 
-	// prepare the output vector for this event
-	vector < float > outputData[10];
-
-	try
+	// the output of this bunch goes straight into the plane data
+	lastSize.resize ( _sensorIDs.size ( ), 0 );
+	std::vector < TrackerDataImpl* > planeData ( _sensorIDs.size ( ), nullptr );
+	for ( size_t i = 0; i < _sensorIDs.size ( ); i++ )
 	{
-	    // process this guy...
-	    LCEvent* evt;
-
-	    bool continueloop = true;
+	    planeData[i] = new TrackerDataImpl ( );
+	    planeData[i] -> chargeValues ( ).reserve ( lastSize[i] );
+	}
 
-	    while ( continueloop == true )
+	// all frames earlier than the end of the bunch
+	while ( _ringCount > 0 && _frameRing[_ringFirst].time < _bunchtime )
+	{
+	    streamlog_out ( DEBUG2 ) << "Adding a telescope frame!" << endl;
+	    const BufferedFrame & frame = _frameRing[_ringFirst];
+	    // sensors showing up for the first time
+	    while ( planeData.size ( ) < frame.sensorData.size ( ) )
 	    {
-		if ( _usestorageevent == false )
-		{
-		    // the telescope is read by the function
-		    bunchcount++;
-		    evt = readTelescope ( );
-		    streamlog_out ( DEBUG4 ) << "Reading telescope bunch " << bunchcount << endl;
-		}
-		else
-		{
-		    evt = _storeevt;
-		    _usestorageevent = false;
-		    streamlog_out ( DEBUG2 ) << "Using stored event!" << endl;
-		}
-
-		_frametime = evt -> getTimeStamp ( );
-		// save for future...
-		_storeevt = evt;
-
-		streamlog_out ( DEBUG2 ) << "Read telescope frame has a time of " << _frametime << endl;
-		
-		if ( _frametime < _bunchtime )
-		{
-		    streamlog_out ( DEBUG2 ) << "Adding a telescope frame!" << endl;
-		}
-		else
-		{
-		    _usestorageevent = true;
-		    continueloop = false;
-		    streamlog_out ( DEBUG2 ) << "Over time, breaking!" << endl;
-		    break;
-		}
-
-		// now read the data
-		telescopeCollectionVec = dynamic_cast < LCCollectionVec * > ( evt -> getCollection ( _inputCollectionName ) );
-		int readsize = telescopeCollectionVec -> getNumberOfElements ( );
-		for ( int j = 0; j < readsize; j++ )
-		{
-		    streamlog_out ( DEBUG1 ) << "Reading telescope ..." << endl;
-		    CellIDDecoder < TrackerDataImpl > inputDecoder ( telescopeCollectionVec );
-		    lcio::TrackerDataImpl * input  = dynamic_cast < lcio::TrackerDataImpl * > ( telescopeCollectionVec -> getElementAt ( j ) );
-		    int sensorID = inputDecoder ( input )["sensorID"];
-		    streamlog_out ( DEBUG0 ) << "Reading sensorID " << sensorID << endl;
-		    FloatVec inputvec;
-		    inputvec = input -> getChargeValues ( );
-
-		    // assume 10 planes tops
-		    for ( int i = 0; i < 10; i++ )
-		    {
-			if ( i == sensorID )
-			{
-			    for ( size_t k = 0; k < inputvec.size ( ); k++ )
-			    {
-				outputData[i].push_back ( inputvec.at ( k ) );
-			    }
-			}
-		    }
-		}
+		planeData.push_back ( new TrackerDataImpl ( ) );
 	    }
-
-	    streamlog_out ( DEBUG4 ) << "Done accumulating, writing!" << endl;
-
-	    for ( int i = 0; i < 6; i++ )
+	    for ( size_t i = 0; i < frame.sensorData.size ( ); i++ )
 	    {
-		TrackerDataImpl* planeData = new TrackerDataImpl ( );
-		encoder["sensorID"] = i;
-		encoder["sparsePixelType"] = 2;
-		encoder.setCellID ( planeData );
-		planeData -> setChargeValues ( outputData[i] );
-		dataCollection -> addElement ( planeData );
+		FloatVec & output = planeData[i] -> chargeValues ( );
+		output.insert ( output.end ( ), frame.sensorData[i].begin ( ), frame.sensorData[i].end ( ) );
 	    }
-	    event -> addCollection ( dataCollection, _outputCollectionName );
-    }
-    catch ( lcio::DataNotAvailableException& )
-    {
-	streamlog_out( ERROR1 ) << "Collection " << _inputCollectionName << " not found" << endl;
-    }
+	    _ringFirst = ( _ringFirst + 1 ) % _frameRing.size ( );
+	    _ringCount--;
+	    fillFrameRing ( );
+	}
+
+	streamlog_out ( DEBUG4 ) << "Done accumulating, writing!" << endl;
+
+	// sensors found in frames of the next bunch are written empty
+	while ( planeData.size ( ) < _sensorIDs.size ( ) )
+	{
+	    planeData.push_back ( new TrackerDataImpl ( ) );
+	}
+	lastSize.resize ( _sensorIDs.size ( ), 0 );
+	for ( size_t j = 0; j < _outputOrder.size ( ); j++ )
+	{
+	    const size_t i = _outputOrder[j];
+	    encoder["sensorID"] = _sensorIDs[i];
+	    encoder["sparsePixelType"] = 2;
+	    encoder.setCellID ( planeData[i] );
+	    lastSize[i] = planeData[i] -> getChargeValues ( ).size ( );
+	    dataCollection -> addElement ( planeData[i] );
+	}
+	event -> addCollection ( dataCollection, _outputCollectionName );
 
-    ProcessorMgr::instance ( ) -> processEvent ( event ) ;
+	ProcessorMgr::instance ( ) -> processEvent ( event ) ;
 
-    _evtcount++;
-    delete event;
+	_evtcount++;
+	delete event;
 
     }
 }
@@ -44,6 +44,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cstdio>
+#include <cmath>
 
 using namespace std;
 using namespace lcio;
@@ -68,7 +69,8 @@ AIDA::IHistogram1D * stubmap_top_y;
 AIDA::IHistogram1D * stubmap_bot_y;
 
 
-CMSStubGenerator::CMSStubGenerator ():Processor ("CMSStubGenerator")
+CMSStubGenerator::CMSStubGenerator ():Processor ("CMSStubGenerator"),
+_candidatesPlane1 (), _candidatesPlane2 (), _fillPairHistos (true)
 {
   // modify processor description
   _description =
@@ -88,6 +90,10 @@ CMSStubGenerator::CMSStubGenerator ():Processor ("CMSStubGenerator")
   registerProcessorParameter ("DUTPlane2", "This is the second DUT sensorID.",
 			      _dutPlane2, 7);
 
+  registerOptionalParameter ("FillPairHistograms",
+			     "Fill the correlation and failed distance plots for every pair of DUT hits? This costs time quadratic in the number of hits",
+			     _fillPairHistos, true);
+
   registerProcessorParameter ("KeepDUTHits",
 			      "Keep the DUT hits in mode 0 after creating subs or discard them?",
 			      _keepDUTHits, true);
@@ -244,75 +250,112 @@ CMSStubGenerator::processEvent (LCEvent * event)
 
   if (_runMode == 0)
     {
-      for (unsigned int iHitPlane1 = 0; iHitPlane1 < dutPlane1Hits.size ();
-	   iHitPlane1++)
+      // reduce the DUT hits of both planes to position and charge once
+      _candidatesPlane1.clear ();
+      _candidatesPlane2.clear ();
+      for (size_t iHit = 0; iHit < dutPlane1Hits.size (); iHit++)
+	{
+	  _candidatesPlane1.push_back (makeCandidate
+				       (inputHitCollection,
+					dutPlane1Hits[iHit]));
+	}
+      for (size_t iHit = 0; iHit < dutPlane2Hits.size (); iHit++)
+	{
+	  _candidatesPlane2.push_back (makeCandidate
+				       (inputHitCollection,
+					dutPlane2Hits[iHit]));
+	}
+
+      // the correlation and failure plots need every pair
+      if (_fillPairHistos)
+	{
+	  for (size_t i1 = 0; i1 < _candidatesPlane1.size (); i1++)
+	    {
+	      const StubCandidate & c1 = _candidatesPlane1[i1];
+	      for (size_t i2 = 0; i2 < _candidatesPlane2.size (); i2++)
+		{
+		  const StubCandidate & c2 = _candidatesPlane2[i2];
+		  streamlog_out (DEBUG0) << " x1 " << c1.x << " y1 " << c1.
+		    y << " q1 " << c1.q << " x2 " << c2.x << " y2 " << c2.
+		    y << " q2 " << c2.q << " evt " << evt->
+		    getRunNumber () << endl;
+
+		  correx->fill (c1.x, c2.x);
+		  correy->fill (c1.y, c2.y);
+
+		  if (!(fabs (c1.x - c2.x) < _maxResidual
+			&& fabs (c1.y - c2.y) < _maxResidual))
+		    {
+		      faildistx->fill (c1.x - c2.x);
+		      faildisty->fill (c1.y - c2.y);
+		    }
+		}
+	    }
+	}
+
+      // sort both planes along the axis with the larger spread, usually the sensitive one
+      float minX = 0.0;
+      float maxX = 0.0;
+      float minY = 0.0;
+      float maxY = 0.0;
+      for (size_t i2 = 0; i2 < _candidatesPlane2.size (); i2++)
+	{
+	  const StubCandidate & c2 = _candidatesPlane2[i2];
+	  minX = (i2 == 0 || c2.x < minX) ? c2.x : minX;
+	  maxX = (i2 == 0 || c2.x > maxX) ? c2.x : maxX;
+	  minY = (i2 == 0 || c2.y < minY) ? c2.y : minY;
+	  maxY = (i2 == 0 || c2.y > maxY) ? c2.y : maxY;
+	}
+      const bool sortX = (maxX - minX >= maxY - minY);
+      auto byKey =[sortX] (const StubCandidate & a, const StubCandidate & b)
+      {
+	return sortX ? a.x < b.x : a.y < b.y;
+      };
+      std::sort (_candidatesPlane1.begin (), _candidatesPlane1.end (), byKey);
+      std::sort (_candidatesPlane2.begin (), _candidatesPlane2.end (), byKey);
+
+      // two pointer sweep: plane 2 hits more than _maxResidual below the current plane 1 hit are never needed again
+      size_t first = 0;
+      for (size_t i1 = 0; i1 < _candidatesPlane1.size (); i1++)
 	{
-	  TrackerHitImpl *Hit1 =
-	    dynamic_cast <
-	    TrackerHitImpl *
-	    >(inputHitCollection->getElementAt (dutPlane1Hits[iHitPlane1]));
-	  float x1 = -1.0;
-	  float y1 = -1.0;
-	  float q1 = -1.0;
-	  const double *pos1 = Hit1->getPosition ();
-	  TrackerDataImpl *clusterVector1 =
-	    static_cast < TrackerDataImpl * >(Hit1->getRawHits ()[0]);
-	  EUTelSimpleVirtualCluster *cluster1 = nullptr;
-	  cluster1 =
-	    new EUTelSparseClusterImpl < EUTelGenericSparsePixel >
-	    (clusterVector1);
-	  if (cluster1 != nullptr)
+	  const StubCandidate & c1 = _candidatesPlane1[i1];
+	  const float key1 = sortX ? c1.x : c1.y;
+	  while (first < _candidatesPlane2.size ()
+		 && key1 - (sortX ? _candidatesPlane2[first].
+			    x : _candidatesPlane2[first].y) >= _maxResidual)
 	    {
-	      cluster1->getCenterOfGravity (x1, y1);
-	      q1 = cluster1->getTotalCharge ();
+	      first++;
 	    }
 
-	  for (unsigned int iHitPlane2 = 0;
-	       iHitPlane2 < dutPlane2Hits.size (); iHitPlane2++)
+	  for (size_t i2 = first; i2 < _candidatesPlane2.size (); i2++)
 	    {
-	      TrackerHitImpl *Hit2 =
-		dynamic_cast <
-		TrackerHitImpl *
-		>(inputHitCollection->
-		  getElementAt (dutPlane2Hits[iHitPlane2]));
-	      float x2 = -1.0;
-	      float y2 = -1.0;
-	      float q2 = -1.0;
-	      const double *pos2 = Hit2->getPosition ();
-	      TrackerDataImpl *clusterVector2 =
-		static_cast < TrackerDataImpl * >(Hit2->getRawHits ()[0]);
-	      EUTelSimpleVirtualCluster *cluster2 = nullptr;
-	      cluster2 =
-		new EUTelSparseClusterImpl < EUTelGenericSparsePixel >
-		(clusterVector2);
-	      if (cluster2 != nullptr)
+	      const StubCandidate & c2 = _candidatesPlane2[i2];
+	      const float key2 = sortX ? c2.x : c2.y;
+	      if (key2 - key1 >= _maxResidual)
 		{
-		  cluster2->getCenterOfGravity (x2, y2);
-		  q2 = cluster2->getTotalCharge ();
+		  break;
 		}
-	      streamlog_out (DEBUG0) << " x1 " << x1 << " y1 " << y1 << " q1 "
-		<< q1 << " x2 " << x2 << " y2 " << y2 << " q2 " << q2 <<
-		" evt " << evt->getRunNumber () << endl;
-
-	      correx->fill (x1, x2);
-	      correy->fill (y1, y2);
 
-	      float dx = -1.0;
-	      float dy = -1.0;
-	      dx = fabs (x1 - x2);
-	      dy = fabs (y1 - y2);
+	      float dx = fabs (c1.x - c2.x);
+	      float dy = fabs (c1.y - c2.y);
 
 	      if (dx < _maxResidual && dy < _maxResidual)
 		{
+		  TrackerHitImpl *Hit1 =
+		    static_cast <
+		    TrackerHitImpl * >(inputHitCollection->getElementAt (c1.index));
+		  TrackerHitImpl *Hit2 =
+		    static_cast <
+		    TrackerHitImpl * >(inputHitCollection->getElementAt (c2.index));
+		  const double *pos1 = Hit1->getPosition ();
+		  const double *pos2 = Hit2->getPosition ();
+
 		  double newPos[3];
 		  newPos[0] = (pos1[0] + pos2[0]) / 2.0;
 		  newPos[1] = (pos1[1] + pos2[1]) / 2.0;
 		  newPos[2] = (pos1[2] + pos2[2]) / 2.0;
 
 		  const double *hitpos = newPos;
-		  CellIDEncoder < TrackerHitImpl >
-		    idHitEncoder (EUTELESCOPE::HITENCODING,
-				  outputHitCollection);
 		  TrackerHitImpl *hit = new TrackerHitImpl;
 		  hit->setPosition (&hitpos[0]);
 		  float cov[TRKHITNCOVMATRIX] =
@@ -323,26 +366,27 @@ CMSStubGenerator::processEvent (LCEvent * event)
 		  hit->setTime (Hit1->getTime ());
 
 		  LCObjectVec clusterVec;
-		  clusterVec.push_back (clusterVector1);
-		  clusterVec.push_back (clusterVector2);
+		  clusterVec.push_back (Hit1->getRawHits ()[0]);
+		  clusterVec.push_back (Hit2->getRawHits ()[0]);
 
 		  hit->rawHits () = clusterVec;
 
-		  idHitEncoder["sensorID"] = _outputSensorID;
-		  idHitEncoder["properties"] = 0;
+		  // the event encoder is on the same collection and encoding
+		  outputCellIDEncoder["sensorID"] = _outputSensorID;
+		  outputCellIDEncoder["properties"] = 0;
 
-		  idHitEncoder.setCellID (hit);
+		  outputCellIDEncoder.setCellID (hit);
 
-		  stubdistx->fill (x1 - x2);
-		  stubdisty->fill (y1 - y2);
+		  stubdistx->fill (c1.x - c2.x);
+		  stubdisty->fill (c1.y - c2.y);
 
 		  bool bitpresent = false;
 		  bool writeoutput = true;
 
 		  if (stub1 == "1" || stub2 == "1" || stub3 == "1")
 		    {
-		      stubdistx_bit->fill (x1 - x2);
-		      stubdisty_bit->fill (y1 - y2);
+		      stubdistx_bit->fill (c1.x - c2.x);
+		      stubdisty_bit->fill (c1.y - c2.y);
 
 		      bitpresent = true;
 
@@ -359,18 +403,17 @@ CMSStubGenerator::processEvent (LCEvent * event)
 		      outputHitCollection->push_back (hit);
 		      _totalstubs++;
 		      stubsinthisevent++;
-		      stubmap_top_x->fill (x1);
-		      stubmap_bot_x->fill (x2);
-		      stubmap_top_y->fill (y1);
-		      stubmap_bot_y->fill (y2);
+		      stubmap_top_x->fill (c1.x);
+		      stubmap_bot_x->fill (c2.x);
+		      stubmap_top_y->fill (c1.y);
+		      stubmap_bot_y->fill (c2.y);
+		    }
+		  else
+		    {
+		      delete hit;
 		    }
 
 		}
-	      else
-		{
-		  faildistx->fill (x1 - x2);
-		  faildisty->fill (y1 - y2);
-		}
 	    }
 	}
       _totalpl1 += dutPlane1Hits.size ();
@@ -396,6 +439,36 @@ CMSStubGenerator::processEvent (LCEvent * event)
 }
 
 
+CMSStubGenerator::StubCandidate
+CMSStubGenerator::makeCandidate (LCCollectionVec * hitCollection, int index)
+{
+  TrackerHitImpl *hit =
+    static_cast < TrackerHitImpl * >(hitCollection->getElementAt (index));
+  TrackerDataImpl *clusterVector =
+    static_cast < TrackerDataImpl * >(hit->getRawHits ()[0]);
+
+  // centre of gravity and total charge of the generic sparse cluster, read from its x, y, q, t values
+  const FloatVec & charges = clusterVector->getChargeValues ();
+  float xPos = 0.0;
+  float yPos = 0.0;
+  float totWeight = 0.0;
+  for (size_t i = 0; i + 3 < charges.size (); i += 4)
+    {
+      const float signal = charges[i + 2];
+      xPos += static_cast < short >(charges[i]) * signal;
+      yPos += static_cast < short >(charges[i + 1]) * signal;
+      totWeight += signal;
+    }
+
+  StubCandidate candidate;
+  candidate.x = xPos / totWeight;
+  candidate.y = yPos / totWeight;
+  candidate.q = totWeight;
+  candidate.index = index;
+  return candidate;
+}
+
+
 TrackerHitImpl *
 CMSStubGenerator::cloneHit (TrackerHitImpl * inputHit)
 {
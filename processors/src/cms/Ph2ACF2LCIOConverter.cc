@@ -36,7 +36,6 @@
 #include <algorithm>
 #include <stdio.h>
 #include <string.h>
-#include <bitset>
 
 using namespace std;
 using namespace marlin;
@@ -94,7 +93,7 @@ void Ph2ACF2LCIOConverter::readDataSource ( int /* numEvents */ )
 
     // open file
     ifstream infile;
-    infile.open ( _fileName.c_str ( ) );
+    infile.open ( _fileName.c_str ( ), ios::in | ios::binary );
     if ( !infile.is_open ( ) )
     {
 	streamlog_out ( ERROR5 ) << "Ph2ACF2LCIOConverter could not read the file " << _fileName << " correctly. Please check the path and file names that have been input!" << endl;
@@ -185,15 +184,13 @@ void Ph2ACF2LCIOConverter::readDataSource ( int /* numEvents */ )
 	    if ( raw_headeropen == false )
 	    {
 		uint32_t cMask = 0xAAAAAAAA;
-		std::vector < uint32_t > headervec;
+		std::vector < uint32_t > headervec ( 12, 0 );
 		raw_headeropen = true;
+		infile.read ( reinterpret_cast < char * > ( headervec.data ( ) ), headervec.size ( ) * sizeof ( uint32_t ) );
 		streamlog_out ( DEBUG0 ) << "File Header: ";
-		for ( int i = 0; i < 12; i++ )
+		for ( size_t i = 0; i < headervec.size ( ); i++ )
 		{
-		    uint32_t tempint;
-		    infile.read ( reinterpret_cast < char * > ( &tempint ), sizeof ( uint32_t ) );
-		    headervec.push_back ( tempint );
-		    streamlog_out ( DEBUG0 ) << tempint << " ";
+		    streamlog_out ( DEBUG0 ) << headervec[i] << " ";
 		}
 		streamlog_out ( DEBUG0 ) << endl;
 		if ( headervec.at ( 0 ) == cMask && headervec.at ( 3 ) == cMask && headervec.at ( 6 ) == cMask && headervec.at ( 9 ) == cMask && headervec.at ( 11 ) == cMask )
@@ -235,20 +232,29 @@ void Ph2ACF2LCIOConverter::readDataSource ( int /* numEvents */ )
 
 	    }
 
-	    // the output vectors
-	    FloatVec dataoutputvec_top;
-	    FloatVec dataoutputvec_bot;
+	    // the whole event is read in one go: header 1, then per FE header 2 and the chip words
+	    const size_t eventWords = HEADER1WORDS + _nFE * ( HEADER2WORDS + _nChips * CHIPWORDS );
+	    _eventBuffer.resize ( eventWords );
+	    infile.read ( reinterpret_cast < char * > ( _eventBuffer.data ( ) ), eventWords * sizeof ( uint32_t ) );
+	    if ( static_cast < size_t > ( infile.gcount ( ) ) != eventWords * sizeof ( uint32_t ) )
+	    {
+		if ( infile.gcount ( ) > 0 )
+		{
+		    streamlog_out ( WARNING5 ) << "Incomplete event at the end of the file, dropping it!" << endl;
+		}
+		break;
+	    }
+	    const uint32_t * word = _eventBuffer.data ( );
+
+	    // the output vectors, all strips start empty and only the fired ones are set
+	    FloatVec dataoutputvec_top ( _nFE * _nChips * STRIPSPERCHIP, 0.0 );
+	    FloatVec dataoutputvec_bot ( _nFE * _nChips * STRIPSPERCHIP, 0.0 );
 
 	    // read event header
 	    streamlog_out ( DEBUG1 ) << endl;
 	    streamlog_out ( DEBUG1 ) << "CBC Header1:" << endl;
-	    uint32_t tempint;
-	    std::vector < uint32_t > vec_header1;
-	    for ( int i = 0; i < 5; i++ )
-	    {
-		infile.read ( reinterpret_cast < char * > ( &tempint ), sizeof ( uint32_t ) );
-		vec_header1.push_back ( tempint );
-	    }
+	    std::vector < uint32_t > vec_header1 ( word, word + HEADER1WORDS );
+	    word += HEADER1WORDS;
 
 	    for ( unsigned int i = 0 ; i < vec_header1.size ( ); i++ )
 	    {
@@ -317,10 +323,8 @@ void Ph2ACF2LCIOConverter::readDataSource ( int /* numEvents */ )
 	    for ( int iFE = 0; iFE < _nFE; iFE++ )
 	    {
 		// read header 2
-		std::vector < uint32_t > vec_header2;
-		uint32_t tempint;
-		infile.read ( reinterpret_cast < char * > ( &tempint ), sizeof ( uint32_t ) );
-		vec_header2.push_back ( tempint );
+		std::vector < uint32_t > vec_header2 ( word, word + HEADER2WORDS );
+		word += HEADER2WORDS;
 		streamlog_out ( DEBUG2 ) << endl;
 		streamlog_out ( DEBUG2 ) << "CBC Header2, FE " << iFE << ":" << endl;
 		for ( unsigned int i = 0; i < vec_header2.size ( ); i++ )
@@ -354,125 +358,55 @@ void Ph2ACF2LCIOConverter::readDataSource ( int /* numEvents */ )
 
 		for ( int j = 0; j < _nChips; j++ )
 		{
-		    // top sensor
-		    int topvec[4][32] = { 0 };
-		    // bottom sensor
-		    int botvec[4][32] = { 0 };
-
-		    // 9 for trg data, 2 for stub
-		    for ( int i = 0; i < 11; i++ )
+		    // the chip words: 4 top strip words, 4 bottom strip words, trigger data and 2 stub words
+		    const uint32_t * chipWords = word;
+		    word += CHIPWORDS;
+
+		    // the strips only go into the output if they fired
+		    const size_t stripOffset = ( iFE * _nChips + j ) * STRIPSPERCHIP;
+		    const int topHits = unpackStrips ( chipWords, dataoutputvec_top, stripOffset );
+		    const int botHits = unpackStrips ( chipWords + 4, dataoutputvec_bot, stripOffset );
+		    streamlog_out ( DEBUG0 ) << "Top hits " << topHits << " bot hits " << botHits << endl;
+
+		    uint32_t tempint = chipWords[8];
+
+		    // cbc trgdata status
+		    unsigned int test =  ( ( tempint & 1 ) >> 1 );
+		    lat_err[iFE].push_back ( test );
+		    streamlog_out ( DEBUG1 ) << " lat_err " << lat_err.at ( iFE ).at ( j ) << endl;
+		    buf_ovf[iFE].push_back ( ( tempint & 2 ) >> 2 );
+		    streamlog_out ( DEBUG1 ) << " buf_ovf " << buf_ovf.at ( iFE ).at ( j ) << endl;
+		    pipeaddr[iFE].push_back ( ( tempint >> 4 ) & 0x09 );
+		    streamlog_out ( DEBUG1 ) << " pipeaddr " << pipeaddr.at ( iFE ).at ( j ) << endl;
+		    l1cnt[iFE].push_back ( ( tempint >> 16 ) & 0xFE );
+		    streamlog_out ( DEBUG1 ) << " l1cnt " << l1cnt.at ( iFE ).at ( j ) << endl;
+
+		    // stubdata
+		    tempint = chipWords[9];
+		    stub1[iFE].push_back ( createMask ( 0, 7 ) & tempint );
+		    stub2[iFE].push_back ( createMask ( 0, 7 ) & ( tempint >> 8 ) );
+		    stub3[iFE].push_back ( createMask ( 0, 7 ) & ( tempint >> 16 ) );
+		    streamlog_out ( DEBUG1 ) << " stub1 " << stub1.at ( iFE ).at ( j ) << " stub2 " << stub2.at ( iFE ).at ( j ) << " stub3 " << stub3.at ( iFE ).at ( j ) << endl;
+
+		    // stubdata
+		    tempint = chipWords[10];
+		    unsigned int sync = ( ( tempint >> 3) & 1 );
+		    unsigned int or254 = ( ( tempint >> 1 ) & 1 );
+		    streamlog_out ( DEBUG1 ) << " sync " << sync << " or254 " << or254 << endl;
+		    bend1[iFE].push_back ( createMask ( 0, 3 ) & ( tempint >> 8 ) );
+		    bend2[iFE].push_back ( createMask ( 0, 3 ) & ( tempint >> 16 ) );
+		    bend3[iFE].push_back ( createMask ( 0, 3 ) & ( tempint >> 24 ) );
+		    streamlog_out ( DEBUG1 ) << " bend1 " << bend1.at ( iFE ).at ( j ) << " bend2 " << bend2.at ( iFE ).at ( j ) << " bend3 " << bend3.at ( iFE ).at ( j ) << endl;
+
+		    // check
+		    if ( stub1.at ( iFE).at ( j ) == 1 )
 		    {
-			uint32_t tempint;
-			infile.read ( reinterpret_cast < char * > ( &tempint ), sizeof ( uint32_t ) );
-
-			if ( i < 4 )
+			if ( sync != 1 || or254 != 1 )
 			{
-			    // top sensor
-			    bitset < 32 > tempbit ( tempint );
-			    for ( unsigned j = 0; j < tempbit.size ( ); j++ )
-			    {
-				if ( tempbit.test ( j ) )
-				{
-				    topvec[i][j] = 1;
-				}
-				else
-				{
-				    topvec[i][j] = 0;
-				}
-			    }
-			}
-			if ( i >=4 && i < 8 )
-			{
-			    // bottom sensor
-			    bitset < 32 > tempbit ( tempint );
-			    for ( unsigned j = 0; j < tempbit.size ( ); j++ )
-			    {
-				if ( tempbit.test ( j ) )
-				{
-				    botvec[i - 4][j] = 1;
-				}
-				else
-				{
-				    botvec[i - 4][j] = 0;
-				}
-			    }
-			}
-			if ( i == 8 )
-			{
-			    // cbc trgdata status
-			    unsigned int test =  ( ( tempint & 1 ) >> 1 );
-			    lat_err[iFE].push_back ( test );
-			    streamlog_out ( DEBUG1 ) << " lat_err " << lat_err.at ( iFE ).at ( j ) << endl;
-			    buf_ovf[iFE].push_back ( ( tempint & 2 ) >> 2 );
-			    streamlog_out ( DEBUG1 ) << " buf_ovf " << buf_ovf.at ( iFE ).at ( j ) << endl;
-			    pipeaddr[iFE].push_back ( ( tempint >> 4 ) & 0x09 );
-			    streamlog_out ( DEBUG1 ) << " pipeaddr " << pipeaddr.at ( iFE ).at ( j ) << endl;
-			    l1cnt[iFE].push_back ( ( tempint >> 16 ) & 0xFE );
-			    streamlog_out ( DEBUG1 ) << " l1cnt " << l1cnt.at ( iFE ).at ( j ) << endl;
-			}
-			if ( i == 9 )
-			{
-			    // stubdata
-			    stub1[iFE].push_back ( createMask ( 0, 7 ) & tempint );
-			    stub2[iFE].push_back ( createMask ( 0, 7 ) & ( tempint >> 8 ) );
-			    stub3[iFE].push_back ( createMask ( 0, 7 ) & ( tempint >> 16 ) );
-			    streamlog_out ( DEBUG1 ) << " stub1 " << stub1.at ( iFE ).at ( j ) << " stub2 " << stub2.at ( iFE ).at ( j ) << " stub3 " << stub3.at ( iFE ).at ( j ) << endl;
-			}
-			if ( i == 10 )
-			{
-			    // stubdata
-			    unsigned int sync = ( ( tempint >> 3) & 1 );
-			    unsigned int or254 = ( ( tempint >> 1 ) & 1 );
-			    streamlog_out ( DEBUG1 ) << " sync " << sync << " or254 " << or254 << endl;
-			    bend1[iFE].push_back ( createMask ( 0, 3 ) & ( tempint >> 8 ) );
-			    bend2[iFE].push_back ( createMask ( 0, 3 ) & ( tempint >> 16 ) );
-			    bend3[iFE].push_back ( createMask ( 0, 3 ) & ( tempint >> 24 ) );
-			    streamlog_out ( DEBUG1 ) << " bend1 " << bend1.at ( iFE ).at ( j ) << " bend2 " << bend2.at ( iFE ).at ( j ) << " bend3 " << bend3.at ( iFE ).at ( j ) << endl;
-
-			    // check
-			    if ( stub1.at ( iFE).at ( j ) == 1 )
-			    {
-				if ( sync != 1 || or254 != 1 )
-				{
-				    streamlog_out ( WARNING1 ) << "Warning! Stub found, but sync/or254 is not 1!" << endl;
-				}
-			    }
+			    streamlog_out ( WARNING1 ) << "Warning! Stub found, but sync/or254 is not 1!" << endl;
 			}
 		    }
 
-		    int counter = 0;
-		    streamlog_out ( DEBUG0 ) << "Top ";
-		    for ( int i = 3; i >= 0; i-- )
-		    {
-			for ( int k = 0; k < 32; k++ )
-			{
-			    counter++;
-			    if ( counter != 32 )
-			    {
-				streamlog_out ( DEBUG0 ) << topvec[i][k] ;
-				// output to the vector
-				dataoutputvec_top.push_back ( topvec[i][k] );
-			    }
-			}
-		    }
-		    streamlog_out ( DEBUG0 ) << endl;
-		    counter = 0;
-		    streamlog_out ( DEBUG0 ) << "Bot ";
-		    for ( int i = 3; i >= 0; i-- )
-		    {
-			for ( int k = 0; k < 32; k++ )
-			{
-			    counter ++;
-			    if ( counter != 32 )
-			    {
-				streamlog_out ( DEBUG0 ) << botvec[i][k] ;
-				// output to the vector
-				dataoutputvec_bot.push_back ( botvec[i][k] );
-			    }
-			}
-		    }
-		    streamlog_out ( DEBUG0 ) << endl;
-
 		} // done chip loop
 
 	    } // done FE loop
@@ -613,6 +547,26 @@ void Ph2ACF2LCIOConverter::end ( )
     streamlog_out ( MESSAGE5 )  << "Ph2ACF2LCIOConverter successfully finished!" << endl;
 }
 
+// sets the fired strips of one sensor of one chip. The 127 strips are packed in 4 words, the last word holds
+// strips 0 to 30 in bits 0 to 30, the word before strips 31 to 62 and so on. Returns the number of fired strips.
+int Ph2ACF2LCIOConverter::unpackStrips ( const uint32_t * words, FloatVec & output, size_t offset )
+{
+    int hits = 0;
+    for ( int i = 3; i >= 0; i-- )
+    {
+	// bit 31 of the last word is not a strip
+	uint32_t bits = ( i == 3 ) ? ( words[i] & 0x7FFFFFFF ) : words[i];
+	const size_t first = offset + ( i == 3 ? 0 : 31 + 32 * ( 2 - i ) );
+	hits += __builtin_popcount ( bits );
+	while ( bits != 0 )
+	{
+	    output[first + __builtin_ctz ( bits )] = 1.0;
+	    bits &= bits - 1;
+	}
+    }
+    return hits;
+}
+
 unsigned Ph2ACF2LCIOConverter::createMask ( unsigned a, unsigned b )
 {
     unsigned r = 0;
@@ -571,9 +571,6 @@ EUTelCalibrateEventProcessor::processEvent (LCEvent * event)
     for (unsigned int iDetector = 0; iDetector < inputCollectionVec->size ();
 	 iDetector++)
       {
-	vector < float >commonModeCorVec;
-	commonModeCorVec.clear ();
-
 	// reset quantity for the common mode.
 	double pixelSum = 0.;
 	double commonMode = 0.;
@@ -622,40 +619,29 @@ EUTelCalibrateEventProcessor::processEvent (LCEvent * event)
 
 	idDataEncoder.setCellID (corrected);
 
-	ShortVec::const_iterator rawIter = rawData->getADCValues ().begin ();
-	FloatVec::const_iterator pedIter =
-	  pedestal->getChargeValues ().begin ();
-	FloatVec::const_iterator noiseIter =
-	  noise->getChargeValues ().begin ();
-	ShortVec::const_iterator statusIter =
-	  status->getADCValues ().begin ();
+	// the input and the calibration are used in place and the
+	// corrected values are written straight into the output
+	const ShortVec & adcValues = rawData->getADCValues ();
+	const FloatVec & pedestalValues = pedestal->getChargeValues ();
+	const FloatVec & noiseValues = noise->getChargeValues ();
+	const ShortVec & statusValues = status->getADCValues ();
+
+	const size_t rowLength = _maxX[iDetector] - _minX[iDetector] + 1;
+	const size_t noOfRows = _maxY[iDetector] - _minY[iDetector] + 1;
+	const size_t noOfPixels =
+	  (_doCommonMode == 2) ? noOfRows * rowLength : adcValues.size ();
+
+	FloatVec & correctedValues = corrected->chargeValues ();
+	correctedValues.resize (noOfPixels);
 
 	bool isEventValid = true;
 	if (_doCommonMode == 1)
 	  {
 
 	    // FULLFRAME common mode
-	    while (rawIter != rawData->getADCValues ().end ())
-	      {
-		bool isHit =
-		  (((*rawIter) - (*pedIter)) >
-		   _hitRejectionCut * (*noiseIter));
-		bool isGood = ((*statusIter) == EUTELESCOPE::GOODPIXEL);
-
-		if (!isHit && isGood)
-		  {
-		    pixelSum += (*rawIter) - (*pedIter);
-		    ++goodPixel;
-		  }
-		else if (isHit)
-		  {
-		    ++skippedPixel;
-		  }
-		++rawIter;
-		++pedIter;
-		++noiseIter;
-		++statusIter;
-	      }
+	    sumGoodPixels (adcValues.data (), pedestalValues.data (),
+			   noiseValues.data (), statusValues.data (),
+			   noOfPixels, pixelSum, goodPixel, skippedPixel);
 
 	    if (((_maxNoOfRejectedPixels == -1) ||
 		 (skippedPixel < _maxNoOfRejectedPixels)) && (goodPixel != 0))
@@ -671,6 +657,9 @@ EUTelCalibrateEventProcessor::processEvent (LCEvent * event)
 		  histo->fill (commonMode);
 #endif
 
+		subtractPedestal (adcValues.data (), pedestalValues.data (),
+				  commonMode, noOfPixels,
+				  correctedValues.data ());
 	      }
 	    else
 	      {
@@ -690,217 +679,113 @@ EUTelCalibrateEventProcessor::processEvent (LCEvent * event)
 	else if (_doCommonMode == 2)
 	  {
 
-	    // ROWWISE common mode
-	    ShortVec adcValues = rawData->getADCValues ();
-	    FloatVec _pedestal = pedestal->getChargeValues ();
-	    ShortVec _status = status->getADCValues ();
-	    FloatVec _noise = noise->getChargeValues ();
-	    int iPixel = 0;
-	    int colCounter = 0;
-	    int rowLength = _maxX[iDetector] - _minX[iDetector] + 1;
-
-	    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector];
-		 yPixel++)
+	    // ROWWISE common mode, each row is corrected as soon as its
+	    // common mode is known
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+	    AIDA::IHistogram1D * commonModeHisto =
+	      dynamic_cast < AIDA::IHistogram1D * >(_aidaHistoMap
+						    [_commonModeDistHistoName
+						     + "_d" +
+						     to_string (sensorID)]);
+#endif
+	    for (size_t firstPixel = 0; firstPixel < noOfPixels;
+		 firstPixel += rowLength)
 	      {
 
-		double pixelSum = 0.;
-		double commonMode = 0.;
-		int goodPixel = 0;
+		double rowPixelSum = 0.;
+		int rowGoodPixel = 0;
 		int skippedPixelPerRow = 0;
 
-		for (int xPixel = _minX[iDetector];
-		     xPixel <= _maxX[iDetector]; xPixel++)
-		  {
-		    bool isHit = ((adcValues[iPixel] - _pedestal[iPixel]) >
-				  _hitRejectionCut * _noise[iPixel]);
-		    bool isGood = (_status[iPixel] == EUTELESCOPE::GOODPIXEL);
-		    if (!isHit && isGood)
-		      {
-			pixelSum += adcValues[iPixel] - _pedestal[iPixel];
-			++goodPixel;
-		      }
-		    else if (isHit)
-		      {
-			++skippedPixelPerRow;
-			++skippedPixel;
-		      }
-		    ++iPixel;
-		  }
+		sumGoodPixels (adcValues.data () + firstPixel,
+			       pedestalValues.data () + firstPixel,
+			       noiseValues.data () + firstPixel,
+			       statusValues.data () + firstPixel, rowLength,
+			       rowPixelSum, rowGoodPixel, skippedPixelPerRow);
+		skippedPixel += skippedPixelPerRow;
 
-		// we are now at the end of the row, so let's calculate the
-		// common mode
+		// the row correction is applied in float precision, rows
+		// failing the cuts are not corrected
+		float rowCommonMode = 0.;
 		if ((skippedPixelPerRow < _maxNoOfRejectedPixelPerRow) &&
-		    (goodPixel != 0))
+		    (rowGoodPixel != 0))
 		  {
-		    commonMode = pixelSum / goodPixel;
-		    commonModeCorVec.insert (commonModeCorVec.begin () +
-					     colCounter * rowLength,
-					     rowLength, commonMode);
+		    double rowMean = rowPixelSum / rowGoodPixel;
+		    rowCommonMode = rowMean;
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-		    string tempHistoName =
-		      _commonModeDistHistoName + "_d" + to_string (sensorID);
-		    if (AIDA::IHistogram1D * histo =
-			dynamic_cast <
-			AIDA::IHistogram1D * >(_aidaHistoMap[tempHistoName]))
-		      histo->fill (commonMode);
+		    if (commonModeHisto)
+		      commonModeHisto->fill (rowMean);
 #endif
 		  }
 		else
 		  {
-		    commonModeCorVec.insert (commonModeCorVec.begin () +
-					     colCounter * rowLength,
-					     rowLength, 0.);
 		    ++skippedRow;
 		  }
 
-		++colCounter;
+		subtractPedestal (adcValues.data () + firstPixel,
+				  pedestalValues.data () + firstPixel,
+				  rowCommonMode, rowLength,
+				  correctedValues.data () + firstPixel);
 	      }
+
 	    if (skippedRow > _maxNoOfSkippedRow)
 	      {
 		isEventValid = false;
 	      }
 
-	  }			// end if on _doCommonMode
-
-	if (isEventValid)
+	  }
+	else
 	  {
-	    if (_doCommonMode == 2)
-	      {
-		ShortVec adcValues = rawData->getADCValues ();
-		FloatVec _pedestal = pedestal->getChargeValues ();
-
-		int iPixel = 0;
 
-		for (int yPixel = _minY[iDetector];
-		     yPixel <= _maxY[iDetector]; yPixel++)
-		  {
-		    for (int xPixel = _minX[iDetector];
-			 xPixel <= _maxX[iDetector]; xPixel++)
-		      {
+	    // that's the case the user doesn't want to apply any
+	    // correction at all. The value of the commonMode variable is
+	    // taken directly from the initialization ( = 0 ).
+	    subtractPedestal (adcValues.data (), pedestalValues.data (),
+			      commonMode, noOfPixels,
+			      correctedValues.data ());
 
-			double correctedValue =
-			  adcValues[iPixel] - _pedestal[iPixel] -
-			  commonModeCorVec[iPixel];
-			corrected->chargeValues ().push_back (correctedValue);
+	  }                     // end if on _doCommonMode
 
-			++iPixel;
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-			if (_fillDebugHisto == 1)
-			  {
-			    string tempHistoName =
-			      _rawDataDistHistoName + "_d" +
-			      to_string (sensorID);
-			    if (AIDA::IHistogram1D * histo =
-				dynamic_cast <
-				AIDA::IHistogram1D *
-				>(_aidaHistoMap[tempHistoName]))
-			      {
-				histo->fill (adcValues[iPixel]);
-			      }
-			    else
-			      {
-				streamlog_out (ERROR1)
-				  <<
-				  "Not able to retrieve histogram pointer for "
-				  << tempHistoName <<
-				  ".\nDisabling histogramming from now on " <<
-				  endl;
-				_fillDebugHisto = 0;
-			      }
-
-			    tempHistoName =
-			      _dataDistHistoName + "_d" +
-			      to_string (sensorID);
-			    if (AIDA::IHistogram1D * histo =
-				dynamic_cast <
-				AIDA::IHistogram1D *
-				>(_aidaHistoMap[tempHistoName]))
-			      {
-				histo->fill (correctedValue);
-			      }
-			    else
-			      {
-				streamlog_out (ERROR1)
-				  <<
-				  "Not able to retrieve histogram pointer for "
-				  << tempHistoName <<
-				  ".\nDisabling histogramming from now on " <<
-				  endl;
-				_fillDebugHisto = 0;
-			      }
-			  }
-#endif
-		      }
+	if (isEventValid && (_fillDebugHisto == 1))
+	  {
+	    string rawDataHistoName =
+	      _rawDataDistHistoName + "_d" + to_string (sensorID);
+	    string dataHistoName =
+	      _dataDistHistoName + "_d" + to_string (sensorID);
+	    AIDA::IHistogram1D * rawDataHisto =
+	      dynamic_cast <
+	      AIDA::IHistogram1D * >(_aidaHistoMap[rawDataHistoName]);
+	    AIDA::IHistogram1D * dataHisto =
+	      dynamic_cast <
+	      AIDA::IHistogram1D * >(_aidaHistoMap[dataHistoName]);
+
+	    if (rawDataHisto && dataHisto)
+	      {
+		for (size_t iPixel = 0; iPixel < noOfPixels; ++iPixel)
+		  {
+		    rawDataHisto->fill (adcValues[iPixel]);
+		    // without the row wise correction the histogram gets
+		    // the value before the rounding to float
+		    if (_doCommonMode == 2)
+		      dataHisto->fill (correctedValues[iPixel]);
+		    else
+		      dataHisto->fill (adcValues[iPixel] -
+				       pedestalValues[iPixel] - commonMode);
 		  }
 	      }
 	    else
 	      {
-
-		// that's the case the user wants to apply the FullFrame
-		// common mode or doesn't want to apply any correction at
-		// all. In this last case the value of the commonMode
-		// variable is taken directly from the initialization ( = 0 ).
-
-		rawIter = rawData->getADCValues ().begin ();
-		pedIter = pedestal->getChargeValues ().begin ();
-
-		while (rawIter != rawData->getADCValues ().end ())
-		  {
-
-		    double correctedValue =
-		      (*rawIter) - (*pedIter) - commonMode;
-		    corrected->chargeValues ().push_back (correctedValue);
-
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-		    if (_fillDebugHisto == 1)
-		      {
-			string tempHistoName =
-			  _rawDataDistHistoName + "_d" + to_string (sensorID);
-			if (AIDA::IHistogram1D * histo =
-			    dynamic_cast <
-			    AIDA::IHistogram1D *
-			    >(_aidaHistoMap[tempHistoName]))
-			  {
-			    histo->fill (*rawIter);
-			  }
-			else
-			  {
-			    streamlog_out (ERROR1)
-			      << "Not able to retrieve histogram pointer for "
-			      << tempHistoName
-			      << ".\nDisabling histogramming from now on " <<
-			      endl;
-			    _fillDebugHisto = 0;
-			  }
-
-			tempHistoName =
-			  _dataDistHistoName + "_d" + to_string (sensorID);
-			if (AIDA::IHistogram1D * histo =
-			    dynamic_cast <
-			    AIDA::IHistogram1D *
-			    >(_aidaHistoMap[tempHistoName]))
-			  {
-			    histo->fill (correctedValue);
-			  }
-			else
-			  {
-			    streamlog_out (ERROR1)
-			      << "Not able to retrieve histogram pointer for "
-			      << tempHistoName
-			      << ".\nDisabling histogramming from now on " <<
-			      endl;
-			    _fillDebugHisto = 0;
-			  }
-		      }
-#endif
-		    ++rawIter;
-		    ++pedIter;
-		  }
+		streamlog_out (ERROR1)
+		  << "Not able to retrieve histogram pointer for "
+		  << (rawDataHisto ? dataHistoName : rawDataHistoName)
+		  << ".\nDisabling histogramming from now on " << endl;
+		_fillDebugHisto = 0;
 	      }
-
 	  }
-	else
+#endif
+
+	if (!isEventValid)
 	  {
 	    // this is the case the event is not valid because of common
 	    // mode. This is the right place to throw a SkipEventException
@@ -926,6 +811,8 @@ EUTelCalibrateEventProcessor::processEvent (LCEvent * event)
 		  getEventNumber () << " for an unknown reason " << endl;
 	      }
 
+	    delete corrected;
+	    delete correctedDataCollection;
 	    throw SkipEventException (this);
 	  }
 
@@ -966,3 +853,63 @@ EUTelCalibrateEventProcessor::end ()
 {
   streamlog_out (MESSAGE2) << "Successfully finished" << endl;
 }
+
+void
+EUTelCalibrateEventProcessor::sumGoodPixels (const short *adcValues,
+					     const float *pedestalValues,
+					     const float *noiseValues,
+					     const short *statusValues,
+					     size_t noOfPixels, double &pixelSum,
+					     int &goodPixel,
+					     int &skippedPixel) const
+{
+  double sum = pixelSum;
+  int good = goodPixel;
+  int skipped = skippedPixel;
+
+  for (size_t iPixel = 0; iPixel < noOfPixels; ++iPixel)
+    {
+      const float signal = adcValues[iPixel] - pedestalValues[iPixel];
+      const bool isHit = signal > _hitRejectionCut * noiseValues[iPixel];
+      const bool isGood = (statusValues[iPixel] == EUTELESCOPE::GOODPIXEL);
+      const bool use = !isHit && isGood;
+
+      // adding zero leaves the sum unchanged, so the pixels are summed
+      // in the same order as with a branch
+      sum += use ? signal : 0.f;
+      good += use;
+      skipped += isHit;
+    }
+
+  pixelSum = sum;
+  goodPixel = good;
+  skippedPixel = skipped;
+}
+
+void
+EUTelCalibrateEventProcessor::subtractPedestal (const short *adcValues,
+						const float *pedestalValues,
+						double commonMode,
+						size_t noOfPixels,
+						float *correctedValues)
+{
+  for (size_t iPixel = 0; iPixel < noOfPixels; ++iPixel)
+    {
+      correctedValues[iPixel] =
+	adcValues[iPixel] - pedestalValues[iPixel] - commonMode;
+    }
+}
+
+void
+EUTelCalibrateEventProcessor::subtractPedestal (const short *adcValues,
+						const float *pedestalValues,
+						float commonMode,
+						size_t noOfPixels,
+						float *correctedValues)
+{
+  for (size_t iPixel = 0; iPixel < noOfPixels; ++iPixel)
+    {
+      correctedValues[iPixel] =
+	adcValues[iPixel] - pedestalValues[iPixel] - commonMode;
+    }
+}
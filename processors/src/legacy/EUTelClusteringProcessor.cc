@@ -90,7 +90,7 @@ _sensorIDVec (), zsInputDataCollectionVec (nullptr),
 nzsInputDataCollectionVec (nullptr), pulseCollectionVec (nullptr),
 noiseCollectionVec (nullptr), statusCollectionVec (nullptr),
 hotPixelCollectionVec (nullptr), hasNZSData (false), hasZSData (false),
-_hitIndexMapVec ()
+_statusMaskVec (), _firedPixelBitmap (), _seedCandidateBitmap ()
 {
 
   // modify processor description
@@ -281,8 +281,8 @@ EUTelClusteringProcessor::init ()
 	}
     }
 
-  // reset hotpixel map vectors
-  _hitIndexMapVec.clear ();
+  // reset the status masks, hot pixels included
+  _statusMaskVec.clear ();
 
   // set to zero the run and event counters
   _iRun = 0;
@@ -435,9 +435,6 @@ EUTelClusteringProcessor::initializeHotPixelMapVec ()
   for (unsigned int iDetector = 0; iDetector < hotPixelCollectionVec->size ();
        iDetector++)
     {
-      if (_hitIndexMapVec.size () < iDetector + 1)
-	_hitIndexMapVec.resize (iDetector + 1);
-
       TrackerDataImpl *hotData =
 	dynamic_cast <
 	TrackerDataImpl * >(hotPixelCollectionVec->getElementAt (iDetector));
@@ -478,95 +475,20 @@ EUTelClusteringProcessor::initializeHotPixelMapVec ()
       // prepare the matrix decoder
       EUTelMatrixDecoder matrixDecoder (noiseDecoder, noise);
 
-      // now prepare the EUTelescope interface to sparsified data.
-      auto sparseData = std::make_unique <
-	EUTelTrackerDataInterfacerImpl < EUTelGenericSparsePixel >> (hotData);
-      auto & pixelVec = sparseData->getPixels ();
-
-      streamlog_out (DEBUG1) << "Processing sparse data on detector " <<
-	sensorID << " with " << sparseData->size () << " pixels " << endl;
-
-    for (auto & sparsePixel:pixelVec)
+      // the hot pixels are kept in the status mask of the sensor
+      if (static_cast < int >(_statusMaskVec.size ()) <= sensorID)
 	{
-	  int decoded_XY_index =
-	    matrixDecoder.getIndexFromXY (sparsePixel.getXCoord (),
-					  sparsePixel.getYCoord ());	// unique pixel index !!
-	  if (_hitIndexMapVec[iDetector].find (decoded_XY_index) ==
-	      _hitIndexMapVec[iDetector].end ())
-	    {
-	      _hitIndexMapVec[iDetector].
-		insert (make_pair
-			(decoded_XY_index, EUTELESCOPE::FIRINGPIXEL));
-	    }
-	  else
-	    {
-	      streamlog_out (ERROR5) << "hot pixel [index " <<
-		decoded_XY_index << "] reoccured ?!" << endl;
-	    }
+	  _statusMaskVec.resize (sensorID + 1);
 	}
-    }
-}
-
-void
-EUTelClusteringProcessor::initializeStatusCollection ()
-{
-  // prepare some decoders
-  CellIDDecoder < TrackerDataImpl > cellDecoder (zsInputDataCollectionVec);
-  CellIDDecoder < TrackerDataImpl > statusDecoder (statusCollectionVec);
-  CellIDDecoder < TrackerDataImpl > noiseDecoder (noiseCollectionVec);
-
-  for (unsigned int iDetector = 0;
-       iDetector < zsInputDataCollectionVec->size (); iDetector++)
-    {
-      if (_hitIndexMapVec.size () < iDetector + 1)
-	_hitIndexMapVec.resize (iDetector + 1);
-
-      // get the TrackerData and guess which kind of sparsified data it
-      // contains.
-
-      TrackerDataImpl *zsData =
-	dynamic_cast <
-	TrackerDataImpl *
-	>(zsInputDataCollectionVec->getElementAt (iDetector));
-      int sensorID = static_cast < int >(cellDecoder (zsData)["sensorID"]);
-
-      // if this is an excluded sensor go to the next element
-
-      bool foundexcludedsensor = false;
-      for (size_t j = 0; j < _ExcludedPlanes.size (); ++j)
+      EUTelPixelStatusMask & statusMask = _statusMaskVec[sensorID];
+      if (statusMask.size () < noise->getChargeValues ().size ())
 	{
-	  if (_ExcludedPlanes[j] == sensorID)
-	    {
-	      foundexcludedsensor = true;
-	    }
+	  statusMask.resize (noise->getChargeValues ().size ());
 	}
-      if (foundexcludedsensor)
-	continue;
-
-      // get the noise and the status matrix with the right detectorID
-      TrackerRawDataImpl *status = nullptr;
-      // the noise map. we only need this map for decoding issues.
-      TrackerDataImpl *noise = nullptr;
-
-      // get the noise and the status matrix with the right detectorID
-      status =
-	dynamic_cast <
-	TrackerRawDataImpl *
-	>(statusCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
-      vector < short >statusVec = status->adcValues ();
-
-      // the noise map. we only need this map for decoding issues.
-      noise =
-	dynamic_cast <
-	TrackerDataImpl *
-	>(noiseCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
-
-      // prepare the matrix decoder
-      EUTelMatrixDecoder matrixDecoder (noiseDecoder, noise);
 
       // now prepare the EUTelescope interface to sparsified data.
       auto sparseData = std::make_unique <
-	EUTelTrackerDataInterfacerImpl < EUTelGenericSparsePixel >> (zsData);
+	EUTelTrackerDataInterfacerImpl < EUTelGenericSparsePixel >> (hotData);
       auto & pixelVec = sparseData->getPixels ();
 
       streamlog_out (DEBUG1) << "Processing sparse data on detector " <<
@@ -574,34 +496,24 @@ EUTelClusteringProcessor::initializeStatusCollection ()
 
     for (auto & sparsePixel:pixelVec)
 	{
-
 	  int decoded_XY_index =
 	    matrixDecoder.getIndexFromXY (sparsePixel.getXCoord (),
 					  sparsePixel.getYCoord ());	// unique pixel index !!
-
-	  if (_hitIndexMapVec[iDetector].find (decoded_XY_index) ==
-	      _hitIndexMapVec[iDetector].end ())
+	  if (statusMask.size () <= static_cast < size_t > (decoded_XY_index))
 	    {
-	      int old_size = status->adcValues ().size ();
-	      int new_size = old_size + 1;
-	      int last_element = old_size;
-
-	      status->adcValues ().resize (new_size);
-	      _hitIndexMapVec[iDetector].
-		insert (make_pair (decoded_XY_index, last_element));
-
-	      status->adcValues ()[last_element] = EUTELESCOPE::HITPIXEL;	// adcValues is a vector, there fore must
-	      // address the elements incrementally
+	      statusMask.resize (decoded_XY_index + 1);
+	    }
+	  if (!statusMask.isHot (decoded_XY_index))
+	    {
+	      statusMask.setHot (decoded_XY_index);
 	    }
 	  else
 	    {
-	      status->
-		adcValues ()[_hitIndexMapVec[iDetector][decoded_XY_index]] =
-		EUTELESCOPE::HITPIXEL;
+	      streamlog_out (ERROR5) << "hot pixel [index " <<
+		decoded_XY_index << "] reoccured ?!" << endl;
 	    }
 	}
     }
-  return;
 }
 
 void
@@ -955,14 +867,11 @@ EUTelClusteringProcessor::digitalFixedFrameClustering (LCEvent * evt,
 
       getMaxPixels (sensorID, _maxX, _maxY);
 
-      // todo: declare a vector of sensormatrizes as a class member in
-      // order to not allocate a new object for each loop iteration.
-      // sensormatrix.push_back(dim2array<bool>((unsigned int)(_maxX+1 - _minX),
-      // (unsigned int)(_maxY+1 - _minY), false));
-      //    dim2array<bool> sensormatrix((unsigned int)(_maxX+1 - _minX),
-      //    (unsigned int)(_maxY+1 - _minY), false);
-
-      std::map < unsigned int, std::map < unsigned int, bool >> sensormatrix;
+      // the fired pixels which are not hot. nx and ny are the size of
+      // the fired pixel bitmap, any pixel outside is not fired.
+      vector < pixel > firedPixels;
+      unsigned int nx = 0;
+      unsigned int ny = 0;
 
       // prepare the matrix decoder
       EUTelMatrixDecoder matrixDecoder (noiseDecoder, noise);
@@ -1005,20 +914,18 @@ EUTelClusteringProcessor::digitalFixedFrameClustering (LCEvent * evt,
 		matrixDecoder.getIndexFromXY (sparsePixel.getXCoord (),
 					      sparsePixel.getYCoord ());
 
-	      if (static_cast < int >(_hitIndexMapVec.size ()) > sensorID)
+	      if (isHotPixel (sensorID, index))
 		{
-		  if (_hitIndexMapVec[sensorID].find (index) !=
-		      _hitIndexMapVec[sensorID].end ())
-		    {
-		      streamlog_out (DEBUG1) << " iDetector " << sensorID
-			<< " unique index " << index
-			<< " at x = " << sparsePixel.getXCoord ()
-			<< " y= " << sparsePixel.getYCoord () << endl;
-		      continue;
-		    }
+		  streamlog_out (DEBUG1) << " iDetector " << sensorID
+		    << " unique index " << index
+		    << " at x = " << sparsePixel.getXCoord ()
+		    << " y= " << sparsePixel.getYCoord () << endl;
+		  continue;
 		}
-	      sensormatrix[sparsePixel.getXCoord ()][sparsePixel.
-						     getYCoord ()] = true;
+	      firedPixels.push_back (pixel (sparsePixel.getXCoord (),
+					    sparsePixel.getYCoord ()));
+	      nx = max (nx, firedPixels.back ().x + 1);
+	      ny = max (ny, firedPixels.back ().y + 1);
 	    }
 	}
       else
@@ -1026,6 +933,23 @@ EUTelClusteringProcessor::digitalFixedFrameClustering (LCEvent * evt,
 	  throw UnknownDataTypeException ("Unknown sparsified pixel");
 	}
 
+      // pixel (x, y) is bit x * ny + y of the fired pixel bitmap, so
+      // that the seed finding visits the fired pixels ordered by x and
+      // then by y. This order is kept by the seed candidate sort.
+      _firedPixelBitmap.resize (static_cast < size_t > (nx) * ny);
+      _firedPixelBitmap.clear ();
+      for (size_t iPixel = 0; iPixel < firedPixels.size (); iPixel++)
+	{
+	  _firedPixelBitmap.set (static_cast < size_t >
+				 (firedPixels[iPixel].x) * ny +
+				 firedPixels[iPixel].y);
+	}
+      auto isFired =[&](unsigned int x, unsigned int y)
+      {
+	return x < nx && y < ny
+	  && _firedPixelBitmap.test (static_cast < size_t > (x) * ny + y);
+      };
+
       // ------------------------------------------------------------------------------------------------------------------
       // now the seed pixel finding !!
       //
@@ -1042,99 +966,57 @@ EUTelClusteringProcessor::digitalFixedFrameClustering (LCEvent * evt,
       ///    expected.
       ///    const int stepy = 1;
 
-      std::map < unsigned int, std::map < unsigned int, bool >>::iterator pos;
-      for (pos = sensormatrix.begin (); pos != sensormatrix.end (); ++pos)
+      // the seed candidates are the fired pixels, found by a bit scan
+      for (size_t bit = _firedPixelBitmap.findNext (0);
+	   bit < _firedPixelBitmap.size ();
+	   bit = _firedPixelBitmap.findNext (bit + 1))
 	{
-	  std::map < unsigned int, bool >::iterator sec;
-	  for (sec = sensormatrix[(*pos).first].begin ();
-	       sec != sensormatrix[(*pos).first].end (); ++sec)
-	    {
-	      //              if(sensormatrix.at(i,j))
-	      if (sensormatrix[pos->first][sec->first])
-		{
-		  const unsigned int i = pos->first;
-		  const unsigned int j = sec->first;
+	  const unsigned int i = bit / ny;
+	  const unsigned int j = bit % ny;
 
-		  // number of neighbours
-		  int nb = 0;
+	  // number of neighbours
+	  int nb = 0;
 
-		  // total number of pixels in a cluster around the seed candidate
-		  // (also diagonal elements are counted)
-		  int npixel_cl = 0;
+	  // total number of pixels in a cluster around the seed candidate
+	  // (also diagonal elements are counted)
+	  int npixel_cl = 0;
 
-		  // first npixel_cl will be determined
-		  for (unsigned int index_x = i - stepx;
-		       index_x <= (i + stepx); index_x++)
+	  // first npixel_cl will be determined
+	  for (unsigned int index_x = i - stepx;
+	       index_x <= (i + stepx); index_x++)
+	    {
+	      for (unsigned int index_y = j - stepy;
+		   index_y <= (j + stepy); index_y++)
+		{
+		  if (index_x > 0 && index_y > 0
+		      && isFired (index_x, index_y))
 		    {
-		      for (unsigned int index_y = j - stepy;
-			   index_y <= (j + stepy); index_y++)
-			{
-
-			  if (index_x > 0 && index_y > 0)
-			    {
-			      std::map < unsigned int,
-				std::map < unsigned int,
-				bool >>::const_iterator z =
-				sensormatrix.find (index_x);
-			      if (z != sensormatrix.end ()
-				  && z->second.find (index_y) !=
-				  z->second.end ())
-				{
-				  if (sensormatrix[index_x][index_y])
-				    {
-				      npixel_cl++;
-				    }
-				}
-			    }
-			}
+		      npixel_cl++;
 		    }
+		}
+	    }
 
-		  if (npixel_cl > 1)
-		    {
-		      if (i >= 1)
-			for (int index_x = static_cast < int >(i - 1);
-			     index_x <= static_cast < int >(i + 1); index_x++)
-			  {
-			    if (index_x >= 0)
-			      {
-				std::map < unsigned int,
-				  std::map < unsigned int,
-				  bool >>::const_iterator z =
-				  sensormatrix.find (index_x);
-				if (z != sensormatrix.end ()
-				    && z->second.find (j) != z->second.end ())
-				  {
-				    if (sensormatrix[index_x][j])
-				      nb++;
-				  }
-			      }
-			  }
+	  if (npixel_cl > 1)
+	    {
+	      if (i >= 1)
+		for (int index_x = static_cast < int >(i - 1);
+		     index_x <= static_cast < int >(i + 1); index_x++)
+		  {
+		    if (index_x >= 0 && isFired (index_x, j))
+		      nb++;
+		  }
 
-		      if (j >= 1)
-			for (int index_y = static_cast < int >(j - 1);
-			     index_y <= static_cast < int >(j + 1); index_y++)
-			  {
-			    if (index_y >= 0)
-			      {
-				std::map < unsigned int,
-				  std::map < unsigned int,
-				  bool >>::const_iterator z =
-				  sensormatrix.find (i);
-				if (z != sensormatrix.end ()
-				    && z->second.find (index_y) !=
-				    z->second.end ())
-				  {
-				    if (sensormatrix[i][index_y])
-				      nb++;
-				  }
-			      }
-			  }
-		    }		// could all this passage be skipped ?
+	      if (j >= 1)
+		for (int index_y = static_cast < int >(j - 1);
+		     index_y <= static_cast < int >(j + 1); index_y++)
+		  {
+		    if (index_y >= 0 && isFired (i, index_y))
+		      nb++;
+		  }
+	    }		// could all this passage be skipped ?
 
-		  // fill this pixel into the list of found seed pixel candidates
-		  seedcandidates.push_back (seed (i, j, nb, npixel_cl));
-		}
-	    }
+	  // fill this pixel into the list of found seed pixel candidates
+	  seedcandidates.push_back (seed (i, j, nb, npixel_cl));
 	}
       // sort the list of seed pixel candidates. the first criteria is
       // the number of neighbours without diagonal neighbours. then the
@@ -1154,13 +1036,10 @@ EUTelClusteringProcessor::digitalFixedFrameClustering (LCEvent * evt,
 	  for (i = seedcandidates.begin (); i != seedcandidates.end (); ++i)
 	    {
 	      // check that this pixel was not used before.
-
-	      std::map < unsigned int, std::map < unsigned int,
-		bool >>::const_iterator z = sensormatrix.find (i->x);
-	      if (z != sensormatrix.end ()
-		  && z->second.find (i->y) != z->second.end ())
+	      if (i->x < nx && i->y < ny)
 		{
-		  if (sensormatrix[i->x][i->y])
+		  if (_firedPixelBitmap.test (static_cast < size_t >
+					      (i->x) * ny + i->y))
 		    {
 		      std::vector < pixel > pix;
 		      // select pixels around the seed pixel
@@ -1178,24 +1057,12 @@ EUTelClusteringProcessor::digitalFixedFrameClustering (LCEvent * evt,
 				   index_y <= static_cast <
 				   int >(i->y + stepy); index_y++)
 				{
-				  if (index_x >= 0 && index_y >= 0)
+				  if (index_x >= 0 && index_y >= 0
+				      && isFired (index_x, index_y))
 				    {
-				      std::map < unsigned int,
-					std::map < unsigned int,
-					bool >>::const_iterator z =
-					sensormatrix.find (index_x);
-				      if (z != sensormatrix.end ()
-					  && z->second.find (index_y) !=
-					  z->second.end ())
-					{
-					  if (sensormatrix[index_x][index_y])
-					    {
-					      pix.
-						push_back (pixel
-							   (index_x,
-							    index_y));
-					    }
-					}
+				      pix.
+					push_back (pixel
+						   (index_x, index_y));
 				    }
 				}
 			    }
@@ -1232,18 +1099,9 @@ EUTelClusteringProcessor::digitalFixedFrameClustering (LCEvent * evt,
 			      // remove pixels, that were assigned to this
 			      // cluster from the dummy sensor map. this
 			      // pixel will then not be used then in other clusters
-			      // sensormatrix.set(pix[j].x,pix[j].y,false);
-
-			      std::map < unsigned int,
-				std::map < unsigned int,
-				bool >>::const_iterator z =
-				sensormatrix.find (pix[j].x);
-			      if (z != sensormatrix.end ()
-				  && z->second.find (pix[j].y) !=
-				  z->second.end ())
-				{
-				  sensormatrix[pix[j].x][pix[j].y] = false;
-				}
+			      _firedPixelBitmap.reset (static_cast < size_t >
+						       (pix[j].x) * ny +
+						       pix[j].y);
 
 			      // dont forget to apply the offset correction!
 			      //                            int index =
@@ -1536,13 +1394,9 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
 	dynamic_cast <
 	TrackerDataImpl *
 	>(noiseCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
-      TrackerRawDataImpl *status =
-	dynamic_cast <
-	TrackerRawDataImpl *
-	>(statusCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
 
       // reset the status
-      resetStatus (status);
+      EUTelPixelStatusMask & status = resetStatusMask (sensorID);
 
       // prepare the matrix decoder
       EUTelMatrixDecoder matrixDecoder (noiseDecoder, noise);
@@ -1551,9 +1405,19 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
       // standard FixedFrameClustering. Initialize all the entries to zero.
       vector < float >dataVec (noise->getChargeValues ().size (), 0.);
 
+      // pixels missing in the status are good
+      if (status.size () < dataVec.size ())
+	{
+	  status.resize (dataVec.size ());
+	}
+
       // prepare a multimap for the seed candidates
       multimap < float, int >seedCandidateMap;
 
+      // the pixels above the seed cut
+      _seedCandidateBitmap.resize (status.size ());
+      _seedCandidateBitmap.clear ();
+
       if (type == kEUTelGenericSparsePixel)
 	{
 
@@ -1573,19 +1437,9 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
 					      sparsePixel.getYCoord ());
 	      float signal = sparsePixel.getSignal ();
 	      dataVec[index] = signal;
-	      if (static_cast < int >(status->getADCValues ().size ()) <
-		  index)
+	      if (signal > _ffSeedCut * noise->getChargeValues ()[index])
 		{
-		  status->adcValues ().resize (index + 1);
-		}
-	      if ((signal > _ffSeedCut * noise->getChargeValues ()[index]) &&
-		  (status->getADCValues ()[index] == EUTELESCOPE::GOODPIXEL))
-		{
-		  seedCandidateMap.insert (make_pair (signal, index));
-		  streamlog_out (DEBUG1) << "Added pixel " << sparsePixel.
-		    getXCoord () << ", " << sparsePixel.
-		    getYCoord () << " with signal " << signal <<
-		    " to the seedCandidateMap" << endl;
+		  _seedCandidateBitmap.set (index);
 		}
 	    }
 	}
@@ -1594,6 +1448,21 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
 	  throw UnknownDataTypeException ("Unknown sparsified pixel");
 	}
 
+      // the seed candidates are the good pixels above the seed cut,
+      // found by a bit scan
+      for (size_t iPixel = status.findGood (0, _seedCandidateBitmap);
+	   iPixel < status.size ();
+	   iPixel = status.findGood (iPixel + 1, _seedCandidateBitmap))
+	{
+	  const int index = static_cast < int >(iPixel);
+	  int seedX, seedY;
+	  matrixDecoder.getXYFromIndex (index, seedX, seedY);
+	  seedCandidateMap.insert (make_pair (dataVec[iPixel], index));
+	  streamlog_out (DEBUG1) << "Added pixel " << seedX << ", " << seedY
+	    << " with signal " << dataVec[iPixel] <<
+	    " to the seedCandidateMap" << endl;
+	}
+
       if (!seedCandidateMap.empty ())
 	{
 
@@ -1607,24 +1476,18 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
 	    {
 
 	      // Remove hot pixel:
-	      if (_hitIndexMapVec.size () > static_cast <
-		  unsigned int >(sensorID))
+	      if (status.isHot ((*rMapIter).second))
 		{
-		  if (_hitIndexMapVec[sensorID].find ((*rMapIter).second) !=
-		      _hitIndexMapVec[sensorID].end ())
-		    {
-		      int seedX, seedY;
-		      matrixDecoder.getXYFromIndex ((*rMapIter).second, seedX,
-						    seedY);
-		      streamlog_out (DEBUG5) << "Detector " << sensorID <<
-			" Pixel " << seedX << " " << seedY <<
-			" -- HOTPIXEL, skipping... " << endl;
-		      ++rMapIter;
-		      continue;
-		    }
+		  int seedX, seedY;
+		  matrixDecoder.getXYFromIndex ((*rMapIter).second, seedX,
+						seedY);
+		  streamlog_out (DEBUG5) << "Detector " << sensorID <<
+		    " Pixel " << seedX << " " << seedY <<
+		    " -- HOTPIXEL, skipping... " << endl;
+		  ++rMapIter;
+		  continue;
 		}
-	      if (status->adcValues ()[(*rMapIter).second] ==
-		  EUTELESCOPE::GOODPIXEL)
+	      if (status.isGood ((*rMapIter).second))
 		{
 		  // if we enter here, this means that at least the seed pixel
 		  // wasn't added yet to another cluster.  Note that now we need
@@ -1654,12 +1517,8 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
 			      int index =
 				matrixDecoder.getIndexFromXY (xPixel, yPixel);
 
-			      bool isHit =
-				(status->getADCValues ()[index] ==
-				 EUTELESCOPE::HITPIXEL);
-			      bool isGood =
-				(status->getADCValues ()[index] ==
-				 EUTELESCOPE::GOODPIXEL);
+			      bool isHit = status.isHit (index);
+			      bool isGood = status.isGood (index);
 
 			      if (isGood)
 				clusterCandidateIndeces.push_back (index);
@@ -1671,8 +1530,7 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
 				  // if the pixel wasn't selected, then its signal
 				  // will be 0.0. Mark it in the status
 				  if (dataVec[index] == 0.0)
-				    status->adcValues ()[index] =
-				      EUTELESCOPE::MISSINGPIXEL;
+				    status.setMissing (index);
 				  clusterCandidateSignal += dataVec[index];
 				  clusterCandidateNoise2 +=
 				    pow (noise->getChargeValues ()[index], 2);
@@ -1748,8 +1606,7 @@ EUTelClusteringProcessor::zsFixedFrameClustering (LCEvent * evt,
 		      while (indexIter != clusterCandidateIndeces.end ())
 			{
 			  if ((*indexIter) != -1)
-			    status->adcValues ()[(*indexIter)] =
-			      EUTELESCOPE::HITPIXEL;
+			    status.setHit (*indexIter);
 			  ++indexIter;
 			}
 
@@ -1888,13 +1745,9 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
 	dynamic_cast <
 	TrackerDataImpl *
 	>(noiseCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
-      TrackerRawDataImpl *status =
-	dynamic_cast <
-	TrackerRawDataImpl *
-	>(statusCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
 
       // reset the status
-      resetStatus (status);
+      EUTelPixelStatusMask & status = resetStatusMask (sensorID);
 
       // prepare the matrix decoder
       EUTelMatrixDecoder matrixDecoder (noiseDecoder, noise);
@@ -1908,11 +1761,15 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
       // here.
       // If the 0.0001 value is found here later on again, then we know that the
       // corresponding pixel was not transmitted!
-      vector < float >dataVec (status->getADCValues ().size (), 0.0001);
+      vector < float >dataVec (status.size (), 0.0001);
 
       // prepare a multimap for the seed candidates
       multimap < float, int >seedCandidateMap;
 
+      // the pixels above the seed cut
+      _seedCandidateBitmap.resize (status.size ());
+      _seedCandidateBitmap.clear ();
+
       if (type == kEUTelGenericSparsePixel)
 	{
 
@@ -1934,27 +1791,9 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
 	      dataVec[index] = signal;
 
 	      //! CUT 1
-	      if ((signal > _ffSeedCut * noise->getChargeValues ()[index]) &&
-		  (status->getADCValues ()[index] == EUTELESCOPE::GOODPIXEL))
+	      if (signal > _ffSeedCut * noise->getChargeValues ()[index])
 		{
-		  seedCandidateMap.insert (make_pair (signal, index));
-		  streamlog_out (DEBUG1) << "Added pixel " << sparsePixel.
-		    getXCoord () << ", " << sparsePixel.
-		    getYCoord () << " with signal " << signal <<
-		    " to the seedCandidateMap" << endl;
-
-		  if (noise->getChargeValues ()[index] < 0.01)
-		    {
-		      streamlog_out (ERROR2)
-			<< "ZERO NOISE SEED PIXEL ADDED!"
-			<< "\n x=" << sparsePixel.getXCoord ()
-			<< "\n y=" << sparsePixel.
-			getYCoord () << "\n amp=" << signal << "\n status=" <<
-			status->
-			getADCValues ()[index] << " GOODP   =  0," <<
-			" BAD     =  1," << " HIT     = -1," <<
-			" MISSING =  2," << " FIRING  =  3.";
-		    }
+		  _seedCandidateBitmap.set (index);
 		}
 	    }
 	}
@@ -1963,6 +1802,32 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
 	  throw UnknownDataTypeException ("Unknown sparsified pixel");
 	}
 
+      // the seed candidates are the good pixels above the seed cut,
+      // found by a bit scan
+      for (size_t iPixel = status.findGood (0, _seedCandidateBitmap);
+	   iPixel < status.size ();
+	   iPixel = status.findGood (iPixel + 1, _seedCandidateBitmap))
+	{
+	  const int index = static_cast < int >(iPixel);
+	  int seedX, seedY;
+	  matrixDecoder.getXYFromIndex (index, seedX, seedY);
+	  seedCandidateMap.insert (make_pair (dataVec[iPixel], index));
+	  streamlog_out (DEBUG1) << "Added pixel " << seedX << ", " << seedY
+	    << " with signal " << dataVec[iPixel] <<
+	    " to the seedCandidateMap" << endl;
+
+	  if (noise->getChargeValues ()[index] < 0.01)
+	    {
+	      streamlog_out (ERROR2)
+		<< "ZERO NOISE SEED PIXEL ADDED!"
+		<< "\n x=" << seedX
+		<< "\n y=" << seedY << "\n amp=" << dataVec[iPixel] <<
+		"\n status=" << EUTELESCOPE::GOODPIXEL << " GOODP   =  0," <<
+		" BAD     =  1," << " HIT     = -1," <<
+		" MISSING =  2," << " FIRING  =  3.";
+	    }
+	}
+
       if (!seedCandidateMap.empty ())
 	{
 
@@ -1974,8 +1839,7 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
 	    seedCandidateMap.rbegin ();
 	  while (rMapIter != seedCandidateMap.rend ())
 	    {
-	      if (status->adcValues ()[(*rMapIter).second] ==
-		  EUTELESCOPE::GOODPIXEL)
+	      if (status.isGood ((*rMapIter).second))
 		{
 		  // if we enter here, this means that at least the seed pixel
 		  // wasn't added yet to another cluster.  Note that now we need
@@ -2021,12 +1885,10 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
 						       getChargeValues ()
 						       [index]);
 
-			      bool isHit = (status->getADCValues ()[index] == EUTELESCOPE::HITPIXEL);	// this is set for pixels
+			      bool isHit = status.isHit (index);	// this is set for pixels
 			      // already used for
 			      // another cluster
-			      bool isGood =
-				(status->getADCValues ()[index] ==
-				 EUTELESCOPE::GOODPIXEL);
+			      bool isGood = status.isGood (index);
 
 			      if (isGood)	// normal case, good means not marked as used by
 				// another cluster, yet
@@ -2041,8 +1903,7 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
 				  // Mark this in the status!
 				  if (dataVec[index] == 0.0001)
 				    {
-				      status->adcValues ()[index] =
-					EUTELESCOPE::MISSINGPIXEL;
+				      status.setMissing (index);
 				    }
 
 				  //! HACK TAKI
@@ -2217,8 +2078,7 @@ EUTelClusteringProcessor::zsBrickedClustering (LCEvent * evt,
 			    {
 			      if ((*indexIter) != -1)
 				{
-				  status->adcValues ()[(*indexIter)] =
-				    EUTELESCOPE::HITPIXEL;
+				  status.setHit (*indexIter);
 				}
 			    }
 			  ++indexIter;
@@ -2468,8 +2328,7 @@ EUTelClusteringProcessor::sparseClustering (LCEvent * evt,
 		  int index =
 		    matrixDecoder.getIndexFromXY (pixel.getXCoord (),
 						  pixel.getYCoord ());
-		  if (_hitIndexMapVec[idetector].find (index) !=
-		      _hitIndexMapVec[idetector].end ())
+		  if (isHotPixel (sensorID, index))
 		    {
 		      // do nothing
 		    }
@@ -2665,16 +2524,12 @@ EUTelClusteringProcessor::fixedFrameClustering (LCEvent * evt,
 	dynamic_cast <
 	TrackerDataImpl *
 	>(noiseCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
-      TrackerRawDataImpl *status =
-	dynamic_cast <
-	TrackerRawDataImpl *
-	>(statusCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
 
       // prepare the matrix decoder
       EUTelMatrixDecoder matrixDecoder (cellDecoder, nzsData);
 
       // reset the status
-      resetStatus (status);
+      EUTelPixelStatusMask & status = resetStatusMask (sensorID);
 
       // initialize the cluster counter
       short clusterCounter = 0;
@@ -2682,18 +2537,16 @@ EUTelClusteringProcessor::fixedFrameClustering (LCEvent * evt,
 
       _seedCandidateMap.clear ();
 
-      for (unsigned int iPixel = 0;
-	   iPixel < nzsData->getChargeValues ().size (); iPixel++)
+      // only the good pixels are scanned
+      for (size_t iPixel = status.findGood (0); iPixel < status.size ();
+	   iPixel = status.findGood (iPixel + 1))
 	{
-	  if (status->getADCValues ()[iPixel] == EUTELESCOPE::GOODPIXEL)
+	  if (nzsData->getChargeValues ()[iPixel] >
+	      _ffSeedCut * noise->getChargeValues ()[iPixel])
 	    {
-	      if (nzsData->getChargeValues ()[iPixel] >
-		  _ffSeedCut * noise->getChargeValues ()[iPixel])
-		{
-		  _seedCandidateMap.
-		    push_back (make_pair
-			       (nzsData->getChargeValues ()[iPixel], iPixel));
-		}
+	      _seedCandidateMap.
+		push_back (make_pair
+			   (nzsData->getChargeValues ()[iPixel], iPixel));
 	    }
 	}
 
@@ -2714,8 +2567,7 @@ EUTelClusteringProcessor::fixedFrameClustering (LCEvent * evt,
 	      --mapIter;
 	      // check if this seed candidate has not been already added to a
 	      // cluster
-	      if (status->adcValues ()[(*mapIter).second] ==
-		  EUTELESCOPE::GOODPIXEL)
+	      if (status.isGood ((*mapIter).second))
 		{
 		  // if we enter here, this means that at least the seed pixel
 		  // wasn't added yet to another cluster.  Note that now we need
@@ -2745,12 +2597,8 @@ EUTelClusteringProcessor::fixedFrameClustering (LCEvent * evt,
 			      int index =
 				matrixDecoder.getIndexFromXY (xPixel, yPixel);
 
-			      bool isHit =
-				(status->getADCValues ()[index] ==
-				 EUTELESCOPE::HITPIXEL);
-			      bool isGood =
-				(status->getADCValues ()[index] ==
-				 EUTELESCOPE::GOODPIXEL);
+			      bool isHit = status.isHit (index);
+			      bool isGood = status.isGood (index);
 
 			      if (isGood)
 				clusterCandidateIndeces.push_back (index);
@@ -2847,8 +2695,7 @@ EUTelClusteringProcessor::fixedFrameClustering (LCEvent * evt,
 			{
 			  if (*indexIter != -1)
 			    {
-			      status->adcValues ()[(*indexIter)] =
-				EUTELESCOPE::HITPIXEL;
+			      status.setHit (*indexIter);
 			    }
 			  ++indexIter;
 			}
@@ -3010,49 +2857,42 @@ EUTelClusteringProcessor::nzsBrickedClustering (LCEvent * evt,
 	dynamic_cast <
 	TrackerDataImpl *
 	>(noiseCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
-      TrackerRawDataImpl *status =
-	dynamic_cast <
-	TrackerRawDataImpl *
-	>(statusCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
 
       // reset the cluster counter for the clusterID
       int clusterID = 0;
 
       // reset the status
-      resetStatus (status);
+      EUTelPixelStatusMask & status = resetStatusMask (sensorID);
 
       // prepare a multimap for the seed candidates
       vector < pair < float, int >>seedCandidateMap;
 
-      // fill the seed candidate map
-      for (unsigned int iPixel = 0;
-	   iPixel < nzsData->getChargeValues ().size (); iPixel++)
+      // fill the seed candidate map, scanning only the good pixels
+      for (size_t iPixel = status.findGood (0); iPixel < status.size ();
+	   iPixel = status.findGood (iPixel + 1))
 	{
-	  if (status->getADCValues ()[iPixel] == EUTELESCOPE::GOODPIXEL)
+	  //! CUT 1
+	  if (nzsData->getChargeValues ()[iPixel] >
+	      _ffSeedCut * noise->getChargeValues ()[iPixel])
 	    {
-	      //! CUT 1
-	      if (nzsData->getChargeValues ()[iPixel] >
-		  _ffSeedCut * noise->getChargeValues ()[iPixel])
+	      seedCandidateMap.
+		push_back (make_pair
+			   (nzsData->getChargeValues ()[iPixel], iPixel));
+	      streamlog_out (MESSAGE2) << "Added pixel at (index=" <<
+		iPixel << ") with signal " << nzsData->
+		getChargeValues ()[iPixel] << " to the seedCandidateMap"
+		<< endl;
+
+	      if (noise->getChargeValues ()[iPixel] < 0.01)
 		{
-		  seedCandidateMap.
-		    push_back (make_pair
-			       (nzsData->getChargeValues ()[iPixel], iPixel));
-		  streamlog_out (MESSAGE2) << "Added pixel at (index=" <<
-		    iPixel << ") with signal " << nzsData->
-		    getChargeValues ()[iPixel] << " to the seedCandidateMap"
-		    << endl;
-
-		  if (noise->getChargeValues ()[iPixel] < 0.01)
-		    {
-		      streamlog_out (ERROR2)
-			<<
-			"ZERO NOISE SEED PIXEL ADDED (nszBrickedClustering)!"
-			<< "\n index=" << iPixel << "\n amp=" << nzsData->
-			getChargeValues ()[iPixel] << "\n status=" << status->
-			getADCValues ()[iPixel] << " GOODP   =  0," <<
-			" BAD     =  1," << " HIT     = -1," <<
-			" MISSING =  2," << " FIRING  =  3.";
-		    }
+		  streamlog_out (ERROR2)
+		    <<
+		    "ZERO NOISE SEED PIXEL ADDED (nszBrickedClustering)!"
+		    << "\n index=" << iPixel << "\n amp=" << nzsData->
+		    getChargeValues ()[iPixel] << "\n status=" <<
+		    EUTELESCOPE::GOODPIXEL << " GOODP   =  0," <<
+		    " BAD     =  1," << " HIT     = -1," <<
+		    " MISSING =  2," << " FIRING  =  3.";
 		}
 	    }
 	}
@@ -3068,8 +2908,7 @@ EUTelClusteringProcessor::nzsBrickedClustering (LCEvent * evt,
 	  while (rMapIter != seedCandidateMap.begin ())
 	    {
 	      rMapIter--;
-	      if (status->adcValues ()[(*rMapIter).second] ==
-		  EUTELESCOPE::GOODPIXEL)
+	      if (status.isGood ((*rMapIter).second))
 		{
 		  // if we enter here, this means that at least the seed pixel
 		  // wasn't added yet to another cluster.  Note that now we need
@@ -3115,12 +2954,10 @@ EUTelClusteringProcessor::nzsBrickedClustering (LCEvent * evt,
 						       getChargeValues ()
 						       [index]);
 
-			      bool isHit = (status->getADCValues ()[index] == EUTELESCOPE::HITPIXEL);	// this is set for pixels
+			      bool isHit = status.isHit (index);	// this is set for pixels
 			      // already used for
 			      // another cluster
-			      bool isGood =
-				(status->getADCValues ()[index] ==
-				 EUTELESCOPE::GOODPIXEL);
+			      bool isGood = status.isGood (index);
 
 			      if (isGood)	// normal case
 				{
@@ -3303,8 +3140,7 @@ EUTelClusteringProcessor::nzsBrickedClustering (LCEvent * evt,
 			    {
 			      if ((*indexIter) != -1)
 				{
-				  status->adcValues ()[(*indexIter)] =
-				    EUTELESCOPE::HITPIXEL;
+				  status.setHit (*indexIter);
 				}
 			    }
 			  ++indexIter;
@@ -3418,25 +3254,45 @@ EUTelClusteringProcessor::end ()
     }
 }
 
-void
-EUTelClusteringProcessor::resetStatus (IMPL::TrackerRawDataImpl * status)
+EUTelPixelStatusMask &
+EUTelClusteringProcessor::resetStatusMask (int sensorID)
 {
+  if (static_cast < int >(_statusMaskVec.size ()) <= sensorID)
+    {
+      _statusMaskVec.resize (sensorID + 1);
+    }
+  EUTelPixelStatusMask & statusMask = _statusMaskVec[sensorID];
+
+  TrackerRawDataImpl *status =
+    dynamic_cast <
+    TrackerRawDataImpl *
+    >(statusCollectionVec->getElementAt (_ancillaryIndexMap[sensorID]));
+
+  // the status collection can be replaced, or changed in place by
+  // another processor: reload the mask when the status values differ
+  // from the ones it was loaded from. The hit and missing pixels are
+  // cleared as well
+  if (!statusMask.hasStatus (status->getADCValues ()))
+    {
+      statusMask.setStatus (status->getADCValues ());
+    }
+  else
+    {
+      statusMask.clearEvent ();
+    }
+  return statusMask;
+}
 
-  int i = 0;
-  ShortVec::iterator iter = status->adcValues ().begin ();
-  while (iter != status->adcValues ().end ())
+bool
+EUTelClusteringProcessor::isHotPixel (int sensorID, int index) const
+{
+  if (sensorID < 0 || sensorID >= static_cast < int >(_statusMaskVec.size ()))
     {
-      if (*iter == EUTELESCOPE::HITPIXEL)
-	{
-	  *iter = EUTELESCOPE::GOODPIXEL;
-	}
-      else if (*iter == EUTELESCOPE::MISSINGPIXEL)
-	{
-	  *iter = EUTELESCOPE::GOODPIXEL;
-	}
-      ++iter;
-      i++;
+      return false;
     }
+  const EUTelPixelStatusMask & statusMask = _statusMaskVec[sensorID];
+  return index >= 0 && static_cast < size_t > (index) < statusMask.size ()
+    && statusMask.isHot (index);
 }
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
@@ -3472,9 +3328,6 @@ EUTelClusteringProcessor::fillHistos (LCEvent * evt)
     LCCollectionVec *noiseCollectionVec =
       dynamic_cast <
       LCCollectionVec * >(evt->getCollection (_noiseCollectionName));
-    LCCollectionVec *statusCollectionVec =
-      dynamic_cast <
-      LCCollectionVec * >(evt->getCollection (_statusCollectionName));
     CellIDDecoder < TrackerDataImpl > noiseDecoder (noiseCollectionVec);
 
     vector < unsigned short >eventCounterVec (_noOfDetector, 0);
@@ -3626,17 +3479,18 @@ EUTelClusteringProcessor::fillHistos (LCEvent * evt)
 	// fill the noise related histograms
 
 	// get the noise TrackerDataImpl corresponding to the detector
-	// under analysis and the status matrix as well
+	// under analysis and the status mask as well
 	TrackerDataImpl *noiseMatrix =
 	  dynamic_cast <
 	  TrackerDataImpl *
 	  >(noiseCollectionVec->
 	    getElementAt (_ancillaryIndexMap[detectorID]));
-	TrackerRawDataImpl *statusMatrix =
-	  dynamic_cast <
-	  TrackerRawDataImpl *
-	  >(statusCollectionVec->
-	    getElementAt (_ancillaryIndexMap[detectorID]));
+	const EUTelPixelStatusMask *statusMask = nullptr;
+	if (detectorID >= 0
+	    && detectorID < static_cast < int >(_statusMaskVec.size ()))
+	  {
+	    statusMask = &_statusMaskVec[detectorID];
+	  }
 
 	// prepare also a MatrixDecoder for this matrix
 	EUTelMatrixDecoder noiseMatrixDecoder (noiseDecoder, noiseMatrix);
@@ -3662,16 +3516,13 @@ EUTelClusteringProcessor::fillHistos (LCEvent * evt)
 		      {
 			int index =
 			  noiseMatrixDecoder.getIndexFromXY (xPixel, yPixel);
-			// the corresponding position in the status matrix has to be
-			// HITPIXEL
-			bool isHit = (statusMatrix->getADCValues ()[index] ==
-				      EUTELESCOPE::HITPIXEL);
-			bool isBad = (statusMatrix->getADCValues ()[index] ==
-				      EUTELESCOPE::BADPIXEL);
-			bool isMissing =
-			  (statusMatrix->getADCValues ()[index] ==
-			   EUTELESCOPE::MISSINGPIXEL);
-			if (!isMissing && !isBad && isHit)
+			// the corresponding position in the status mask has to
+			// be HITPIXEL, hit pixels are neither bad nor missing
+			bool isHit = (statusMask != nullptr)
+			  && (static_cast < size_t > (index) <
+			      statusMask->size ())
+			  && statusMask->isHit (index);
+			if (isHit)
 			  {
 			    noiseValues.push_back (noiseMatrix->
 						   getChargeValues ()[index]);
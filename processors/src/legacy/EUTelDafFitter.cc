@@ -148,11 +148,16 @@ void EUTelDafFitter::dafEvent(LCEvent *event) {
   }
 
   // Check found tracks
+  size_t batchEnd = 0;
   for (size_t ii = 0; ii < _system.getNtracks(); ii++) {
     // run track fitte
     _nCandidates++;
-    // prepare track for DAF fit
-    _system.fitPlanesInfoDaf(_system.tracks.at(ii));
+    // DAF fit of the candidates, a batch at a time
+    if (ii == batchEnd) {
+      batchEnd = ii + _system.fitPlanesInfoDafBatch(ii);
+    }
+    // plane z positions of this candidate for the output
+    _system.loadBatchPlanes(ii);
     // check resids, intime, angles
     if (not checkTrack(_system.tracks.at(ii))) {
       continue;
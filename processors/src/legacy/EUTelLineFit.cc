@@ -149,6 +149,12 @@ EUTelLineFit::EUTelLineFit() : Processor("EUTelLineFit") {
                             "Alignment Constants for sixth Telescope Layer:\n "
                             "off_x, off_y, theta_x, theta_y, theta_z",
                             _alignmentConstantsSixthLayer, constantsSixthLayer);
+
+  registerOptionalParameter(
+      "MaxHitCombinations",
+      "Maximum number of combinations of one hit per plane fitted in an "
+      "event, events with more combinations are not fitted",
+      _maxHitCombinations, 1000);
 }
 
 void EUTelLineFit::init() {
@@ -191,16 +197,75 @@ void EUTelLineFit::init() {
 
   _nPlanes = _siPlanesParameters->getSiPlanesNumber();
 
-  _xPos = new double[_nPlanes];
-  _yPos = new double[_nPlanes];
-  _zPos = new double[_nPlanes];
-  _waferResidX = new double[_nPlanes];
-  _waferResidY = new double[_nPlanes];
-  _xFitPos = new double[_nPlanes];
-  _yFitPos = new double[_nPlanes];
+  _layerHitsX.assign(_nPlanes, std::vector<double>());
+  _layerHitsY.assign(_nPlanes, std::vector<double>());
+  _zPos.assign(_nPlanes, 0.0);
+  _waferResidX.assign(_nPlanes, 0.0);
+  _waferResidY.assign(_nPlanes, 0.0);
+
+  _intrResolX.assign(_nPlanes, 0.0);
+  _intrResolY.assign(_nPlanes, 0.0);
+
+  // everything depending only on the layer is looked up once: the
+  // layer of each sensor ID, the intrinsic resolution and the
+  // alignment correction
+  _layerIndexTable.clear();
+  const int nLayers = std::min(_nPlanes, _siPlanesLayerLayout->getNLayers());
+  for (int iLayer = 0; iLayer < nLayers; iLayer++) {
+    const int sensorID = _siPlanesLayerLayout->getID(iLayer);
+    if (sensorID < 0) {
+      streamlog_out(WARNING2) << "Negative sensor ID " << sensorID
+                              << " of layer " << iLayer << " ignored" << endl;
+      continue;
+    }
+    if (sensorID >= static_cast<int>(_layerIndexTable.size())) {
+      _layerIndexTable.resize(sensorID + 1, -1);
+    }
+    if (_layerIndexTable[sensorID] < 0) {
+      _layerIndexTable[sensorID] = iLayer;
+    }
 
-  _intrResolX = new double[_nPlanes];
-  _intrResolY = new double[_nPlanes];
+    // here we take intrinsic resolution from geometry database
+    _intrResolX[iLayer] =
+        1000 * _siPlanesLayerLayout->getSensitiveResolution(iLayer); // um
+    _intrResolY[iLayer] =
+        1000 * _siPlanesLayerLayout->getSensitiveResolution(iLayer); // um
+  }
+
+  // The other layers were aligned with respect to the first one.
+  std::vector<float> noAlignment(5, 0.0);
+  _layerAlignment.resize(_nPlanes);
+  for (int iLayer = 0; iLayer < _nPlanes; iLayer++) {
+    const std::vector<float> *constants = &noAlignment;
+    if (iLayer == 1) {
+      constants = &_alignmentConstantsSecondLayer;
+    } else if (iLayer == 2) {
+      constants = &_alignmentConstantsThirdLayer;
+    } else if (iLayer == 3) {
+      constants = &_alignmentConstantsFourthLayer;
+    } else if (iLayer == 4) {
+      constants = &_alignmentConstantsFifthLayer;
+    } else if (iLayer == 5) {
+      constants = &_alignmentConstantsSixthLayer;
+    }
+
+    const double off_x = (*constants)[0];
+    const double off_y = (*constants)[1];
+    const double theta_x = (*constants)[2];
+    const double theta_y = (*constants)[3];
+    const double theta_z = (*constants)[4];
+
+    // For documentation of these formulas look at EUTelAlign
+    LayerAlignment &alignment = _layerAlignment[iLayer];
+    alignment.xx = cos(theta_y) * cos(theta_z);
+    alignment.xy = (-1) * sin(theta_x) * sin(theta_y) * cos(theta_z) +
+                   cos(theta_x) * sin(theta_z);
+    alignment.yx = (-1) * cos(theta_y) * sin(theta_z);
+    alignment.yy = sin(theta_x) * sin(theta_y) * sin(theta_z) +
+                   cos(theta_x) * cos(theta_z);
+    alignment.offX = off_x;
+    alignment.offY = off_y;
+  }
 }
 
 void EUTelLineFit::processRunHeader(LCRunHeader *rdr) {
@@ -271,238 +336,122 @@ void EUTelLineFit::processEvent(LCEvent *event) {
     LCCollectionVec *hitCollection = static_cast<LCCollectionVec *>(
         event->getCollection(_hitCollectionName));
 
-    int detectorID = -99; // it's a non sense
-    int oldDetectorID = -100;
-    int layerIndex;
+    UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder(hitCollection);
+    for (int iLayer = 0; iLayer < _nPlanes; iLayer++) {
+      _layerHitsX[iLayer].clear();
+      _layerHitsY[iLayer].clear();
+    }
 
     for (int iHit = 0; iHit < hitCollection->getNumberOfElements(); iHit++) {
 
       TrackerHitImpl *hit =
           static_cast<TrackerHitImpl *>(hitCollection->getElementAt(iHit));
-      UTIL::CellIDDecoder<TrackerHitImpl> hitDecoder(hitCollection);
-      detectorID = hitDecoder(hit)["sensorID"];
-
-      if (detectorID != oldDetectorID) {
-        oldDetectorID = detectorID;
-
-        if (_conversionIdMap.size() !=
-            static_cast<unsigned>(_siPlanesParameters->getSiPlanesNumber())) {
-          // first of all try to see if this detectorID already belong to
-          if (_conversionIdMap.find(detectorID) == _conversionIdMap.end()) {
-            // this means that this detector ID was not already inserted,
-            // so this is the right place to do that
-            for (int iLayer = 0; iLayer < _siPlanesLayerLayout->getNLayers();
-                 iLayer++) {
-              if (_siPlanesLayerLayout->getID(iLayer) == detectorID) {
-                _conversionIdMap.insert(make_pair(detectorID, iLayer));
-                break;
-              }
-            }
-          }
-        }
-
-        // here we take intrinsic resolution from geometry database
-
-        layerIndex = _conversionIdMap[detectorID];
-        _intrResolX[layerIndex] =
-            1000 *
-            _siPlanesLayerLayout->getSensitiveResolution(layerIndex); // um
-        _intrResolY[layerIndex] =
-            1000 *
-            _siPlanesLayerLayout->getSensitiveResolution(layerIndex); // um
+      const int detectorID = hitDecoder(hit)["sensorID"];
+
+      if (detectorID < 0 ||
+          detectorID >= static_cast<int>(_layerIndexTable.size()) ||
+          _layerIndexTable[detectorID] < 0) {
+        streamlog_out(DEBUG5) << "Hit on sensor " << detectorID
+                              << " without telescope layer skipped" << endl;
+        continue;
       }
+      const int layerIndex = _layerIndexTable[detectorID];
 
       // Getting positions of the hits.
       // Here the alignment constants are used to correct the positions.
 
-      layerIndex = _conversionIdMap[detectorID];
-
-      // The other layers were aligned with respect to the first one.
-
-      double off_x, off_y, theta_x, theta_y, theta_z;
-
-      if (layerIndex == 0) {
-
-        _xPos[iHit] = 1000 * hit->getPosition()[0]; // in um
-        _yPos[iHit] = 1000 * hit->getPosition()[1]; // in um
-        _zPos[iHit] = 1000 * hit->getPosition()[2]; // in um
-
-      } else {
-
-        if (layerIndex == 1) {
-
-          off_x = _alignmentConstantsSecondLayer[0];
-          off_y = _alignmentConstantsSecondLayer[1];
-          theta_x = _alignmentConstantsSecondLayer[2];
-          theta_y = _alignmentConstantsSecondLayer[3];
-          theta_z = _alignmentConstantsSecondLayer[4];
-
-        } else if (layerIndex == 2) {
-
-          off_x = _alignmentConstantsThirdLayer[0];
-          off_y = _alignmentConstantsThirdLayer[1];
-          theta_x = _alignmentConstantsThirdLayer[2];
-          theta_y = _alignmentConstantsThirdLayer[3];
-          theta_z = _alignmentConstantsThirdLayer[4];
-
-        } else if (layerIndex == 3) {
-
-          off_x = _alignmentConstantsFourthLayer[0];
-          off_y = _alignmentConstantsFourthLayer[1];
-          theta_x = _alignmentConstantsFourthLayer[2];
-          theta_y = _alignmentConstantsFourthLayer[3];
-          theta_z = _alignmentConstantsFourthLayer[4];
-
-        } else if (layerIndex == 4) {
-
-          off_x = _alignmentConstantsFifthLayer[0];
-          off_y = _alignmentConstantsFifthLayer[1];
-          theta_x = _alignmentConstantsFifthLayer[2];
-          theta_y = _alignmentConstantsFifthLayer[3];
-          theta_z = _alignmentConstantsFifthLayer[4];
-
-        } else if (layerIndex == 5) {
-
-          off_x = _alignmentConstantsSixthLayer[0];
-          off_y = _alignmentConstantsSixthLayer[1];
-          theta_x = _alignmentConstantsSixthLayer[2];
-          theta_y = _alignmentConstantsSixthLayer[3];
-          theta_z = _alignmentConstantsSixthLayer[4];
-
-        } else {
-
-          off_x = 0.0;
-          off_y = 0.0;
-          theta_x = 0.0;
-          theta_y = 0.0;
-          theta_z = 0.0;
-        }
-
-        // For documentation of these formulas look at EUTelAlign
-
-        _xPos[iHit] =
-            (cos(theta_y) * cos(theta_z)) * hit->getPosition()[0] * 1000 +
-            ((-1) * sin(theta_x) * sin(theta_y) * cos(theta_z) +
-             cos(theta_x) * sin(theta_z)) *
-                hit->getPosition()[1] * 1000 +
-            off_x;
-        _yPos[iHit] = ((-1) * cos(theta_y) * sin(theta_z)) *
-                          hit->getPosition()[0] * 1000 +
-                      (sin(theta_x) * sin(theta_y) * sin(theta_z) +
-                       cos(theta_x) * cos(theta_z)) *
-                          hit->getPosition()[1] * 1000 +
-                      off_y;
-        _zPos[iHit] = 1000 * hit->getPosition()[2];
+      const LayerAlignment &alignment = _layerAlignment[layerIndex];
+      const double *position = hit->getPosition();
+      _layerHitsX[layerIndex].push_back(alignment.xx * position[0] * 1000 +
+                                        alignment.xy * position[1] * 1000 +
+                                        alignment.offX);
+      _layerHitsY[layerIndex].push_back(alignment.yx * position[0] * 1000 +
+                                        alignment.yy * position[1] * 1000 +
+                                        alignment.offY);
+      // all hits of a plane share its z, the first one is taken
+      if (_layerHitsX[layerIndex].size() == 1) {
+        _zPos[layerIndex] = 1000 * position[2]; // in um
       }
     }
 
-    // ++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    // ++++++++++++ See Blobel Page 226 !!! +++++++++++++++++
-    // ++++++++++++++++++++++++++++++++++++++++++++++++++++++
-
-    int counter;
-
-    float S1[2] = {0, 0};
-    float Sx[2] = {0, 0};
-    float Xbar[2] = {0, 0};
-
-    float *Zbar_X = new float[_nPlanes];
-    float *Zbar_Y = new float[_nPlanes];
-    for (counter = 0; counter < _nPlanes; counter++) {
-      Zbar_X[counter] = 0.;
-      Zbar_Y[counter] = 0.;
-    }
-
-    float Sy[2] = {0, 0};
-    float Ybar[2] = {0, 0};
-    float Sxybar[2] = {0, 0};
-    float Sxxbar[2] = {0, 0};
-    float A2[2] = {0, 0};
-    float Chiquare[2] = {0, 0};
-    float angle[2] = {0, 0};
-
-    // define S1
-    for (counter = 0; counter < _nPlanes; counter++) {
-      S1[0] = S1[0] + 1 / pow(_intrResolX[counter], 2);
-      S1[1] = S1[1] + 1 / pow(_intrResolY[counter], 2);
-    }
-
-    // define Sx
-    for (counter = 0; counter < _nPlanes; counter++) {
-      Sx[0] = Sx[0] + _zPos[counter] / pow(_intrResolX[counter], 2);
-      Sx[1] = Sx[1] + _zPos[counter] / pow(_intrResolY[counter], 2);
+    // the fit needs a hit on each plane, every combination of one hit
+    // per plane is fitted and the one with the lowest chi2 is kept
+    size_t nCombinations = 1;
+    for (int iLayer = 0; iLayer < _nPlanes && nCombinations > 0; iLayer++) {
+      nCombinations *= _layerHitsX[iLayer].size();
+      if (nCombinations > static_cast<size_t>(_maxHitCombinations)) {
+        break;
+      }
     }
 
-    // define Xbar
-    Xbar[0] = Sx[0] / S1[0];
-    Xbar[1] = Sx[1] / S1[1];
-
-    // coordinate transformation !! -> bar
-    for (counter = 0; counter < _nPlanes; counter++) {
-      Zbar_X[counter] = _zPos[counter] - Xbar[0];
-      Zbar_Y[counter] = _zPos[counter] - Xbar[1];
+    if (nCombinations == 0 ||
+        nCombinations > static_cast<size_t>(_maxHitCombinations)) {
+      streamlog_out(DEBUG5) << "Event " << event->getEventNumber()
+                            << (nCombinations == 0
+                                    ? " has a plane without hit"
+                                    : " has too many hit combinations")
+                            << ": no fit" << endl;
+      ++_iEvt;
+      if (isFirstEvent())
+        _isFirstEvent = false;
+      return;
     }
 
-    // define Sy
-    for (counter = 0; counter < _nPlanes; counter++) {
-      Sy[0] = Sy[0] + _xPos[counter] / pow(_intrResolX[counter], 2);
-      Sy[1] = Sy[1] + _yPos[counter] / pow(_intrResolY[counter], 2);
+    // the combinations are stored plane by plane for the fit, the
+    // combination number has one digit per plane
+    _xPos.resize(_nPlanes * nCombinations);
+    _yPos.resize(_nPlanes * nCombinations);
+    size_t planeMod = 1;
+    for (int iLayer = _nPlanes - 1; iLayer >= 0; iLayer--) {
+      const size_t nHits = _layerHitsX[iLayer].size();
+      for (size_t iComb = 0; iComb < nCombinations; iComb++) {
+        const size_t iHit = (iComb / planeMod) % nHits;
+        _xPos[iLayer * nCombinations + iComb] = _layerHitsX[iLayer][iHit];
+        _yPos[iLayer * nCombinations + iComb] = _layerHitsY[iLayer][iHit];
+      }
+      planeMod *= nHits;
     }
 
-    // define Ybar
-    Ybar[0] = Sy[0] / S1[0];
-    Ybar[1] = Sy[1] / S1[1];
+    // ++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    // ++++++++++++ See Blobel Page 226 !!! +++++++++++++++++
+    // ++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-    // define Sxybar
-    for (counter = 0; counter < _nPlanes; counter++) {
-      Sxybar[0] =
-          Sxybar[0] +
-          Zbar_X[counter] * _xPos[counter] / pow(_intrResolX[counter], 2);
-      Sxybar[1] =
-          Sxybar[1] +
-          Zbar_Y[counter] * _yPos[counter] / pow(_intrResolY[counter], 2);
+    // the fit coefficients only change with the plane positions
+    if (_zPos != _lineFit.getZPositions()) {
+      _lineFit.setPlanes(_zPos, _intrResolX, _intrResolY);
     }
 
-    // define Sxxbar
-    for (counter = 0; counter < _nPlanes; counter++) {
-      Sxxbar[0] =
-          Sxxbar[0] +
-          Zbar_X[counter] * Zbar_X[counter] / pow(_intrResolX[counter], 2);
-      Sxxbar[1] =
-          Sxxbar[1] +
-          Zbar_Y[counter] * Zbar_Y[counter] / pow(_intrResolX[counter], 2);
+    _xFitPos.resize(_nPlanes * nCombinations);
+    _yFitPos.resize(_nPlanes * nCombinations);
+    _slopeX.resize(nCombinations);
+    _slopeY.resize(nCombinations);
+    _chi2X.resize(nCombinations);
+    _chi2Y.resize(nCombinations);
+    _lineFit.fitX(nCombinations, _xPos.data(), _xFitPos.data(),
+                  _slopeX.data(), _chi2X.data());
+    _lineFit.fitY(nCombinations, _yPos.data(), _yFitPos.data(),
+                  _slopeY.data(), _chi2Y.data());
+
+    size_t best = 0;
+    for (size_t iComb = 1; iComb < nCombinations; iComb++) {
+      if (_chi2X[iComb] + _chi2Y[iComb] < _chi2X[best] + _chi2Y[best]) {
+        best = iComb;
+      }
     }
 
-    // define A2
-
-    A2[0] = Sxybar[0] / Sxxbar[0];
-    A2[1] = Sxybar[1] / Sxxbar[1];
-
-    // Calculate chi sqaured
-    // Chi^2 for X and Y coordinate for hits in all planes
-
-    for (counter = 0; counter < _nPlanes; counter++) {
-      Chiquare[0] += pow(-_zPos[counter] * A2[0] + _xPos[counter] - Ybar[0] +
-                             Xbar[0] * A2[0],
-                         2) /
-                     pow(_intrResolX[counter], 2);
-      Chiquare[1] += pow(-_zPos[counter] * A2[1] + _yPos[counter] - Ybar[1] +
-                             Xbar[1] * A2[1],
-                         2) /
-                     pow(_intrResolY[counter], 2);
-    }
+    double slope[2] = {_slopeX[best], _slopeY[best]};
+    double chi2[2] = {_chi2X[best], _chi2Y[best]};
 
+    int counter;
     for (counter = 0; counter < _nPlanes; counter++) {
-      _waferResidX[counter] =
-          (Ybar[0] - Xbar[0] * A2[0] + _zPos[counter] * A2[0]) - _xPos[counter];
-      _waferResidY[counter] =
-          (Ybar[1] - Xbar[1] * A2[1] + _zPos[counter] * A2[1]) - _yPos[counter];
+      const size_t index = counter * nCombinations + best;
+      _waferResidX[counter] = _xFitPos[index] - _xPos[index];
+      _waferResidY[counter] = _yFitPos[index] - _yPos[index];
     }
 
     // define angle
 
-    angle[0] = atan(A2[0]);
-    angle[1] = atan(A2[1]);
+    double angle[2] = {atan(slope[0]), atan(slope[1])};
 
     // Define output track and hit collections
     LCCollectionVec *fittrackvec = new LCCollectionVec(LCIO::TRACK);
@@ -530,25 +479,22 @@ void EUTelLineFit::processEvent(LCEvent *event) {
 
     // Used class members
 
-    fittrack->setChi2(Chiquare[0]); // x Chi2 of the fit
+    fittrack->setChi2(chi2[0]); // x Chi2 of the fit
     //  fittrack->setNdf(nBestFired); // Number of planes fired (!)
 
     //    fittrack->setIsReferencePointPCA(false);
 
-    // Calculate positions of fitted track in every plane
+    // Store positions of fitted track in every plane
 
     for (counter = 0; counter < _nPlanes; counter++) {
 
-      _xFitPos[counter] = Ybar[0] - Xbar[0] * A2[0] + _zPos[counter] * A2[0];
-      _yFitPos[counter] = Ybar[1] - Xbar[1] * A2[1] + _zPos[counter] * A2[1];
-
       TrackerHitImpl *fitpoint = new TrackerHitImpl;
 
       // Plane number stored as hit type
       fitpoint->setType(counter + 1);
       double pos[3];
-      pos[0] = _xFitPos[counter];
-      pos[1] = _yFitPos[counter];
+      pos[0] = _xFitPos[counter * nCombinations + best];
+      pos[1] = _yFitPos[counter * nCombinations + best];
       pos[2] = _zPos[counter];
 
       fitpoint->setPosition(pos);
@@ -577,7 +523,7 @@ void EUTelLineFit::processEvent(LCEvent *event) {
       }
       if (AIDA::IHistogram1D *chi2x_histo = dynamic_cast<AIDA::IHistogram1D *>(
               _aidaHistoMap[_chi2XLocalname]))
-        chi2x_histo->fill(Chiquare[0]);
+        chi2x_histo->fill(chi2[0]);
       else {
         message<ERROR5>(log() << "Not able to retrieve histogram pointer for "
                               << _chi2XLocalname
@@ -593,7 +539,7 @@ void EUTelLineFit::processEvent(LCEvent *event) {
       }
       if (AIDA::IHistogram1D *chi2y_histo = dynamic_cast<AIDA::IHistogram1D *>(
               _aidaHistoMap[_chi2YLocalname]))
-        chi2y_histo->fill(Chiquare[1]);
+        chi2y_histo->fill(chi2[1]);
       else {
         message<ERROR5>(log() << "Not able to retrieve histogram pointer for "
                               << _chi2YLocalname
@@ -675,9 +621,6 @@ void EUTelLineFit::processEvent(LCEvent *event) {
 
 #endif
 
-    delete[] Zbar_X;
-    delete[] Zbar_Y;
-
   } catch (DataNotAvailableException &e) {
 
     streamlog_out(WARNING2) << "No input collection found on event "
@@ -693,16 +636,6 @@ void EUTelLineFit::processEvent(LCEvent *event) {
 
 void EUTelLineFit::end() {
 
-  delete[] _intrResolY;
-  delete[] _intrResolX;
-  delete[] _yFitPos;
-  delete[] _xFitPos;
-  delete[] _waferResidY;
-  delete[] _waferResidX;
-  delete[] _zPos;
-  delete[] _yPos;
-  delete[] _xPos;
-
   message<MESSAGE5>(log() << "Successfully finished");
 }
 
@@ -688,6 +688,15 @@ void EUTelMille::init() {
     _trackResidZ.push_back(DoubleVec(_nPlanes, 0.0));
   }
 
+  _trackFinder.setResidualWindows(
+      std::vector<double>(_residualsXMin.begin(), _residualsXMin.end()),
+      std::vector<double>(_residualsXMax.begin(), _residualsXMax.end()),
+      std::vector<double>(_residualsYMin.begin(), _residualsYMin.end()),
+      std::vector<double>(_residualsYMax.begin(), _residualsYMax.end()));
+  _trackFinder.setAllowedMissingHits(getAllowedMissingHits());
+  _trackFinder.setMaxCandidates(
+      static_cast<size_t>(std::max(_maxTrackCandidates, 0)));
+
   if (!_distanceMaxVec.empty()) {
     if (_distanceMaxVec.size() != static_cast<unsigned int>(_nPlanes)) {
       streamlog_out(WARNING2)
@@ -735,140 +744,6 @@ void EUTelMille::processRunHeader(LCRunHeader *rdr) {
   ++_iRun;
 }
 
-void EUTelMille::findtracks2(
-    int missinghits, std::vector<IntVec> &indexarray, IntVec vec,
-    std::vector<std::vector<EUTelMille::HitsInPlane>> &_allHitsArray,
-    unsigned int i, int y) {
-  if (y == -1)
-    missinghits++;
-  streamlog_out(DEBUG9) << "Missing hits:" << missinghits << std::endl;
-
-  if (missinghits > getAllowedMissingHits()) {
-    // recursive chain is dropped here;
-    streamlog_out(DEBUG9) << "indexarray size:" << indexarray.size()
-                          << std::endl;
-    return;
-  }
-
-  if (i > 0) {
-    vec.push_back(y); // recall hit id from the plane (i-1)
-  }
-
-  if ((_allHitsArray[i].size() == 0) && (i < _allHitsArray.size() - 1)) {
-    findtracks2(missinghits, indexarray, vec, _allHitsArray, i + 1, -1);
-  }
-
-  for (size_t j = 0; j < _allHitsArray[i].size(); j++) {
-    int ihit = static_cast<int>(j);
-    streamlog_out(DEBUG5) << "ihit:" << ihit << std::endl;
-
-    // if we are not in the last plane, call this method again
-    if (i < _allHitsArray.size() - 1) {
-      vec.push_back(ihit); // index of the cluster in the last plane
-
-      // track candidate requirements
-      bool taketrack = true;
-      const int e = vec.size() - 2;
-      if (e >= 0) {
-        double residualX = -999999.;
-        double residualY = -999999.;
-        double residualZ = -999999.;
-
-        // ACTIVE
-        // stop on the last non-zero hit
-
-        // now loop through all hits on a track candidate "vec"
-        // start at the end, stop on the first non-zero hit
-        for (int ivec = e; ivec >= e; --ivec) //     <-> OFF
-        {
-          if (vec[ivec] >= 0) // non zero hit has id vec[ivec]>=0 {otherwise -1}
-          {
-            double x = _allHitsArray[ivec][vec[ivec]].measuredX;
-            double y = _allHitsArray[ivec][vec[ivec]].measuredY;
-            double z = _allHitsArray[ivec][vec[ivec]].measuredZ;
-            residualX = abs(x - _allHitsArray[e + 1][vec[e + 1]].measuredX);
-            residualY = abs(y - _allHitsArray[e + 1][vec[e + 1]].measuredY);
-            residualZ = abs(z - _allHitsArray[e + 1][vec[e + 1]].measuredZ);
-            streamlog_out(DEBUG9) << "residuals:" << std::endl;
-            streamlog_out(DEBUG9) << residualX << std::endl;
-            streamlog_out(DEBUG9) << residualY << std::endl;
-            streamlog_out(DEBUG9) << residualZ << std::endl;
-
-            break;
-          }
-        }
-
-        if (residualX < _residualsXMin[e] || residualX > _residualsXMax[e] ||
-            residualY < _residualsYMin[e] || residualY > _residualsYMax[e])
-          taketrack = false;
-
-        if (taketrack == false) {
-          taketrack = true;
-          ihit = -1;
-        }
-      }
-      vec.pop_back();
-
-      if (taketrack) {
-        findtracks2(missinghits, indexarray, vec, _allHitsArray, i + 1, ihit);
-      }
-    } else {
-      // we are in the last plane
-      vec.push_back(ihit); // index of the cluster in the last plane
-
-      // track candidate requirements
-      bool taketrack = true;
-      const int e = vec.size() - 2;
-      if (e >= 0) {
-        double residualX = -999999.;
-        double residualY = -999999.;
-        // double residualZ  = -999999.;
-
-        // now loop through all hits on a track candidate "vec"
-        // start at the end, stop on the first non-zero hit
-        for (int ivec = e; ivec >= e; --ivec) //   <-> OFF
-        {
-          if (vec[ivec] >= 0) // non zero hit has id vec[ivec]>=0 {otherwise -1}
-          {
-            double x = _allHitsArray[ivec][vec[ivec]].measuredX;
-            double y = _allHitsArray[ivec][vec[ivec]].measuredY;
-            // double z = _allHitsArray[ivec][vec[ivec]].measuredZ;
-            residualX = abs(x - _allHitsArray[e + 1][vec[e + 1]].measuredX);
-            residualY = abs(y - _allHitsArray[e + 1][vec[e + 1]].measuredY);
-            // residualZ  = abs(z - _allHitsArray[e+1][vec[e+1]].measuredZ);
-            break;
-          }
-        }
-
-        if (residualX < _residualsXMin[e] || residualX > _residualsXMax[e] ||
-            residualY < _residualsYMin[e] || residualY > _residualsYMax[e])
-          taketrack = false;
-
-        if (taketrack == false) {
-          taketrack = true;
-          ihit = -1;
-        }
-      }
-
-      if (static_cast<int>(indexarray.size()) >= _maxTrackCandidates)
-        taketrack = false;
-
-      if (taketrack) {
-        indexarray.push_back(vec);
-        streamlog_out(DEBUG9)
-            << "indexarray size at last plane:" << indexarray.size()
-            << std::endl;
-      }
-      vec.pop_back(); // last element must be removed because the
-      // vector is still used -> we are in a last plane hit loop!
-    }
-  }
-
-  if ((_allHitsArray[i].size() == 0) && (i >= _allHitsArray.size() - 1)) {
-    indexarray.push_back(vec);
-  }
-}
-
 void EUTelMille::findtracks(
     std::vector<IntVec> &indexarray, IntVec vec,
     std::vector<std::vector<EUTelMille::HitsInPlane>> &_hitsArray, int i,
@@ -1400,9 +1275,17 @@ void EUTelMille::processEvent(LCEvent *event) {
     // This is done separately for different numbers of planes.
 
     std::vector<IntVec> indexarray;
+    std::vector<std::vector<double>> xHits(_nPlanes);
+    std::vector<std::vector<double>> yHits(_nPlanes);
+    for (size_t i = 0; i < _nPlanes; i++) {
+      for (size_t j = 0; j < _allHitsArray[i].size(); j++) {
+        xHits[i].push_back(_allHitsArray[i][j].measuredX);
+        yHits[i].push_back(_allHitsArray[i][j].measuredY);
+      }
+    }
 
     streamlog_out(DEBUG5) << "Event #" << _iEvt << std::endl;
-    findtracks2(0, indexarray, IntVec(), _allHitsArray, 0, 0);
+    _trackFinder.findTracks(xHits, yHits, indexarray);
     for (size_t i = 0; i < indexarray.size(); i++) {
       for (size_t j = 0; j < _nPlanes; j++) {
 
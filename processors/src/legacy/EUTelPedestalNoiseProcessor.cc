@@ -173,6 +173,17 @@ EUTelPedestalNoiseProcessor::EUTelPedestalNoiseProcessor()
       "Perform a fast first loop to improve the efficiency of hit rejection",
       _preLoopSwitch, true);
 
+  registerOptionalParameter(
+      "CacheRawFrames",
+      "Keep the raw frames of the first pass in memory and run all the other "
+      "loops on them instead of re-reading the input file",
+      _frameCacheSwitch, false);
+  registerOptionalParameter(
+      "FrameCacheMaxSize",
+      "Maximum size of the raw frame cache in MB. If the pedestal events do "
+      "not fit, the input file is re-read as without the cache",
+      _frameCacheMaxSize, 2048);
+
   registerProcessorParameter("FirstEvent",
                              "First event for pedestal calculation",
                              _firstEvent, 0);
@@ -260,6 +271,14 @@ void EUTelPedestalNoiseProcessor::init() {
   // reset the skip event list
   _skippedEventList.clear();
   _nextEventToSkip = _skippedEventList.begin();
+
+  // reset the raw frame cache
+  _useFrameCache = _frameCacheSwitch;
+  _replayingFrames = false;
+  _frameCache.clear();
+  _frameOffsetVec.clear();
+  _frameSize = 0;
+  _noOfCachedFrames = 0;
 }
 
 void EUTelPedestalNoiseProcessor::processRunHeader(LCRunHeader *rdr) {
@@ -309,6 +328,11 @@ void EUTelPedestalNoiseProcessor::processRunHeader(LCRunHeader *rdr) {
   if (_additionalMaskingLoop)
     additionalLoop = 1;
 
+  // with the frame cache the input file is read only once
+  int noOfPasses = _noOfCMIterations + 1 + additionalLoop;
+  if (_useFrameCache)
+    noOfPasses = 1;
+
   if (_lastEvent == -1) {
     // the user didn't select an upper limit for the event range, so
     // we don't know on how many events the calculation should be done
@@ -323,7 +347,7 @@ void EUTelPedestalNoiseProcessor::processRunHeader(LCRunHeader *rdr) {
           << maxRecordNumber << ".\n"
           << "This means that in order to properly perform the pedestal "
              "calculation the maximum allowed number of events is "
-          << maxRecordNumber / (_noOfCMIterations + 1 + additionalLoop) << ".\n"
+          << maxRecordNumber / noOfPasses << ".\n"
           << "Let's hope it is correct and try to continue." << endl;
     }
   } else {
@@ -331,15 +355,11 @@ void EUTelPedestalNoiseProcessor::processRunHeader(LCRunHeader *rdr) {
     // we can compare this number with the maxRecordNumber if
     // different from 0
     if (maxRecordNumber != 0) {
-      if ((_lastEvent - _firstEvent) *
-              (_noOfCMIterations + 1 + additionalLoop) >
-          maxRecordNumber) {
+      if ((_lastEvent - _firstEvent) * noOfPasses > maxRecordNumber) {
         streamlog_out(ERROR4)
             << "The pedestal calculation should be done on "
-            << _lastEvent - _firstEvent << " times " << _noOfCMIterations + 1
-            << " iterations = "
-            << (_lastEvent - _firstEvent) *
-                   (_noOfCMIterations + 1 + additionalLoop)
+            << _lastEvent - _firstEvent << " times " << noOfPasses
+            << " iterations = " << (_lastEvent - _firstEvent) * noOfPasses
             << " records.\n"
             << "The global variable MarRecordNumber is limited to "
             << maxRecordNumber << endl;
@@ -348,7 +368,9 @@ void EUTelPedestalNoiseProcessor::processRunHeader(LCRunHeader *rdr) {
     }
   }
 
-  if (_iLoop == 0) {
+  // the header is written in the first loop, or in the pre-loop when
+  // the following loops run on the frame cache
+  if ((_iLoop == 0) || (_useFrameCache && (_iLoop == -1))) {
     // write the current header to the output condition file
     LCWriter *lcWriter = LCFactory::getInstance()->createLCWriter();
 
@@ -865,6 +887,9 @@ void EUTelPedestalNoiseProcessor::preLoop(LCEvent *event) {
     _isFirstEvent = false;
   }
 
+  if (_useFrameCache)
+    cacheFrame(evt);
+
   // here is the real begin
   for (size_t iCol = 0; iCol < _rawDataCollectionNameVec.size(); ++iCol) {
 
@@ -880,7 +905,7 @@ void EUTelPedestalNoiseProcessor::preLoop(LCEvent *event) {
 
         TrackerRawData *trackerRawData = dynamic_cast<TrackerRawData *>(
             collectionVec->getElementAt(iDetector));
-        ShortVec adcValues = trackerRawData->getADCValues();
+        const ShortVec &adcValues = trackerRawData->getADCValues();
 
         for (size_t iPixel = 0; iPixel < adcValues.size(); ++iPixel) {
           short currentVal = adcValues[iPixel];
@@ -939,221 +964,188 @@ void EUTelPedestalNoiseProcessor::firstLoop(LCEvent *event) {
     throw SkipEventException(this);
   }
 
-  if (isFirstEvent()) {
+  if (_useFrameCache)
+    cacheFrame(evt);
 
-    for (size_t iCol = 0; iCol < _rawDataCollectionNameVec.size(); ++iCol) {
+  for (size_t iCol = 0; iCol < _rawDataCollectionNameVec.size(); ++iCol) {
 
-      try {
+    try {
+      LCCollectionVec *collectionVec = dynamic_cast<LCCollectionVec *>(
+          evt->getCollection(_rawDataCollectionNameVec.at(iCol)));
 
-        LCCollectionVec *collectionVec = dynamic_cast<LCCollectionVec *>(
-            evt->getCollection(_rawDataCollectionNameVec.at(iCol)));
+      size_t detectorOffset = (iCol == 0) ? 0 : _noOfDetectorVec.at(iCol - 1);
 
-        for (size_t iDetector = 0; iDetector < collectionVec->size();
-             ++iDetector) {
+      for (size_t iDetector = 0; iDetector < collectionVec->size();
+           ++iDetector) {
 
-          // _tempPedestal, _tempNoise, _tempEntries are vector of vector.
-          // they have been already cleared in the init() method we are
-          // already looping on detectors, so we just need to push back a
-          // vector empty for each cycle
-          //
-          // _tempPedestal should be initialized with the adcValues, while
-          // _tempNoise and _tempEntries must be initialized to zero. Since
-          // adcValues is a vector of shorts, we need to copy each
-          // elements into _tempPedestal with a suitable re-casting
+        // get the TrackerRawData object from the collection for this detector
+        TrackerRawData *trackerRawData = dynamic_cast<TrackerRawData *>(
+            collectionVec->getElementAt(iDetector));
+        const ShortVec &adcValues = trackerRawData->getADCValues();
 
-          // get the TrackerRawData object from the collection for this detector
+        if (isFirstEvent()) {
+          initializeDetector(iDetector + detectorOffset, adcValues.data(),
+                             adcValues.size());
+        } else {
+          firstLoopDetector(iDetector + detectorOffset, adcValues.data());
+        }
+      }
 
-          TrackerRawData *trackerRawData = dynamic_cast<TrackerRawData *>(
-              collectionVec->getElementAt(iDetector));
-          ShortVec adcValues = trackerRawData->getADCValues();
+    } catch (DataNotAvailableException &e) {
+      streamlog_out(WARNING2)
+          << "No input collection " << _rawDataCollectionNameVec.at(iCol)
+          << " is not available in the current event" << endl;
+    }
+  }
 
-          if (_pedestalAlgo == EUTELESCOPE::MEANRMS) {
-            // in the case of MEANRMS we have to deal with the standard
-            // vectors
-            ShortVec::iterator iter = adcValues.begin();
-            FloatVec tempDoubleVec;
-            while (iter != adcValues.end()) {
-              tempDoubleVec.push_back(static_cast<double>(*iter));
-              ++iter;
-            }
-            _tempPede.push_back(tempDoubleVec);
+  if (isFirstEvent()) {
+    bookHistos();
+    _isFirstEvent = false;
+  }
 
-            // initialize _tempNoise and _tempEntries with all zeros and
-            // ones
-            _tempNoise.push_back(FloatVec(adcValues.size(), 0.));
-            _tempEntries.push_back(IntVec(adcValues.size(), 1));
+  // increment the event number
+  ++_iEvt;
+}
 
-          } else if (_pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
+void EUTelPedestalNoiseProcessor::initializeDetector(size_t iDetector,
+                                                     const short *adcValues,
+                                                     size_t noOfPixels) {
 
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-            // in the case of AIDAPROFILE we don't need any vectors since
-            // everything is done by the IProfile2D automatically
-            int iPixel = 0;
-            size_t detectorOffset =
-                (iCol == 0) ? 0 : _noOfDetectorVec.at(iCol - 1);
-            stringstream ss;
-            ss << _tempProfile2DName << "_d"
-               << _orderedSensorIDVec.at(iDetector + detectorOffset);
-            for (int yPixel = _minY[iDetector + detectorOffset];
-                 yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
-              for (int xPixel = _minX[iDetector + detectorOffset];
-                   xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-                double temp = static_cast<double>(adcValues[iPixel]);
-                if (AIDA::IProfile2D *profile =
-                        dynamic_cast<AIDA::IProfile2D *>(
-                            _aidaHistoMap[ss.str()])) {
-                  profile->fill(static_cast<double>(xPixel),
-                                static_cast<double>(yPixel), temp);
-                } else {
-                  streamlog_out(ERROR4)
-                      << "Irreversible error: " << ss.str()
-                      << " is not available. Sorry for quitting." << endl;
-                  exit(-1);
-                }
-                ++iPixel;
-              }
-            }
-#endif
-          }
+  // _tempPedestal, _tempNoise, _tempEntries are vector of vector.
+  // they have been already cleared in the init() method and the
+  // detectors come in order, so we just need to push back a vector
+  // for each of them
+  //
+  // _tempPedestal should be initialized with the adcValues, while
+  // _tempNoise and _tempEntries must be initialized to zero. Since
+  // adcValues is an array of shorts, we need to copy each
+  // elements into _tempPedestal with a suitable re-casting
 
-          // the status vector can be initialize as well with all
-          // GOODPIXEL
-          _status.push_back(ShortVec(adcValues.size(), EUTELESCOPE::GOODPIXEL));
+  if (_pedestalAlgo == EUTELESCOPE::MEANRMS) {
+    // in the case of MEANRMS we have to deal with the standard
+    // vectors
+    FloatVec tempDoubleVec;
+    tempDoubleVec.reserve(noOfPixels);
+    for (size_t iPixel = 0; iPixel < noOfPixels; ++iPixel) {
+      tempDoubleVec.push_back(static_cast<double>(adcValues[iPixel]));
+    }
+    _tempPede.push_back(tempDoubleVec);
 
-          // if the user wants to add an additional loop on events to
-          // mask pixels singing too loud, so the corresponding counter
-          // vector should be reset
-          if (_additionalMaskingLoop)
-            _hitCounter.push_back(ShortVec(adcValues.size(), 0));
+    // initialize _tempNoise and _tempEntries with all zeros and
+    // ones
+    _tempNoise.push_back(FloatVec(noOfPixels, 0.));
+    _tempEntries.push_back(IntVec(noOfPixels, 1));
 
-        } // end of detector loop
+  } else if (_pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
 
-      } catch (DataNotAvailableException &e) {
-        streamlog_out(WARNING2)
-            << "No input collection " << _rawDataCollectionNameVec.at(iCol)
-            << " is not available in the current event" << endl;
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+    // in the case of AIDAPROFILE we don't need any vectors since
+    // everything is done by the IProfile2D automatically
+    int iPixel = 0;
+    stringstream ss;
+    ss << _tempProfile2DName << "_d" << _orderedSensorIDVec.at(iDetector);
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
+      for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector];
+           xPixel++) {
+        double temp = static_cast<double>(adcValues[iPixel]);
+        if (AIDA::IProfile2D *profile =
+                dynamic_cast<AIDA::IProfile2D *>(_aidaHistoMap[ss.str()])) {
+          profile->fill(static_cast<double>(xPixel),
+                        static_cast<double>(yPixel), temp);
+        } else {
+          streamlog_out(ERROR4)
+              << "Irreversible error: " << ss.str()
+              << " is not available. Sorry for quitting." << endl;
+          exit(-1);
+        }
+        ++iPixel;
       }
     }
+#endif
+  }
 
-    bookHistos();
+  // the status vector can be initialize as well with all
+  // GOODPIXEL
+  _status.push_back(ShortVec(noOfPixels, EUTELESCOPE::GOODPIXEL));
 
-    _isFirstEvent = false;
+  // if the user wants to add an additional loop on events to
+  // mask pixels singing too loud, so the corresponding counter
+  // vector should be reset
+  if (_additionalMaskingLoop)
+    _hitCounter.push_back(ShortVec(noOfPixels, 0));
+}
 
-  } else {
+void EUTelPedestalNoiseProcessor::firstLoopDetector(size_t iDetector,
+                                                    const short *adcValues) {
 
-    // this is when it is not the first event
-    for (size_t iCol = 0; iCol < _rawDataCollectionNameVec.size(); ++iCol) {
+  // after the firstEvent all temp vectors and the status one have
+  // the correct number of entries for both indexes
+  if (_pedestalAlgo == EUTELESCOPE::MEANRMS) {
 
-      try {
-        LCCollectionVec *collectionVec = dynamic_cast<LCCollectionVec *>(
-            evt->getCollection(_rawDataCollectionNameVec.at(iCol)));
+    // start looping on all pixels
+    int iPixel = 0;
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
+      for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector];
+           xPixel++) {
+        short currentVal = adcValues[iPixel];
+        bool use = true;
+        if (_preLoopSwitch && ((_iEvt == _maxValuePos[iDetector][iPixel]) ||
+                               (_iEvt == _minValuePos[iDetector][iPixel]))) {
+          use = false;
+        }
 
-        // after the firstEvent all temp vectors and the status one have
-        // the correct number of entries for both indexes
-        // loop on the detectors
-        for (size_t iDetector = 0; iDetector < collectionVec->size();
-             iDetector++) {
+        if (use) {
+
+          _tempEntries[iDetector][iPixel] = _tempEntries[iDetector][iPixel] + 1;
+          _tempPede[iDetector][iPixel] =
+              ((_tempEntries[iDetector][iPixel] - 1) *
+                   _tempPede[iDetector][iPixel] +
+               currentVal) /
+              _tempEntries[iDetector][iPixel];
+          _tempNoise[iDetector][iPixel] =
+              sqrt(((_tempEntries[iDetector][iPixel] - 1) *
+                        pow(_tempNoise[iDetector][iPixel], 2) +
+                    pow(currentVal - _tempPede[iDetector][iPixel], 2)) /
+                   _tempEntries[iDetector][iPixel]);
+        }
 
-          // get the TrackerRawData object from the collection for this plane
-          TrackerRawData *trackerRawData = dynamic_cast<TrackerRawData *>(
-              collectionVec->getElementAt(iDetector));
-          ShortVec adcValues = trackerRawData->getADCValues();
+        ++iPixel;
+      } // end loop on xPixel
+    }   // end loop on yPixel
 
-          size_t detectorOffset =
-              (iCol == 0) ? 0 : _noOfDetectorVec.at(iCol - 1);
-
-          if (_pedestalAlgo == EUTELESCOPE::MEANRMS) {
-
-            // start looping on all pixels
-            int iPixel = 0;
-            for (int yPixel = _minY[iDetector + detectorOffset];
-                 yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
-              for (int xPixel = _minX[iDetector + detectorOffset];
-                   xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-                short currentVal = adcValues[iPixel];
-                bool use = true;
-                if (_preLoopSwitch &&
-                    ((_iEvt ==
-                      _maxValuePos[iDetector + detectorOffset][iPixel]) ||
-                     (_iEvt ==
-                      _minValuePos[iDetector + detectorOffset][iPixel]))) {
-                  use = false;
-                }
-
-                if (use) {
-
-                  _tempEntries[iDetector + detectorOffset][iPixel] =
-                      _tempEntries[iDetector + detectorOffset][iPixel] + 1;
-                  _tempPede[iDetector + detectorOffset][iPixel] =
-                      ((_tempEntries[iDetector + detectorOffset][iPixel] - 1) *
-                           _tempPede[iDetector + detectorOffset][iPixel] +
-                       currentVal) /
-                      _tempEntries[iDetector + detectorOffset][iPixel];
-                  _tempNoise[iDetector + detectorOffset][iPixel] = sqrt(
-                      ((_tempEntries[iDetector + detectorOffset][iPixel] - 1) *
-                           pow(_tempNoise[iDetector + detectorOffset][iPixel],
-                               2) +
-                       pow(currentVal -
-                               _tempPede[iDetector + detectorOffset][iPixel],
-                           2)) /
-                      _tempEntries[iDetector + detectorOffset][iPixel]);
-                }
-
-                ++iPixel;
-              } // end loop on xPixel
-            }   // end loop on yPixel
-
-          } else if (_pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
+  } else if (_pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-            stringstream ss;
-            ss << _tempProfile2DName << "_d"
-               << _orderedSensorIDVec.at(iDetector + detectorOffset);
-
-            int iPixel = 0;
-            for (int yPixel = _minY[iDetector + detectorOffset];
-                 yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
-              for (int xPixel = _minX[iDetector + detectorOffset];
-                   xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-                bool use = true;
-                if (_preLoopSwitch &&
-                    ((_iEvt ==
-                      _maxValuePos[iDetector + detectorOffset][iPixel]) ||
-                     (_iEvt ==
-                      _minValuePos[iDetector + detectorOffset][iPixel]))) {
-                  use = false;
-                }
-                if (use) {
-                  if (AIDA::IProfile2D *profile =
-                          dynamic_cast<AIDA::IProfile2D *>(
-                              _aidaHistoMap[ss.str()]))
-                    profile->fill(static_cast<double>(xPixel),
-                                  static_cast<double>(yPixel),
-                                  static_cast<double>(adcValues[iPixel]));
-                  else {
-                    streamlog_out(ERROR5)
-                        << "Irreversible error: " << ss.str()
-                        << " is not available. Sorry for quitting." << endl;
-                    exit(-1);
-                  }
-                }
-                ++iPixel;
-              }
-            }
-#endif
-          }
+    stringstream ss;
+    ss << _tempProfile2DName << "_d" << _orderedSensorIDVec.at(iDetector);
 
-        } // end loop on detectors
-
-      } catch (DataNotAvailableException &e) {
-        streamlog_out(WARNING2)
-            << "No input collection " << _rawDataCollectionNameVec.at(iCol)
-            << " is not available in the current event" << endl;
+    int iPixel = 0;
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
+      for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector];
+           xPixel++) {
+        bool use = true;
+        if (_preLoopSwitch && ((_iEvt == _maxValuePos[iDetector][iPixel]) ||
+                               (_iEvt == _minValuePos[iDetector][iPixel]))) {
+          use = false;
+        }
+        if (use) {
+          if (AIDA::IProfile2D *profile =
+                  dynamic_cast<AIDA::IProfile2D *>(_aidaHistoMap[ss.str()]))
+            profile->fill(static_cast<double>(xPixel),
+                          static_cast<double>(yPixel),
+                          static_cast<double>(adcValues[iPixel]));
+          else {
+            streamlog_out(ERROR5)
+                << "Irreversible error: " << ss.str()
+                << " is not available. Sorry for quitting." << endl;
+            exit(-1);
+          }
+        }
+        ++iPixel;
       }
     }
-    // increment the event number
-    ++_iEvt;
-  } // end elif firstEvent
+#endif
+  }
 }
 
 void EUTelPedestalNoiseProcessor::otherLoop(LCEvent *event) {
@@ -1188,266 +1180,242 @@ void EUTelPedestalNoiseProcessor::otherLoop(LCEvent *event) {
       LCCollectionVec *collectionVec = dynamic_cast<LCCollectionVec *>(
           evt->getCollection(_rawDataCollectionNameVec.at(iCol)));
 
+      size_t detectorOffset = (iCol == 0) ? 0 : _noOfDetectorVec.at(iCol - 1);
+
       for (size_t iDetector = 0; iDetector < collectionVec->size();
            iDetector++) {
 
         // get the TrackerRawData object from the collection for this detector
         TrackerRawData *trackerRawData = dynamic_cast<TrackerRawData *>(
             collectionVec->getElementAt(iDetector));
-        ShortVec adcValues = trackerRawData->getADCValues();
+        const ShortVec &adcValues = trackerRawData->getADCValues();
+
+        otherLoopDetector(iDetector + detectorOffset, adcValues.data());
+      }
+    } catch (DataNotAvailableException &e) {
+      streamlog_out(WARNING2)
+          << "No input collection " << _rawDataCollectionNameVec.at(iCol)
+          << " is not available in the current event" << endl;
+    }
+  }
+  ++_iEvt;
+}
 
-        // new approach for a better common mode calculation. The idea
-        // is that instead of using, as before, a single value of
-        // common mode per matrix, we will have a vector of floats
-        // containing the common mode correction for each pixel
-        vector<float> commonModeCorVec;
-        commonModeCorVec.clear();
+void EUTelPedestalNoiseProcessor::otherLoopDetector(size_t iDetector,
+                                                    const short *adcValues) {
 
-        bool isEventValid = true;
-        int skippedPixel = 0;
-        int skippedRow = 0;
+  // new approach for a better common mode calculation. The idea
+  // is that instead of using, as before, a single value of
+  // common mode per matrix, we will have a vector of floats
+  // containing the common mode correction for each pixel
+  vector<float> commonModeCorVec;
+  commonModeCorVec.clear();
 
-        size_t detectorOffset = (iCol == 0) ? 0 : _noOfDetectorVec.at(iCol - 1);
+  bool isEventValid = true;
+  int skippedPixel = 0;
+  int skippedRow = 0;
 
-        if (_commonModeAlgo == EUTELESCOPE::FULLFRAME) {
-
-          double pixelSum = 0.;
-          double commonMode = 0.;
-          int goodPixel = 0;
-          int iPixel = 0;
-
-          // start looping on all pixels for hit rejection
-          for (int yPixel = _minY[iDetector + detectorOffset];
-               yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
-            for (int xPixel = _minX[iDetector + detectorOffset];
-                 xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-              bool isHit = ((adcValues[iPixel] -
-                             _pedestal[iDetector + detectorOffset][iPixel]) >
-                            _hitRejectionCut *
-                                _noise[iDetector + detectorOffset][iPixel]);
-              bool isGood = (_status[iDetector + detectorOffset][iPixel] ==
-                             EUTELESCOPE::GOODPIXEL);
-              if (!isHit && isGood) {
-                pixelSum += adcValues[iPixel] -
-                            _pedestal[iDetector + detectorOffset][iPixel];
-                ++goodPixel;
-              } else if (isHit) {
-                ++skippedPixel;
-              }
-              ++iPixel;
-            }
-          }
+  if (_commonModeAlgo == EUTELESCOPE::FULLFRAME) {
+
+    double pixelSum = 0.;
+    double commonMode = 0.;
+    int goodPixel = 0;
+    int iPixel = 0;
+
+    // start looping on all pixels for hit rejection
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
+      for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector];
+           xPixel++) {
+        bool isHit = ((adcValues[iPixel] - _pedestal[iDetector][iPixel]) >
+                      _hitRejectionCut * _noise[iDetector][iPixel]);
+        bool isGood =
+            (_status[iDetector][iPixel] == EUTELESCOPE::GOODPIXEL);
+        if (!isHit && isGood) {
+          pixelSum += adcValues[iPixel] - _pedestal[iDetector][iPixel];
+          ++goodPixel;
+        } else if (isHit) {
+          ++skippedPixel;
+        }
+        ++iPixel;
+      }
+    }
 
-          if ((skippedPixel < _maxNoOfRejectedPixels) && (goodPixel != 0)) {
+    if ((skippedPixel < _maxNoOfRejectedPixels) && (goodPixel != 0)) {
 
-            commonMode = pixelSum / goodPixel;
-            commonModeCorVec.insert(commonModeCorVec.begin(), iPixel + 1,
-                                    commonMode);
-            isEventValid = true;
+      commonMode = pixelSum / goodPixel;
+      commonModeCorVec.insert(commonModeCorVec.begin(), iPixel + 1,
+                              commonMode);
+      isEventValid = true;
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-            string histoname =
-                _commonModeHistoName + "_d" +
-                to_string(_orderedSensorIDVec.at(iDetector + detectorOffset)) +
-                "_l" + to_string(_iLoop);
-            AIDA::IHistogram1D *histo =
-                (dynamic_cast<AIDA::IHistogram1D *>(_aidaHistoMap[histoname]));
-            if (histo) {
-              histo->fill(commonMode);
-            }
+      string histoname = _commonModeHistoName + "_d" +
+                         to_string(_orderedSensorIDVec.at(iDetector)) + "_l" +
+                         to_string(_iLoop);
+      AIDA::IHistogram1D *histo =
+          (dynamic_cast<AIDA::IHistogram1D *>(_aidaHistoMap[histoname]));
+      if (histo) {
+        histo->fill(commonMode);
+      }
 #endif
 
-          } else {
+    } else {
 
-            isEventValid = false;
-          }
+      isEventValid = false;
+    }
 
-        } else if (_commonModeAlgo == EUTELESCOPE::ROWWISE) {
-
-          int iPixel = 0;
-          int colCounter = 0;
-          int rowLength = _maxX[iDetector + detectorOffset] -
-                          _minX[iDetector + detectorOffset] + 1;
-
-          for (int yPixel = _minY[iDetector + detectorOffset];
-               yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
-
-            double pixelSum = 0.;
-            double commonMode = 0.;
-            int goodPixel = 0;
-            int skippedPixelPerRow = 0;
-
-            for (int xPixel = _minX[iDetector + detectorOffset];
-                 xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-              bool isHit = ((adcValues[iPixel] -
-                             _pedestal[iDetector + detectorOffset][iPixel]) >
-                            _hitRejectionCut *
-                                _noise[iDetector + detectorOffset][iPixel]);
-              bool isGood = (_status[iDetector + detectorOffset][iPixel] ==
-                             EUTELESCOPE::GOODPIXEL);
-              if (!isHit && isGood) {
-                pixelSum += adcValues[iPixel] -
-                            _pedestal[iDetector + detectorOffset][iPixel];
-                ++goodPixel;
-              } else if (isHit) {
-                ++skippedPixelPerRow;
-                ++skippedPixel;
-              }
-              ++iPixel;
-            }
+  } else if (_commonModeAlgo == EUTELESCOPE::ROWWISE) {
+
+    int iPixel = 0;
+    int colCounter = 0;
+    int rowLength = _maxX[iDetector] - _minX[iDetector] + 1;
+
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
 
-            // we are now at the end of the row, so let's calculate the
-            // common mode
-            if ((skippedPixelPerRow < _maxNoOfRejectedPixelPerRow) &&
-                (goodPixel != 0)) {
-              commonMode = pixelSum / goodPixel;
-              commonModeCorVec.insert(commonModeCorVec.begin() +
-                                          colCounter * rowLength,
-                                      rowLength, commonMode);
+      double pixelSum = 0.;
+      double commonMode = 0.;
+      int goodPixel = 0;
+      int skippedPixelPerRow = 0;
+
+      for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector];
+           xPixel++) {
+        bool isHit = ((adcValues[iPixel] - _pedestal[iDetector][iPixel]) >
+                      _hitRejectionCut * _noise[iDetector][iPixel]);
+        bool isGood =
+            (_status[iDetector][iPixel] == EUTELESCOPE::GOODPIXEL);
+        if (!isHit && isGood) {
+          pixelSum += adcValues[iPixel] - _pedestal[iDetector][iPixel];
+          ++goodPixel;
+        } else if (isHit) {
+          ++skippedPixelPerRow;
+          ++skippedPixel;
+        }
+        ++iPixel;
+      }
+
+      // we are now at the end of the row, so let's calculate the
+      // common mode
+      if ((skippedPixelPerRow < _maxNoOfRejectedPixelPerRow) &&
+          (goodPixel != 0)) {
+        commonMode = pixelSum / goodPixel;
+        commonModeCorVec.insert(commonModeCorVec.begin() +
+                                    colCounter * rowLength,
+                                rowLength, commonMode);
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-              string histoname = _commonModeHistoName + "_d" +
-                                 to_string(_orderedSensorIDVec.at(
-                                     iDetector + detectorOffset)) +
-                                 "_l" + to_string(_iLoop);
-              AIDA::IHistogram1D *histo = (dynamic_cast<AIDA::IHistogram1D *>(
-                  _aidaHistoMap[histoname]));
-              if (histo) {
-                histo->fill(commonMode);
-              }
+        string histoname = _commonModeHistoName + "_d" +
+                           to_string(_orderedSensorIDVec.at(iDetector)) +
+                           "_l" + to_string(_iLoop);
+        AIDA::IHistogram1D *histo =
+            (dynamic_cast<AIDA::IHistogram1D *>(_aidaHistoMap[histoname]));
+        if (histo) {
+          histo->fill(commonMode);
+        }
 #endif
 
-            } else {
-              commonModeCorVec.insert(commonModeCorVec.begin() +
-                                          colCounter * rowLength,
-                                      rowLength, 0.);
-              ++skippedRow;
-            }
+      } else {
+        commonModeCorVec.insert(commonModeCorVec.begin() +
+                                    colCounter * rowLength,
+                                rowLength, 0.);
+        ++skippedRow;
+      }
 
-            ++colCounter;
-          }
+      ++colCounter;
+    }
 
-          if (skippedRow < _maxNoOfSkippedRow) {
+    if (skippedRow < _maxNoOfSkippedRow) {
 
-            isEventValid = true;
+      isEventValid = true;
 
-          } else {
+    } else {
 
-            isEventValid = false;
-          }
+      isEventValid = false;
+    }
 
-        } else {
-          streamlog_out(ERROR4)
-              << "Unknown common mode algorithm. Using flat null correction"
-              << endl;
-          commonModeCorVec.insert(commonModeCorVec.begin(),
-                                  (_maxY[iDetector + detectorOffset] -
-                                   _minY[iDetector + detectorOffset] + 1) *
-                                      (_maxX[iDetector + detectorOffset] -
-                                       _minX[iDetector + detectorOffset] + 1),
-                                  0.);
-          isEventValid = true;
-        }
+  } else {
+    streamlog_out(ERROR4)
+        << "Unknown common mode algorithm. Using flat null correction" << endl;
+    commonModeCorVec.insert(commonModeCorVec.begin(),
+                            (_maxY[iDetector] - _minY[iDetector] + 1) *
+                                (_maxX[iDetector] - _minX[iDetector] + 1),
+                            0.);
+    isEventValid = true;
+  }
 
-        if (isEventValid) {
-
-          int iPixel = 0;
-          for (int yPixel = _minY[iDetector + detectorOffset];
-               yPixel <= _maxY[iDetector + detectorOffset]; yPixel++) {
-            for (int xPixel = _minX[iDetector + detectorOffset];
-                 xPixel <= _maxX[iDetector + detectorOffset]; xPixel++) {
-              if (_status[iDetector + detectorOffset][iPixel] ==
-                  EUTELESCOPE::GOODPIXEL) {
-                double pedeCorrected =
-                    adcValues[iPixel] - commonModeCorVec[iPixel];
-                if (std::abs(pedeCorrected -
-                             _pedestal[iDetector + detectorOffset][iPixel]) <
-                    _hitRejectionCut *
-                        _noise[iDetector + detectorOffset][iPixel]) {
-                  if (_pedestalAlgo == EUTELESCOPE::MEANRMS) {
-
-                    bool use = true;
-                    if (_preLoopSwitch &&
-                        ((_iEvt ==
-                          _maxValuePos[iDetector + detectorOffset][iPixel]) ||
-                         (_iEvt ==
-                          _minValuePos[iDetector + detectorOffset][iPixel]))) {
-                      use = false;
-                    }
-                    if (use) {
-                      _tempEntries[iDetector + detectorOffset][iPixel] =
-                          _tempEntries[iDetector + detectorOffset][iPixel] + 1;
-                      _tempPede[iDetector + detectorOffset][iPixel] =
-                          ((_tempEntries[iDetector + detectorOffset][iPixel] -
-                            1) *
-                               _tempPede[iDetector + detectorOffset][iPixel] +
-                           pedeCorrected) /
-                          _tempEntries[iDetector + detectorOffset][iPixel];
-                      _tempNoise[iDetector + detectorOffset][iPixel] = sqrt(
-                          ((_tempEntries[iDetector + detectorOffset][iPixel] -
-                            1) *
-                               pow(_tempNoise[iDetector + detectorOffset]
-                                             [iPixel],
-                                   2) +
-                           pow(pedeCorrected -
-                                   _tempPede[iDetector + detectorOffset]
-                                            [iPixel],
-                               2)) /
-                          _tempEntries[iDetector + detectorOffset][iPixel]);
-                    }
-                  } else if (_pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
+  if (isEventValid) {
+
+    int iPixel = 0;
+    for (int yPixel = _minY[iDetector]; yPixel <= _maxY[iDetector]; yPixel++) {
+      for (int xPixel = _minX[iDetector]; xPixel <= _maxX[iDetector];
+           xPixel++) {
+        if (_status[iDetector][iPixel] == EUTELESCOPE::GOODPIXEL) {
+          double pedeCorrected = adcValues[iPixel] - commonModeCorVec[iPixel];
+          if (std::abs(pedeCorrected - _pedestal[iDetector][iPixel]) <
+              _hitRejectionCut * _noise[iDetector][iPixel]) {
+            if (_pedestalAlgo == EUTELESCOPE::MEANRMS) {
+
+              bool use = true;
+              if (_preLoopSwitch &&
+                  ((_iEvt == _maxValuePos[iDetector][iPixel]) ||
+                   (_iEvt == _minValuePos[iDetector][iPixel]))) {
+                use = false;
+              }
+              if (use) {
+                _tempEntries[iDetector][iPixel] =
+                    _tempEntries[iDetector][iPixel] + 1;
+                _tempPede[iDetector][iPixel] =
+                    ((_tempEntries[iDetector][iPixel] - 1) *
+                         _tempPede[iDetector][iPixel] +
+                     pedeCorrected) /
+                    _tempEntries[iDetector][iPixel];
+                _tempNoise[iDetector][iPixel] =
+                    sqrt(((_tempEntries[iDetector][iPixel] - 1) *
+                              pow(_tempNoise[iDetector][iPixel], 2) +
+                          pow(pedeCorrected - _tempPede[iDetector][iPixel],
+                              2)) /
+                         _tempEntries[iDetector][iPixel]);
+              }
+            } else if (_pedestalAlgo == EUTELESCOPE::AIDAPROFILE) {
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-                    bool use = true;
-                    if (_preLoopSwitch &&
-                        ((_iEvt ==
-                          _maxValuePos[iDetector + detectorOffset][iPixel]) ||
-                         (_iEvt ==
-                          _minValuePos[iDetector + detectorOffset][iPixel]))) {
-                      use = false;
-                    }
-                    if (use) {
-                      stringstream ss;
-                      ss << _tempProfile2DName << "_d"
-                         << _orderedSensorIDVec.at(iDetector + detectorOffset);
-                      (dynamic_cast<AIDA::IProfile2D *>(
-                           _aidaHistoMap[ss.str()]))
-                          ->fill(static_cast<double>(xPixel),
-                                 static_cast<double>(yPixel), pedeCorrected);
-                    }
-#endif
-                  }
-                }
+              bool use = true;
+              if (_preLoopSwitch &&
+                  ((_iEvt == _maxValuePos[iDetector][iPixel]) ||
+                   (_iEvt == _minValuePos[iDetector][iPixel]))) {
+                use = false;
               }
-              ++iPixel;
+              if (use) {
+                stringstream ss;
+                ss << _tempProfile2DName << "_d"
+                   << _orderedSensorIDVec.at(iDetector);
+                (dynamic_cast<AIDA::IProfile2D *>(_aidaHistoMap[ss.str()]))
+                    ->fill(static_cast<double>(xPixel),
+                           static_cast<double>(yPixel), pedeCorrected);
+              }
+#endif
             }
           }
-        } else {
-          if (_commonModeAlgo == EUTELESCOPE::FULLFRAME) {
-            streamlog_out(WARNING2)
-                << "Skipping event " << _iEvt
-                << " because of max number of rejected pixels exceeded. ("
-                << skippedPixel << ") on detector "
-                << _orderedSensorIDVec.at(iDetector) << endl;
-          } else if (_commonModeAlgo == EUTELESCOPE::ROWWISE) {
-            streamlog_out(WARNING2)
-                << "Skipping event " << _iEvt
-                << " because of max number of skipped rows is reached. ("
-                << skippedRow << ") on detector "
-                << _orderedSensorIDVec.at(iDetector) << endl;
-          }
-
-          // the event has been skipped, so add this event number to the
-          // skipped list
-          _skippedEventList.push_back(_iEvt);
         }
+        ++iPixel;
       }
-    } catch (DataNotAvailableException &e) {
+    }
+  } else {
+    if (_commonModeAlgo == EUTELESCOPE::FULLFRAME) {
       streamlog_out(WARNING2)
-          << "No input collection " << _rawDataCollectionNameVec.at(iCol)
-          << " is not available in the current event" << endl;
+          << "Skipping event " << _iEvt
+          << " because of max number of rejected pixels exceeded. ("
+          << skippedPixel << ") on detector "
+          << _orderedSensorIDVec.at(iDetector) << endl;
+    } else if (_commonModeAlgo == EUTELESCOPE::ROWWISE) {
+      streamlog_out(WARNING2)
+          << "Skipping event " << _iEvt
+          << " because of max number of skipped rows is reached. ("
+          << skippedRow << ") on detector "
+          << _orderedSensorIDVec.at(iDetector) << endl;
     }
+
+    // the event has been skipped, so add this event number to the
+    // skipped list
+    _skippedEventList.push_back(_iEvt);
   }
-  ++_iEvt;
 }
 
 void EUTelPedestalNoiseProcessor::bookHistos() {
@@ -1783,8 +1751,7 @@ void EUTelPedestalNoiseProcessor::simpleRewind() {
   _isFirstEvent = true;
   _iEvt = 0;
 
-  setReturnValue("IsPedestalFinished", false);
-  throw RewindDataFilesException(this);
+  rewindOrReplay();
 }
 
 void EUTelPedestalNoiseProcessor::finalizeProcessor(bool fromMaskingLoop) {
@@ -2071,15 +2038,13 @@ void EUTelPedestalNoiseProcessor::finalizeProcessor(bool fromMaskingLoop) {
       }
 #endif
     }
-    setReturnValue("IsPedestalFinished", false);
-    throw RewindDataFilesException(this);
+    rewindOrReplay();
   } else if ((_additionalMaskingLoop) && (_iLoop == _noOfCMIterations + 1)) {
     // additional loop!
     // now we need to loop again
     // so reset the event counter
     _iEvt = 0;
-    setReturnValue("IsPedestalFinished", false);
-    throw RewindDataFilesException(this);
+    rewindOrReplay();
   }
 }
 
@@ -2096,7 +2061,8 @@ void EUTelPedestalNoiseProcessor::additionalMaskingLoop(LCEvent *event) {
     throw SkipEventException(this);
   }
 
-  if (*_nextEventToSkip == _iEvt) {
+  if ((_nextEventToSkip != _skippedEventList.end()) &&
+      (*_nextEventToSkip == _iEvt)) {
     streamlog_out(MESSAGE4)
         << "Event " << _iEvt
         << " is skipped because labelled bad by the common mode procedure."
@@ -2121,46 +2087,204 @@ void EUTelPedestalNoiseProcessor::additionalMaskingLoop(LCEvent *event) {
         // get the TrackerRawData object from the collection for this detector
         TrackerRawData *trackerRawData = dynamic_cast<TrackerRawData *>(
             collectionVec->getElementAt(iDetector));
-        ShortVec adcValues = trackerRawData->getADCValues();
-        for (unsigned int iPixel = 0; iPixel < adcValues.size(); iPixel++) {
-          if (_status[iDetector + detectorOffset][iPixel] ==
-              EUTELESCOPE::GOODPIXEL) {
-            float correctedValue =
-                adcValues[iPixel] -
-                _pedestal[iDetector + detectorOffset][iPixel];
-            float threshold = _noise[iDetector + detectorOffset][iPixel] * 3.0;
-#if defined(MARLIN_USE_AIDA) || defined(USE_AIDA)
-            if (_histogramSwitch && iPixel == 1 + (adcValues.size() / 10)) {
-              string tempHistoName = _aPixelHistoName + "_d" +
-                                     to_string(_orderedSensorIDVec.at(
-                                         iDetector + detectorOffset)) +
-                                     "_l" + to_string(_iLoop);
-              if (AIDA::IHistogram1D *histo =
-                      dynamic_cast<AIDA::IHistogram1D *>(
-                          _aidaHistoMap[tempHistoName]))
-                histo->fill(correctedValue);
-              else {
-                streamlog_out(ERROR1)
-                    << "Not able to retrieve histogram pointer for "
-                    << tempHistoName
-                    << ".\nDisabling histogramming from now on " << endl;
-                _histogramSwitch = false;
-              }
-            }
-#endif
-            if (correctedValue > threshold) {
-              _hitCounter[iDetector + detectorOffset][iPixel]++;
-            }
-          }
-        }
+        const ShortVec &adcValues = trackerRawData->getADCValues();
+        additionalMaskingLoopDetector(iDetector + detectorOffset,
+                                      adcValues.data(), adcValues.size());
       }
     } catch (DataNotAvailableException &e) {
       streamlog_out(WARNING2)
           << "No input collection " << _rawDataCollectionNameVec.at(iCol)
           << " is not available in the current event" << endl;
     }
-    ++_iEvt;
   }
+  ++_iEvt;
+}
+
+void EUTelPedestalNoiseProcessor::additionalMaskingLoopDetector(
+    size_t iDetector, const short *adcValues, size_t noOfPixels) {
+
+  for (unsigned int iPixel = 0; iPixel < noOfPixels; iPixel++) {
+    if (_status[iDetector][iPixel] == EUTELESCOPE::GOODPIXEL) {
+      float correctedValue = adcValues[iPixel] - _pedestal[iDetector][iPixel];
+      float threshold = _noise[iDetector][iPixel] * 3.0;
+#if defined(MARLIN_USE_AIDA) || defined(USE_AIDA)
+      if (_histogramSwitch && iPixel == 1 + (noOfPixels / 10)) {
+        string tempHistoName = _aPixelHistoName + "_d" +
+                               to_string(_orderedSensorIDVec.at(iDetector)) +
+                               "_l" + to_string(_iLoop);
+        if (AIDA::IHistogram1D *histo = dynamic_cast<AIDA::IHistogram1D *>(
+                _aidaHistoMap[tempHistoName]))
+          histo->fill(correctedValue);
+        else {
+          streamlog_out(ERROR1)
+              << "Not able to retrieve histogram pointer for " << tempHistoName
+              << ".\nDisabling histogramming from now on " << endl;
+          _histogramSwitch = false;
+        }
+      }
+#endif
+      if (correctedValue > threshold) {
+        _hitCounter[iDetector][iPixel]++;
+      }
+    }
+  }
+}
+
+void EUTelPedestalNoiseProcessor::cacheFrame(LCEvent *evt) {
+
+  // the frame layout follows the detector index, it is set up with
+  // the first frame
+  if (_frameSize == 0) {
+    _frameOffsetVec.clear();
+    for (size_t iDetector = 0; iDetector < _noOfDetector; ++iDetector) {
+      _frameOffsetVec.push_back(_frameSize);
+      _frameSize += (_maxX[iDetector] - _minX[iDetector] + 1) *
+                    (_maxY[iDetector] - _minY[iDetector] + 1);
+    }
+  }
+
+  const size_t maxFrames =
+      (static_cast<size_t>(_frameCacheMaxSize) << 20) /
+      (sizeof(short) * std::max(_frameSize, static_cast<size_t>(1)));
+  if (_noOfCachedFrames >= maxFrames) {
+    clearFrameCache("the frame cache is full");
+    return;
+  }
+
+  // with a known event range the cache is allocated once
+  if ((_noOfCachedFrames == 0) && (_lastEvent != -1)) {
+    const size_t noOfFrames = std::min(
+        maxFrames, static_cast<size_t>(std::max(_lastEvent - _firstEvent, 0)));
+    _frameCache.reserve(noOfFrames * _frameSize);
+  }
+
+  const size_t frameBegin = _frameCache.size();
+  _frameCache.resize(frameBegin + _frameSize);
+
+  for (size_t iCol = 0; iCol < _rawDataCollectionNameVec.size(); ++iCol) {
+
+    size_t detectorOffset = (iCol == 0) ? 0 : _noOfDetectorVec.at(iCol - 1);
+
+    try {
+      LCCollectionVec *collectionVec = dynamic_cast<LCCollectionVec *>(
+          evt->getCollection(_rawDataCollectionNameVec.at(iCol)));
+
+      for (size_t iDetector = 0; iDetector < collectionVec->size();
+           ++iDetector) {
+        TrackerRawData *trackerRawData = dynamic_cast<TrackerRawData *>(
+            collectionVec->getElementAt(iDetector));
+        const ShortVec &adcValues = trackerRawData->getADCValues();
+
+        const size_t index = iDetector + detectorOffset;
+        const size_t noOfPixels = (index + 1 < _noOfDetector)
+                                      ? _frameOffsetVec[index + 1]
+                                      : _frameSize;
+        if ((index >= _noOfDetector) ||
+            (adcValues.size() != noOfPixels - _frameOffsetVec[index])) {
+          clearFrameCache("the detector layout changed");
+          return;
+        }
+        std::copy(adcValues.begin(), adcValues.end(),
+                  _frameCache.begin() + frameBegin + _frameOffsetVec[index]);
+      }
+
+    } catch (DataNotAvailableException &e) {
+      clearFrameCache("an input collection is missing");
+      return;
+    }
+  }
+
+  ++_noOfCachedFrames;
+}
+
+void EUTelPedestalNoiseProcessor::clearFrameCache(const std::string &reason) {
+
+  streamlog_out(WARNING2) << "Not caching the raw frames any more because "
+                          << reason << ".\n"
+                          << "The remaining loops will re-read the input file."
+                          << endl;
+
+  _useFrameCache = false;
+  _noOfCachedFrames = 0;
+  ShortVec().swap(_frameCache);
+}
+
+void EUTelPedestalNoiseProcessor::rewindOrReplay() {
+
+  setReturnValue("IsPedestalFinished", false);
+
+  if (!_useFrameCache) {
+    throw RewindDataFilesException(this);
+  }
+
+  // the replay drives all the remaining loops itself
+  if (!_replayingFrames) {
+    replayFrameCache();
+  }
+}
+
+void EUTelPedestalNoiseProcessor::replayFrameCache() {
+
+  streamlog_out(MESSAGE4) << "Running the remaining loops on "
+                          << _noOfCachedFrames << " cached frames" << endl;
+
+  _replayingFrames = true;
+
+  int additionalLoop = 0;
+  if (_additionalMaskingLoop)
+    additionalLoop = 1;
+
+  while (_iLoop < _noOfCMIterations + 1 + additionalLoop) {
+
+    const bool isMaskingLoop =
+        _additionalMaskingLoop && (_iLoop == _noOfCMIterations + 1);
+    const bool isFirstLoop = (_iLoop == 0);
+
+    for (size_t iFrame = 0; iFrame < _noOfCachedFrames; ++iFrame) {
+
+      // the frames are numbered as the events they were taken from
+      _iEvt = _firstEvent + static_cast<int>(iFrame);
+      const short *frame = _frameCache.data() + iFrame * _frameSize;
+
+      if (isMaskingLoop && (_nextEventToSkip != _skippedEventList.end()) &&
+          (*_nextEventToSkip == _iEvt)) {
+        streamlog_out(MESSAGE4)
+            << "Event " << _iEvt
+            << " is skipped because labelled bad by the common mode procedure."
+            << endl;
+        ++_nextEventToSkip;
+        continue;
+      }
+
+      for (size_t iDetector = 0; iDetector < _noOfDetector; ++iDetector) {
+        const short *adcValues = frame + _frameOffsetVec[iDetector];
+        const size_t noOfPixels = ((iDetector + 1 < _noOfDetector)
+                                       ? _frameOffsetVec[iDetector + 1]
+                                       : _frameSize) -
+                                  _frameOffsetVec[iDetector];
+        if (isFirstLoop && isFirstEvent())
+          initializeDetector(iDetector, adcValues, noOfPixels);
+        else if (isFirstLoop)
+          firstLoopDetector(iDetector, adcValues);
+        else if (isMaskingLoop)
+          additionalMaskingLoopDetector(iDetector, adcValues, noOfPixels);
+        else
+          otherLoopDetector(iDetector, adcValues);
+      }
+
+      if (isFirstLoop && isFirstEvent()) {
+        bookHistos();
+        _isFirstEvent = false;
+      }
+    }
+
+    _iEvt = _firstEvent + static_cast<int>(_noOfCachedFrames);
+
+    // this is throwing a StopProcessingException after the last loop
+    finalizeProcessor(isMaskingLoop);
+  }
+
+  _replayingFrames = false;
 }
 
 void EUTelPedestalNoiseProcessor::setBadPixelAlgoSwitches() {
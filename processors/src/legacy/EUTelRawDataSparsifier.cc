@@ -18,6 +18,7 @@
 #include "EUTelGenericSparsePixel.h"
 #include "EUTelMatrixDecoder.h"
 #include "EUTelRunHeaderImpl.h"
+#include "EUTelThresholdCompaction.h"
 #include "EUTelTrackerDataInterfacerImpl.h"
 
 // marlin includes ".h"
@@ -209,11 +210,8 @@ void EUTelRawDataSparsifier::processEvent(LCEvent *event) {
 
       EUTelMatrixDecoder matrixDecoder(cellDecoder, rawData);
 
-      ShortVec::const_iterator rawIter = rawData->getADCValues().begin();
-      FloatVec::const_iterator pedIter = pedestal->getChargeValues().begin();
-      FloatVec::const_iterator noiseIter = noise->getChargeValues().begin();
-      ShortVec::const_iterator statusIter = status->getADCValues().begin();
-      int iPixel = 0;
+      const ShortVec &adcValues = rawData->getADCValues();
+      const size_t noOfPixels = adcValues.size();
 
       // there was a bug here in a previous version because we were
       // looking for
@@ -225,26 +223,36 @@ void EUTelRawDataSparsifier::processEvent(LCEvent *event) {
 
       if (_pixelType == kEUTelGenericSparsePixel) {
 
-        EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> sparseData(
-            sparsified);
-        while (rawIter != rawData->getADCValues().end()) {
-          if ((*statusIter) == EUTELESCOPE::GOODPIXEL) {
-            float data = (*rawIter) - (*pedIter);
-            float threshold = sigmaCut * (*noiseIter);
-            if (data > threshold) {
-              auto sparsePixel = std::make_unique<EUTelGenericSparsePixel>();
-              sparsePixel->setXCoord(matrixDecoder.getXFromIndex(iPixel));
-              sparsePixel->setYCoord(matrixDecoder.getYFromIndex(iPixel));
-              sparsePixel->setSignal(static_cast<short>(data));
-              streamlog_out(DEBUG0) << (*sparsePixel.get()) << endl;
-              sparseData.push_back(*sparsePixel.get());
-            }
+        // select the surviving pixels in one pass over the frame
+        if (_sparseIndices.size() < noOfPixels) {
+          _sparseIndices.resize(noOfPixels);
+          _sparseSignals.resize(noOfPixels);
+        }
+        size_t noOfHits = ThresholdCompaction::compact(
+            adcValues.data(), pedestal->getChargeValues().data(),
+            noise->getChargeValues().data(), status->getADCValues().data(),
+            noOfPixels, sigmaCut, _sparseIndices.data(),
+            _sparseSignals.data());
+
+        // and append them in the EUTelGenericSparsePixel layout
+        // (x, y, signal, time) used by EUTelTrackerDataInterfacerImpl
+        FloatVec &chargeValues = sparsified->chargeValues();
+        chargeValues.resize(4 * noOfHits);
+        for (size_t iHit = 0; iHit < noOfHits; ++iHit) {
+          int iPixel = _sparseIndices[iHit];
+          float *pixel = &chargeValues[4 * iHit];
+          pixel[0] = static_cast<float>(matrixDecoder.getXFromIndex(iPixel));
+          pixel[1] = static_cast<float>(matrixDecoder.getYFromIndex(iPixel));
+          pixel[2] = static_cast<short>(_sparseSignals[iHit]);
+          pixel[3] = 0;
+        }
+
+        if (streamlog_level(DEBUG0)) {
+          EUTelTrackerDataInterfacerImpl<EUTelGenericSparsePixel> sparseData(
+              sparsified);
+          for (auto &sparsePixel : sparseData) {
+            streamlog_out(DEBUG0) << sparsePixel << endl;
           }
-          ++rawIter;
-          ++pedIter;
-          ++noiseIter;
-          ++statusIter;
-          ++iPixel;
         }
 
       } else if (_pixelType == kUnknownPixelType) {
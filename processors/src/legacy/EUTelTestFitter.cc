@@ -17,6 +17,7 @@
 #include "EUTelEventImpl.h"
 #include "EUTelExceptions.h"
 #include "EUTelHistogramManager.h"
+#include "EUTelHitSelectionSearch.h"
 #include "EUTelRunHeaderImpl.h"
 
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
@@ -49,6 +50,7 @@
 #include <IMPL/TrackImpl.h>
 
 // system includes <>
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <fstream>
@@ -112,7 +114,7 @@ EUTelTestFitter::EUTelTestFitter()
       _planeShiftY(nullptr), _planeRotZ(nullptr), _planePosition(nullptr),
       _planeThickness(nullptr), _planeX0(nullptr), _planeResolution(nullptr),
       _isActive(nullptr), _planeWindowIDs(nullptr), _planeMaskIDs(nullptr), _nRun(0),
-      _nEvt(0), _planeHits(nullptr), _planeChoice(nullptr), _planeMod(nullptr),
+      _nEvt(0), _planeHits(), _hitSelectionSearch(),
       _planeX(nullptr), _planeEx(nullptr), _planeY(nullptr), _planeEy(nullptr),
       _planeScatAngle(nullptr), _planeDist(nullptr), _planeScat(nullptr), _fitX(nullptr),
       _fitEx(nullptr), _fitY(nullptr), _fitEy(nullptr), _fitArray(nullptr),
@@ -636,9 +638,15 @@ void EUTelTestFitter::init() {
 
   // Allocate arrays for track fitting
 
-  _planeHits = new int[_nTelPlanes];
-  _planeChoice = new int[_nTelPlanes];
-  _planeMod = new type_fitcount[_nTelPlanes];
+  _planeHits.assign(_nTelPlanes, 0);
+
+  _hitSelectionSearch.setActivePlanes(
+      std::vector<bool>(_isActive, _isActive + _nTelPlanes));
+  _hitSelectionSearch.setAllowedMissingHits(_allowMissingHits);
+  _hitSelectionSearch.setAllowedSkipHits(_allowSkipHits);
+  _hitSelectionSearch.setPenalties(_missingHitPenalty, _skipHitPenalty);
+  _hitSelectionSearch.setChi2Limits(_chi2Min, _chi2Max);
+  _hitSelectionSearch.setBeamConstraint(_useBeamConstraint);
 
   _planeX = new double[_nTelPlanes];
   _planeEx = new double[_nTelPlanes];
@@ -808,6 +816,234 @@ void EUTelTestFitter::processRunHeader(LCRunHeader *runHeader) {
   }
 }
 
+//! Fit of the hit selections of one event
+/*! Fills the position and error arrays of the processor with the hits
+ *  of a selection, fits them and stores the accepted fits.
+ */
+class EUTelTestFitter::SelectionFitter
+    : public EUTelHitSelectionSearch::Fitter {
+public:
+  SelectionFitter(EUTelTestFitter &processor, LCEvent *event,
+                  const IntVec *planeHitID, const double *hitX,
+                  const double *hitEx, const double *hitY,
+                  const double *hitEy,
+                  std::multimap<double, int> &fittedChi2,
+                  std::vector<double> &fittedPenalty,
+                  std::vector<int> &fittedFired, std::vector<double> &fittedX,
+                  std::vector<double> &fittedEx, std::vector<double> &fittedY,
+                  std::vector<double> &fittedEy, std::vector<int> &fittedHits)
+      : _processor(processor), _event(event), _planeHitID(planeHitID),
+        _hitX(hitX), _hitEx(hitEx), _hitY(hitY), _hitEy(hitEy),
+        _fittedChi2(fittedChi2), _fittedPenalty(fittedPenalty),
+        _fittedFired(fittedFired), _fittedX(fittedX), _fittedEx(fittedEx),
+        _fittedY(fittedY), _fittedEy(fittedEy), _fittedHits(fittedHits) {}
+
+  virtual int preselect(const std::vector<int> &hits);
+  virtual double fit(const std::vector<int> &hits, int nFired);
+  virtual void accept(const std::vector<int> &hits, int nFired, double chi2,
+                      double penalty);
+
+private:
+  EUTelTestFitter &_processor;
+  LCEvent *_event;
+  const IntVec *_planeHitID;
+  const double *_hitX;
+  const double *_hitEx;
+  const double *_hitY;
+  const double *_hitEy;
+  std::multimap<double, int> &_fittedChi2;
+  std::vector<double> &_fittedPenalty;
+  std::vector<int> &_fittedFired;
+  std::vector<double> &_fittedX;
+  std::vector<double> &_fittedEx;
+  std::vector<double> &_fittedY;
+  std::vector<double> &_fittedEy;
+  std::vector<int> &_fittedHits;
+};
+
+int EUTelTestFitter::SelectionFitter::preselect(const std::vector<int> &hits) {
+  EUTelTestFitter &p = _processor;
+
+  int ifirst = -1;
+  int ilast = 0;
+
+  // Preselection based on slope
+  // will be set to plane number if
+  //   - hit too far from the expected position (based on first
+  //             plane + beam slope): hit missed
+  //   - angle between track segments (slope change) too large:
+  //                  track slope
+  //
+  // Value >0 gives first layer which failed the cut
+  // 0 value means that preselection cuts were passed by all hits
+
+  int firstHitMissed = 0;
+  int firstTrackSlope = 0;
+
+  // If beam constraint used: assume the track should go along
+  // beam direction, otherwise beam is assumed to be perpendicular
+  // to the sensor plane
+
+  double expTrackSlopeX = 0.;
+  double expTrackSlopeY = 0.;
+
+  if (p._useBeamConstraint) {
+    expTrackSlopeX = p._beamSlopeX;
+    expTrackSlopeY = p._beamSlopeY;
+  }
+
+  double lastSlopeX = 0.;
+  double lastSlopeY = 0.;
+
+  // Fill position and error arrays for this hit configuration
+
+  for (int ipl = 0; ipl < p._nTelPlanes; ipl++) {
+    p._planeX[ipl] = p._planeY[ipl] = p._planeEx[ipl] = p._planeEy[ipl] = 0.;
+
+    if (hits[ipl] < 0) {
+      continue;
+    }
+
+    int jhit = _planeHitID[ipl].at(hits[ipl]);
+
+    p._planeX[ipl] = _hitX[jhit];
+    p._planeY[ipl] = _hitY[jhit];
+    p._planeEx[ipl] =
+        (p._useNominalResolution) ? p._planeResolution[ipl] : _hitEx[jhit];
+    p._planeEy[ipl] =
+        (p._useNominalResolution) ? p._planeResolution[ipl] : _hitEy[jhit];
+
+    // Calculate distance from expected position
+    // starting from the second hit (when ifirst already set)
+
+    if (p._UseSlope && ifirst >= 0 && firstHitMissed == 0) {
+      double expX = p._planeX[ifirst] +
+                    expTrackSlopeX *
+                        (p._planePosition[ipl] - p._planePosition[ifirst]);
+      double expY = p._planeY[ifirst] +
+                    expTrackSlopeY *
+                        (p._planePosition[ipl] - p._planePosition[ifirst]);
+      if (abs(p._planeX[ipl] - expX) > p._SlopeDistanceMax / 1000. ||
+          abs(p._planeY[ipl] - expY) > p._SlopeDistanceMax / 1000.)
+        firstHitMissed = ipl;
+    }
+
+    // Calculate slope and check slope change w.r.t. previous slope
+
+    if (p._UseSlope && ifirst >= 0 && firstTrackSlope == 0) {
+      double slopeX = (p._planeX[ipl] - p._planeX[ifirst]) /
+                      (p._planePosition[ipl] - p._planePosition[ifirst]);
+
+      double slopeY = (p._planeY[ipl] - p._planeY[ifirst]) /
+                      (p._planePosition[ipl] - p._planePosition[ifirst]);
+
+      if (ilast > ifirst && (abs(slopeX - lastSlopeX) > p._SlopeXLimit ||
+                             abs(slopeY - lastSlopeY) > p._SlopeYLimit))
+        firstTrackSlope = ipl;
+
+      lastSlopeX = slopeX;
+      lastSlopeY = slopeY;
+    }
+
+    if (ifirst < 0) {
+      ifirst = ipl;
+    }
+
+    ilast = ipl;
+  }
+
+  // Cut on distance from expected position first, then on track slope
+  // changes
+
+  return (firstHitMissed > 0) ? firstHitMissed : firstTrackSlope;
+}
+
+double EUTelTestFitter::SelectionFitter::fit(const std::vector<int> &,
+                                             int nFired) {
+  EUTelTestFitter &p = _processor;
+  double choiceChi2 = -1.;
+
+  // Select fit method
+  // "Nominal" fit only if all active planes used
+
+  if (p._useNominalResolution && (nFired == p._nActivePlanes)) {
+    choiceChi2 = p.NominalFit();
+  } else {
+    if (p._useNominalResolution && p._beamSlopeX == p._beamSlopeY)
+      choiceChi2 = p.SingleFit();
+    else
+      choiceChi2 = p.MatrixFit();
+  }
+
+  // Fit failed ?
+
+  if (choiceChi2 < 0.) {
+    streamlog_out(WARNING2)
+        << "Fit to " << nFired << " planes failed for event "
+        << _event->getEventNumber() << " in run " << _event->getRunNumber()
+        << endl;
+  }
+
+  return choiceChi2;
+}
+
+void EUTelTestFitter::SelectionFitter::accept(const std::vector<int> &hits,
+                                              int nFired, double chi2,
+                                              double penalty) {
+  EUTelTestFitter &p = _processor;
+
+  // Fill all tracks passing chi2 cut
+
+  _fittedChi2.insert(make_pair(chi2, static_cast<int>(_fittedFired.size())));
+
+  _fittedPenalty.push_back(penalty);
+  _fittedFired.push_back(nFired);
+
+  for (int ipl = 0; ipl < p._nTelPlanes; ipl++) {
+    int jhit = -1;
+
+    if (hits[ipl] >= 0) {
+      jhit = _planeHitID[ipl].at(hits[ipl]);
+    }
+
+    _fittedHits.push_back(jhit);
+
+    _fittedX.push_back(p._fitX[ipl]);
+    _fittedY.push_back(p._fitY[ipl]);
+    _fittedEx.push_back(p._fitEx[ipl]);
+    _fittedEy.push_back(p._fitEy[ipl]);
+#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
+    stringstream iden;
+    iden << "pl" << p._planeID[ipl] << "_";
+    string bname = iden.str();
+    if (jhit >= 0) {
+      p._aidaHistoMap1D[bname + "fitX"]->fill(p._fitX[ipl]);
+      p._aidaHistoMap1D[bname + "fitY"]->fill(p._fitY[ipl]);
+      p._aidaHistoMap1D[bname + "hitX"]->fill(_hitX[jhit]);
+      p._aidaHistoMap1D[bname + "hitY"]->fill(_hitY[jhit]);
+      p._aidaHistoMap1D[bname + "residualX"]->fill(p._fitX[ipl] -
+                                                   _hitX[jhit]);
+      p._aidaHistoMap1D[bname + "residualY"]->fill(p._fitY[ipl] -
+                                                   _hitY[jhit]);
+      // Resids
+      p._aidaHistoMap2D[bname + "residualXdX"]->fill(
+          p._fitX[ipl], p._fitX[ipl] - _hitX[jhit]);
+      p._aidaHistoMap2D[bname + "residualYdX"]->fill(
+          p._fitX[ipl], p._fitY[ipl] - _hitY[jhit]);
+      p._aidaHistoMap2D[bname + "residualXdY"]->fill(
+          p._fitY[ipl], p._fitX[ipl] - _hitX[jhit]);
+      p._aidaHistoMap2D[bname + "residualYdY"]->fill(
+          p._fitY[ipl], p._fitY[ipl] - _hitY[jhit]);
+      // Hit Maps
+      p._aidaHistoMap2D[bname + "hitMapHITS"]->fill(_hitX[jhit], _hitY[jhit]);
+      p._aidaHistoMap2D[bname + "hitMapTRACKS"]->fill(p._fitX[ipl],
+                                                      p._fitY[ipl]);
+    }
+
+#endif
+  }
+}
+
 void EUTelTestFitter::processEvent(LCEvent *event) {
 
   _nEvt++;
@@ -1224,30 +1460,18 @@ void EUTelTestFitter::processEvent(LCEvent *event) {
   std::vector<double> fittedEy;
   std::vector<int> fittedHits;
 
-  // Total number of fitted tracks stored in vectors
-
-  int nFittedTracks = 0;
-
   // Count planes active in this event and number of fit possibilities
   //
   int nFiredPlanes = 0;
   type_fitcount nChoice = 1;
 
-  // Count from the last plane, to allow for "smart" track finding
-  //
   for (int ipl = _nTelPlanes - 1; ipl >= 0; ipl--) {
     _planeHits[ipl] = planeHitID[ipl].size();
 
     if (_planeHits[ipl] > 0) {
       nFiredPlanes++;
-
-      _planeChoice[ipl] = _planeHits[ipl] + 1;
-    } else {
-      _planeChoice[ipl] = 1;
+      nChoice *= _planeHits[ipl] + 1;
     }
-
-    _planeMod[ipl] = nChoice;
-    nChoice *= _planeChoice[ipl];
   }
 
   // Debug output
@@ -1304,282 +1528,27 @@ void EUTelTestFitter::processEvent(LCEvent *event) {
                           << " fit possibilities " << endl;
   }
 
-  // Check all track possibilities
-
-  double chi2min = numeric_limits<double>::max();
-
-  // Loop over fit possibilities
-  // Start from one-hit track to allow for "smart" skipping of wrong matches
-
-  int istart = 0;
-  int nmiss = _allowMissingHits;
-
-  while (nmiss > 0 || !_isActive[istart]) {
-    if (_isActive[istart]) {
-      nmiss--;
-    }
-    istart++;
-  }
-
-  for (type_fitcount ichoice = nChoice - _planeMod[istart] - 1; ichoice >= 0;
-       ichoice--) {
-    int nChoiceFired = 0;
-    double choiceChi2 = -1.;
-    double trackChi2 = -1.;
-    int ifirst = -1;
-    int ilast = 0;
-    int nleft = 0;
-
-    // New variables for preselection based on slope
-    // will be set to plane number if
-    //   - hit too far from the expected position (based on first
-    //             plane + beam slope): hit missed
-    //   - angle between track segments (slope change) too large:
-    //                  track slope
-    //
-    // Value >0 gives first layer which failed the cut
-    // 0 value means that preselection cuts were passed by all hits
-
-    int firstHitMissed = 0;
-    int firstTrackSlope = 0;
-
-    // If beam constraint used: assume the track should go along
-    // beam direction, otherwise beam is assumed to be perpendicular
-    // to the sensor plane
-
-    double expTrackSlopeX = 0.;
-    double expTrackSlopeY = 0.;
-
-    if (_useBeamConstraint) {
-      expTrackSlopeX = _beamSlopeX;
-      expTrackSlopeY = _beamSlopeY;
-    }
-
-    double lastSlopeX = 0.;
-    double lastSlopeY = 0.;
-
-    // Fill position and error arrays for this hit configuration
+  // Check all track possibilities, see EUTelHitSelectionSearch
+  // The lowest Chi2 of all fits goes to the first Chi2 histogram
 
-    for (int ipl = 0; ipl < _nTelPlanes; ipl++) {
-      _planeX[ipl] = _planeY[ipl] = _planeEx[ipl] = _planeEy[ipl] = 0.;
-
-      if (_isActive[ipl]) {
-        int ihit = (ichoice / _planeMod[ipl]) % _planeChoice[ipl];
-
-        if (ihit < _planeHits[ipl]) {
-          int jhit = planeHitID[ipl].at(ihit);
-
-          _planeX[ipl] = hitX[jhit];
-          _planeY[ipl] = hitY[jhit];
-          _planeEx[ipl] =
-              (_useNominalResolution) ? _planeResolution[ipl] : hitEx[jhit];
-          _planeEy[ipl] =
-              (_useNominalResolution) ? _planeResolution[ipl] : hitEy[jhit];
-
-          // Calculate distance from expected position
-          // starting from the second hit (when ifirst already set)
-
-          if (_UseSlope && ifirst >= 0 && firstHitMissed == 0) {
-            double expX =
-                _planeX[ifirst] +
-                expTrackSlopeX * (_planePosition[ipl] - _planePosition[ifirst]);
-            double expY =
-                _planeY[ifirst] +
-                expTrackSlopeY * (_planePosition[ipl] - _planePosition[ifirst]);
-            if (abs(_planeX[ipl] - expX) > _SlopeDistanceMax / 1000. ||
-                abs(_planeY[ipl] - expY) > _SlopeDistanceMax / 1000.)
-              firstHitMissed = ipl;
-          }
-
-          // Calculate slope and check slope change w.r.t. previous slope
-
-          if (_UseSlope && ifirst >= 0 && firstTrackSlope == 0) {
-            double slopeX = (_planeX[ipl] - _planeX[ifirst]) /
-                            (_planePosition[ipl] - _planePosition[ifirst]);
-
-            double slopeY = (_planeY[ipl] - _planeY[ifirst]) /
-                            (_planePosition[ipl] - _planePosition[ifirst]);
-
-            if (ilast > ifirst && (abs(slopeX - lastSlopeX) > _SlopeXLimit ||
-                                   abs(slopeY - lastSlopeY) > _SlopeYLimit))
-              firstTrackSlope = ipl;
-
-            lastSlopeX = slopeX;
-            lastSlopeY = slopeY;
-          }
-
-          if (ifirst < 0) {
-            ifirst = ipl;
-          }
-
-          ilast = ipl;
-          nleft = 0;
-          nChoiceFired++;
-        } else {
-          nleft++; // Counts number of planes with missing
-                   // hits after the last hit
-        }
-      }
-    }
-    // End of plane loop (decoding fit hypothesis)
-
-    // Check number of selected hits
-    // =============================
-
-    // No fit to 1 hit :-)
-
-    if (nChoiceFired < 2) {
-      continue;
-    }
-    // Fit with 2 hits make sense only with beam constraint, or
-    // when 2 point fit is allowed
-
-    if (nChoiceFired == 2 && !_useBeamConstraint &&
-        nChoiceFired + _allowMissingHits < _nActivePlanes) {
-      continue;
-    }
-
-    // Skip also if the fit can not be extended to proper number
-    // of planes; no need to check remaining planes !!!
-
-    if (nChoiceFired + nleft < _nActivePlanes - _allowMissingHits) {
-      ichoice -= _planeMod[ilast] - 1;
-      continue;
-    }
-
-    // Preselection added before full Chi2 calculation
-    //
-    // Cut on distance from expected position
-
-    if (firstHitMissed > 0) {
-      ichoice -= _planeMod[firstHitMissed] - 1;
-      continue;
-    }
-
-    // Cut on track slope changes
-
-    if (firstTrackSlope > 0) {
-      ichoice -= _planeMod[firstTrackSlope] - 1;
-      continue;
-    }
-
-    // Select fit method
-    // "Nominal" fit only if all active planes used
-
-    if (_useNominalResolution && (nChoiceFired == _nActivePlanes)) {
-      choiceChi2 = NominalFit();
-    } else {
-      if (_useNominalResolution && _beamSlopeX == _beamSlopeY)
-        choiceChi2 = SingleFit();
-      else
-        choiceChi2 = MatrixFit();
-    }
-
-    // Fit failed ?
-
-    if (choiceChi2 < 0.) {
-      streamlog_out(WARNING2)
-          << "Fit to " << nChoiceFired << " planes failed for event "
-          << event->getEventNumber() << " in run " << event->getRunNumber()
-          << endl;
+  SelectionFitter selectionFitter(*this, event, planeHitID, hitX, hitEx, hitY,
+                                  hitEy, fittedChi2, fittedPenalty,
+                                  fittedFired, fittedX, fittedEx, fittedY,
+                                  fittedEy, fittedHits);
 
-      continue;
-    }
-
-    // Penalty for missing or skiped hits
-    double penalty = (_nActivePlanes - nFiredPlanes) * _missingHitPenalty +
-                     (nFiredPlanes - nChoiceFired) * _skipHitPenalty;
-
-    trackChi2 = choiceChi2 + penalty;
-
-    if (nChoiceFired + _allowMissingHits >= _nActivePlanes &&
-        nChoiceFired + _allowSkipHits >= nFiredPlanes && trackChi2 < chi2min) {
-      chi2min = trackChi2;
-    }
-
-    // Check if better than chi2Max
-    // If not: skip also all track possibilities which include
-    // this hit selection !!!
-
-    if (choiceChi2 >= _chi2Max || choiceChi2 < _chi2Min) {
-      ichoice -= _planeMod[ilast] - 1;
-      continue;
-    }
-
-    //
-    // Skip fit if could not be accepted (too few planes fired)
-    //
-
-    if (nChoiceFired + _allowMissingHits < _nActivePlanes ||
-        nChoiceFired + _allowSkipHits < nFiredPlanes) {
-      continue;
-    }
-
-    // Fill all tracks passing chi2 cut
-
-    if (trackChi2 < _chi2Max && trackChi2 > _chi2Min) {
-
-      fittedChi2.insert(make_pair(trackChi2, nFittedTracks));
-
-      fittedPenalty.push_back(penalty);
-      fittedFired.push_back(nChoiceFired);
-
-      for (int ipl = 0; ipl < _nTelPlanes; ipl++) {
-        int jhit = -1;
-
-        if (_isActive[ipl]) {
-          int ihit = (ichoice / _planeMod[ipl]) % _planeChoice[ipl];
-
-          if (ihit < _planeHits[ipl]) {
-            jhit = planeHitID[ipl].at(ihit);
-          }
-        }
-
-        fittedHits.push_back(jhit);
-
-        fittedX.push_back(_fitX[ipl]);
-        fittedY.push_back(_fitY[ipl]);
-        fittedEx.push_back(_fitEx[ipl]);
-        fittedEy.push_back(_fitEy[ipl]);
 #if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
-        stringstream iden;
-        iden << "pl" << _planeID[ipl] << "_";
-        string bname = iden.str();
-        if (jhit >= 0) {
-          _aidaHistoMap1D[bname + "fitX"]->fill(_fitX[ipl]);
-          _aidaHistoMap1D[bname + "fitY"]->fill(_fitY[ipl]);
-          _aidaHistoMap1D[bname + "hitX"]->fill(hitX[jhit]);
-          _aidaHistoMap1D[bname + "hitY"]->fill(hitY[jhit]);
-          _aidaHistoMap1D[bname + "residualX"]->fill(_fitX[ipl] - hitX[jhit]);
-          _aidaHistoMap1D[bname + "residualY"]->fill(_fitY[ipl] - hitY[jhit]);
-          // Resids
-          _aidaHistoMap2D[bname + "residualXdX"]->fill(_fitX[ipl],
-                                                       _fitX[ipl] - hitX[jhit]);
-          _aidaHistoMap2D[bname + "residualYdX"]->fill(_fitX[ipl],
-                                                       _fitY[ipl] - hitY[jhit]);
-          _aidaHistoMap2D[bname + "residualXdY"]->fill(_fitY[ipl],
-                                                       _fitX[ipl] - hitX[jhit]);
-          _aidaHistoMap2D[bname + "residualYdY"]->fill(_fitY[ipl],
-                                                       _fitY[ipl] - hitY[jhit]);
-          // Hit Maps
-          _aidaHistoMap2D[bname + "hitMapHITS"]->fill(hitX[jhit], hitY[jhit]);
-          _aidaHistoMap2D[bname + "hitMapTRACKS"]->fill(_fitX[ipl], _fitY[ipl]);
-        }
+  double chi2min = _hitSelectionSearch.search(_planeHits, selectionFitter);
 
-#endif
-      }
-
-      nFittedTracks++;
-
-    } // end of track filling
-  }
-// End of loop over track possibilities
-
-#if defined(USE_AIDA) || defined(MARLIN_USE_AIDA)
   (dynamic_cast<AIDA::IHistogram1D *>(_aidaHistoMap[_firstChi2HistoName]))
       ->fill(log10(chi2min));
+#else
+  _hitSelectionSearch.search(_planeHits, selectionFitter);
 #endif
 
+  // Total number of fitted tracks stored in vectors
+
+  int nFittedTracks = static_cast<int>(fittedFired.size());
+
   if (nFittedTracks == 0) {
     if (streamlog_level(DEBUG5)) {
       streamlog_out(DEBUG5) << "No track fulfilling search criteria found ! "
@@ -2007,10 +1976,6 @@ void EUTelTestFitter::end() {
   delete[] _planeScatAngle;
   delete[] _isActive;
 
-  delete[] _planeHits;
-  delete[] _planeChoice;
-  delete[] _planeMod;
-
   delete[] _planeX;
   delete[] _planeEx;
   delete[] _planeY;
@@ -1,4 +1,5 @@
 #include "estmat.h"
+#include <algorithm>
 #include <Eigen/Cholesky>
 #include <Eigen/LU>
 #include <TH2D.h>
@@ -136,26 +137,26 @@ void FakeChi2::calibrate(TrackerSystem<FITTERTYPE, 4> &system) {
   firstRun = false;
 }
 
-void FakeChi2::operator()(size_t offset, size_t stride) {
+void FakeChi2::prepareChunks(size_t nChunks) {
+  // Calibrate before the workers start, they all use the residual errors
+  if (firstRun) {
+    calibrate(systems.at(0));
+  }
+  Minimizer::prepareChunks(nChunks);
+}
+
+void FakeChi2::operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                          int first, int last) {
   // Get the global chi2 of the track sample
-  TrackerSystem<FITTERTYPE, 4> &system = systems.at(offset);
 
   // Track candidate is the same for all tracks
   system.index0tracker();
   TrackCandidate<FITTERTYPE, 4> candidate = system.tracks.at(0);
 
-  {
-#ifdef DOTHREAD
-    boost::mutex::scoped_lock lock(resultGurad);
-#endif
-    if (firstRun) {
-      calibrate(system);
-    }
-  }
   Eigen::Matrix<FITTERTYPE, 2, 1> resv;
 
   FITTERTYPE chi2 = 0;
-  for (int track = offset; track < mat.itMax; track += stride) {
+  for (int track = first; track < last; track++) {
     // prepare system for new track: clear system from prev go around, read
     // track from memory, run track finder
     system.clear();
@@ -184,34 +185,21 @@ void FakeChi2::operator()(size_t offset, size_t stride) {
     }
   }
 
-  {
-#ifdef DOTHREAD
-    boost::mutex::scoped_lock lock(resultGurad);
-#endif
-    result += chi2;
-  }
+  chunkResults.at(chunk) = chi2;
 }
 
-void FakeAbsDev::operator()(size_t offset, size_t stride) {
+void FakeAbsDev::operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                            int first, int last) {
   // Get the global chi2 of the track sample
-  TrackerSystem<FITTERTYPE, 4> &system = systems.at(offset);
 
   // Track candidate is the same for all tracks
   system.index0tracker();
   TrackCandidate<FITTERTYPE, 4> candidate = system.tracks.at(0);
 
-  {
-#ifdef DOTHREAD
-    boost::mutex::scoped_lock lock(resultGurad);
-#endif
-    if (firstRun) {
-      calibrate(system);
-    }
-  }
   Eigen::Matrix<FITTERTYPE, 2, 1> resv;
 
   FITTERTYPE chi2 = 0;
-  for (int track = offset; track < mat.itMax; track += stride) {
+  for (int track = first; track < last; track++) {
     // prepare system for new track: clear system from prev go around, read
     // track from memory, run track finder
     system.clear();
@@ -240,24 +228,19 @@ void FakeAbsDev::operator()(size_t offset, size_t stride) {
     }
   }
 
-  {
-#ifdef DOTHREAD
-    boost::mutex::scoped_lock lock(resultGurad);
-#endif
-    result += chi2;
-  }
+  chunkResults.at(chunk) = chi2;
 }
 
-void Chi2::operator()(size_t offset, size_t stride) {
+void Chi2::operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                      int first, int last) {
   // Get the global chi2 of the track sample
-  TrackerSystem<FITTERTYPE, 4> &system = systems.at(offset);
 
   // Track candidate is the same for all tracks
   system.index0tracker();
   TrackCandidate<FITTERTYPE, 4> candidate = system.tracks.at(0);
 
   double varchi2(0.0);
-  for (int track = offset; track < mat.itMax; track += stride) {
+  for (int track = first; track < last; track++) {
     system.clear();
     mat.readTrack(track, system);
     system.fitInfoFWBiased(candidate);
@@ -265,31 +248,26 @@ void Chi2::operator()(size_t offset, size_t stride) {
     varchi2 += candidate.chi2;
   }
 
-  {
-#ifdef DOTHREAD
-    boost::mutex::scoped_lock lock(resultGurad);
-#endif
-    result += varchi2;
-  }
+  chunkResults.at(chunk) = varchi2;
 }
 
-void SDR::operator()(size_t offset, size_t stride) {
+void SDR::operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                     int first, int last) {
   // Get the mean^2 + (1 - variance) of the standardized residuals of chi2
   // increments and or pull distributions
-  TrackerSystem<FITTERTYPE, 4> &system = systems.at(offset);
-  std::vector<double> sqrPullXFW(system.planes.size() - 2, 0.0);
-  std::vector<double> sqrPullXBW(system.planes.size() - 2, 0.0);
-  std::vector<double> sqrPullYFW(system.planes.size() - 2, 0.0);
-  std::vector<double> sqrPullYBW(system.planes.size() - 2, 0.0);
-  std::vector<std::vector<double>> sqrParams(system.planes.size() - 3,
-                                             std::vector<double>(4, 0.0));
-  int nTracks = 0;
+  PullSums &sums = chunkPulls.at(chunk);
+  std::vector<double> &sqrPullXFW = sums.sqrPullXFW;
+  std::vector<double> &sqrPullXBW = sums.sqrPullXBW;
+  std::vector<double> &sqrPullYFW = sums.sqrPullYFW;
+  std::vector<double> &sqrPullYBW = sums.sqrPullYBW;
+  std::vector<std::vector<double>> &sqrParams = sums.sqrParams;
+  int &nTracks = sums.nTracks;
 
   // Track candidate is the same for all tracks
   system.index0tracker();
   TrackCandidate<FITTERTYPE, 4> candidate = system.tracks.at(0);
 
-  for (int track = offset; track < mat.itMax; track += stride) {
+  for (int track = first; track < last; track++) {
     // prepare system for new track: clear system from prev go around, read
     // track from memory, run track finder
     system.clear();
@@ -372,10 +350,34 @@ void SDR::operator()(size_t offset, size_t stride) {
     }
     nTracks++;
   }
+}
+
+void SDR::prepareChunks(size_t nChunks) {
+  Minimizer::prepareChunks(nChunks);
+  chunkPulls.resize(nChunks);
+  for (size_t chunk = 0; chunk < nChunks; chunk++) {
+    chunkPulls.at(chunk).reset(mat.system.planes.size());
+  }
+}
+
+void SDR::reduce() {
+  // The pull variances are not additive, sum the chunks first
+  PullSums sums;
+  sums.reset(mat.system.planes.size());
+  for (size_t chunk = 0; chunk < chunkPulls.size(); chunk++) {
+    sums.add(chunkPulls.at(chunk));
+  }
+  std::vector<double> &sqrPullXFW = sums.sqrPullXFW;
+  std::vector<double> &sqrPullXBW = sums.sqrPullXBW;
+  std::vector<double> &sqrPullYFW = sums.sqrPullYFW;
+  std::vector<double> &sqrPullYBW = sums.sqrPullYBW;
+  std::vector<std::vector<double>> &sqrParams = sums.sqrParams;
+  int nTracks = sums.nTracks;
+  size_t nPlanes = mat.system.planes.size();
 
   double varvar(0.0);
   if (SDR2) {
-    for (size_t pl = 0; pl < system.planes.size() - 2; pl++) {
+    for (size_t pl = 0; pl < nPlanes - 2; pl++) {
       double resvar = 1.0f - (sqrPullXFW.at(pl) / (nTracks - 1));
       varvar += resvar * resvar;
       resvar = 1.0f - (sqrPullYFW.at(pl) / (nTracks - 1));
@@ -387,40 +389,35 @@ void SDR::operator()(size_t offset, size_t stride) {
     }
   }
   if (SDR1) {
-    for (size_t pl = 1; pl < system.planes.size() - 2; pl++) {
+    for (size_t pl = 1; pl < nPlanes - 2; pl++) {
       for (int param = 0; param < 4; param++) {
         double resvar = 1.0f - (sqrParams.at(pl - 1).at(param) / (nTracks - 1));
         varvar += resvar * resvar;
       }
     }
   }
-  {
-#ifdef DOTHREAD
-    boost::mutex::scoped_lock lock(resultGurad);
-#endif
-    result += varvar;
-  }
+  result = varvar;
+  retVal2 = 0.0f;
 }
 
-void FwBw::operator()(size_t offset, size_t stride) {
+void FwBw::operator()(TrackerSystem<FITTERTYPE, 4> &system, size_t chunk,
+                      int first, int last) {
   // Get the negative log likelihood of the state difference of a forward and
   // backward running Kalman filter.
-  TrackerSystem<FITTERTYPE, 4> &system = systems.at(offset);
 
   // Track candidate is the same for all tracks
   system.index0tracker();
   TrackCandidate<FITTERTYPE, 4> candidate = system.tracks.at(0);
 
-  double logL(0.0);
-  std::vector<double> sqrPullXFW(system.planes.size() - 2, 0.0);
-  std::vector<double> sqrPullXBW(system.planes.size() - 2, 0.0);
-  std::vector<double> sqrPullYFW(system.planes.size() - 2, 0.0);
-  std::vector<double> sqrPullYBW(system.planes.size() - 2, 0.0);
-  std::vector<std::vector<double>> sqrParams(system.planes.size() - 3,
-                                             std::vector<double>(4, 0.0));
-  int nTracks = 0;
+  PullSums &sums = chunkPulls.at(chunk);
+  std::vector<double> &sqrPullXFW = sums.sqrPullXFW;
+  std::vector<double> &sqrPullXBW = sums.sqrPullXBW;
+  std::vector<double> &sqrPullYFW = sums.sqrPullYFW;
+  std::vector<double> &sqrPullYBW = sums.sqrPullYBW;
+  int &nTracks = sums.nTracks;
+  double &logL = sums.logL;
 
-  for (int track = offset; track < mat.itMax; track += stride) {
+  for (int track = first; track < last; track++) {
     // prepare system for new track: clear system from prev go around, read
     // track from memory, run track finder
     system.clear();
@@ -482,8 +479,32 @@ void FwBw::operator()(size_t offset, size_t stride) {
       sqrPullYBW.at(pl) += pull2(1);
     }
   }
+}
+
+void FwBw::prepareChunks(size_t nChunks) {
+  Minimizer::prepareChunks(nChunks);
+  chunkPulls.resize(nChunks);
+  for (size_t chunk = 0; chunk < nChunks; chunk++) {
+    chunkPulls.at(chunk).reset(mat.system.planes.size());
+  }
+}
+
+void FwBw::reduce() {
+  // The pull variances are not additive, sum the chunks first
+  PullSums sums;
+  sums.reset(mat.system.planes.size());
+  for (size_t chunk = 0; chunk < chunkPulls.size(); chunk++) {
+    sums.add(chunkPulls.at(chunk));
+  }
+  std::vector<double> &sqrPullXFW = sums.sqrPullXFW;
+  std::vector<double> &sqrPullXBW = sums.sqrPullXBW;
+  std::vector<double> &sqrPullYFW = sums.sqrPullYFW;
+  std::vector<double> &sqrPullYBW = sums.sqrPullYBW;
+  int nTracks = sums.nTracks;
+  size_t nPlanes = mat.system.planes.size();
+
   FITTERTYPE return2 = 0.0;
-  for (size_t pl = 0; pl < system.planes.size() - 2; pl++) {
+  for (size_t pl = 0; pl < nPlanes - 2; pl++) {
     double resvar = 1.0 - sqrPullXFW.at(pl) / (nTracks - 1);
     return2 += resvar * resvar;
     resvar = 1.0 - sqrPullYFW.at(pl) / (nTracks - 1);
@@ -493,13 +514,8 @@ void FwBw::operator()(size_t offset, size_t stride) {
     resvar = 1.0 - sqrPullYBW.at(pl) / (nTracks - 1);
     return2 += resvar * resvar;
   }
-  {
-#ifdef DOTHREAD
-    boost::mutex::scoped_lock lock(resultGurad);
-#endif
-    result += -1.0 * logL;
-    retVal2 += return2;
-  }
+  result = -1.0 * sums.logL;
+  retVal2 = return2;
 }
 
 void Minimizer::init() {
@@ -511,6 +527,9 @@ void Minimizer::init() {
   if (not inited) {
     systems.assign(nThreads, mat.system);
   }
+  if (mat.pool.size() != nThreads) {
+    mat.pool.resize(nThreads);
+  }
   inited = true;
 }
 
@@ -529,22 +548,175 @@ void Minimizer::prepareThreads() {
   retVal2 = 0.0f;
 }
 
+void Minimizer::prepareChunks(size_t nChunks) {
+  chunkResults.assign(nChunks, 0.0);
+  chunkResults2.assign(nChunks, 0.0);
+}
+
+void Minimizer::reduce() {
+  // Sum the chunks in order, independent of which worker did them
+  double sum(0.0), sum2(0.0);
+  for (size_t chunk = 0; chunk < chunkResults.size(); chunk++) {
+    sum += chunkResults.at(chunk);
+    sum2 += chunkResults2.at(chunk);
+  }
+  result = sum;
+  retVal2 = sum2;
+}
+
 FITTERTYPE Minimizer::operator()(void) {
-  // Start threads if DOTHREAD, run job in main thread if not.
+  // Hand out the tracks in chunks to the worker pool, each worker fits with
+  // its own system. The calling thread does all the chunks if not DOTHREAD.
   prepareThreads();
-#ifdef DOTHREAD
-  boost::thread_group threads;
-  for (int ii = 0; ii < nThreads; ii++) {
-    threads.create_thread(
-        boost::bind(&Minimizer::operator(), this, ii, nThreads));
-  }
-  threads.join_all();
-#else
-  (*this)(0, 1);
-#endif
+  size_t nTracks = mat.itMax > 0 ? static_cast<size_t>(mat.itMax) : 0;
+  size_t nChunks = (nTracks + chunkSize - 1) / chunkSize;
+  prepareChunks(nChunks);
+  mat.pool.run(nChunks, [this, nTracks](size_t worker, size_t chunk) {
+    size_t first = chunk * chunkSize;
+    size_t last = std::min(first + chunkSize, nTracks);
+    (*this)(systems.at(worker), chunk, static_cast<int>(first),
+            static_cast<int>(last));
+  });
+  reduce();
   return (result);
 }
 
+void PullSums::reset(size_t nPlanes) {
+  sqrPullXFW.assign(nPlanes - 2, 0.0);
+  sqrPullXBW.assign(nPlanes - 2, 0.0);
+  sqrPullYFW.assign(nPlanes - 2, 0.0);
+  sqrPullYBW.assign(nPlanes - 2, 0.0);
+  sqrParams.assign(nPlanes - 3, std::vector<double>(4, 0.0));
+  logL = 0.0;
+  nTracks = 0;
+}
+
+void PullSums::add(const PullSums &other) {
+  for (size_t pl = 0; pl < sqrPullXFW.size(); pl++) {
+    sqrPullXFW.at(pl) += other.sqrPullXFW.at(pl);
+    sqrPullXBW.at(pl) += other.sqrPullXBW.at(pl);
+    sqrPullYFW.at(pl) += other.sqrPullYFW.at(pl);
+    sqrPullYBW.at(pl) += other.sqrPullYBW.at(pl);
+  }
+  for (size_t pl = 0; pl < sqrParams.size(); pl++) {
+    for (size_t param = 0; param < 4; param++) {
+      sqrParams.at(pl).at(param) += other.sqrParams.at(pl).at(param);
+    }
+  }
+  logL += other.logL;
+  nTracks += other.nTracks;
+}
+
+WorkerPool::WorkerPool()
+    : m_threads(), m_ranges(1), m_mutex(), m_start(), m_done(),
+      m_job(nullptr), m_busy(0), m_generation(0), m_stop(false), m_error() {
+  ;
+}
+
+WorkerPool::~WorkerPool() { stop(); }
+
+void WorkerPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_start.notify_all();
+  for (size_t ii = 0; ii < m_threads.size(); ii++) {
+    m_threads.at(ii).join();
+  }
+  m_threads.clear();
+  m_stop = false;
+}
+
+void WorkerPool::resize(size_t nWorkers) {
+  // Must not be called during run()
+  stop();
+  if (nWorkers < 1) {
+    nWorkers = 1;
+  }
+  m_ranges = std::vector<Range>(nWorkers);
+  for (size_t worker = 1; worker < nWorkers; worker++) {
+    m_threads.push_back(
+        std::thread(&WorkerPool::workerLoop, this, worker, m_generation));
+  }
+}
+
+void WorkerPool::run(size_t nChunks, const Job &job) {
+  size_t nWorkers = m_ranges.size();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Contiguous ranges of chunks, the first ones get the remainder
+    size_t next = 0;
+    for (size_t worker = 0; worker < nWorkers; worker++) {
+      size_t count =
+          nChunks / nWorkers + (worker < nChunks % nWorkers ? 1 : 0);
+      m_ranges.at(worker).next.store(next);
+      m_ranges.at(worker).end = next + count;
+      next += count;
+    }
+    m_job = &job;
+    m_busy = m_threads.size();
+    m_error = nullptr;
+    m_generation++;
+  }
+  m_start.notify_all();
+  work(0);
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return (m_busy == 0); });
+    m_job = nullptr;
+    error = m_error;
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void WorkerPool::workerLoop(size_t worker, unsigned long generation) {
+  // Wait for an evaluation, do it, report back, repeat until stopped
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_start.wait(lock, [this, generation] {
+        return (m_stop or m_generation != generation);
+      });
+      if (m_stop) {
+        return;
+      }
+      generation = m_generation;
+    }
+    work(worker);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_busy--;
+      if (m_busy == 0) {
+        m_done.notify_one();
+      }
+    }
+  }
+}
+
+void WorkerPool::work(size_t worker) {
+  // Own range first, then steal from the others. Owner and thieves both take
+  // chunks by incrementing the range cursor, so every chunk is done once.
+  size_t nWorkers = m_ranges.size();
+  try {
+    for (size_t victim = 0; victim < nWorkers; victim++) {
+      Range &range = m_ranges.at((worker + victim) % nWorkers);
+      for (size_t chunk = range.next++; chunk < range.end;
+           chunk = range.next++) {
+        (*m_job)(worker, chunk);
+      }
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (not m_error) {
+      m_error = std::current_exception();
+    }
+  }
+}
+
 // void EstMat::simulate(int nTracks){
 //   // Toy simulation of a straight track with Gaussian uncertainties and
 //   scattering
@@ -0,0 +1,128 @@
+#ifndef EUTELRANDOMEVENTS_H
+#define EUTELRANDOMEVENTS_H
+
+//STL
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Random input for the tests that check a rewritten algorithm against the code it replaced,
+// and the timing of their benchmarks.
+//
+// All of them draw from the same fixed seed, so that a failing event comes back on the next
+// run. The benchmarks are DISABLED_ tests, run them with --gtest_also_run_disabled_tests.
+namespace eutelrandom {
+
+	// The seed of the generators
+	const unsigned seed = 20170601;
+
+	// Straight tracks through parallel planes plus uniform noise hits. The hits of plane ii are
+	// x[ii] and y[ii] in the units of the plane positions z. Every track and every noise hit
+	// takes the next number of the event, label[ii] holds it for each hit.
+	class TelescopeEvent {
+	public:
+		// Track and noise positions are uniform within +-halfSize, the slopes are gaussian with
+		// slopeSigma, the hits are smeared with a gaussian of sigma resolution.
+		TelescopeEvent(double halfSize, double slopeSigma, double resolution)
+		  : z(), x(), y(), label(), halfSize(halfSize), slopeSigma(slopeSigma), resolution(resolution),
+		    resolX(), resolY(), nLabels(0) {}
+
+		// Sets the planes, all with the resolution of the event, and removes the hits
+		void setPlanes(const std::vector<double> & planeZ) {
+			setPlanes(planeZ, std::vector<double>(planeZ.size(), resolution), std::vector<double>(planeZ.size(), resolution));
+		}
+
+		// Sets the planes with their own resolutions in x and y, and removes the hits
+		void setPlanes(const std::vector<double> & planeZ, const std::vector<double> & planeResolX,
+		               const std::vector<double> & planeResolY) {
+			z = planeZ;
+			resolX = planeResolX;
+			resolY = planeResolY;
+			clear();
+		}
+
+		// Removes the hits, the planes are kept
+		void clear() {
+			x.assign(z.size(), std::vector<double>());
+			y.assign(z.size(), std::vector<double>());
+			label.assign(z.size(), std::vector<int>());
+			nLabels = 0;
+		}
+
+		// Adds tracks which hit each plane with the probability efficiency
+		void addTracks(std::default_random_engine & generator, size_t nTracks, double efficiency) {
+			std::uniform_real_distribution<double> position(-halfSize, halfSize);
+			std::normal_distribution<double> slope(0.0, slopeSigma);
+			std::normal_distribution<double> gauss(0.0, 1.0);
+			std::uniform_real_distribution<double> uniform(0.0, 1.0);
+			for(size_t tt = 0; tt < nTracks; tt++) {
+				double x0 = position(generator), y0 = position(generator);
+				double xdz = slope(generator), ydz = slope(generator);
+				for(size_t ii = 0; ii < z.size(); ii++) {
+					if(uniform(generator) > efficiency) continue;
+					x[ii].push_back(x0 + xdz * z[ii] + resolX[ii] * gauss(generator));
+					y[ii].push_back(y0 + ydz * z[ii] + resolY[ii] * gauss(generator));
+					label[ii].push_back(nLabels);
+				}
+				nLabels++;
+			}
+		}
+
+		// Adds noise hits, one plane after the other
+		void addNoise(std::default_random_engine & generator, size_t nNoise) {
+			std::uniform_real_distribution<double> position(-halfSize, halfSize);
+			for(size_t nn = 0; nn < nNoise; nn++) {
+				size_t ii = nn % z.size();
+				x[ii].push_back(position(generator));
+				y[ii].push_back(position(generator));
+				label[ii].push_back(nLabels++);
+			}
+		}
+
+		// Puts the hits of each plane in random order, as in a hit collection, instead of by track
+		void shuffle(std::default_random_engine & generator) {
+			for(size_t ii = 0; ii < z.size(); ii++) {
+				for(size_t hh = x[ii].size(); hh > 1; hh--) {
+					std::uniform_int_distribution<size_t> pick(0, hh - 1);
+					size_t other = pick(generator);
+					std::swap(x[ii][hh - 1], x[ii][other]);
+					std::swap(y[ii][hh - 1], y[ii][other]);
+					std::swap(label[ii][hh - 1], label[ii][other]);
+				}
+			}
+		}
+
+		std::vector<double> z;
+		std::vector<std::vector<double> > x;
+		std::vector<std::vector<double> > y;
+		std::vector<std::vector<int> > label;
+
+	private:
+		double halfSize;
+		double slopeSigma;
+		double resolution;
+		std::vector<double> resolX;
+		std::vector<double> resolY;
+		int nLabels;
+	};
+
+	// Wall clock time of the steps of a benchmark
+	class BenchmarkTimer {
+	public:
+		BenchmarkTimer() : last(std::chrono::steady_clock::now()) {}
+
+		// Microseconds since the previous lap, or since the timer was made
+		double lap() {
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			double elapsed = std::chrono::duration<double, std::micro>(now - last).count();
+			last = now;
+			return elapsed;
+		}
+
+	private:
+		std::chrono::steady_clock::time_point last;
+	};
+}
+#endif
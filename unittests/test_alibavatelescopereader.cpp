@@ -0,0 +1,115 @@
+//STL
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//LCIO
+#include <lcio.h>
+#include <EVENT/LCIO.h>
+#include <IO/LCWriter.h>
+#include <IOIMPL/LCFactory.h>
+#include <IMPL/LCEventImpl.h>
+#include <IMPL/LCRunHeaderImpl.h>
+
+//EUTelescope
+#include "AlibavaTelescopeReader.h"
+
+using alibava::AlibavaTelescopeReader;
+
+// A telescope file whose event numbers are repeated and out of order, as after lost or duplicated triggers.
+// Every event carries its position in the file as the parameter "record".
+class alibavaTelescopeReaderTest : public ::testing::Test {
+protected:
+
+	alibavaTelescopeReaderTest() : filename("test_alibavatelescopereader.slcio"), eventNumbers({5, 3, 3, 7, 1, 3, 9, 2}) {}
+
+	virtual void SetUp() {
+		IO::LCWriter * writer = IOIMPL::LCFactory::getInstance()->createLCWriter();
+		writer->open(filename, EVENT::LCIO::WRITE_NEW);
+		IMPL::LCRunHeaderImpl header;
+		header.setRunNumber(1);
+		writer->writeRunHeader(&header);
+		for(size_t ii = 0; ii < eventNumbers.size(); ii++) {
+			IMPL::LCEventImpl event;
+			event.setRunNumber(1);
+			event.setEventNumber(eventNumbers[ii]);
+			event.parameters().setValue("record", static_cast<int>(ii));
+			writer->writeEvent(&event);
+		}
+		writer->close();
+		delete writer;
+	}
+
+	virtual void TearDown() {
+		std::remove(filename.c_str());
+	}
+
+	// The position in the file of the event, -1 for no event
+	static int record(lcio::LCEvent * event) {
+		return event == nullptr ? -1 : event->getParameters().getIntVal("record");
+	}
+
+	std::string filename;
+	std::vector<int> eventNumbers;
+};
+
+/** Events by position are the records of the file in file order, also reading backwards and
+ *  with read ahead. Past the last record there is no event.
+ */
+TEST_F(alibavaTelescopeReaderTest, Positions) {
+	for(unsigned int readAhead : {0u, 3u}) {
+		SCOPED_TRACE(testing::Message() << "read ahead " << readAhead);
+		AlibavaTelescopeReader reader;
+		ASSERT_TRUE(reader.open(filename, readAhead, false));
+		for(size_t ii = 0; ii < eventNumbers.size(); ii++) {
+			lcio::LCEvent * event = reader.getEventAt(ii);
+			ASSERT_EQ(static_cast<int>(ii), record(event));
+			EXPECT_EQ(eventNumbers[ii], event->getEventNumber());
+		}
+		EXPECT_EQ(-1, record(reader.getEventAt(eventNumbers.size())));
+		EXPECT_EQ(-1, record(reader.getEventAt(eventNumbers.size() + 5)));
+
+		// backwards, onto records with a repeated number
+		for(size_t ii = eventNumbers.size(); ii > 0; ii--) {
+			EXPECT_EQ(static_cast<int>(ii - 1), record(reader.getEventAt(ii - 1)));
+		}
+		// skipping forward
+		EXPECT_EQ(2, record(reader.getEventAt(2)));
+		EXPECT_EQ(5, record(reader.getEventAt(5)));
+		EXPECT_EQ(1, record(reader.getEventAt(1)));
+		EXPECT_EQ(7, record(reader.getEventAt(7)));
+	}
+}
+
+/** Events by number take the first record with that number in the file, the repeated numbers
+ *  are counted. Without the index no event is found by number.
+ */
+TEST_F(alibavaTelescopeReaderTest, EventNumbers) {
+	for(unsigned int readAhead : {0u, 3u}) {
+		SCOPED_TRACE(testing::Message() << "read ahead " << readAhead);
+		AlibavaTelescopeReader reader;
+		ASSERT_TRUE(reader.open(filename, readAhead, true));
+		EXPECT_EQ(2, reader.getNumberOfDuplicates());
+		EXPECT_EQ(4, record(reader.getEventByNumber(1)));
+		EXPECT_EQ(7, record(reader.getEventByNumber(2)));
+		EXPECT_EQ(1, record(reader.getEventByNumber(3)));
+		EXPECT_EQ(0, record(reader.getEventByNumber(5)));
+		EXPECT_EQ(3, record(reader.getEventByNumber(7)));
+		EXPECT_EQ(6, record(reader.getEventByNumber(9)));
+		EXPECT_EQ(-1, record(reader.getEventByNumber(4)));
+
+		// the index does not change the positions
+		EXPECT_EQ(2, record(reader.getEventAt(2)));
+		EXPECT_EQ(5, record(reader.getEventAt(5)));
+		EXPECT_EQ(-1, record(reader.getEventAt(eventNumbers.size())));
+	}
+
+	AlibavaTelescopeReader reader;
+	ASSERT_TRUE(reader.open(filename, 0, false));
+	EXPECT_EQ(0, reader.getNumberOfDuplicates());
+	EXPECT_EQ(-1, record(reader.getEventByNumber(5)));
+	EXPECT_EQ(0, record(reader.getEventAt(0)));
+}
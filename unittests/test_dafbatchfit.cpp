@@ -0,0 +1,163 @@
+//STL
+#include <random>
+#include <cmath>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTelDafTrackerSystem.h"
+#include "eutelrandomevents.h"
+
+typedef daffitter::TrackerSystem<float, 4> System;
+typedef daffitter::TrackCandidate<float, 4> Candidate;
+
+// Equal to the last bit, a NaN only matches a NaN
+static bool same(float a, float b) {
+	return a == b or (std::isnan(a) and std::isnan(b));
+}
+
+// The fixture for testing the batched DAF fit against the scalar one, on six telescope planes
+// and an excluded DUT.
+class dafBatchFitTest : public ::testing::Test {
+protected:
+
+	dafBatchFitTest() : telescope(10.0, 0.002, 0.0043) {
+		std::vector<double> z;
+		for(int ii = 0; ii < 7; ii++) {
+			system.addPlane(ii, ii * 150.0, 0.0043, 0.0043, 1e-7, ii == 3);
+			z.push_back(system.planes[ii].getZpos());
+		}
+		system.setMaxCandidates(10000);
+		system.init(true);
+		system.setClusterRadius(0.3);
+		system.setMinClusterSize(3);
+		system.setDAFChi2Cut(50.0);
+		telescope.setPlanes(z);
+	}
+
+	virtual void SetUp() {
+		generator.seed(eutelrandom::seed);
+	}
+
+	// Fills the planes with a random event and finds the candidates. A quarter of the tracks
+	// are 50% efficient, so some candidates have only a few hits.
+	void fillEvent(size_t nTracks, size_t nNoise) {
+		telescope.clear();
+		telescope.addTracks(generator, nTracks / 4, 0.5);
+		telescope.addTracks(generator, nTracks - nTracks / 4, 0.95);
+		telescope.addNoise(generator, nNoise);
+		system.clear();
+		for(size_t ii = 0; ii < system.planes.size(); ii++) {
+			for(size_t hh = 0; hh < telescope.x[ii].size(); hh++) {
+				system.addMeasurement(ii, telescope.x[ii][hh], telescope.y[ii][hh], system.planes[ii].getZpos(), true, telescope.label[ii][hh]);
+			}
+		}
+		system.clusterTracker();
+	}
+
+	// Fits all candidates with both fitters and requires the same results to the last bit: both run the
+	// same operations in the same order, so also candidates mixing noise hits anneal alike.
+	void compare() {
+		std::vector<Candidate> batched(system.tracks.begin(), system.tracks.begin() + system.getNtracks());
+		std::vector<float> startZ;
+		for(size_t ii = 0; ii < system.planes.size(); ii++) {
+			startZ.push_back(system.planes[ii].getMeasZ());
+		}
+
+		// Scalar fit, every candidate starting from the same plane positions as a lane of the batch
+		std::vector<std::vector<float> > scalarZ;
+		for(size_t tt = 0; tt < system.getNtracks(); tt++) {
+			for(size_t ii = 0; ii < system.planes.size(); ii++) {
+				system.planes[ii].setMeasZ(startZ[ii]);
+			}
+			system.fitPlanesInfoDaf(system.tracks[tt]);
+			std::vector<float> z;
+			for(size_t ii = 0; ii < system.planes.size(); ii++) {
+				z.push_back(system.planes[ii].getMeasZ());
+			}
+			scalarZ.push_back(z);
+		}
+		std::vector<Candidate> scalar(system.tracks.begin(), system.tracks.begin() + system.getNtracks());
+
+		std::copy(batched.begin(), batched.end(), system.tracks.begin());
+		size_t batchEnd = 0;
+		for(size_t tt = 0; tt < system.getNtracks(); tt++) {
+			if(tt == batchEnd) {
+				for(size_t ii = 0; ii < system.planes.size(); ii++) {
+					system.planes[ii].setMeasZ(startZ[ii]);
+				}
+				batchEnd = tt + system.fitPlanesInfoDafBatch(tt);
+			}
+			system.loadBatchPlanes(tt);
+			const Candidate& a = scalar[tt];
+			const Candidate& b = system.tracks[tt];
+			SCOPED_TRACE(testing::Message() << "candidate " << tt);
+			ASSERT_PRED2(same, a.ndof, b.ndof);
+			ASSERT_PRED2(same, a.chi2, b.chi2);
+			for(size_t ii = 0; ii < system.planes.size(); ii++) {
+				ASSERT_EQ(a.weights[ii].size(), b.weights[ii].size());
+				for(int mm = 0; mm < a.weights[ii].size(); mm++) {
+					ASSERT_PRED2(same, a.weights[ii](mm), b.weights[ii](mm));
+				}
+				// A candidate that leaves the annealing early has no estimates. In its last iteration the
+				// scalar fit skips the smoothing and moves the planes with the smoothed estimates left
+				// over from an earlier fit, so its plane positions are not a result.
+				if(not (a.ndof > -1.9f)) continue;
+				ASSERT_PRED2(same, scalarZ[tt][ii], system.planes[ii].getMeasZ());
+				ASSERT_EQ(a.indexes[ii], b.indexes[ii]);
+				for(int pp = 0; pp < 4; pp++) {
+					ASSERT_PRED2(same, a.estimates[ii].params(pp), b.estimates[ii].params(pp));
+					for(int qq = 0; qq < 4; qq++) {
+						ASSERT_PRED2(same, a.estimates[ii].cov(pp, qq), b.estimates[ii].cov(pp, qq));
+					}
+				}
+			}
+		}
+	}
+
+	std::default_random_engine generator;
+	eutelrandom::TelescopeEvent telescope;
+	System system;
+};
+
+/** Multi-track events, batches with candidates leaving the annealing early.
+ */
+TEST_F(dafBatchFitTest, MultiTrackEvents) {
+	for(size_t event = 0; event < 50; event++) {
+		fillEvent(1 + event % 20, 0);
+		compare();
+	}
+}
+
+/** Multi-track events with noise hits, every candidate is compared.
+ */
+TEST_F(dafBatchFitTest, NoisyEvents) {
+	for(size_t event = 0; event < 50; event++) {
+		fillEvent(1 + event % 40, 2 * event);
+		compare();
+	}
+}
+
+/** A tilted plane, where the measurement z position of each lane follows its own track.
+ */
+TEST_F(dafBatchFitTest, TiltedPlane) {
+	Eigen::Matrix<float, 3, 1> norm(0.2, -0.1, 1.0);
+	system.planes[2].setPlaneNorm(norm);
+	for(size_t event = 0; event < 20; event++) {
+		fillEvent(15, 0);
+		compare();
+	}
+}
+
+/** Batch sizes that do not divide the number of candidates, down to a single lane.
+ */
+TEST_F(dafBatchFitTest, BatchSizes) {
+	const size_t sizes [] = {1, 3, 7, 64};
+	for(size_t size: sizes) {
+		system.setDafBatchSize(size);
+		fillEvent(20, 0);
+		compare();
+	}
+}
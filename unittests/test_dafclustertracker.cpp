@@ -0,0 +1,310 @@
+//STL
+#include <cmath>
+#include <random>
+#include <list>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTelDafTrackerSystem.h"
+#include "eutelrandomevents.h"
+
+typedef daffitter::TrackerSystem<float, 4> System;
+typedef daffitter::PlaneHit<float> Hit;
+
+// The fixture for testing the track finders of the DAF tracker system: six telescope planes
+// around a DUT they ignore, positions in mm.
+class dafClusterTrackerTest : public ::testing::Test {
+protected:
+
+	dafClusterTrackerTest() : telescope(10.0, 0.002, 0.01) {
+		std::vector<double> z;
+		for(int ii = 0; ii < 7; ii++) {
+			system.addPlane(ii, ii * 150.0, 0.0043, 0.0043, 1e-7, ii == 3);
+			z.push_back(system.planes[ii].getZpos());
+		}
+		telescope.setPlanes(z);
+		system.setMaxCandidates(10000);
+		system.init(true);
+		system.setClusterRadius(0.3);
+		system.setNominalXdz(0.001);
+		system.setNominalYdz(-0.002);
+		system.setMinClusterSize(4);
+	}
+
+	virtual void SetUp() {
+		generator.seed(eutelrandom::seed);
+	}
+
+	// Fills the planes with a random event of 95% efficient tracks and noise
+	void fillEvent(size_t nTracks, size_t nNoise) {
+		telescope.clear();
+		telescope.addTracks(generator, nTracks, 0.95);
+		telescope.addNoise(generator, nNoise);
+		system.clear();
+		for(size_t ii = 0; ii < system.planes.size(); ii++) {
+			for(size_t hh = 0; hh < telescope.x[ii].size(); hh++) {
+				system.addMeasurement(ii, telescope.x[ii][hh], telescope.y[ii][hh], system.planes[ii].getZpos(), true, telescope.label[ii][hh]);
+			}
+		}
+	}
+
+	// The cluster tracker as it was: grow each candidate by rescanning the remaining hits until nothing is added.
+	// Returns one weight vector per plane and candidate.
+	std::vector<std::vector<std::vector<float> > > reference(float sqrClusterRadius, size_t minClusterSize) {
+		std::list<Hit> availableHits;
+		for(size_t ii = 0; ii < system.planes.size(); ii++) {
+			if(system.planes[ii].isExcluded()) continue;
+			float xShift = -1 * system.getNominalXdz() * system.planes[ii].getZpos();
+			float yShift = -1 * system.getNominalYdz() * system.planes[ii].getZpos();
+			for(size_t mm = 0; mm < system.planes[ii].meas.size(); mm++) {
+				availableHits.push_back(Hit(system.planes[ii].meas[mm].getX() + xShift, system.planes[ii].meas[mm].getY() + yShift, ii, mm));
+			}
+		}
+
+		std::vector<std::vector<std::vector<float> > > candidates;
+		while(not availableHits.empty()) {
+			std::vector<Hit> candidate;
+			candidate.push_back(availableHits.front());
+			availableHits.pop_front();
+			int counter = 1;
+			while(counter > 0) {
+				counter = 0;
+				for(std::list<Hit>::iterator hit = availableHits.begin(); hit != availableHits.end(); hit++) {
+					for(std::vector<Hit>::iterator cand = candidate.begin(); cand != candidate.end(); cand++) {
+						Eigen::Matrix<float, 2, 1> resids = (*hit).getM() - (*cand).getM();
+						if(resids.squaredNorm() > sqrClusterRadius) continue;
+						candidate.push_back(*hit);
+						hit = availableHits.erase(hit);
+						counter++;
+						break;
+					}
+				}
+			}
+			if(candidate.size() < minClusterSize) continue;
+
+			std::vector<std::vector<float> > weights(system.planes.size());
+			for(size_t ii = 0; ii < system.planes.size(); ii++) {
+				weights[ii].assign(system.planes[ii].meas.size(), 0.0);
+			}
+			for(size_t ii = 0; ii < candidate.size(); ii++) {
+				weights[candidate[ii].getPlane()][candidate[ii].getIndex()] = 1.0;
+			}
+			candidates.push_back(weights);
+		}
+		return candidates;
+	}
+
+	// Runs both trackers on the current event and compares the candidates, including their order
+	void compare(float clusterRadius, size_t minClusterSize) {
+		system.setClusterRadius(clusterRadius);
+		system.setMinClusterSize(minClusterSize);
+		std::vector<std::vector<std::vector<float> > > expected = reference(clusterRadius * clusterRadius, minClusterSize);
+
+		system.clusterTracker();
+		ASSERT_EQ(expected.size(), system.getNtracks());
+		for(size_t tt = 0; tt < expected.size(); tt++) {
+			for(size_t ii = 0; ii < system.planes.size(); ii++) {
+				ASSERT_EQ(static_cast<long>(expected[tt][ii].size()), system.tracks[tt].weights[ii].size());
+				for(size_t mm = 0; mm < expected[tt][ii].size(); mm++) {
+					ASSERT_EQ(expected[tt][ii][mm], system.tracks[tt].weights[ii](mm));
+				}
+			}
+		}
+	}
+
+	std::default_random_engine generator;
+	eutelrandom::TelescopeEvent telescope;
+	System system;
+};
+
+/** Multi-track events with noise: the candidates must be the same as with the old cluster tracker.
+ */
+TEST_F(dafClusterTrackerTest, MultiTrackEvents) {
+	for(size_t event = 0; event < 50; event++) {
+		fillEvent(1 + event % 20, 3 * event);
+		compare(0.3, 4);
+	}
+}
+
+/** High rate events, where the clusters of neighbouring tracks merge.
+ */
+TEST_F(dafClusterTrackerTest, HighRateEvents) {
+	for(size_t event = 0; event < 10; event++) {
+		fillEvent(200, 300);
+		compare(0.3, 4);
+		fillEvent(200, 300);
+		compare(1.0, 3);
+	}
+}
+
+/** Cluster radius of zero: only hits at the same position are joined.
+ */
+TEST_F(dafClusterTrackerTest, ZeroRadius) {
+	fillEvent(10, 10);
+	compare(0.0, 1);
+}
+
+// The combinatorial KF before the search windows and the chi2/ndof pruning: every hit of a plane is tried on every
+// branch. Kept here to check that the pruned search finds the same tracks, in the same order.
+class dafCKFTest : public dafClusterTrackerTest {
+protected:
+
+	typedef daffitter::TrackEstimate<float, 4> Estimate;
+
+	struct FoundTrack {
+		std::vector<int> indexes;
+		float chi2;
+		float ndof;
+	};
+
+	void setCuts(float ckfChi2, float chi2OverNdof, float slopeDeviance) {
+		system.setCKFChi2Cut(ckfChi2);
+		system.setChi2OverNdofCut(chi2OverNdof);
+		system.setXdzMaxDeviance(slopeDeviance);
+		system.setYdzMaxDeviance(slopeDeviance);
+	}
+
+	void referenceCKF() {
+		found.clear();
+		std::vector<int> indexes(system.planes.size(), -1);
+		Estimate e;
+		for(size_t ii = 0; ii < skipMax + 1; ii++) {
+			if(ii > 0) indexes[ii - 1] = -1;
+			for(size_t hit = 0; hit < system.planes[ii].meas.size(); hit++) {
+				if(ii > 0 and isUsed(ii, hit)) continue;
+				e.makeSeedInfo();
+				indexes[ii] = hit;
+				system.m_fitter.updateInfo(system.planes[ii], hit, e);
+				referencePermutation(ii + 1, e, ii, indexes, 1, 0.0f);
+			}
+		}
+	}
+
+	bool isUsed(size_t plane, size_t hit) const {
+		for(size_t tt = 0; tt < found.size(); tt++) {
+			if(found[tt].indexes[plane] == static_cast<int>(hit)) return true;
+		}
+		return false;
+	}
+
+	void referenceFinalize(Estimate & est, const std::vector<int> & indexes, int nMeas, float chi2) {
+		daffitter::fastInvert(est.cov);
+		est.params = est.cov * est.params;
+		if(std::fabs(est.getXdz() - system.getNominalXdz()) > system.getXdzMaxDeviance() or
+		   std::fabs(est.getYdz() - system.getNominalYdz()) > system.getYdzMaxDeviance()) return;
+		FoundTrack track;
+		track.ndof = nMeas * 2 - 4;
+		track.chi2 = chi2;
+		if(track.chi2 / track.ndof > system.getChi2OverNdofCut()) return;
+		track.indexes = indexes;
+		found.push_back(track);
+	}
+
+	void referencePermutation(size_t plane, Estimate & est, size_t nSkipped, std::vector<int> & indexes, int nMeas, float chi2) {
+		if(found.size() >= maxCandidates) return;
+		if(plane == system.planes.size()) {
+			referenceFinalize(est, indexes, nMeas, chi2);
+			return;
+		}
+		if(nMeas > 1) system.m_fitter.addScatteringInfo(system.planes[plane - 1], est);
+		system.m_fitter.predictInfo(system.planes[plane - 1], system.planes[plane], est);
+		if(system.planes[plane].isExcluded()) {
+			indexes[plane] = -1;
+			referencePermutation(plane + 1, est, nSkipped, indexes, nMeas, chi2);
+			return;
+		}
+
+		size_t nFound = found.size();
+		Eigen::Matrix<float, 2, 1> resv, errv;
+		Eigen::Matrix<float, 4, 1> state;
+		double chi2m = 0;
+		double oldX(0.0), oldY(0.0), oldZ(0.0);
+		if(nMeas > 1) {
+			Eigen::Matrix<float, 4, 4> tmp4x4 = est.cov;
+			daffitter::fastInvert(tmp4x4);
+			state = tmp4x4 * est.params;
+			errv = system.planes[plane].getSigmas().array().square() + tmp4x4.diagonal().head(2).array();
+		}
+		if(nMeas == 1) {
+			for(size_t ii = 0; ii < plane; ii++) {
+				if(indexes[ii] < 0) continue;
+				oldX = system.planes[ii].meas[indexes[ii]].getX();
+				oldY = system.planes[ii].meas[indexes[ii]].getY();
+				oldZ = system.planes[ii].getZpos();
+				break;
+			}
+		}
+
+		for(size_t hit = 0; hit < system.planes[plane].meas.size(); hit++) {
+			daffitter::Measurement<float> & mm = system.planes[plane].meas[hit];
+			bool filterMeas = false;
+			if(nMeas > 1) {
+				resv = (state.head(2) - mm.getM()).array().square();
+				chi2m = (resv.array() / errv.array()).sum();
+				filterMeas = chi2m < system.getCKFChi2Cut();
+			} else if(nMeas == 1) {
+				double newZ = system.planes[plane].getZpos();
+				filterMeas = std::fabs((mm.getX() - oldX) / (newZ - oldZ) - system.getNominalXdz()) < system.getXdzMaxDeviance() and
+				             std::fabs((mm.getY() - oldY) / (newZ - oldZ) - system.getNominalYdz()) < system.getYdzMaxDeviance();
+			}
+			if(filterMeas) {
+				Estimate clone(est);
+				system.m_fitter.updateInfo(system.planes[plane], hit, clone);
+				indexes[plane] = hit;
+				referencePermutation(plane + 1, clone, nSkipped, indexes, nMeas + 1, chi2 + chi2m);
+			}
+		}
+		if(nFound == found.size() and nSkipped < skipMax) {
+			indexes[plane] = -1;
+			referencePermutation(plane + 1, est, nSkipped + 1, indexes, nMeas, chi2);
+		}
+	}
+
+	// Runs both searches on the current event and compares the tracks, including their order
+	void compare() {
+		referenceCKF();
+		ASSERT_LT(found.size(), maxCandidates) << "the event is too busy to compare all tracks";
+		system.combinatorialKF();
+		ASSERT_EQ(found.size(), system.getNtracks());
+		for(size_t tt = 0; tt < found.size(); tt++) {
+			SCOPED_TRACE(testing::Message() << "track " << tt);
+			EXPECT_EQ(found[tt].chi2, system.tracks[tt].chi2);
+			EXPECT_EQ(found[tt].ndof, system.tracks[tt].ndof);
+			for(size_t ii = 0; ii < system.planes.size(); ii++) {
+				ASSERT_EQ(found[tt].indexes[ii], system.tracks[tt].indexes[ii]) << "plane " << ii;
+			}
+		}
+	}
+
+	// The TrackerSystem defaults, setMaxCandidates(10000) in the fixture
+	const size_t skipMax = 2;
+	const size_t maxCandidates = 10000;
+	std::vector<FoundTrack> found;
+};
+
+/** All cuts open: every combination of hits is a track, the search windows and the pruning must not lose any.
+ */
+TEST_F(dafCKFTest, OpenCuts) {
+	setCuts(1e30, 1e30, 1e3);
+	for(size_t event = 0; event < 40; event++) {
+		SCOPED_TRACE(testing::Message() << "event " << event);
+		fillEvent(1 + event % 3, event % 4);
+		compare();
+	}
+}
+
+/** Cuts as in the processor, up to tight ones where most seeds die or skip planes.
+ */
+TEST_F(dafCKFTest, ActiveCuts) {
+	for(size_t event = 0; event < 60; event++) {
+		SCOPED_TRACE(testing::Message() << "event " << event);
+		fillEvent(1 + event % 30, 2 * event);
+		if(event % 3 == 0) setCuts(30.0, 10.0, 0.01);
+		if(event % 3 == 1) setCuts(10.0, 5.0, 0.005);
+		if(event % 3 == 2) setCuts(3.0, 1.0, 0.002);
+		compare();
+	}
+}
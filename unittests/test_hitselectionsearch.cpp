@@ -0,0 +1,326 @@
+//STL
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTelHitSelectionSearch.h"
+#include "eutelrandomevents.h"
+
+using eutelescope::EUTelHitSelectionSearch;
+
+namespace {
+
+	struct SearchConfig {
+		std::vector<bool> isActive;
+		int allowMissingHits;
+		int allowSkipHits;
+		double missingHitPenalty;
+		double skipHitPenalty;
+		double chi2Min;
+		double chi2Max;
+		bool useBeamConstraint;
+		double maxDistance;
+	};
+
+	struct AcceptedFit {
+		std::vector<int> hits;
+		int nFired;
+		double chi2;
+		double penalty;
+	};
+
+	// Straight line least squares fit in x and y, the preselection cuts on the distance to the first hit
+	class LineFitter : public EUTelHitSelectionSearch::Fitter {
+	public:
+		LineFitter(const std::vector<double> & z, const std::vector<std::vector<double> > & x,
+		           const std::vector<std::vector<double> > & y, double sigma, double maxDistance)
+		  : z(z), x(x), y(y), sigma(sigma), maxDistance(maxDistance), nFits(0) {}
+
+		virtual int preselect(const std::vector<int> & hits) {
+			int first = -1;
+			for(size_t ipl = 0; ipl < hits.size(); ipl++) {
+				if(hits[ipl] < 0) continue;
+				if(first < 0) {
+					first = ipl;
+				} else if(std::abs(x[ipl][hits[ipl]] - x[first][hits[first]]) > maxDistance ||
+				          std::abs(y[ipl][hits[ipl]] - y[first][hits[first]]) > maxDistance) {
+					return ipl;
+				}
+			}
+			return 0;
+		}
+
+		virtual double fit(const std::vector<int> & hits, int) {
+			nFits++;
+			return lineChi2(hits, x) + lineChi2(hits, y);
+		}
+
+		virtual void accept(const std::vector<int> & hits, int nFired, double chi2, double penalty) {
+			AcceptedFit fit = {hits, nFired, chi2, penalty};
+			accepted.push_back(fit);
+		}
+
+		double lineChi2(const std::vector<int> & hits, const std::vector<std::vector<double> > & pos) const {
+			double n = 0, sz = 0, szz = 0, sp = 0, szp = 0;
+			for(size_t ipl = 0; ipl < hits.size(); ipl++) {
+				if(hits[ipl] < 0) continue;
+				double p = pos[ipl][hits[ipl]];
+				n += 1;
+				sz += z[ipl];
+				szz += z[ipl] * z[ipl];
+				sp += p;
+				szp += z[ipl] * p;
+			}
+			double slope = (n * szp - sz * sp) / (n * szz - sz * sz);
+			double offset = (sp - slope * sz) / n;
+			double chi2 = 0;
+			for(size_t ipl = 0; ipl < hits.size(); ipl++) {
+				if(hits[ipl] < 0) continue;
+				double residual = (pos[ipl][hits[ipl]] - offset - slope * z[ipl]) / sigma;
+				chi2 += residual * residual;
+			}
+			return chi2;
+		}
+
+		const std::vector<double> & z;
+		const std::vector<std::vector<double> > & x;
+		const std::vector<std::vector<double> > & y;
+		double sigma;
+		double maxDistance;
+		long nFits;
+		std::vector<AcceptedFit> accepted;
+	};
+
+	// The loop of EUTelTestFitter before the branch and bound: every hit selection is decoded in turn, only
+	// the failed chi2 cut, the preselection and too few planes skip the selections extending it.
+	double referenceSearch(const SearchConfig & config, const std::vector<int> & planeHits,
+	                       EUTelHitSelectionSearch::Fitter & fitter) {
+		typedef EUTelHitSelectionSearch::type_fitcount type_fitcount;
+		const int nTelPlanes = config.isActive.size();
+		int nActivePlanes = 0;
+		for(int ipl = 0; ipl < nTelPlanes; ipl++) {
+			if(config.isActive[ipl]) nActivePlanes++;
+		}
+		double chi2min = std::numeric_limits<double>::max();
+
+		std::vector<int> planeChoice(nTelPlanes);
+		std::vector<type_fitcount> planeMod(nTelPlanes);
+		int nFiredPlanes = 0;
+		type_fitcount nChoice = 1;
+		for(int ipl = nTelPlanes - 1; ipl >= 0; ipl--) {
+			planeChoice[ipl] = planeHits[ipl] > 0 ? planeHits[ipl] + 1 : 1;
+			if(planeHits[ipl] > 0) nFiredPlanes++;
+			planeMod[ipl] = nChoice;
+			nChoice *= planeChoice[ipl];
+		}
+		if(nFiredPlanes + config.allowMissingHits < nActivePlanes) return chi2min;
+
+		int istart = 0;
+		int nmiss = config.allowMissingHits;
+		while(nmiss > 0 || !config.isActive[istart]) {
+			if(config.isActive[istart]) nmiss--;
+			istart++;
+		}
+
+		std::vector<int> hits(nTelPlanes, -1);
+		for(type_fitcount ichoice = nChoice - planeMod[istart] - 1; ichoice >= 0; ichoice--) {
+			int nChoiceFired = 0;
+			int ilast = 0;
+			int nleft = 0;
+			for(int ipl = 0; ipl < nTelPlanes; ipl++) {
+				hits[ipl] = -1;
+				if(!config.isActive[ipl]) continue;
+				int ihit = (ichoice / planeMod[ipl]) % planeChoice[ipl];
+				if(ihit < planeHits[ipl]) {
+					hits[ipl] = ihit;
+					ilast = ipl;
+					nleft = 0;
+					nChoiceFired++;
+				} else {
+					nleft++;
+				}
+			}
+
+			if(nChoiceFired < 2) continue;
+			if(nChoiceFired == 2 && !config.useBeamConstraint && nChoiceFired + config.allowMissingHits < nActivePlanes) continue;
+			if(nChoiceFired + nleft < nActivePlanes - config.allowMissingHits) {
+				ichoice -= planeMod[ilast] - 1;
+				continue;
+			}
+			int firstFailed = fitter.preselect(hits);
+			if(firstFailed > 0) {
+				ichoice -= planeMod[firstFailed] - 1;
+				continue;
+			}
+
+			double choiceChi2 = fitter.fit(hits, nChoiceFired);
+			if(choiceChi2 < 0.) continue;
+			double penalty = (nActivePlanes - nFiredPlanes) * config.missingHitPenalty +
+			                 (nFiredPlanes - nChoiceFired) * config.skipHitPenalty;
+			double trackChi2 = choiceChi2 + penalty;
+			if(nChoiceFired + config.allowMissingHits >= nActivePlanes &&
+			   nChoiceFired + config.allowSkipHits >= nFiredPlanes && trackChi2 < chi2min) {
+				chi2min = trackChi2;
+			}
+			if(choiceChi2 >= config.chi2Max || choiceChi2 < config.chi2Min) {
+				ichoice -= planeMod[ilast] - 1;
+				continue;
+			}
+			if(nChoiceFired + config.allowMissingHits < nActivePlanes ||
+			   nChoiceFired + config.allowSkipHits < nFiredPlanes) continue;
+			if(trackChi2 < config.chi2Max && trackChi2 > config.chi2Min) {
+				fitter.accept(hits, nChoiceFired, trackChi2, penalty);
+			}
+		}
+		return chi2min;
+	}
+
+}
+
+// The fixture for testing the hit selection search of EUTelTestFitter, positions in mm.
+class hitSelectionSearchTest : public ::testing::Test {
+protected:
+
+	hitSelectionSearchTest() : sigma(0.0043), telescope(5.0, 0.0005, sigma) {}
+
+	virtual void SetUp() {
+		generator.seed(eutelrandom::seed);
+	}
+
+	// Fills a random event on planes 150 mm apart
+	void fillEvent(size_t nPlanes, size_t nTracks, size_t nNoise, double efficiency) {
+		if(telescope.z.size() != nPlanes) {
+			std::vector<double> z;
+			for(size_t ipl = 0; ipl < nPlanes; ipl++) z.push_back(150.0 * ipl);
+			telescope.setPlanes(z);
+		}
+		telescope.clear();
+		telescope.addTracks(generator, nTracks, efficiency);
+		telescope.addNoise(generator, nNoise);
+		planeHits.resize(nPlanes);
+		for(size_t ipl = 0; ipl < nPlanes; ipl++) planeHits[ipl] = telescope.x[ipl].size();
+	}
+
+	static EUTelHitSelectionSearch makeSearch(const SearchConfig & config) {
+		EUTelHitSelectionSearch search;
+		search.setActivePlanes(config.isActive);
+		search.setAllowedMissingHits(config.allowMissingHits);
+		search.setAllowedSkipHits(config.allowSkipHits);
+		search.setPenalties(config.missingHitPenalty, config.skipHitPenalty);
+		search.setChi2Limits(config.chi2Min, config.chi2Max);
+		search.setBeamConstraint(config.useBeamConstraint);
+		return search;
+	}
+
+	// Runs the search and the old loop on the current event: the accepted fits must be the same, in the same
+	// order, and the lowest chi2 too when a fit was accepted. Returns the number of accepted fits.
+	size_t compare(const SearchConfig & config) {
+		LineFitter expected(telescope.z, telescope.x, telescope.y, sigma, config.maxDistance);
+		double expectedChi2 = referenceSearch(config, planeHits, expected);
+		LineFitter found(telescope.z, telescope.x, telescope.y, sigma, config.maxDistance);
+		double chi2 = makeSearch(config).search(planeHits, found);
+
+		EXPECT_LE(found.nFits, expected.nFits);
+		EXPECT_EQ(expected.accepted.size(), found.accepted.size());
+		if(expected.accepted.size() != found.accepted.size()) return 0;
+		for(size_t ii = 0; ii < found.accepted.size(); ii++) {
+			EXPECT_EQ(expected.accepted[ii].hits, found.accepted[ii].hits) << "fit " << ii;
+			EXPECT_EQ(expected.accepted[ii].nFired, found.accepted[ii].nFired) << "fit " << ii;
+			EXPECT_EQ(expected.accepted[ii].chi2, found.accepted[ii].chi2) << "fit " << ii;
+			EXPECT_EQ(expected.accepted[ii].penalty, found.accepted[ii].penalty) << "fit " << ii;
+		}
+		if(!found.accepted.empty()) EXPECT_EQ(expectedChi2, chi2);
+		return found.accepted.size();
+	}
+
+	std::default_random_engine generator;
+	double sigma;
+	eutelrandom::TelescopeEvent telescope;
+	std::vector<int> planeHits;
+};
+
+/** Random events with missing and skipped hits allowed at various penalties and chi2 cuts, against the
+ *  old loop over all hit selections.
+ */
+TEST_F(hitSelectionSearchTest, RandomEvents) {
+	const std::vector<bool> six(6, true);
+	const SearchConfig configs[] = {
+		{six, 0, 0, 0., 100., 0., 100., false, 1000.},
+		{six, 1, 1, 0., 100., 0., 100., false, 1000.},
+		{six, 1, 1, 10., 20., 0., 100., false, 1000.},
+		{six, 2, 2, 5., 15., 0., 50., false, 0.5},
+		{six, 1, 0, 0., 100., 0., 1000., false, 1000.},
+		{six, 2, 1, 30., 5., 1., 40., true, 1000.},
+		{six, 3, 3, 0., 0., 0., 20., false, 1000.},
+	};
+	size_t nAccepted = 0;
+	for(size_t ic = 0; ic < sizeof(configs) / sizeof(configs[0]); ic++) {
+		for(size_t event = 0; event < 60; event++) {
+			SCOPED_TRACE(testing::Message() << "config " << ic << ", event " << event);
+			fillEvent(6, 1 + event % 5, event % 7, 0.9);
+			nAccepted += compare(configs[ic]);
+		}
+	}
+	EXPECT_GT(nAccepted, 0u);
+}
+
+/** Planes that are not active, as the DUT in the middle of the telescope, and empty planes.
+ */
+TEST_F(hitSelectionSearchTest, InactivePlanes) {
+	std::vector<bool> isActive(7, true);
+	isActive[3] = false;
+	const SearchConfig configs[] = {
+		{isActive, 1, 1, 10., 20., 0., 100., false, 1000.},
+		{isActive, 2, 0, 5., 100., 0., 60., false, 1000.},
+	};
+	for(size_t ic = 0; ic < sizeof(configs) / sizeof(configs[0]); ic++) {
+		for(size_t event = 0; event < 60; event++) {
+			SCOPED_TRACE(testing::Message() << "config " << ic << ", event " << event);
+			fillEvent(7, 1 + event % 4, event % 5, 0.7);
+			compare(configs[ic]);
+		}
+	}
+}
+
+/** Timing of the search versus the number of hits per plane, with missing and skipped hits allowed.
+ */
+TEST_F(hitSelectionSearchTest, DISABLED_BenchmarkMultiplicity) {
+	const std::vector<bool> six(6, true);
+	const SearchConfig configs[] = {
+		{six, 0, 0, 0., 100., 0., 100., false, 1000.},
+		{six, 1, 1, 0., 100., 0., 100., false, 1000.},
+		{six, 1, 0, 0., 100., 0., 1000., false, 1000.},
+	};
+	const size_t nEvents = 20;
+	for(size_t ic = 0; ic < sizeof(configs) / sizeof(configs[0]); ic++) {
+		const SearchConfig & config = configs[ic];
+		const EUTelHitSelectionSearch search = makeSearch(config);
+		std::cout << "AllowMissingHits " << config.allowMissingHits << ", AllowSkipHits " << config.allowSkipHits
+		          << ", Chi2Max " << config.chi2Max << std::endl;
+		for(size_t multiplicity : {1, 2, 4, 6, 8, 10}) {
+			double searchTime = 0, referenceTime = 0;
+			long searchFits = 0, referenceFits = 0;
+			for(size_t event = 0; event < nEvents; event++) {
+				fillEvent(6, multiplicity, 0, 0.97);
+				LineFitter reference(telescope.z, telescope.x, telescope.y, sigma, config.maxDistance);
+				LineFitter fitter(telescope.z, telescope.x, telescope.y, sigma, config.maxDistance);
+				eutelrandom::BenchmarkTimer timer;
+				referenceSearch(config, planeHits, reference);
+				referenceTime += timer.lap();
+				search.search(planeHits, fitter);
+				searchTime += timer.lap();
+				referenceFits += reference.nFits;
+				searchFits += fitter.nFits;
+			}
+			std::cout << "  " << multiplicity << " hits/plane: old loop " << referenceTime / nEvents << " us, "
+			          << referenceFits / nEvents << " fits; search " << searchTime / nEvents << " us, "
+			          << searchFits / nEvents << " fits" << std::endl;
+		}
+	}
+}
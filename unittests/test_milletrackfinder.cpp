@@ -0,0 +1,169 @@
+//STL
+#include <random>
+#include <cmath>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTelMilleTrackFinder.h"
+#include "eutelrandomevents.h"
+
+using eutelescope::EUTelMilleTrackFinder;
+
+// The fixture for testing the track candidate search of EUTelMille, positions in um as in EUTelMille.
+class milleTrackFinderTest : public ::testing::Test {
+protected:
+
+	milleTrackFinderTest() : telescope(10000.0, 0.002, 5.0) {
+		setWindows(6, 0.0, 300.0);
+	}
+
+	virtual void SetUp() {
+		generator.seed(eutelrandom::seed);
+	}
+
+	void setWindows(size_t nPlanes, double min, double max) {
+		xMin.assign(nPlanes, min);
+		xMax.assign(nPlanes, max);
+		yMin.assign(nPlanes, min);
+		yMax.assign(nPlanes, max);
+	}
+
+	// Fills a random event on planes 150 mm apart, the hits of a plane in random order
+	void fillEvent(size_t nPlanes, size_t nTracks, size_t nNoise, float efficiency) {
+		if(telescope.z.size() != nPlanes) {
+			std::vector<double> z;
+			for(size_t ii = 0; ii < nPlanes; ii++) z.push_back(ii * 150000.0);
+			telescope.setPlanes(z);
+		}
+		telescope.clear();
+		telescope.addTracks(generator, nTracks, efficiency);
+		telescope.addNoise(generator, nNoise);
+		telescope.shuffle(generator);
+	}
+
+	// The recursive search as it was in EUTelMille::findtracks2
+	void reference(int missinghits, std::vector<std::vector<int> > &indexarray, std::vector<int> vec, unsigned int i, int y) {
+		if(y == -1) missinghits++;
+		if(missinghits > allowedMissing) return;
+		if(i > 0) vec.push_back(y);
+		if((telescope.x[i].size() == 0) && (i < telescope.x.size() - 1)) {
+			reference(missinghits, indexarray, vec, i + 1, -1);
+		}
+		for(size_t j = 0; j < telescope.x[i].size(); j++) {
+			int ihit = static_cast<int>(j);
+			vec.push_back(ihit);
+			bool taketrack = true;
+			const int e = vec.size() - 2;
+			if(e >= 0) {
+				double residualX = -999999.;
+				double residualY = -999999.;
+				if(vec[e] >= 0) {
+					residualX = std::abs(telescope.x[e][vec[e]] - telescope.x[e + 1][vec[e + 1]]);
+					residualY = std::abs(telescope.y[e][vec[e]] - telescope.y[e + 1][vec[e + 1]]);
+				}
+				if(residualX < xMin[e] || residualX > xMax[e] || residualY < yMin[e] || residualY > yMax[e]) {
+					ihit = -1;
+				}
+			}
+			if(i < telescope.x.size() - 1) {
+				vec.pop_back();
+				reference(missinghits, indexarray, vec, i + 1, ihit);
+			} else {
+				if(indexarray.size() < maxCandidates) indexarray.push_back(vec);
+				vec.pop_back();
+			}
+		}
+		if((telescope.x[i].size() == 0) && (i >= telescope.x.size() - 1)) {
+			indexarray.push_back(vec);
+		}
+	}
+
+	// Runs both searches on the current event and compares the candidates, including their order
+	void compare() {
+		std::vector<std::vector<int> > expected;
+		reference(0, expected, std::vector<int>(), 0, 0);
+
+		EUTelMilleTrackFinder finder;
+		finder.setResidualWindows(xMin, xMax, yMin, yMax);
+		finder.setAllowedMissingHits(allowedMissing);
+		finder.setMaxCandidates(maxCandidates);
+		std::vector<std::vector<int> > candidates;
+		finder.findTracks(telescope.x, telescope.y, candidates);
+
+		ASSERT_EQ(expected.size(), candidates.size());
+		for(size_t tt = 0; tt < expected.size(); tt++) {
+			ASSERT_EQ(expected[tt], candidates[tt]);
+		}
+	}
+
+	std::default_random_engine generator;
+	eutelrandom::TelescopeEvent telescope;
+	std::vector<double> xMin, xMax, yMin, yMax;
+	int allowedMissing = 0;
+	size_t maxCandidates = 2000;
+};
+
+/** Multi-track events with noise and without missing hits, the default configuration.
+ */
+TEST_F(milleTrackFinderTest, NoMissingHits) {
+	for(size_t event = 0; event < 50; event++) {
+		fillEvent(6, 1 + event % 10, event, 0.98);
+		compare();
+	}
+}
+
+/** Inefficient planes with one or two missing hits allowed: the branches without hit
+ *  on a plane are repeated for every hit failing the cut.
+ */
+TEST_F(milleTrackFinderTest, MissingHits) {
+	for(allowedMissing = 1; allowedMissing <= 2; allowedMissing++) {
+		for(size_t event = 0; event < 50; event++) {
+			fillEvent(6, 1 + event % 5, event / 5, 0.8);
+			compare();
+		}
+	}
+}
+
+/** Busy events running into the limit on the number of candidates.
+ */
+TEST_F(milleTrackFinderTest, CandidateLimit) {
+	allowedMissing = 2;
+	maxCandidates = 50;
+	setWindows(6, 0.0, 3000.0);
+	for(size_t event = 0; event < 20; event++) {
+		fillEvent(6, 20, 20, 0.9);
+		compare();
+	}
+}
+
+/** Empty planes, including an empty last plane whose candidates are not limited.
+ */
+TEST_F(milleTrackFinderTest, EmptyPlanes) {
+	allowedMissing = 2;
+	maxCandidates = 5;
+	for(size_t event = 0; event < 20; event++) {
+		fillEvent(6, 3, 3, 0.9);
+		telescope.x[event % 6].clear();
+		telescope.y[event % 6].clear();
+		compare();
+	}
+}
+
+/** A window which accepts a missing previous hit and a lower residual cut.
+ */
+TEST_F(milleTrackFinderTest, UnusualWindows) {
+	allowedMissing = 1;
+	setWindows(6, -1e7, 300.0);
+	for(size_t event = 0; event < 20; event++) {
+		fillEvent(6, 3, 6, 0.8);
+		compare();
+	}
+	setWindows(6, 5.0, 300.0);
+	for(size_t event = 0; event < 20; event++) {
+		fillEvent(6, 3, 6, 0.8);
+		compare();
+	}
+}
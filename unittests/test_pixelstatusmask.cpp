@@ -0,0 +1,237 @@
+//STL
+#include <random>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTELESCOPE.h"
+#include "EUTelPixelStatusMask.h"
+#include "eutelrandomevents.h"
+
+using eutelescope::EUTelPixelBitmap;
+using eutelescope::EUTelPixelStatusMask;
+using eutelescope::EUTELESCOPE;
+
+// The fixture for testing the pixel status masks of EUTelClusteringProcessor on random sensor status.
+class pixelStatusMaskTest : public ::testing::Test {
+protected:
+
+	virtual void SetUp() {
+		generator.seed(eutelrandom::seed);
+	}
+
+	// A status vector with a fraction of bad pixels and some left over hit and missing pixels
+	std::vector<short> randomStatus(size_t nPixels, double badFraction) {
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		std::vector<short> status(nPixels, EUTELESCOPE::GOODPIXEL);
+		for(size_t ii = 0; ii < nPixels; ii++) {
+			double draw = uniform(generator);
+			if(draw < badFraction) {
+				status[ii] = draw < badFraction / 2 ? EUTELESCOPE::BADPIXEL : EUTELESCOPE::FIRINGPIXEL;
+			} else if(draw < badFraction + 0.01) {
+				status[ii] = EUTELESCOPE::HITPIXEL;
+			} else if(draw < badFraction + 0.02) {
+				status[ii] = EUTELESCOPE::MISSINGPIXEL;
+			}
+		}
+		return status;
+	}
+
+	// Compares the mask with the status vector as the clustering modified and reset it
+	void compare(const EUTelPixelStatusMask & mask, const std::vector<short> & status) {
+		ASSERT_EQ(status.size(), mask.size());
+		size_t next = mask.findGood(0);
+		for(size_t ii = 0; ii < status.size(); ii++) {
+			EXPECT_EQ(status[ii] == EUTELESCOPE::GOODPIXEL, mask.isGood(ii));
+			EXPECT_EQ(status[ii] == EUTELESCOPE::HITPIXEL, mask.isHit(ii));
+			EXPECT_EQ(status[ii] == EUTELESCOPE::MISSINGPIXEL, mask.isMissing(ii));
+			if(status[ii] == EUTELESCOPE::GOODPIXEL) {
+				ASSERT_EQ(ii, next);
+				next = mask.findGood(ii + 1);
+			}
+		}
+		EXPECT_EQ(status.size(), next);
+	}
+
+	// resetStatus of EUTelClusteringProcessor
+	void resetStatus(std::vector<short> & status) {
+		for(size_t ii = 0; ii < status.size(); ii++) {
+			if(status[ii] == EUTELESCOPE::HITPIXEL || status[ii] == EUTELESCOPE::MISSINGPIXEL) {
+				status[ii] = EUTELESCOPE::GOODPIXEL;
+			}
+		}
+	}
+
+	std::default_random_engine generator;
+};
+
+/** Setting, resetting and scanning single bits, also across word boundaries.
+ */
+TEST_F(pixelStatusMaskTest, Bitmap) {
+	EUTelPixelBitmap bitmap;
+	bitmap.resize(200);
+	EXPECT_EQ(200u, bitmap.size());
+	EXPECT_EQ(200u, bitmap.findNext(0));
+	const size_t bits[] = {0, 1, 63, 64, 127, 128, 199};
+	for(size_t bit : bits) bitmap.set(bit);
+	EXPECT_EQ(7u, bitmap.count());
+	size_t found = 0;
+	for(size_t bit : bits) {
+		found = bitmap.findNext(found);
+		EXPECT_EQ(bit, found);
+		EXPECT_TRUE(bitmap.test(found));
+		found++;
+	}
+	EXPECT_EQ(200u, bitmap.findNext(found));
+	bitmap.reset(63);
+	EXPECT_FALSE(bitmap.test(63));
+	EXPECT_EQ(64u, bitmap.findNext(2));
+
+	// shrinking drops the bits past the end, growing does not bring them back
+	bitmap.resize(100);
+	EXPECT_EQ(3u, bitmap.count());
+	bitmap.resize(200);
+	EXPECT_EQ(3u, bitmap.count());
+	EXPECT_EQ(200u, bitmap.findNext(65));
+
+	bitmap.clear();
+	EXPECT_EQ(0u, bitmap.count());
+	EXPECT_EQ(200u, bitmap.size());
+}
+
+/** Events of random clusters: the mask follows the status vector as written and
+ *  reset by the clustering, and the good pixel scan finds exactly the good pixels.
+ */
+TEST_F(pixelStatusMaskTest, Events) {
+	std::uniform_int_distribution<size_t> size(1, 5000);
+	for(size_t sensor = 0; sensor < 10; sensor++) {
+		std::vector<short> status = randomStatus(size(generator), 0.05 * sensor);
+		EUTelPixelStatusMask mask;
+		EXPECT_FALSE(mask.hasStatus());
+		mask.setStatus(status);
+		EXPECT_TRUE(mask.hasStatus());
+		resetStatus(status);
+		compare(mask, status);
+
+		std::uniform_int_distribution<size_t> pixel(0, status.size() - 1);
+		for(size_t event = 0; event < 20; event++) {
+			mask.clearEvent();
+			resetStatus(status);
+			for(size_t cluster = 0; cluster < 10; cluster++) {
+				// good pixels without data are marked missing, the good ones of a cluster hit
+				for(size_t ii = 0; ii < 3; ii++) {
+					size_t index = pixel(generator);
+					if(status[index] != EUTELESCOPE::GOODPIXEL) continue;
+					status[index] = EUTELESCOPE::MISSINGPIXEL;
+					mask.setMissing(index);
+				}
+				for(size_t ii = 0; ii < 9; ii++) {
+					size_t index = pixel(generator);
+					if(status[index] != EUTELESCOPE::GOODPIXEL && status[index] != EUTELESCOPE::MISSINGPIXEL) continue;
+					status[index] = EUTELESCOPE::HITPIXEL;
+					mask.setHit(index);
+				}
+			}
+			compare(mask, status);
+		}
+	}
+}
+
+/** The good pixel scan within candidate pixels, as the zero suppressed clustering
+ *  looks for seeds, finds exactly the good candidates. Candidates past the end of
+ *  the candidate bitmap or of the sensor are not found.
+ */
+TEST_F(pixelStatusMaskTest, Candidates) {
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	for(size_t sensor = 0; sensor < 10; sensor++) {
+		std::vector<short> status = randomStatus(3000 + 7 * sensor, 0.1);
+		EUTelPixelStatusMask mask;
+		mask.setStatus(status);
+		resetStatus(status);
+		for(size_t ii = 0; ii < status.size(); ii += 5) {
+			if(status[ii] == EUTELESCOPE::GOODPIXEL) {
+				status[ii] = EUTELESCOPE::HITPIXEL;
+				mask.setHit(ii);
+			}
+		}
+
+		// a shorter, an equal and a longer candidate bitmap
+		EUTelPixelBitmap candidates;
+		candidates.resize(status.size() - 1000 + 1000 * (sensor % 3));
+		for(size_t ii = 0; ii < candidates.size(); ii++) {
+			if(uniform(generator) < 0.02 * sensor) candidates.set(ii);
+		}
+
+		size_t next = mask.findGood(0, candidates);
+		for(size_t ii = 0; ii < status.size(); ii++) {
+			if(status[ii] == EUTELESCOPE::GOODPIXEL && ii < candidates.size() && candidates.test(ii)) {
+				ASSERT_EQ(ii, next);
+				next = mask.findGood(ii + 1, candidates);
+			}
+		}
+		EXPECT_EQ(status.size(), next);
+		EXPECT_EQ(status.size(), mask.findGood(status.size() + 100, candidates));
+	}
+}
+
+/** Hot pixels are kept apart from the status, also when the status is reloaded
+ *  or the sensor grows.
+ */
+TEST_F(pixelStatusMaskTest, HotPixels) {
+	EUTelPixelStatusMask mask;
+	mask.resize(1000);
+	mask.setHot(10);
+	mask.setHot(999);
+	EXPECT_FALSE(mask.hasStatus());
+	EXPECT_EQ(0u, mask.findGood(0));
+
+	std::vector<short> status = randomStatus(700, 0.2);
+	status[10] = EUTELESCOPE::GOODPIXEL;
+	mask.setStatus(status);
+	EXPECT_EQ(1000u, mask.size());
+	EXPECT_TRUE(mask.isHot(10));
+	EXPECT_TRUE(mask.isGood(10));
+	EXPECT_TRUE(mask.isHot(999));
+	EXPECT_FALSE(mask.isHot(11));
+
+	mask.resize(1500);
+	EXPECT_TRUE(mask.isHot(999));
+	EXPECT_TRUE(mask.isGood(1499));
+	EXPECT_FALSE(mask.isHot(1499));
+
+	mask.clearStatus();
+	EXPECT_FALSE(mask.hasStatus());
+	EXPECT_TRUE(mask.isHot(10));
+	EXPECT_EQ(0u, mask.findGood(0));
+}
+
+/** The mask recognises the status values it was loaded from, also in another vector,
+ *  and not once they were changed in place, as the clustering checks before reusing it.
+ */
+TEST_F(pixelStatusMaskTest, StatusChanges) {
+	std::vector<short> status = randomStatus(3000, 0.1);
+	status[100] = EUTELESCOPE::GOODPIXEL;
+	EUTelPixelStatusMask mask;
+	EXPECT_FALSE(mask.hasStatus(status));
+	mask.setStatus(status);
+	EXPECT_TRUE(mask.hasStatus(status));
+	const std::vector<short> copy(status);
+	EXPECT_TRUE(mask.hasStatus(copy));
+
+	status[100] = EUTELESCOPE::BADPIXEL;
+	EXPECT_FALSE(mask.hasStatus(status));
+	EXPECT_TRUE(mask.isGood(100));
+	mask.setHit(101);
+	mask.setStatus(status);
+	EXPECT_TRUE(mask.hasStatus(status));
+	EXPECT_TRUE(mask.isBad(100));
+	EXPECT_FALSE(mask.isHit(101));
+
+	status.push_back(EUTELESCOPE::GOODPIXEL);
+	EXPECT_FALSE(mask.hasStatus(status));
+
+	mask.clearStatus();
+	EXPECT_FALSE(mask.hasStatus(copy));
+}
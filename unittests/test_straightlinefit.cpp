@@ -0,0 +1,138 @@
+//STL
+#include <random>
+#include <cmath>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTelStraightLineFit.h"
+#include "eutelrandomevents.h"
+
+using eutelescope::EUTelStraightLineFit;
+
+// The fixture for testing the straight line fit of EUTelLineFit, positions in um.
+class straightLineFitTest : public ::testing::Test {
+protected:
+
+	straightLineFitTest() : telescope(10000.0, 0.002, 0.0) {}
+
+	virtual void SetUp() {
+		generator.seed(eutelrandom::seed);
+		// six planes, with different resolutions in X and Y
+		std::uniform_real_distribution<double> resolution(2.0, 10.0);
+		for(size_t ii = 0; ii < 6; ii++) {
+			zPos.push_back(ii * 150000.0 + (ii > 2 ? 50000.0 : 0.0));
+			resolX.push_back(resolution(generator));
+			resolY.push_back(resolution(generator));
+		}
+		fitter.setPlanes(zPos, resolX, resolY);
+		telescope.setPlanes(zPos, resolX, resolY);
+	}
+
+	// Fills nTracks random tracks with a hit on every plane, stored plane by plane as the fit takes them
+	void fillTracks(size_t nTracks) {
+		telescope.clear();
+		telescope.addTracks(generator, nTracks, 1.0);
+		xPos.resize(zPos.size() * nTracks);
+		yPos.resize(zPos.size() * nTracks);
+		for(size_t ii = 0; ii < zPos.size(); ii++) {
+			for(size_t tt = 0; tt < nTracks; tt++) {
+				xPos[ii * nTracks + tt] = telescope.x[ii][tt];
+				yPos[ii * nTracks + tt] = telescope.y[ii][tt];
+			}
+		}
+	}
+
+	// The fit as it was written in EUTelLineFit, for one coordinate of track tt
+	void reference(const std::vector<double> & pos, const std::vector<double> & resol, size_t nTracks, size_t tt,
+	               std::vector<double> & fitPos, double & slope, double & chi2) {
+		double S1 = 0, Sx = 0, Sy = 0, Sxybar = 0, Sxxbar = 0;
+		for(size_t ii = 0; ii < zPos.size(); ii++) {
+			S1 += 1 / pow(resol[ii], 2);
+			Sx += zPos[ii] / pow(resol[ii], 2);
+			Sy += pos[ii * nTracks + tt] / pow(resol[ii], 2);
+		}
+		double Xbar = Sx / S1;
+		double Ybar = Sy / S1;
+		for(size_t ii = 0; ii < zPos.size(); ii++) {
+			double Zbar = zPos[ii] - Xbar;
+			Sxybar += Zbar * pos[ii * nTracks + tt] / pow(resol[ii], 2);
+			Sxxbar += Zbar * Zbar / pow(resol[ii], 2);
+		}
+		slope = Sxybar / Sxxbar;
+		chi2 = 0;
+		fitPos.resize(zPos.size());
+		for(size_t ii = 0; ii < zPos.size(); ii++) {
+			fitPos[ii] = Ybar - Xbar * slope + zPos[ii] * slope;
+			chi2 += pow(fitPos[ii] - pos[ii * nTracks + tt], 2) / pow(resol[ii], 2);
+		}
+	}
+
+	// Fits all tracks at once and compares each track with the reference
+	void compare(size_t nTracks) {
+		fillTracks(nTracks);
+		std::vector<double> xFit(xPos.size()), yFit(yPos.size());
+		std::vector<double> xSlope(nTracks), ySlope(nTracks), xChi2(nTracks), yChi2(nTracks);
+		fitter.fitX(nTracks, xPos.data(), xFit.data(), xSlope.data(), xChi2.data());
+		fitter.fitY(nTracks, yPos.data(), yFit.data(), ySlope.data(), yChi2.data());
+
+		std::vector<double> fitPos;
+		double slope, chi2;
+		for(size_t tt = 0; tt < nTracks; tt++) {
+			reference(xPos, resolX, nTracks, tt, fitPos, slope, chi2);
+			EXPECT_NEAR(slope, xSlope[tt], 1e-12);
+			EXPECT_NEAR(chi2, xChi2[tt], 1e-9 * (1 + chi2));
+			for(size_t ii = 0; ii < zPos.size(); ii++) {
+				EXPECT_NEAR(fitPos[ii], xFit[ii * nTracks + tt], 1e-8);
+			}
+			reference(yPos, resolY, nTracks, tt, fitPos, slope, chi2);
+			EXPECT_NEAR(slope, ySlope[tt], 1e-12);
+			EXPECT_NEAR(chi2, yChi2[tt], 1e-9 * (1 + chi2));
+			for(size_t ii = 0; ii < zPos.size(); ii++) {
+				EXPECT_NEAR(fitPos[ii], yFit[ii * nTracks + tt], 1e-8);
+			}
+		}
+	}
+
+	std::default_random_engine generator;
+	eutelrandom::TelescopeEvent telescope;
+	EUTelStraightLineFit fitter;
+	std::vector<double> zPos, resolX, resolY;
+	std::vector<double> xPos, yPos;
+};
+
+/** Single tracks, as fitted event by event in EUTelLineFit.
+ */
+TEST_F(straightLineFitTest, SingleTrack) {
+	for(size_t event = 0; event < 100; event++) {
+		compare(1);
+	}
+}
+
+/** Batches of tracks of several sizes must give the same result as track by track.
+ */
+TEST_F(straightLineFitTest, Batches) {
+	for(size_t nTracks = 2; nTracks < 40; nTracks += 7) {
+		compare(nTracks);
+	}
+	compare(1000);
+}
+
+/** Points on a straight line are fitted exactly.
+ */
+TEST_F(straightLineFitTest, ExactLine) {
+	const size_t nPlanes = zPos.size();
+	std::vector<double> pos(nPlanes), fit(nPlanes);
+	for(size_t ii = 0; ii < nPlanes; ii++) {
+		pos[ii] = 100.0 - 0.001 * zPos[ii];
+	}
+	double slope, chi2;
+	fitter.fitX(1, pos.data(), fit.data(), &slope, &chi2);
+	EXPECT_NEAR(-0.001, slope, 1e-15);
+	EXPECT_NEAR(0.0, chi2, 1e-12);
+	for(size_t ii = 0; ii < nPlanes; ii++) {
+		EXPECT_NEAR(pos[ii], fit[ii], 1e-9);
+	}
+}
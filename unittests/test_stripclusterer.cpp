@@ -0,0 +1,192 @@
+//STL
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTelStripClusterer.h"
+#include "eutelrandomevents.h"
+
+using eutelescope::EUTelStripClusterer;
+typedef EUTelStripClusterer::StripCluster StripCluster;
+
+namespace {
+
+	// Random binary strips, each hit with the given probability
+	std::vector<float> randomStrips(std::default_random_engine & generator, int nStrips, double occupancy) {
+		std::bernoulli_distribution hit(occupancy);
+		std::vector<float> strips(nStrips, 0.0);
+		for(int ii = 0; ii < nStrips; ii++) {
+			if(hit(generator)) strips[ii] = 1.0;
+		}
+		return strips;
+	}
+
+	// The runs of hit strips found strip by strip, split into clusters of at most maxSize
+	std::vector<StripCluster> referenceClusters(const std::vector<float> & strips, int maxSize) {
+		std::vector<StripCluster> clusters;
+		const int nStrips = strips.size();
+		int strip = 0;
+		while(strip < nStrips) {
+			if(strips[strip] <= 0) {
+				strip++;
+				continue;
+			}
+			int last = strip;
+			while(last + 1 < nStrips && strips[last + 1] > 0) last++;
+			const int step = maxSize > 0 ? maxSize : last - strip + 1;
+			for(int first = strip; first <= last; first += step) {
+				StripCluster cluster;
+				cluster.first = first;
+				cluster.size = std::min(step, last - first + 1);
+				clusters.push_back(cluster);
+			}
+			strip = last + 1;
+		}
+		return clusters;
+	}
+
+	void compareClusters(const std::vector<StripCluster> & expected, const std::vector<StripCluster> & clusters) {
+		ASSERT_EQ(expected.size(), clusters.size());
+		for(size_t ii = 0; ii < clusters.size(); ii++) {
+			EXPECT_EQ(expected[ii].first, clusters[ii].first) << "cluster " << ii;
+			EXPECT_EQ(expected[ii].size, clusters[ii].size) << "cluster " << ii;
+		}
+	}
+
+	// The clustering core of CBCClustering before the packed engine: a cluster number per strip,
+	// then the strips of each cluster collected by a loop over all strips. Only used for the timing.
+	size_t oldClusteringCore(const std::vector<float> & strips, int maxSize) {
+		std::vector<int> clusterNumber(strips.size(), 0);
+		int nClusters = 0;
+		for(size_t ichan = 0; ichan < strips.size(); ichan++) {
+			if(strips[ichan] > 0) {
+				size_t left = ichan, right = ichan;
+				int size = 1;
+				nClusters++;
+				while(ichan + 1 < strips.size() - 1) {
+					ichan++;
+					if(strips[ichan] > 0 && size < maxSize) {
+						right = ichan;
+						size++;
+					} else {
+						break;
+					}
+				}
+				for(size_t k = left; k <= right; k++) clusterNumber[k] = nClusters;
+			}
+		}
+		size_t found = 0;
+		for(std::vector<int>::iterator it = clusterNumber.begin(); it != clusterNumber.end(); ++it) {
+			std::vector<float> cluster;
+			for(size_t j = 0; j < strips.size(); j++) {
+				if(clusterNumber[j] == *it && clusterNumber[j] > 0) {
+					cluster.push_back(j);
+					if(it != clusterNumber.end() - 1) ++it;
+				}
+			}
+			found += cluster.size();
+		}
+		return found;
+	}
+
+}
+
+/** Single runs at every position around the word boundaries: the run must be found
+ *  whole when it crosses from one word into the next, and split by maxSize.
+ */
+TEST(stripClustererTest, RunsAcrossWords) {
+	EUTelStripClusterer clusterer;
+	std::vector<StripCluster> clusters;
+	const int nStrips = 200;
+	for(int first = 0; first < nStrips; first++) {
+		for(int length = 1; length <= 70 && first + length <= nStrips; length++) {
+			std::vector<float> strips(nStrips, 0.0);
+			std::fill(strips.begin() + first, strips.begin() + first + length, 1.0);
+			for(int maxSize : {0, 1, 3, 64}) {
+				clusterer.setStrips(strips.data(), nStrips);
+				clusters.clear();
+				clusterer.findClusters(maxSize, clusters);
+				SCOPED_TRACE(testing::Message() << "run " << first << "+" << length << ", maxSize " << maxSize);
+				compareClusters(referenceClusters(strips, maxSize), clusters);
+			}
+		}
+	}
+}
+
+/** Sensors of random size and occupancy, filled from a dense strip vector or strip by strip,
+ *  against the strip by strip run search.
+ */
+TEST(stripClustererTest, RandomSensors) {
+	std::default_random_engine generator(eutelrandom::seed);
+	std::uniform_int_distribution<int> size(1, 1100);
+	std::uniform_int_distribution<int> maxSize(0, 6);
+	std::uniform_real_distribution<double> occupancy(0.0, 1.0);
+	EUTelStripClusterer clusterer;
+	std::vector<StripCluster> clusters;
+	for(size_t sensor = 0; sensor < 2000; sensor++) {
+		const int nStrips = size(generator);
+		const int maximum = maxSize(generator);
+		const std::vector<float> strips = randomStrips(generator, nStrips, occupancy(generator));
+		const std::vector<StripCluster> expected = referenceClusters(strips, maximum);
+		SCOPED_TRACE(testing::Message() << "sensor " << sensor << " with " << nStrips << " strips, maxSize " << maximum);
+
+		clusterer.setStrips(strips.data(), nStrips);
+		EXPECT_EQ(std::count_if(strips.begin(), strips.end(), [](float value) { return value > 0; }), clusterer.getNumberOfHits());
+		clusters.clear();
+		clusterer.findClusters(maximum, clusters);
+		compareClusters(expected, clusters);
+
+		// the ZS input sets the strips one by one, strips outside the sensor are ignored
+		clusterer.reset(nStrips);
+		clusterer.setStrip(-1);
+		clusterer.setStrip(nStrips);
+		for(int strip = 0; strip < nStrips; strip++) {
+			if(strips[strip] > 0) clusterer.setStrip(strip);
+		}
+		clusters.clear();
+		clusterer.findClusters(maximum, clusters);
+		compareClusters(expected, clusters);
+	}
+}
+
+/** Timing of the clustering of synthetic CBC modules, two sensors of 1016 strips,
+ *  versus the occupancy.
+ */
+TEST(stripClustererTest, DISABLED_BenchmarkModules) {
+	std::default_random_engine generator(eutelrandom::seed);
+	const int nStrips = 1016;
+	const int maxSize = 4;
+	const size_t nEvents = 2000;
+	EUTelStripClusterer clusterer;
+	std::vector<StripCluster> clusters;
+	for(double occupancy : {0.001, 0.01, 0.05, 0.2}) {
+		std::vector<std::vector<float>> sensors;
+		for(size_t ii = 0; ii < 64; ii++) sensors.push_back(randomStrips(generator, nStrips, occupancy));
+
+		size_t found = 0;
+		eutelrandom::BenchmarkTimer timer;
+		for(size_t event = 0; event < nEvents; event++) {
+			for(size_t sensor = 0; sensor < 2; sensor++) {
+				const std::vector<float> & strips = sensors[(2 * event + sensor) % sensors.size()];
+				clusterer.setStrips(strips.data(), nStrips);
+				clusters.clear();
+				clusterer.findClusters(maxSize, clusters);
+				found += clusters.size();
+			}
+		}
+		const double packed = timer.lap() / nEvents;
+		for(size_t event = 0; event < nEvents; event++) {
+			for(size_t sensor = 0; sensor < 2; sensor++) {
+				found += oldClusteringCore(sensors[(2 * event + sensor) % sensors.size()], maxSize);
+			}
+		}
+		const double old = timer.lap() / nEvents;
+		std::cout << "occupancy " << occupancy << ": packed " << packed << " us/module, old core " << old
+		          << " us/module, speed-up " << old / packed << " (" << found << ")" << std::endl;
+	}
+}
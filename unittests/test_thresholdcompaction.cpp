@@ -0,0 +1,160 @@
+//STL
+#include <iostream>
+#include <random>
+#include <vector>
+
+//GTest
+#include "gtest/gtest.h"
+
+//EUTelescope
+#include "EUTELESCOPE.h"
+#include "EUTelThresholdCompaction.h"
+#include "eutelrandomevents.h"
+
+using eutelescope::EUTELESCOPE;
+namespace compaction = eutelescope::ThresholdCompaction;
+
+// The fixture for testing the threshold compaction of EUTelRawDataSparsifier on random frames.
+class thresholdCompactionTest : public ::testing::Test {
+protected:
+
+	virtual void SetUp() {
+		generator.seed(eutelrandom::seed);
+	}
+
+	// Fills a random frame: gaussian pedestals and noise, a few pixels with a signal and a few bad pixels
+	void fillFrame(size_t noOfPixels) {
+		std::normal_distribution<float> pedestal(500.0, 30.0);
+		std::normal_distribution<float> noise(3.0, 0.5);
+		std::normal_distribution<float> gauss(0.0, 1.0);
+		std::uniform_real_distribution<float> uniform(0.0, 1.0);
+
+		adcValues.resize(noOfPixels);
+		pedestalValues.resize(noOfPixels);
+		noiseValues.resize(noOfPixels);
+		statusValues.resize(noOfPixels);
+
+		for(size_t i = 0; i < noOfPixels; i++) {
+			pedestalValues[i] = pedestal(generator);
+			noiseValues[i] = noise(generator);
+			float signal = noiseValues[i] * gauss(generator);
+			if(uniform(generator) < 0.02) signal += 50.0 * uniform(generator);
+			adcValues[i] = static_cast<short>(pedestalValues[i] + signal);
+			statusValues[i] = (uniform(generator) < 0.05) ? EUTELESCOPE::BADPIXEL : EUTELESCOPE::GOODPIXEL;
+		}
+	}
+
+	// The selection as it was done pixel by pixel in EUTelRawDataSparsifier
+	void reference(float sigmaCut, std::vector<int> & indices, std::vector<float> & signals) {
+		indices.clear();
+		signals.clear();
+		for(size_t i = 0; i < adcValues.size(); i++) {
+			if(statusValues[i] == EUTELESCOPE::GOODPIXEL) {
+				float data = adcValues[i] - pedestalValues[i];
+				float threshold = sigmaCut * noiseValues[i];
+				if(data > threshold) {
+					indices.push_back(i);
+					signals.push_back(data);
+				}
+			}
+		}
+	}
+
+	// Checks the implementation picked for this CPU and the scalar one against the pixel by pixel selection
+	void compare(float sigmaCut) {
+		std::vector<int> refIndices;
+		std::vector<float> refSignals;
+		reference(sigmaCut, refIndices, refSignals);
+
+		size_t noOfPixels = adcValues.size();
+		std::vector<int> indices(noOfPixels);
+		std::vector<float> signals(noOfPixels);
+
+		size_t count = compaction::compact(adcValues.data(), pedestalValues.data(), noiseValues.data(),
+		                                   statusValues.data(), noOfPixels, sigmaCut, indices.data(), signals.data());
+		ASSERT_EQ(refIndices.size(), count);
+		for(size_t i = 0; i < count; i++) {
+			ASSERT_EQ(refIndices[i], indices[i]);
+			ASSERT_EQ(refSignals[i], signals[i]);
+		}
+
+		count = compaction::compactScalar(adcValues.data(), pedestalValues.data(), noiseValues.data(),
+		                                  statusValues.data(), noOfPixels, sigmaCut, indices.data(), signals.data());
+		ASSERT_EQ(refIndices.size(), count);
+		for(size_t i = 0; i < count; i++) {
+			ASSERT_EQ(refIndices[i], indices[i]);
+			ASSERT_EQ(refSignals[i], signals[i]);
+		}
+	}
+
+	std::default_random_engine generator;
+	std::vector<short> adcValues;
+	std::vector<float> pedestalValues;
+	std::vector<float> noiseValues;
+	std::vector<short> statusValues;
+};
+
+/** Random full Mimosa26 frames (1152x576) at a few sigma cuts must give the same
+ *  pixels and signals as the pixel by pixel selection.
+ */
+TEST_F(thresholdCompactionTest, RandomFullFrames) {
+	const float sigmaCuts [] = {0.0, 2.5, 4.0, 10.0};
+	for(size_t iFrame = 0; iFrame < 5; iFrame++) {
+		fillFrame(1152 * 576);
+		for(float sigmaCut: sigmaCuts) {
+			compare(sigmaCut);
+		}
+	}
+}
+
+/** Frames whose size is not a multiple of the vector width, so the tail is
+ *  handled by the scalar part.
+ */
+TEST_F(thresholdCompactionTest, RandomOddFrames) {
+	for(size_t noOfPixels = 0; noOfPixels < 100; noOfPixels++) {
+		fillFrame(noOfPixels);
+		compare(2.5);
+	}
+}
+
+/** A negative cut lets every good pixel with a signal above the negative threshold through,
+ *  which fills whole vectors at once.
+ */
+TEST_F(thresholdCompactionTest, DenseSelection) {
+	fillFrame(4096);
+	compare(-100.0);
+}
+
+/** Timing of the compaction of a full Mimosa26 frame (1152x576) at a 4 sigma cut: the
+ *  pixel by pixel selection, the scalar fallback and the implementation picked for this
+ *  CPU (AVX2 if available).
+ */
+TEST_F(thresholdCompactionTest, DISABLED_BenchmarkFullFrame) {
+	const size_t noOfPixels = 1152 * 576;
+	const size_t noOfRepeats = 200;
+	const float sigmaCut = 4.0;
+	fillFrame(noOfPixels);
+	std::vector<int> refIndices, indices(noOfPixels);
+	std::vector<float> refSignals, signals(noOfPixels);
+	size_t count = 0;
+
+	eutelrandom::BenchmarkTimer timer;
+	for(size_t repeat = 0; repeat < noOfRepeats; repeat++) {
+		reference(sigmaCut, refIndices, refSignals);
+		count += refIndices.size();
+	}
+	const double reference = timer.lap() / noOfRepeats;
+	for(size_t repeat = 0; repeat < noOfRepeats; repeat++) {
+		count += compaction::compactScalar(adcValues.data(), pedestalValues.data(), noiseValues.data(),
+		                                   statusValues.data(), noOfPixels, sigmaCut, indices.data(), signals.data());
+	}
+	const double scalar = timer.lap() / noOfRepeats;
+	for(size_t repeat = 0; repeat < noOfRepeats; repeat++) {
+		count += compaction::compact(adcValues.data(), pedestalValues.data(), noiseValues.data(),
+		                             statusValues.data(), noOfPixels, sigmaCut, indices.data(), signals.data());
+	}
+	const double fastest = timer.lap() / noOfRepeats;
+	std::cout << "pixel by pixel " << reference << " us/frame, scalar " << scalar << " us/frame, "
+	          << (compaction::hasAVX2() ? "AVX2 " : "scalar (no AVX2) ") << fastest << " us/frame ("
+	          << count / (3 * noOfRepeats) << " pixels)" << std::endl;
+}